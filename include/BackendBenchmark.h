@@ -0,0 +1,47 @@
+#pragma once
+#include "RenderBackend.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct BackendBenchmarkSettings
+{
+	std::vector<std::string> modelPaths;
+	std::string hdriPath;
+	uint32_t frameCount = 10000;
+	uint32_t framesInFlight = 3; // NUM_FRAMES_IN_FLIGHT
+	uint32_t constantBlocksPerFrame = 6; // camera, previous camera, render settings, render data, post process, denoise
+	uint32_t latency = 2; // submissions the null backend's fences complete after
+};
+
+// Times the device independent half of loading and rendering on a RenderBackend: Scene loading its models and
+// HDRI, and the per frame scene queries and ConstantRing updates paced by frame fences like Renderer does them.
+// On the null backend it runs headless on any platform, so load time and CPU overhead can be measured without a GPU
+class BackendBenchmark
+{
+public:
+	struct Report
+	{
+		std::string backend;
+		BackendBenchmarkSettings settings;
+		bool failed = false;
+		uint32_t meshCount = 0;
+		uint32_t textureCount = 0;
+		uint64_t triangleCount = 0;
+		double loadMs = 0.0; // Scene::LoadModel and LoadHDRI: parsing, decoding, uploads and acceleration structure builds
+		double frameUs = 0.0; // CPU time of one frame, averaged
+		uint64_t constantBytesPerFrame = 0; // peak use of a ConstantRing slice
+		BackendStats loadStats;
+		BackendStats frameStats; // only what the frames added
+
+		void Print(std::ostream& out) const;
+		bool WriteJSON(const std::string& path) const;
+	};
+
+	[[nodiscard]] static Report Run(RenderBackend& backend, const BackendBenchmarkSettings& settings);
+
+	[[nodiscard]] static bool IsRequested(int argc, char* argv[]);
+	// Entry point for --backend-benchmark, returns the exit code
+	static int RunFromCommandLine(int argc, char* argv[]);
+};
@@ -0,0 +1,98 @@
+#pragma once
+#include "OfflineRenderer.h"
+#include "CPUPathTracer.h"
+
+#include <glm/glm.hpp>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// A fixed scene and camera to measure convergence on
+struct ConvergenceCase
+{
+	std::string name;
+	std::vector<std::string> modelPaths;
+	std::string hdriPath;
+	glm::vec3 cameraPosition{ 0.0f, 0.0f, 2.0f };
+	glm::vec3 cameraDirection{ 0.0f, 0.0f, -1.0f };
+	float fov = 60.0f;
+};
+
+struct ConvergenceSettings
+{
+	uint32_t width = 640;
+	uint32_t height = 360;
+	uint32_t referenceSampleCount = 4096;
+	uint32_t maxSampleCount = 256;
+	double timeBudget = 0.0; // seconds of rendering per case, 0 only stops at maxSampleCount
+	CPURenderSettings renderSettings;
+	OfflineBackend backend = OfflineBackend::Auto;
+	std::string referenceDirectory = "convergence"; // references are cached here, keyed by case, resolution, bounces and spp
+	bool rebuildReferences = false;
+	std::string label; // describes the configuration under test in the report, e.g. "rr from bounce 1"
+	bool debugLayer = false;
+	bool compareAdaptive = false; // runs every case with uniform and adaptive sampling, needs a time budget
+	bool compareSamplers = false; // runs every case with the random and the Sobol sequence
+};
+
+// Renders every case to a high sample count reference once, then renders it again with the current
+// configuration and records the error against the reference at every power of two sample count.
+// Reference samples start far past the measured ones, so the two never share random numbers
+class ConvergenceBenchmark
+{
+public:
+	static constexpr uint32_t REFERENCE_FIRST_SAMPLE = 1u << 24;
+
+	struct ErrorMetrics
+	{
+		double rmse = 0.0;
+		double relMse = 0.0; // squared error over (reference^2 + 0.01), per channel
+	};
+
+	struct Point
+	{
+		uint32_t sampleCount = 0;
+		double averageSampleCount = 0.0; // lower than sampleCount once adaptive sampling stops converged pixels
+		double renderMs = 0.0; // wall time spent rendering, excludes readback and error evaluation
+		ErrorMetrics error;
+	};
+
+	struct CaseReport
+	{
+		std::string name;
+		bool failed = false;
+		bool referenceCached = false;
+		double referenceMs = 0.0;
+		std::vector<Point> points;
+
+		// 1 / (relMSE * seconds) at the last point, higher is better
+		[[nodiscard]] double GetEfficiency() const;
+	};
+
+	struct Report
+	{
+		std::string label;
+		std::string device;
+		ConvergenceSettings settings;
+		std::vector<CaseReport> cases;
+
+		void Print(std::ostream& out) const;
+		bool WriteJSON(const std::string& path) const;
+	};
+
+	// References are always rendered with uniform sampling and the random sequence
+	[[nodiscard]] static Report Run(const std::vector<ConvergenceCase>& cases, const ConvergenceSettings& settings);
+	// Error of both runs at the end of the same time budget, per case
+	static void PrintComparison(std::ostream& out, const Report& uniform, const Report& adaptive);
+	// Error of both runs at every sample count they share, per case
+	static void PrintSamplerComparison(std::ostream& out, const Report& random, const Report& sobol);
+	[[nodiscard]] static ErrorMetrics ComputeError(const std::vector<glm::vec3>& image, const std::vector<glm::vec3>& reference);
+
+	[[nodiscard]] static std::vector<ConvergenceCase> GetDefaultCases();
+	// One case per line: a name followed by the scene and camera arguments of --headless, # starts a comment
+	static bool LoadCases(const std::string& path, std::vector<ConvergenceCase>& cases);
+
+	[[nodiscard]] static bool IsRequested(int argc, char* argv[]);
+	// Entry point for --convergence, returns the exit code
+	static int RunFromCommandLine(int argc, char* argv[]);
+};
@@ -0,0 +1,81 @@
+#pragma once
+#include "HeadlessRenderer.h"
+
+#include <glm/glm.hpp>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// The raw accumulation a worker process hands back: one region of the image over one range of samples
+struct RenderPartial
+{
+	uint32_t width = 0; // of the full image
+	uint32_t height = 0;
+	glm::uvec4 region{ 0 }; // x, y, width, height
+	uint32_t firstSample = 0;
+	uint32_t sampleCount = 0;
+	double renderMs = 0.0;
+	std::vector<glm::vec4> sums; // region pixels row by row, unnormalized like the accumulation buffer
+
+	// Cuts the region out of a full image accumulation
+	[[nodiscard]] static RenderPartial FromAccumulation(const std::vector<glm::vec4>& accumulation, uint32_t width, uint32_t height,
+	                                                    glm::uvec4 region, uint32_t firstSample, uint32_t sampleCount, double renderMs);
+
+	bool Write(const std::string& path) const;
+	static bool Read(const std::string& path, RenderPartial& partial);
+};
+
+// One piece of a distributed render. Workers get a list of them, load the scene once and write a partial per job
+struct RenderJob
+{
+	glm::uvec4 region{ 0 }; // x, y, width, height
+	uint32_t firstSample = 0;
+	uint32_t sampleCount = 0;
+	std::string partialPath;
+
+	// One job per line, the partial path last so it can contain spaces
+	static bool WriteList(const std::string& path, const std::vector<RenderJob>& jobs);
+	static bool ReadList(const std::string& path, std::vector<RenderJob>& jobs);
+};
+
+// Splits a headless render over long lived worker processes of this executable and merges their partials. Each
+// worker loads the scene once and renders every job assigned to it, jobs are dealt out in turn so neighbouring
+// tiles of similar cost end up on different workers. Tiles render every sample of a part of the image, and because RNG seeds and camera rays only depend on
+// the pixel and sample index the merged image is bit for bit the single process one. Sample ranges render
+// the whole image and are summed in job order, which is deterministic but rounds differently from a single
+// process, it is the only split the GPU backend supports
+class DistributedRenderer
+{
+public:
+	explicit DistributedRenderer(HeadlessOptions options);
+
+	// Exit code for main
+	int Run();
+
+private:
+	struct Job : RenderJob
+	{
+		int slot = -1; // worker that renders it
+		double renderMs = 0.0; // reported by the worker
+	};
+
+	struct Slot
+	{
+		uint32_t jobCount = 0;
+		double busyMs = 0.0; // process start to exit, including the scene load
+		std::string jobListPath;
+	};
+
+	// Jobs in merge order, each assigned to one of slotCount workers
+	[[nodiscard]] std::vector<Job> CreateJobs(const std::string& partialDirectory, size_t slotCount) const;
+	[[nodiscard]] std::vector<std::string> GetWorkerArguments(const Slot& slot) const;
+	// Starts one process per slot with its job list and waits for all of them
+	bool RunJobs(const std::vector<Job>& jobs, std::vector<Slot>& slots) const;
+	bool Merge(std::vector<Job>& jobs, std::vector<glm::vec4>& accumulation) const;
+
+	void PrintSummary(std::ostream& out, const std::vector<Job>& jobs, const std::vector<Slot>& slots, double renderMs, double totalMs) const;
+	bool WriteSummary(const std::string& path, const std::vector<Job>& jobs, const std::vector<Slot>& slots, double renderMs, double totalMs) const;
+
+	HeadlessOptions m_options;
+	uint32_t m_threadsPerWorker = 1;
+};
@@ -0,0 +1,91 @@
+#pragma once
+#include "CPUPathTracer.h"
+#include "Tonemapping.h"
+#include "OfflineRenderer.h"
+#include "Denoiser.h"
+
+#include <glm/glm.hpp>
+#include <chrono>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct HeadlessOptions
+{
+	std::vector<std::string> modelPaths;
+	std::string hdriPath;
+	glm::vec3 cameraPosition{ 0.0f, 0.0f, 2.0f };
+	glm::vec3 cameraDirection{ 0.0f, 0.0f, -1.0f };
+	float fov = 60.0f;
+	uint32_t width = 1920;
+	uint32_t height = 1080;
+	uint32_t sampleCount = 0; // 0 means no limit, a time budget has to be given then
+	double timeBudget = 0.0; // seconds of rendering, 0 means no limit
+	std::string outputPath = "render.bmp"; // tonemapped
+	std::string linearPath; // empty uses the output path with a .pfm extension
+	std::string summaryPath; // empty uses the output path with a .json extension
+	bool writeFeatures = false; // first hit albedo, normal, depth, motion and IDs as .pfm next to the output
+	bool denoise = false; // filter the accumulation before writing the images
+	Denoiser::Settings denoiseSettings;
+	OfflineBackend backend = OfflineBackend::Auto;
+	CPURenderSettings renderSettings;
+	Tonemapping::Operator tonemapper = Tonemapping::Operator::AgX;
+	float exposure = 25.0f;
+	bool debugLayer = false;
+	uint32_t threadCount = 0; // CPU threads of this process, 0 uses every hardware thread
+
+	// Distributed rendering over worker processes, see DistributedRenderer
+	uint32_t workerCount = 0; // 0 renders in this process
+	bool splitSamples = false; // split into sample ranges over the whole image instead of tiles
+	uint32_t tileSize = 256;
+	bool keepPartials = false;
+	std::vector<std::string> sceneArguments; // scene, camera and render setting arguments, forwarded to workers
+
+	// Set on worker processes: load the scene once, then render every job in the list and write its raw
+	// accumulation as a partial instead of images
+	std::string jobListPath;
+
+	// Returns false and prints the problem for malformed arguments
+	static bool Parse(int argc, char* argv[], HeadlessOptions& options);
+	static void PrintUsage(std::ostream& out);
+};
+
+// Batch rendering without a window: loads the scene, renders until the sample count or time budget is
+// reached, then writes the tonemapped and linear images and a timing summary
+class HeadlessRenderer
+{
+public:
+	explicit HeadlessRenderer(HeadlessOptions options);
+	~HeadlessRenderer();
+
+	// Exit code for main
+	int Run();
+
+	[[nodiscard]] static bool IsRequested(int argc, char* argv[]);
+
+private:
+	struct Timings
+	{
+		double setupMs = 0.0;
+		double loadMs = 0.0;
+		double resetMs = 0.0;
+		double renderMs = 0.0;
+		double readbackMs = 0.0;
+		double denoiseMs = 0.0;
+		double writeMs = 0.0;
+		double totalMs = 0.0;
+	};
+
+	// Worker side of DistributedRenderer, after the scene was loaded
+	int RunJobs(Timings& timings, std::chrono::steady_clock::time_point startTime);
+
+	void PrintSummary(std::ostream& out, const Timings& timings) const;
+	bool WriteSummary(const std::string& path, const Timings& timings) const;
+	// Writes <output>_albedo, _normal, _depth, _motion and _ids .pfm images, averaged like the linear image
+	bool WriteFeatures(const std::vector<glm::vec4>& accumulation, const FeatureBuffers& features) const;
+
+	HeadlessOptions m_options;
+	std::unique_ptr<OfflineRenderer> m_renderer;
+	double m_pathCount = 0.0; // camera paths traced, sum of the per-pixel sample counts
+};
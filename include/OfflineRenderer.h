@@ -0,0 +1,47 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class Camera;
+struct CPURenderSettings;
+struct FeatureBuffers;
+
+enum class OfflineBackend
+{
+	Auto, // GPU when a raytracing capable adapter exists, CPU otherwise
+	GPU,
+	CPU,
+};
+
+// Renders into an accumulation buffer without a window or swap chain, implemented by the GPU path tracer
+// and by the CPU reference so headless runs work on machines without a raytracing capable GPU
+class OfflineRenderer
+{
+public:
+	virtual ~OfflineRenderer() = default;
+
+	virtual bool LoadModel(const std::string& path) = 0;
+	virtual bool LoadHDRI(const std::string& path) = 0;
+	// Clears the accumulation, call after loading the scene. Sample indices (and RNG seeds) start at firstSample
+	virtual void Reset(uint32_t width, uint32_t height, uint32_t firstSample) = 0;
+	// Only renders the given rectangle of the image until the next Reset, returns false if the backend can't
+	virtual bool SetRegion(uint32_t x, uint32_t y, uint32_t width, uint32_t height) = 0;
+	// Renders one sample per pixel and returns once it has finished, so it can be timed
+	virtual void RenderSample(const Camera& camera, const CPURenderSettings& settings) = 0;
+
+	// RGB sum and per-pixel sample count in alpha like accumulationBuffer
+	[[nodiscard]] virtual std::vector<glm::vec4> ReadAccumulation() = 0;
+	// First hit albedo, normal, depth, motion and IDs of the same samples, see FeatureBuffers
+	[[nodiscard]] virtual FeatureBuffers ReadFeatures() = 0;
+	[[nodiscard]] virtual uint32_t GetSampleCount() const = 0;
+	[[nodiscard]] virtual std::string GetName() const = 0;
+	[[nodiscard]] virtual OfflineBackend GetBackend() const = 0;
+
+	// Resolves Auto, returns nullptr when the GPU is requested but no adapter supports DXR
+	[[nodiscard]] static std::unique_ptr<OfflineRenderer> Create(OfflineBackend backend, bool debug);
+	[[nodiscard]] static bool ParseBackend(const std::string& name, OfflineBackend& backend);
+	[[nodiscard]] static const char* GetBackendName(OfflineBackend backend);
+};
@@ -0,0 +1,158 @@
+#pragma once
+#include "Geometry.h"
+#include "CacheSimulator.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// 32 byte node: interior nodes store the index of their left child (the right child follows it),
+// leaves store the first entry in the primitive index list
+struct BVHNode
+{
+    glm::vec3 aabbMin;
+    uint32_t leftFirst;
+    glm::vec3 aabbMax;
+    uint32_t primCount;
+
+    [[nodiscard]] bool IsLeaf() const { return primCount > 0; }
+};
+static_assert(sizeof(BVHNode) == 32);
+
+constexpr uint32_t BVH_MAX_DEPTH = 64;
+
+// Default node layout for MeshBVH traversal, 1 = quantized 4-wide nodes (CompressedBVH), 0 = 32 byte binary nodes
+#ifndef USE_COMPRESSED_BVH
+#define USE_COMPRESSED_BVH 0
+#endif
+
+enum class BVHUpdateMode
+{
+    Refit,
+    Rebuild,
+    Auto // refit, and rebuild once the refit SAH cost exceeds rebuildThreshold times the cost after the last build
+};
+
+struct BVHBuildSettings
+{
+    uint32_t binCount = 16;
+    uint32_t maxLeafSize = 4;
+    float traversalCost = 1.0f;
+    float intersectionCost = 1.0f;
+    float rebuildThreshold = 1.5f;
+    bool compressed = USE_COMPRESSED_BVH; // only used by MeshBVH, the top level always stays binary
+};
+
+struct TraversalStats
+{
+    uint64_t nodeVisits = 0; // node bounds tested
+
+    uint64_t primitiveTests = 0;
+    CacheSimulator* cache = nullptr; // optional, fed the nodes and primitives touched, not accumulated by +=
+
+    TraversalStats& operator+=(const TraversalStats& other)
+    {
+        nodeVisits += other.nodeVisits;
+        primitiveTests += other.primitiveTests;
+        return *this;
+    }
+};
+
+// Binned SAH BVH over arbitrary primitive bounds, used for both mesh (bottom level) and instance (top level) hierarchies
+class BVH
+{
+public:
+    void Build(const std::vector<AABB>& primitiveBounds, const BVHBuildSettings& settings = {});
+    // Recomputes node bounds bottom-up for moved primitives, the topology is kept as is
+    void Refit(const std::vector<AABB>& primitiveBounds);
+    // Refits or rebuilds according to mode, returns true if the hierarchy was rebuilt
+    bool Update(const std::vector<AABB>& primitiveBounds, BVHUpdateMode mode);
+
+    // Closest-first traversal, intersect(primIndex, ray) is expected to shrink ray.tMax on a hit
+    template<typename IntersectFn>
+    void Traverse(Ray& ray, IntersectFn&& intersect, TraversalStats* stats = nullptr) const;
+
+    // SAH cost normalized by the root surface area
+    [[nodiscard]] float ComputeSAHCost(float traversalCost, float intersectionCost) const;
+    [[nodiscard]] uint32_t ComputeMaxDepth() const;
+
+    [[nodiscard]] const std::vector<BVHNode>& GetNodes() const { return m_nodes; }
+    [[nodiscard]] const std::vector<uint32_t>& GetPrimitiveIndices() const { return m_primIndices; }
+    [[nodiscard]] const BVHBuildSettings& GetSettings() const { return m_settings; }
+    [[nodiscard]] size_t GetMemoryFootprint() const { return m_nodes.size() * sizeof(BVHNode) + m_primIndices.size() * sizeof(uint32_t); }
+    [[nodiscard]] float GetBuildSAHCost() const { return m_buildCost; }
+    [[nodiscard]] AABB GetBounds() const;
+    [[nodiscard]] bool IsEmpty() const { return m_nodes.empty(); }
+
+private:
+    struct Split
+    {
+        float cost = std::numeric_limits<float>::max();
+        int axis = -1;
+        uint32_t bin = 0; // primitives in bins below this index go left
+        float centroidMin = 0.0f;
+        float scale = 0.0f;
+    };
+
+    void UpdateNodeBounds(uint32_t nodeIndex, const std::vector<AABB>& primitiveBounds);
+    [[nodiscard]] Split FindBestSplit(const BVHNode& node, const std::vector<glm::vec3>& centroids,
+                                      const std::vector<AABB>& primitiveBounds) const;
+
+    std::vector<BVHNode> m_nodes;
+    std::vector<uint32_t> m_primIndices;
+    BVHBuildSettings m_settings;
+    float m_buildCost = 0.0f;
+};
+
+template<typename IntersectFn>
+void BVH::Traverse(Ray& ray, IntersectFn&& intersect, TraversalStats* stats) const
+{
+    if (m_nodes.empty()) return;
+
+    const BVHNode* stack[BVH_MAX_DEPTH];
+    uint32_t stackSize = 0;
+    const BVHNode* node = &m_nodes[0];
+    CacheSimulator* cache = stats ? stats->cache : nullptr;
+    if (stats) stats->nodeVisits++;
+    if (cache) cache->Access(node, sizeof(BVHNode));
+    if (IntersectAABB(ray, node->aabbMin, node->aabbMax) == RAY_T_MAX) return;
+
+    while (true)
+    {
+        if (node->IsLeaf())
+        {
+            if (cache) cache->Access(&m_primIndices[node->leftFirst], node->primCount * sizeof(uint32_t));
+            for (uint32_t i = 0; i < node->primCount; i++)
+            {
+                intersect(m_primIndices[node->leftFirst + i], ray);
+            }
+            if (stats) stats->primitiveTests += node->primCount;
+            if (stackSize == 0) break;
+            node = stack[--stackSize];
+            continue;
+        }
+
+        const BVHNode* child1 = &m_nodes[node->leftFirst];
+        const BVHNode* child2 = &m_nodes[node->leftFirst + 1];
+        float dist1 = IntersectAABB(ray, child1->aabbMin, child1->aabbMax);
+        float dist2 = IntersectAABB(ray, child2->aabbMin, child2->aabbMax);
+        if (stats) stats->nodeVisits += 2;
+        if (cache) cache->Access(child1, 2 * sizeof(BVHNode));
+        if (dist1 > dist2)
+        {
+            std::swap(dist1, dist2);
+            std::swap(child1, child2);
+        }
+
+        if (dist1 == RAY_T_MAX)
+        {
+            if (stackSize == 0) break;
+            node = stack[--stackSize];
+        }
+        else
+        {
+            node = child1;
+            if (dist2 != RAY_T_MAX) stack[stackSize++] = child2;
+        }
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "SceneBVH.h"
+
+#include <array>
+#include <ostream>
+
+class Camera;
+
+struct BVHAnalyzerSettings
+{
+    BVHBuildSettings build{};
+    uint32_t rayWidth = 320;
+    uint32_t rayHeight = 180;
+    uint32_t reportedMeshes = 10;
+};
+
+// Builds a CPU mirror of the scene's acceleration structures and reports their quality:
+// SAH cost, node/leaf counts and leaf sizes per mesh, top level instance overlap,
+// and measured node visits for a sampled set of primary and one-bounce diffuse rays
+class BVHAnalyzer
+{
+public:
+    struct MeshReport
+    {
+        std::string name;
+        uint32_t instanceCount = 0;
+        uint32_t triangleCount = 0;
+        uint32_t nodeCount = 0;
+        uint32_t leafCount = 0;
+        uint32_t maxDepth = 0;
+        float sahCost = 0.0f;
+        float triangleOverlap = 0.0f; // sum of triangle bounds area over root area, high values favour spatial splits
+        std::array<uint32_t, 8> leafHistogram{}; // leaves holding 1..7 triangles, the last bucket is 8+
+        uint64_t rayEntries = 0; // rays that entered one of this mesh's instances
+        TraversalStats traversal;
+    };
+
+    struct RayReport
+    {
+        uint64_t rayCount = 0;
+        uint64_t hitCount = 0;
+        TraversalStats topLevel; // primitiveTests are instance entries
+        TraversalStats bottomLevel;
+    };
+
+    struct Report
+    {
+        std::vector<MeshReport> meshes;
+        uint32_t instanceCount = 0;
+        uint32_t topNodeCount = 0;
+        uint32_t topMaxDepth = 0;
+        float topSAHCost = 0.0f;
+        float sceneSAHCost = 0.0f;
+        float averageSiblingOverlap = 0.0f; // overlap area of sibling nodes relative to their parent
+        float maxSiblingOverlap = 0.0f;
+        uint64_t overlappingInstancePairs = 0;
+        float instanceAreaRatio = 0.0f; // sum of instance bounds area over scene bounds area
+        RayReport primary;
+        RayReport secondary;
+        double buildTimeMs = 0.0;
+        double traceTimeMs = 0.0;
+        uint32_t reportedMeshes = 10;
+
+        void Print(std::ostream& out) const;
+    };
+
+    [[nodiscard]] static Report Analyze(const std::vector<CPUInstance>& instances, const Camera& camera,
+                                        float aspectRatio, const BVHAnalyzerSettings& settings = {});
+};
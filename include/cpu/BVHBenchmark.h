@@ -0,0 +1,63 @@
+#pragma once
+#include "SceneBVH.h"
+
+#include <ostream>
+
+class Camera;
+
+struct BVHBenchmarkSettings
+{
+    BVHBuildSettings build{};
+    uint32_t frameCount = 60;
+    uint32_t rayWidth = 160;
+    uint32_t rayHeight = 90;
+    float motionScale = 0.1f; // instance motion amplitude relative to the scene diagonal
+    float deformationScale = 0.02f; // vertex displacement amplitude relative to the mesh diagonal
+    uint32_t randomRayCount = 1 << 18; // incoherent rays for the node layout comparison
+};
+
+// Animates the scene on the CPU and compares refitting against rebuilding, both for instance
+// transform changes (top level) and for deformed vertices of the largest mesh (bottom level).
+// Also compares the binary and compressed bottom level node layouts
+class BVHBenchmark
+{
+public:
+    struct Result
+    {
+        BVHUpdateMode mode = BVHUpdateMode::Refit;
+        uint32_t rebuildCount = 0;
+        double updateMs = 0.0;
+        double traceMs = 0.0;
+        uint64_t rayCount = 0;
+        uint64_t nodeVisits = 0;
+        float finalSAHCost = 0.0f;
+    };
+
+    struct LayoutResult
+    {
+        bool compressed = false;
+        size_t memoryBytes = 0;
+        double buildMs = 0.0;
+        double primaryMs = 0.0;
+        double randomMs = 0.0;
+        uint64_t primaryRays = 0;
+        uint64_t randomRays = 0;
+        TraversalStats primaryStats;
+        TraversalStats randomStats;
+    };
+
+    struct Report
+    {
+        std::vector<LayoutResult> layouts;
+        uint32_t frameCount = 0;
+        std::vector<Result> instanceMotion;
+        std::string deformedMesh;
+        uint32_t deformedTriangles = 0;
+        std::vector<Result> deformation;
+
+        void Print(std::ostream& out) const;
+    };
+
+    [[nodiscard]] static Report Run(const std::vector<CPUInstance>& instances, const Camera& camera,
+                                    float aspectRatio, const BVHBenchmarkSettings& settings = {});
+};
@@ -0,0 +1,27 @@
+#pragma once
+#include "OfflineRenderer.h"
+#include "CPUPathTracer.h"
+
+// OfflineRenderer backed by the CPU path tracer, the fallback when no raytracing GPU is available
+class CPUOfflineRenderer : public OfflineRenderer
+{
+public:
+    bool LoadModel(const std::string& path) override;
+    bool LoadHDRI(const std::string& path) override;
+    void Reset(uint32_t width, uint32_t height, uint32_t firstSample) override;
+    bool SetRegion(uint32_t x, uint32_t y, uint32_t width, uint32_t height) override;
+    void RenderSample(const Camera& camera, const CPURenderSettings& settings) override;
+
+    [[nodiscard]] std::vector<glm::vec4> ReadAccumulation() override { return m_tracer.GetAccumulation(); }
+    [[nodiscard]] FeatureBuffers ReadFeatures() override { return m_tracer.GetFeatures(); }
+    [[nodiscard]] uint32_t GetSampleCount() const override { return m_tracer.GetSampleCount(); }
+    [[nodiscard]] std::string GetName() const override;
+    [[nodiscard]] OfflineBackend GetBackend() const override { return OfflineBackend::CPU; }
+
+    [[nodiscard]] const CPUPathTracer& GetPathTracer() const { return m_tracer; }
+
+private:
+    CPUScene m_scene;
+    CPUPathTracer m_tracer;
+    bool m_modelsChanged = true; // since the BVH was built
+};
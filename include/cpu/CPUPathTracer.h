@@ -0,0 +1,169 @@
+#pragma once
+#include "CPUScene.h"
+#include "SceneBVH.h"
+#include "RaySorter.h"
+#include "RNG.h"
+
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+
+class Camera;
+
+// CPU counterpart of RenderSettings, without the D3D12 types
+struct CPURenderSettings
+{
+    uint32_t bounces = 2;
+    float skyIntensity = 1.0f;
+    float lightIntensity = 1.0f;
+    bool whiteFurnace = false;
+    bool sortRays = false; // sort secondary rays by origin cell and direction octant before tracing them
+    bool simulateCache = false; // feed traversal through one CacheSimulator per worker, costs tracing speed
+
+    // Adaptive sampling: pixels stop being traced once the relative standard error of their mean luminance
+    // drops below adaptiveThreshold. The convergence mask is updated after adaptiveMinSamples samples and
+    // every adaptiveInterval samples after that
+    bool adaptiveSampling = false;
+    float adaptiveThreshold = 0.02f;
+    uint32_t adaptiveMinSamples = 16;
+    uint32_t adaptiveInterval = 8;
+
+    RNG::Sequence sequence = RNG::Sequence::Random; // Sobol converges faster on the low dimensions of a path
+};
+
+// Whether the convergence mask gets recomputed once sampleCount samples have been accumulated
+[[nodiscard]] inline bool IsConvergenceUpdate(uint32_t sampleCount, uint32_t minSamples, uint32_t interval)
+{
+    return sampleCount >= std::max(minSamples, 2u) && (sampleCount - std::max(minSamples, 2u)) % std::max(interval, 1u) == 0;
+}
+
+// Relative standard error of a pixel's mean luminance, from its accumulation (sample count in alpha) and
+// luminance^2 sum. Same estimate as convergence_pass.slang
+[[nodiscard]] inline float EstimateRelativeError(const glm::vec4& accumulated, float luminanceSquaredSum)
+{
+    const float n = accumulated.w;
+    if (n < 2.0f) return 1e30f;
+
+    const float mean = glm::dot(glm::vec3(accumulated), glm::vec3(0.2126f, 0.7152f, 0.0722f)) / n;
+    const float variance = std::max(luminanceSquaredSum / n - mean * mean, 0.0f) * n / (n - 1.0f);
+    return std::sqrt(variance / n) / (mean + 1e-3f);
+}
+
+// First hit features of every path, summed over the same samples as the accumulation (its alpha resolves
+// them) except for the IDs and motion, which hold the latest sample. Misses have white albedo, zero normal and
+// depth and INVALID_FEATURE_ID
+struct FeatureBuffers
+{
+    std::vector<glm::vec4> albedo;
+    std::vector<glm::vec4> normalDepth; // shading normal, linear depth along the camera forward in w
+    std::vector<glm::vec2> motion; // pixels a point moved since the previous sample's camera
+    std::vector<glm::uvec2> ids; // instance and material index
+};
+
+constexpr uint32_t INVALID_FEATURE_ID = 0xFFFFFFFF;
+
+struct CPUBounceStats
+{
+    uint64_t rayCount = 0;
+    uint64_t hitCount = 0;
+    double sortMs = 0.0;
+    double traceMs = 0.0; // traversal and shading
+    TraversalStats traversal;
+    uint64_t cacheAccesses = 0;
+    uint64_t cacheMisses = 0;
+};
+
+struct CPURenderStats
+{
+    std::vector<CPUBounceStats> bounces; // index 0 holds the primary rays
+    uint32_t sampleCount = 0;
+    uint64_t convergedPixels = 0; // in the mask after the last sample
+    double totalMs = 0.0;
+
+    void Print(std::ostream& out) const;
+};
+
+// Wavefront port of raytracing.slang: every bounce traces the whole batch of live paths before shading
+// them, which gives secondary rays a point where they can be reordered for coherence.
+// Uses the same RNG seeding and sample sequence as the GPU, so sample N matches frame N
+class CPUPathTracer
+{
+public:
+    struct RaySortingComparison
+    {
+        CPURenderStats unsorted;
+        CPURenderStats sorted;
+        bool identical = false; // sorting only changes the trace order, the image has to stay bit-exact
+
+        void Print(std::ostream& out) const;
+    };
+
+    void SetScene(const CPUScene& scene, const BVHBuildSettings& settings = {});
+    // Sample indices start at firstSample, so separate runs can render disjoint parts of the sequence
+    void Reset(uint32_t width, uint32_t height, uint32_t firstSample = 0);
+    // Restricts tracing to a rectangle of the image, clipped to it. Pixels keep the RNG seeds and camera rays
+    // they have in a full frame, so tiles rendered separately match a full render exactly. Reset clears the region
+    void SetRegion(uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+    // Traces one sample per pixel, skipping converged pixels with adaptive sampling, and adds it to the accumulation
+    void RenderSample(const Camera& camera, const CPURenderSettings& settings);
+
+    // RGB sum and per-pixel sample count in alpha
+    [[nodiscard]] const std::vector<glm::vec4>& GetAccumulation() const { return m_accumulation; }
+    [[nodiscard]] const std::vector<uint8_t>& GetConvergenceMask() const { return m_converged; }
+    // Motion is always zero, the CPU tracer renders a still camera
+    [[nodiscard]] const FeatureBuffers& GetFeatures() const { return m_features; }
+    [[nodiscard]] uint32_t GetWidth() const { return m_width; }
+    [[nodiscard]] uint32_t GetHeight() const { return m_height; }
+    [[nodiscard]] uint32_t GetSampleCount() const { return m_sampleCount; }
+    [[nodiscard]] uint32_t GetFirstSample() const { return m_firstSample; }
+    [[nodiscard]] const SceneBVH& GetSceneBVH() const { return m_bvh; }
+    [[nodiscard]] const CPURenderStats& GetStats() const { return m_stats; }
+    void ResetStats() { m_stats = {}; }
+
+    // Renders the same samples with and without ray sorting, and once more with the cache simulator for miss counts
+    [[nodiscard]] static RaySortingComparison CompareRaySorting(const CPUScene& scene, const Camera& camera, uint32_t width,
+                                                                uint32_t height, uint32_t sampleCount, CPURenderSettings settings = {});
+
+private:
+    struct PathState
+    {
+        glm::vec3 origin;
+        uint32_t pixel;
+        glm::vec3 direction;
+        RNG rng;
+        glm::vec3 throughput;
+    };
+
+    void UpdateConvergence(const CPURenderSettings& settings);
+    void SortPaths(CPUBounceStats& stats);
+    // Primary bounces also write the feature buffers
+    void TraceBounce(const CPURenderSettings& settings, CPUBounceStats& stats, bool primary);
+    // Returns false once the path is done
+    bool ShadeHit(PathState& path, const Hit& hit, const CPURenderSettings& settings, bool primary);
+    void ShadeMiss(const PathState& path, const CPURenderSettings& settings, bool primary);
+
+    const CPUScene* m_scene = nullptr;
+    SceneBVH m_bvh;
+    RaySorter m_sorter;
+
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    uint32_t m_firstSample = 0;
+    glm::uvec2 m_regionMin{ 0 };
+    glm::uvec2 m_regionMax{ 0 }; // exclusive
+    uint32_t m_sampleCount = 0;
+    std::vector<glm::vec4> m_accumulation; // RGB sum and sample count like accumulationBuffer
+    std::vector<float> m_luminanceMoments; // luminance^2 sum like momentBuffer
+    std::vector<uint8_t> m_converged;
+    FeatureBuffers m_features;
+    glm::vec3 m_cameraForward{ 0.0f, 0.0f, -1.0f };
+    std::vector<uint32_t> m_rowOffsets; // first path of every region row
+    std::vector<glm::vec3> m_radiance; // radiance of the sample in flight, one path per pixel
+    std::vector<PathState> m_paths;
+    std::vector<PathState> m_nextPaths;
+    std::vector<uint8_t> m_alive;
+    std::vector<uint32_t> m_sortKeys;
+    std::vector<uint32_t> m_sortOrder;
+    std::vector<CacheSimulator> m_caches;
+    CPURenderStats m_stats;
+};
@@ -0,0 +1,74 @@
+#pragma once
+#include "Geometry.h"
+
+#include <string>
+#include <vector>
+
+// Texture kept in memory for the CPU path tracer. LDR images stay RGBA8 and are decoded on fetch,
+// HDR images are stored as float
+struct CPUTexture
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    bool srgb = false; // matches the R8G8B8A8_UNORM_SRGB views used on the GPU
+    std::vector<uint8_t> ldrTexels;
+    std::vector<glm::vec4> hdrTexels;
+
+    // Bilinear filtering with wrap addressing, like the linear static sampler
+    [[nodiscard]] glm::vec4 Sample(glm::vec2 uv) const;
+    [[nodiscard]] glm::vec4 Fetch(uint32_t x, uint32_t y) const;
+    [[nodiscard]] bool IsValid() const { return width > 0 && height > 0; }
+    [[nodiscard]] size_t GetMemoryFootprint() const { return ldrTexels.size() + hdrTexels.size() * sizeof(glm::vec4); }
+};
+
+// Same layout as MaterialData, texture indices refer to CPUScene::GetTextures instead of descriptors
+struct CPUMaterial
+{
+    glm::vec3 albedoFactor = glm::vec3(1.0f);
+    int32_t albedoIndex = -1;
+    glm::vec3 emissiveFactor = glm::vec3(1.0f);
+    int32_t emissiveIndex = -1;
+    float metallicFactor = 1.0f;
+    float roughnessFactor = 1.0f;
+    int32_t metallicRoughnessIndex = -1;
+    int32_t normalIndex = -1;
+};
+
+// One glTF primitive placed in the world, with the vertex attributes ClosestHit reads
+struct CPUMesh
+{
+    CPUGeometry geometry;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> texCoords;
+    std::vector<glm::vec4> tangents;
+    glm::mat4 transform{ 1.0f };
+    uint32_t materialIndex = 0;
+    std::string name;
+};
+
+// Device independent copy of a scene, loaded straight from glTF/HDR files the same way Model and Scene
+// load them for the GPU, so the CPU path tracer can render without a D3D12 device
+class CPUScene
+{
+public:
+    bool LoadModel(const std::string& path);
+    bool LoadHDRI(const std::string& path);
+
+    // Instances in the same order as the meshes, and therefore as the TLAS instance IDs
+    [[nodiscard]] std::vector<CPUInstance> GetInstances() const;
+
+    [[nodiscard]] const std::vector<CPUMesh>& GetMeshes() const { return m_meshes; }
+    [[nodiscard]] const std::vector<CPUMaterial>& GetMaterials() const { return m_materials; }
+    [[nodiscard]] const std::vector<CPUTexture>& GetTextures() const { return m_textures; }
+    [[nodiscard]] const CPUMaterial& GetMaterial(uint32_t index) const;
+    // nullptr for -1 and for images that failed to load
+    [[nodiscard]] const CPUTexture* GetTexture(int32_t index) const { return index >= 0 && m_textures[index].IsValid() ? &m_textures[index] : nullptr; }
+    [[nodiscard]] const CPUTexture* GetHDRI() const { return m_hdri.IsValid() ? &m_hdri : nullptr; }
+    [[nodiscard]] bool IsEmpty() const { return m_meshes.empty(); }
+
+private:
+    std::vector<CPUMesh> m_meshes;
+    std::vector<CPUMaterial> m_materials;
+    std::vector<CPUTexture> m_textures;
+    CPUTexture m_hdri;
+};
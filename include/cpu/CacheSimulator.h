@@ -0,0 +1,66 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Set associative LRU model of a per-core data cache, fed the addresses touched during traversal.
+// Hardware miss counters aren't portable, this gives a repeatable proxy for how well a ray order reuses memory
+class CacheSimulator
+{
+public:
+    explicit CacheSimulator(uint32_t sizeBytes = 256 * 1024, uint32_t lineBytes = 64, uint32_t ways = 8)
+        : m_lineShift(0), m_ways(ways)
+    {
+        while ((1u << m_lineShift) < lineBytes) m_lineShift++;
+        m_setCount = std::max(1u, sizeBytes / (lineBytes * ways));
+        m_tags.assign(static_cast<size_t>(m_setCount) * ways, EMPTY);
+    }
+
+    void Access(const void* address, size_t size)
+    {
+        uint64_t first = reinterpret_cast<uintptr_t>(address) >> m_lineShift;
+        uint64_t last = (reinterpret_cast<uintptr_t>(address) + size - 1) >> m_lineShift;
+        for (uint64_t line = first; line <= last; line++)
+        {
+            AccessLine(line);
+        }
+    }
+
+    void Reset()
+    {
+        std::fill(m_tags.begin(), m_tags.end(), EMPTY);
+        m_accesses = 0;
+        m_misses = 0;
+    }
+
+    [[nodiscard]] uint64_t GetAccesses() const { return m_accesses; }
+    [[nodiscard]] uint64_t GetMisses() const { return m_misses; }
+
+private:
+    static constexpr uint64_t EMPTY = ~0ull;
+
+    void AccessLine(uint64_t line)
+    {
+        m_accesses++;
+
+        // Ways are kept in most recently used order
+        uint64_t* set = &m_tags[(line % m_setCount) * m_ways];
+        uint32_t way = 0;
+        while (way < m_ways && set[way] != line) way++;
+        if (way == m_ways)
+        {
+            m_misses++;
+            way = m_ways - 1;
+        }
+        std::memmove(set + 1, set, way * sizeof(uint64_t));
+        set[0] = line;
+    }
+
+    uint32_t m_lineShift;
+    uint32_t m_ways;
+    uint32_t m_setCount;
+    std::vector<uint64_t> m_tags;
+    uint64_t m_accesses = 0;
+    uint64_t m_misses = 0;
+};
@@ -0,0 +1,111 @@
+#pragma once
+#include "BVH.h"
+
+#include <cmath>
+
+// 4-wide node with child bounds quantized to 8 bits relative to the parent, stored per axis so the
+// four child slab tests can run side by side. Replaces roughly three 32 byte binary nodes with 56 bytes
+struct CompressedBVHNode
+{
+    glm::vec3 origin;
+    int8_t exponent[3]; // child bounds are origin + q * 2^exponent
+    uint8_t childCount;
+    uint8_t quantMin[3][4];
+    uint8_t quantMax[3][4];
+    uint32_t children[4]; // interior: node index, leaf: LEAF_FLAG | count << LEAF_COUNT_SHIFT | first primitive
+};
+static_assert(sizeof(CompressedBVHNode) == 56);
+
+// Collapsed, quantized copy of a binary BVH. Leaves reference the primitive index list of the source BVH
+class CompressedBVH
+{
+public:
+    static constexpr uint32_t LEAF_FLAG = 0x80000000u;
+    static constexpr uint32_t LEAF_COUNT_SHIFT = 27;
+    static constexpr uint32_t LEAF_MAX_COUNT = 15;
+    static constexpr uint32_t LEAF_FIRST_MASK = (1u << LEAF_COUNT_SHIFT) - 1;
+
+    void Build(const BVH& source, const std::vector<AABB>& primitiveBounds);
+
+    template<typename IntersectFn>
+    void Traverse(Ray& ray, IntersectFn&& intersect, TraversalStats* stats = nullptr) const;
+
+    [[nodiscard]] const std::vector<CompressedBVHNode>& GetNodes() const { return m_nodes; }
+    [[nodiscard]] size_t GetMemoryFootprint() const { return m_nodes.size() * sizeof(CompressedBVHNode) + m_primIndices.size() * sizeof(uint32_t); }
+    [[nodiscard]] bool IsEmpty() const { return m_nodes.empty(); }
+    void Clear() { m_nodes.clear(); m_primIndices.clear(); }
+
+private:
+    struct Child
+    {
+        AABB bounds;
+        uint32_t code; // final child encoding, or the source node index while pending
+        bool pending; // interior source node that has not been collapsed yet
+    };
+
+    uint32_t EmitNode(const BVH& source, const std::vector<AABB>& primitiveBounds, const std::vector<Child>& children);
+    Child MakeChild(const BVH& source, const std::vector<AABB>& primitiveBounds, uint32_t sourceIndex);
+    uint32_t EmitLeafRange(const std::vector<AABB>& primitiveBounds, uint32_t first, uint32_t count, AABB& bounds);
+
+    std::vector<CompressedBVHNode> m_nodes;
+    std::vector<uint32_t> m_primIndices;
+};
+
+template<typename IntersectFn>
+void CompressedBVH::Traverse(Ray& ray, IntersectFn&& intersect, TraversalStats* stats) const
+{
+    if (m_nodes.empty()) return;
+
+    struct StackEntry
+    {
+        uint32_t code;
+        float distance;
+    };
+    StackEntry stack[4 * BVH_MAX_DEPTH];
+    uint32_t stackSize = 0;
+    stack[stackSize++] = { 0, 0.0f };
+    CacheSimulator* cache = stats ? stats->cache : nullptr;
+
+    while (stackSize > 0)
+    {
+        StackEntry entry = stack[--stackSize];
+        if (entry.distance >= ray.tMax) continue;
+
+        if (entry.code & LEAF_FLAG)
+        {
+            uint32_t first = entry.code & LEAF_FIRST_MASK;
+            uint32_t count = (entry.code & ~LEAF_FLAG) >> LEAF_COUNT_SHIFT;
+            if (cache) cache->Access(&m_primIndices[first], count * sizeof(uint32_t));
+            for (uint32_t i = 0; i < count; i++)
+            {
+                intersect(m_primIndices[first + i], ray);
+            }
+            if (stats) stats->primitiveTests += count;
+            continue;
+        }
+
+        const CompressedBVHNode& node = m_nodes[entry.code];
+        if (stats) stats->nodeVisits += node.childCount;
+        if (cache) cache->Access(&node, sizeof(CompressedBVHNode));
+
+        glm::vec3 scale(std::ldexp(1.0f, node.exponent[0]), std::ldexp(1.0f, node.exponent[1]), std::ldexp(1.0f, node.exponent[2]));
+        StackEntry hits[4];
+        uint32_t hitCount = 0;
+        for (uint32_t c = 0; c < node.childCount; c++)
+        {
+            glm::vec3 boundsMin = node.origin + glm::vec3(node.quantMin[0][c], node.quantMin[1][c], node.quantMin[2][c]) * scale;
+            glm::vec3 boundsMax = node.origin + glm::vec3(node.quantMax[0][c], node.quantMax[1][c], node.quantMax[2][c]) * scale;
+            float distance = IntersectAABB(ray, boundsMin, boundsMax);
+            if (distance == RAY_T_MAX) continue;
+
+            // Insertion sort, farthest first so the nearest child is popped next
+            uint32_t i = hitCount++;
+            for (; i > 0 && hits[i - 1].distance < distance; i--) hits[i] = hits[i - 1];
+            hits[i] = { node.children[c], distance };
+        }
+        for (uint32_t i = 0; i < hitCount; i++)
+        {
+            stack[stackSize++] = hits[i];
+        }
+    }
+}
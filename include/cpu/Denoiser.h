@@ -0,0 +1,27 @@
+#pragma once
+#include "CPUPathTracer.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+// CPU port of shaders/denoise_pass.slang: a 3x3 luminance variance estimate and an edge-avoiding a-trous
+// filter guided by the first hit albedo, normal and depth. Works on planes of floats, one
+// row at a time per tap, so the inner loops have no gathers or branches and vectorize
+namespace Denoiser
+{
+    constexpr uint32_t MAX_ITERATIONS = 5; // step sizes 1 to 16
+
+    // CPU counterpart of DenoiseSettings
+    struct Settings
+    {
+        uint32_t iterations = 5;
+        float sigmaLuminance = 4.0f;
+        float sigmaAlbedo = 0.1f;
+        float sigmaNormal = 128.0f;
+        float sigmaDepth = 0.05f;
+    };
+
+    // Returns RGB sum and sample count like the accumulation it was given, so it resolves the same way
+    [[nodiscard]] std::vector<glm::vec4> Denoise(const std::vector<glm::vec4>& accumulation, const FeatureBuffers& features,
+                                                 uint32_t width, uint32_t height, const Settings& settings);
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+constexpr float RAY_T_MAX = 65536.0f; // matches MAX_RAY_DEPTH in settings.slang
+
+struct AABB
+{
+    glm::vec3 min{ std::numeric_limits<float>::max() };
+    glm::vec3 max{ -std::numeric_limits<float>::max() };
+
+    void Grow(const glm::vec3& point)
+    {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    void Grow(const AABB& other)
+    {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+
+    [[nodiscard]] bool IsValid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+    [[nodiscard]] glm::vec3 Extent() const { return max - min; }
+    [[nodiscard]] glm::vec3 Centroid() const { return (min + max) * 0.5f; }
+
+    [[nodiscard]] float SurfaceArea() const
+    {
+        if (!IsValid()) return 0.0f;
+        glm::vec3 e = Extent();
+        return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+    }
+
+    [[nodiscard]] static AABB Intersection(const AABB& a, const AABB& b)
+    {
+        AABB result;
+        result.min = glm::max(a.min, b.min);
+        result.max = glm::min(a.max, b.max);
+        return result;
+    }
+
+    // Bounds of the box after an affine transform (Arvo's method)
+    [[nodiscard]] AABB Transformed(const glm::mat4& transform) const
+    {
+        AABB result;
+        result.min = result.max = glm::vec3(transform[3]);
+        for (int column = 0; column < 3; column++)
+        {
+            for (int row = 0; row < 3; row++)
+            {
+                float a = transform[column][row] * min[column];
+                float b = transform[column][row] * max[column];
+                result.min[row] += glm::min(a, b);
+                result.max[row] += glm::max(a, b);
+            }
+        }
+        return result;
+    }
+};
+
+struct Ray
+{
+    Ray() = default;
+    Ray(const glm::vec3& origin, const glm::vec3& direction, float tMax = RAY_T_MAX)
+        : origin(origin), direction(direction), invDirection(1.0f / direction), tMax(tMax) {}
+
+    glm::vec3 origin{ 0.0f };
+    glm::vec3 direction{ 0.0f, 0.0f, 1.0f };
+    glm::vec3 invDirection{ std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(), 1.0f };
+    float tMax = RAY_T_MAX;
+};
+
+struct Hit
+{
+    float t = RAY_T_MAX;
+    glm::vec2 barycentrics{ 0.0f }; // weights of v1 and v2, same convention as DXR
+    uint32_t instanceIndex = ~0u;
+    uint32_t primitiveIndex = ~0u;
+
+    [[nodiscard]] bool IsValid() const { return instanceIndex != ~0u; }
+};
+
+// CPU-side copy of a mesh's geometry, kept around for the CPU ray tracing tools
+struct CPUGeometry
+{
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+
+    [[nodiscard]] uint32_t GetTriangleCount() const { return static_cast<uint32_t>(indices.size() / 3); }
+};
+
+// World-space placement of a CPUGeometry, the CPU equivalent of a TLAS instance
+struct CPUInstance
+{
+    const CPUGeometry* geometry = nullptr;
+    glm::mat4 transform{ 1.0f };
+    std::string name;
+};
+
+// Slab test, returns the entry distance or RAY_T_MAX on a miss
+inline float IntersectAABB(const Ray& ray, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+    glm::vec3 t0 = (boundsMin - ray.origin) * ray.invDirection;
+    glm::vec3 t1 = (boundsMax - ray.origin) * ray.invDirection;
+    glm::vec3 tSmall = glm::min(t0, t1);
+    glm::vec3 tLarge = glm::max(t0, t1);
+    float tEnter = glm::max(glm::max(tSmall.x, tSmall.y), glm::max(tSmall.z, 0.0f));
+    float tExit = glm::min(glm::min(tLarge.x, tLarge.y), glm::min(tLarge.z, ray.tMax));
+    return tEnter <= tExit ? tEnter : RAY_T_MAX;
+}
+
+// Moller-Trumbore, two-sided to match D3D12_RAYTRACING_INSTANCE_FLAG_NONE with opaque geometry
+inline bool IntersectTriangle(const Ray& ray, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2,
+                              float& t, glm::vec2& barycentrics)
+{
+    constexpr float epsilon = 1e-9f;
+    glm::vec3 edge1 = v1 - v0;
+    glm::vec3 edge2 = v2 - v0;
+    glm::vec3 p = glm::cross(ray.direction, edge2);
+    float det = glm::dot(edge1, p);
+    if (glm::abs(det) < epsilon) return false;
+
+    float invDet = 1.0f / det;
+    glm::vec3 s = ray.origin - v0;
+    float u = glm::dot(s, p) * invDet;
+    if (u < 0.0f || u > 1.0f) return false;
+
+    glm::vec3 q = glm::cross(s, edge1);
+    float v = glm::dot(ray.direction, q) * invDet;
+    if (v < 0.0f || u + v > 1.0f) return false;
+
+    float hitT = glm::dot(edge2, q) * invDet;
+    if (hitT <= 0.0f || hitT >= ray.tMax) return false;
+
+    t = hitT;
+    barycentrics = glm::vec2(u, v);
+    return true;
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+// Minimal image writers for rendered output, pixels are stored row by row from the top left like the
+// accumulation buffer
+namespace ImageIO
+{
+    // The format follows the extension:
+    // .hdr Radiance RGBE and .pfm 32-bit float keep the full range,
+    // .bmp and .ppm are 8-bit, values are clamped to [0, 1] and written as they would go to the swap chain
+    bool Write(const std::string& path, uint32_t width, uint32_t height, const std::vector<glm::vec3>& pixels);
+    // Reads back .pfm images only, which are lossless for cached float results
+    bool Read(const std::string& path, uint32_t& width, uint32_t& height, std::vector<glm::vec3>& pixels);
+
+    [[nodiscard]] bool IsSupported(const std::string& path);
+    [[nodiscard]] bool IsHDR(const std::string& path);
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "BVH.h"
+#include "CompressedBVH.h"
+
+// Bottom level hierarchy over the triangles of a single CPUGeometry, the CPU equivalent of a BLAS
+class MeshBVH
+{
+public:
+    void Build(const CPUGeometry& geometry, const BVHBuildSettings& settings = {});
+    // Takes deformed vertex positions with unchanged topology, returns true if the hierarchy was rebuilt
+    bool Update(const CPUGeometry& geometry, BVHUpdateMode mode);
+
+    // Object space closest hit, returns true and shrinks ray.tMax if a closer triangle was found
+    bool Intersect(Ray& ray, Hit& hit, TraversalStats* stats = nullptr) const;
+
+    [[nodiscard]] const BVH& GetBVH() const { return m_bvh; }
+    [[nodiscard]] const CompressedBVH& GetCompressedBVH() const { return m_compressed; }
+    [[nodiscard]] bool IsCompressed() const { return !m_compressed.IsEmpty(); }
+    // Bytes used by the hierarchy traversed in Intersect
+    [[nodiscard]] size_t GetMemoryFootprint() const { return IsCompressed() ? m_compressed.GetMemoryFootprint() : m_bvh.GetMemoryFootprint(); }
+    [[nodiscard]] uint32_t GetTriangleCount() const { return static_cast<uint32_t>(m_vertices.size() / 3); }
+    [[nodiscard]] const glm::vec3* GetTriangle(uint32_t primitiveIndex) const { return &m_vertices[primitiveIndex * 3]; }
+
+private:
+    std::vector<AABB> GatherTriangles(const CPUGeometry& geometry);
+
+    BVH m_bvh;
+    CompressedBVH m_compressed; // built from m_bvh when BVHBuildSettings::compressed is set, m_bvh is kept for refits
+    std::vector<glm::vec3> m_vertices; // three per triangle, de-indexed for cache friendly intersection
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Caps the threads ParallelFor uses by default, for processes that share the machine with other workers. 0 means no cap
+inline std::atomic<uint32_t> g_workerCountLimit = 0;
+
+[[nodiscard]] inline uint32_t GetWorkerCount()
+{
+    const uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    const uint32_t limit = g_workerCountLimit.load();
+    return limit > 0 ? std::min(limit, hardwareThreads) : hardwareThreads;
+}
+
+// Runs fn(index, workerIndex) for every index in [0, count), items are handed out dynamically
+template<typename Fn>
+void ParallelFor(uint32_t count, Fn&& fn, uint32_t workerCount = GetWorkerCount())
+{
+    workerCount = std::min(workerCount, count);
+    if (workerCount <= 1)
+    {
+        for (uint32_t i = 0; i < count; i++) fn(i, 0u);
+        return;
+    }
+
+    std::atomic<uint32_t> next = 0;
+    auto worker = [&](uint32_t workerIndex)
+    {
+        for (uint32_t i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+        {
+            fn(i, workerIndex);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workerCount - 1);
+    for (uint32_t w = 1; w < workerCount; w++)
+    {
+        threads.emplace_back(worker, w);
+    }
+    worker(0);
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
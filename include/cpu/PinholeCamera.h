@@ -0,0 +1,13 @@
+#pragma once
+#include "Geometry.h"
+#include "Camera.h"
+
+// Same projection as Camera::PinholeCamera in camera.slang, uv is in [0, 1] with y pointing down
+inline Ray GeneratePrimaryRay(const Camera& camera, glm::vec2 uv, float aspectRatio)
+{
+    glm::vec2 ndc = uv * 2.0f - 1.0f;
+    float tanHalfFov = glm::tan(glm::radians(camera.m_fov) * 0.5f);
+    glm::vec3 dir = glm::normalize(glm::vec3(ndc.x * aspectRatio * tanHalfFov, -ndc.y * tanHalfFov, 1.0f));
+    glm::vec3 worldDir = dir.x * camera.GetRight() + dir.y * camera.GetUp() + dir.z * camera.GetForward();
+    return Ray(camera.GetPosition(), glm::normalize(worldDir));
+}
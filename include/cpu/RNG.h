@@ -0,0 +1,166 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+
+// CPU port of shaders/random/xxhash32.slang, shaders/random/sobol.slang and shaders/rng.slang, produces the
+// same sequence as the GPU
+// Spec: https://github.com/Cyan4973/xxHash/blob/f9155bd4c57e/doc/xxhash_spec.md
+namespace xxHash32
+{
+    constexpr uint32_t PRIME1 = 2654435761u;
+    constexpr uint32_t PRIME2 = 2246822519u;
+    constexpr uint32_t PRIME3 = 3266489917u;
+    constexpr uint32_t PRIME4 = 668265263u;
+    constexpr uint32_t PRIME5 = 374761393u;
+
+    constexpr uint32_t Rol(uint32_t v, uint32_t r) { return (v << r) | (v >> (32u - r)); }
+
+    constexpr uint32_t ConsumeUint(uint32_t h, uint32_t val)
+    {
+        h += val * PRIME3;
+        return Rol(h, 17) * PRIME4;
+    }
+
+    constexpr uint32_t Avalanche(uint32_t h)
+    {
+        h ^= h >> 15; h *= PRIME2;
+        h ^= h >> 13; h *= PRIME3;
+        h ^= h >> 16;
+        return h;
+    }
+
+    constexpr uint32_t Hash(uint32_t p, uint32_t seed = 0)
+    {
+        uint32_t h = seed + PRIME5 + 4u;
+        h = ConsumeUint(h, p);
+        return Avalanche(h);
+    }
+
+    constexpr uint32_t Hash(glm::uvec2 p, uint32_t seed = 0)
+    {
+        uint32_t h = seed + PRIME5 + 8u;
+        h = ConsumeUint(h, p.x);
+        h = ConsumeUint(h, p.y);
+        return Avalanche(h);
+    }
+
+    constexpr uint32_t Hash(uint32_t x, uint32_t y, uint32_t z, uint32_t seed = 0)
+    {
+        uint32_t h = seed + PRIME5 + 12u;
+        h = ConsumeUint(h, x);
+        h = ConsumeUint(h, y);
+        h = ConsumeUint(h, z);
+        return Avalanche(h);
+    }
+}
+
+// Owen-scrambled Sobol (0,2)-sequence, after Burley 2020, "Practical Hash-based Owen Scrambling"
+// https://jcgt.org/published/0009/04/01/
+namespace Sobol
+{
+    constexpr uint32_t ReverseBits(uint32_t x)
+    {
+        x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+        x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+        x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+        x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+        return (x >> 16) | (x << 16);
+    }
+
+    constexpr uint32_t LaineKarras(uint32_t x, uint32_t seed)
+    {
+        x += seed;
+        x ^= x * 0x6c50b47cu;
+        x ^= x * 0xb82f1e52u;
+        x ^= x * 0xc7afe638u;
+        x ^= x * 0x8d22f6e6u;
+        return x;
+    }
+
+    constexpr uint32_t NestedUniformScramble(uint32_t x, uint32_t seed)
+    {
+        return ReverseBits(LaineKarras(ReverseBits(x), seed));
+    }
+
+    constexpr uint32_t Dimension0(uint32_t index) { return ReverseBits(index); }
+
+    constexpr uint32_t Dimension1(uint32_t index)
+    {
+        uint32_t result = 0;
+        for (uint32_t v = 1u << 31; index != 0; index >>= 1, v ^= v >> 1)
+        {
+            if (index & 1) result ^= v;
+        }
+        return result;
+    }
+
+    constexpr float ToFloat(uint32_t x) { return static_cast<float>(x >> 8) * 0x1p-24f; }
+}
+
+struct RNG
+{
+    // Same as SampleSequence in shaders/rng.slang
+    enum class Sequence : uint32_t
+    {
+        Random,
+        Sobol,
+    };
+
+    uint32_t pixel = 0;
+    uint32_t sample = 0;
+    uint32_t dimension = 0;
+    Sequence sequence = Sequence::Random;
+
+    [[nodiscard]] static RNG Create(glm::uvec2 pixelCoord, uint32_t screenWidth, uint32_t sampleIndex, Sequence sequence = Sequence::Random)
+    {
+        return { pixelCoord.y * screenWidth + pixelCoord.x, sampleIndex, 0, sequence };
+    }
+
+    [[nodiscard]] static RNG Create(uint32_t pixelIndex, uint32_t sampleIndex, Sequence sequence = Sequence::Random)
+    {
+        return { pixelIndex, sampleIndex, 0, sequence };
+    }
+
+    // "random" or "sobol"
+    static bool ParseSequence(const std::string& name, Sequence& sequence)
+    {
+        if (name == "random") sequence = Sequence::Random;
+        else if (name == "sobol") sequence = Sequence::Sobol;
+        else return false;
+        return true;
+    }
+
+    [[nodiscard]] static const char* GetSequenceName(Sequence sequence)
+    {
+        return sequence == Sequence::Sobol ? "sobol" : "random";
+    }
+
+    uint32_t NextUint() { return xxHash32::Hash(pixel, sample, dimension++); }
+
+    float NextFloat()
+    {
+        if (sequence == Sequence::Sobol)
+        {
+            const uint32_t seed = xxHash32::Hash(glm::uvec2(pixel, dimension++));
+            const uint32_t index = Sobol::NestedUniformScramble(sample, seed);
+            return Sobol::ToFloat(Sobol::NestedUniformScramble(Sobol::Dimension0(index), xxHash32::Hash(seed, 1)));
+        }
+        return static_cast<float>(NextUint()) * 0x1p-32f;
+    }
+
+    glm::vec2 NextFloat2()
+    {
+        if (sequence == Sequence::Sobol)
+        {
+            const uint32_t seed = xxHash32::Hash(glm::uvec2(pixel, dimension));
+            dimension += 2;
+            const uint32_t index = Sobol::NestedUniformScramble(sample, seed);
+            return { Sobol::ToFloat(Sobol::NestedUniformScramble(Sobol::Dimension0(index), xxHash32::Hash(seed, 1))),
+                     Sobol::ToFloat(Sobol::NestedUniformScramble(Sobol::Dimension1(index), xxHash32::Hash(seed, 2))) };
+        }
+        float x = NextFloat();
+        return { x, NextFloat() };
+    }
+};
@@ -0,0 +1,24 @@
+#pragma once
+#include "Geometry.h"
+
+#include <vector>
+
+// Orders a batch of rays so that rays starting in the same region of the scene and heading into the same
+// direction octant are traced back to back, which keeps the nodes and triangles they visit in cache
+class RaySorter
+{
+public:
+    static constexpr uint32_t CELL_BITS = 9; // per axis, 512^3 origin cells over the scene bounds
+    static constexpr uint32_t KEY_BITS = 3 * CELL_BITS + 3;
+
+    // Morton code of the origin cell in the high bits, direction octant in the low 3 bits. Origin first
+    // keeps each region of the scene in one contiguous run instead of revisiting it once per octant
+    [[nodiscard]] static uint32_t ComputeKey(const glm::vec3& origin, const glm::vec3& direction, const AABB& bounds);
+
+    // Stable LSD radix sort, order receives the indices of keys in ascending key order
+    void Sort(const std::vector<uint32_t>& keys, std::vector<uint32_t>& order);
+
+private:
+    std::vector<uint32_t> m_keys[2];
+    std::vector<uint32_t> m_values[2];
+};
@@ -0,0 +1,66 @@
+#pragma once
+#include <glm/glm.hpp>
+
+// CPU port of the parts of shaders/random/sampling.slang used by the CPU tools
+namespace Sampling
+{
+    constexpr float PI = 3.14159265358979323846f;
+    constexpr float TWO_PI = 6.28318530717958647692f;
+    constexpr float INV_PI = 0.31830988618379067154f;
+
+    inline glm::vec2 SampleDisk(glm::vec2 rand)
+    {
+        glm::vec2 offset = 2.0f * rand - 1.0f;
+        if (offset.x == 0.0f && offset.y == 0.0f)
+            return glm::vec2(0.0f);
+
+        float theta, r;
+        if (glm::abs(offset.x) > glm::abs(offset.y))
+        {
+            r = offset.x;
+            theta = (PI / 4.0f) * (offset.y / offset.x);
+        }
+        else
+        {
+            r = offset.y;
+            theta = (PI / 2.0f) - (PI / 4.0f) * (offset.x / offset.y);
+        }
+        return r * glm::vec2(glm::cos(theta), glm::sin(theta));
+    }
+
+    inline glm::vec3 SampleCosineHemisphere(glm::vec2 rand)
+    {
+        glm::vec2 d = SampleDisk(rand);
+        float z = glm::sqrt(glm::max(0.0f, 1.0f - d.x * d.x - d.y * d.y));
+        return glm::vec3(d.x, d.y, z);
+    }
+
+    inline glm::vec3 SampleUniformSphere(glm::vec2 rand)
+    {
+        float z = 1.0f - 2.0f * rand.x;
+        float r = glm::sqrt(glm::max(0.0f, 1.0f - z * z));
+        float phi = TWO_PI * rand.y;
+        return glm::vec3(r * glm::cos(phi), r * glm::sin(phi), z);
+    }
+
+    inline void BuildTBN(const glm::vec3& n, glm::vec3& t, glm::vec3& b)
+    {
+        if (n.z < -0.9999999f)
+        {
+            t = glm::vec3(0.0f, -1.0f, 0.0f);
+            b = glm::vec3(-1.0f, 0.0f, 0.0f);
+            return;
+        }
+        float a = 1.0f / (1.0f + n.z);
+        float d = -n.x * n.y * a;
+        t = glm::vec3(1.0f - n.x * n.x * a, d, -n.x);
+        b = glm::vec3(d, 1.0f - n.y * n.y * a, -n.y);
+    }
+
+    inline glm::vec3 TangentToWorld(const glm::vec3& localDir, const glm::vec3& n)
+    {
+        glm::vec3 t, b;
+        BuildTBN(n, t, b);
+        return t * localDir.x + b * localDir.y + n * localDir.z;
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "MeshBVH.h"
+
+struct BVHInstance
+{
+    uint32_t meshIndex = 0;
+    glm::mat4 transform{ 1.0f };
+    glm::mat4 inverseTransform{ 1.0f };
+    AABB worldBounds;
+};
+
+// Two level hierarchy mirroring the TLAS/BLAS split on the GPU: one MeshBVH per unique geometry,
+// and a top level BVH over the world-space bounds of the instances
+class SceneBVH
+{
+public:
+    void Build(const std::vector<CPUInstance>& instances, const BVHBuildSettings& settings = {});
+
+    // Transform and geometry changes only touch the affected bounds, UpdateTopLevel brings the
+    // top level up to date afterwards, like TLAS::Update does on the GPU
+    void SetInstanceTransform(uint32_t instanceIndex, const glm::mat4& transform);
+    bool UpdateMesh(uint32_t meshIndex, const CPUGeometry& geometry, BVHUpdateMode mode = BVHUpdateMode::Auto);
+    bool UpdateTopLevel(BVHUpdateMode mode = BVHUpdateMode::Auto);
+
+    // World space closest hit, hit.instanceIndex refers to the order of the instances passed to Build
+    bool Intersect(Ray& ray, Hit& hit, TraversalStats* topStats = nullptr, TraversalStats* bottomStats = nullptr) const;
+
+    [[nodiscard]] static Ray ToObjectSpace(const Ray& ray, const BVHInstance& instance);
+
+    [[nodiscard]] const BVH& GetTopLevel() const { return m_topLevel; }
+    [[nodiscard]] const std::vector<MeshBVH>& GetMeshes() const { return m_meshes; }
+    [[nodiscard]] const std::vector<BVHInstance>& GetInstances() const { return m_instances; }
+    [[nodiscard]] bool IsTopLevelDirty() const { return m_topLevelDirty; }
+
+private:
+    BVH m_topLevel;
+    std::vector<MeshBVH> m_meshes;
+    std::vector<BVHInstance> m_instances;
+    std::vector<AABB> m_instanceBounds;
+    bool m_topLevelDirty = false;
+};
@@ -0,0 +1,167 @@
+#pragma once
+#include "RNG.h"
+#include "Sampling.h"
+
+#include <bit>
+#include <cmath>
+
+// CPU port of shaders/pbr.slang and the helpers.slang functions used by the CPU path tracer,
+// kept line for line with the shaders so both consume the RNG in the same order
+namespace Shading
+{
+    inline float Sanitize(float x)
+    {
+        return std::isnan(x) || std::isinf(x) ? 0.0f : x;
+    }
+
+    inline glm::vec3 Sanitize(const glm::vec3& v) { return { Sanitize(v.x), Sanitize(v.y), Sanitize(v.z) }; }
+
+    template<typename T>
+    T SampleTriangle(const T& x0, const T& x1, const T& x2, glm::vec2 bary)
+    {
+        float w = 1.0f - bary.x - bary.y;
+        return x0 * w + x1 * bary.x + x2 * bary.y;
+    }
+
+    inline glm::vec3 OffsetRay(const glm::vec3& p, const glm::vec3& n)
+    {
+        constexpr float origin = 1.0f / 32.0f;
+        constexpr float floatScale = 1.0f / 65536.0f;
+        constexpr float intScale = 256.0f;
+
+        glm::vec3 result;
+        for (int i = 0; i < 3; i++)
+        {
+            int32_t offset = static_cast<int32_t>(intScale * n[i]);
+            float pi = std::bit_cast<float>(std::bit_cast<int32_t>(p[i]) + (p[i] < 0.0f ? -offset : offset));
+            result[i] = std::abs(p[i]) < origin ? p[i] + floatScale * n[i] : pi;
+        }
+        return result;
+    }
+
+    inline glm::vec2 DirectionToEquirectangular(const glm::vec3& dir)
+    {
+        float u = std::atan2(dir.z, dir.x) / Sampling::TWO_PI + 0.5f;
+        float v = 1.0f - (std::asin(glm::clamp(dir.y, -1.0f, 1.0f)) / Sampling::PI + 0.5f);
+        return { u, v };
+    }
+
+    // from "Efficient Construction of Perpendicular Vectors Without Branching"
+    inline glm::vec3 GetPerpendicularVector(const glm::vec3& u)
+    {
+        glm::vec3 a = glm::abs(u);
+        uint32_t xm = ((a.x - a.y) < 0 && (a.x - a.z) < 0) ? 1 : 0;
+        uint32_t ym = (a.y - a.z) < 0 ? (1 ^ xm) : 0;
+        uint32_t zm = 1 ^ (xm | ym);
+        return glm::normalize(glm::cross(u, glm::vec3(xm, ym, zm)));
+    }
+
+    inline float GGXSmithG(float NdotX, float roughness)
+    {
+        float a2 = roughness * roughness;
+        float denom = NdotX + std::sqrt(a2 + (1.0f - a2) * NdotX * NdotX);
+        return 2.0f * NdotX / denom;
+    }
+
+    inline glm::vec3 Fresnel(const glm::vec3& f0, float LdotH)
+    {
+        return f0 + (glm::vec3(1.0f) - f0) * std::pow(1.0f - LdotH, 5.0f);
+    }
+
+    // From "Sampling the GGX Distribution of Visible Normals" - Heitz 2018
+    inline glm::vec3 SampleGGXVNDF(const glm::vec3& Ve, float alpha, glm::vec2 rand)
+    {
+        glm::vec3 Vh = glm::normalize(glm::vec3(alpha * Ve.x, alpha * Ve.y, Ve.z));
+
+        float lensq = Vh.x * Vh.x + Vh.y * Vh.y;
+        glm::vec3 T1 = lensq > 0 ? glm::vec3(-Vh.y, Vh.x, 0.0f) / std::sqrt(lensq) : glm::vec3(1.0f, 0.0f, 0.0f);
+        glm::vec3 T2 = glm::cross(Vh, T1);
+
+        float r = std::sqrt(rand.x);
+        float phi = Sampling::TWO_PI * rand.y;
+        float t1 = r * std::cos(phi);
+        float t2 = r * std::sin(phi);
+        float s = 0.5f * (1.0f + Vh.z);
+        t2 = (1.0f - s) * std::sqrt(1.0f - t1 * t1) + s * t2;
+
+        glm::vec3 Nh = t1 * T1 + t2 * T2 + std::sqrt(std::max(0.0f, 1.0f - t1 * t1 - t2 * t2)) * Vh;
+
+        return glm::normalize(glm::vec3(alpha * Nh.x, alpha * Nh.y, std::max(0.0f, Nh.z)));
+    }
+
+    inline glm::vec3 GetGGXMicrofacet(RNG& rng, float roughness, const glm::vec3& n, const glm::vec3& v)
+    {
+        glm::vec2 rand = rng.NextFloat2();
+
+        glm::vec3 B = GetPerpendicularVector(n);
+        glm::vec3 T = glm::cross(B, n);
+
+        glm::vec3 Ve(glm::dot(v, T), glm::dot(v, B), glm::dot(n, v));
+        glm::vec3 hLocal = SampleGGXVNDF(Ve, roughness, rand);
+
+        return T * hLocal.x + B * hLocal.y + n * hLocal.z;
+    }
+
+    inline glm::vec3 PBRIndirect(RNG& rng, const glm::vec3& n, const glm::vec3& g, const glm::vec3& v,
+                                 const glm::vec3& albedo, float roughness, float metallic, glm::vec3& l)
+    {
+        glm::vec3 F0 = glm::mix(glm::vec3(0.04f), albedo, metallic);
+        glm::vec3 diffuseColor = (1.0f - metallic) * albedo;
+
+        glm::vec3 h = GetGGXMicrofacet(rng, roughness, n, v);
+        float VdotH = glm::dot(v, h);
+        if (VdotH < 0.0f)
+        {
+            l = glm::vec3(0.0f);
+            return glm::vec3(0.0f);
+        }
+
+        glm::vec3 F = Fresnel(F0, VdotH);
+
+        float specularChance = (F.r + F.g + F.b) / 3.0f;
+
+        if (rng.NextFloat() < specularChance)
+        {
+            glm::vec2 rand = rng.NextFloat2();
+
+            glm::vec3 B = GetPerpendicularVector(n);
+            glm::vec3 T = glm::cross(B, n);
+
+            glm::vec3 Ve(glm::dot(v, T), glm::dot(v, B), glm::dot(n, v));
+            glm::vec3 hLocal = SampleGGXVNDF(Ve, roughness, rand);
+
+            h = T * hLocal.x + B * hLocal.y + n * hLocal.z;
+            l = glm::reflect(-v, h);
+
+            if (glm::dot(l, g) < 0.0f)
+            {
+                l = glm::reflect(l, g);
+            }
+
+            float NdotL = glm::clamp(glm::dot(n, l), 0.0f, 1.0f);
+            if (NdotL <= 0.0f)
+                return glm::vec3(0.0f);
+
+            if (glm::dot(g, n) * glm::dot(g, l) < 0.0f)
+                return glm::vec3(0.0f);
+
+            float G1_l = GGXSmithG(NdotL, roughness);
+
+            glm::vec3 singleScatter = F * G1_l;
+
+            return glm::clamp(singleScatter / specularChance, 0.0f, 1.0f);
+        }
+
+        // Diffuse
+        l = Sampling::TangentToWorld(Sampling::SampleCosineHemisphere(rng.NextFloat2()), n);
+
+        if (glm::dot(l, g) < 0.0f)
+            l = glm::reflect(l, g);
+
+        if (glm::dot(g, n) * glm::dot(g, l) < 0.0f)
+            return glm::vec3(0.0f);
+
+        glm::vec3 transmitted = (1.0f - F) * diffuseColor;
+        return glm::clamp(transmitted / (1.0f - specularChance), 0.0f, 1.0f);
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+// CPU port of shaders/tonemapping.slang and the operators in shaders/tonemapping/, for output that
+// never goes through the tonemapping pass. Apply on a single color follows the shaders line by line, the
+// image functions run a vectorized version of the same operators on every worker thread
+namespace Tonemapping
+{
+    // Same order as TonemapOperator
+    enum class Operator : uint32_t
+    {
+        Linear,
+        Aces,
+        Reinhard,
+        AgX,
+        GT7,
+    };
+
+    [[nodiscard]] glm::vec3 Apply(glm::vec3 color, Operator op, float exposure);
+    // Tonemaps every pixel of a linear image, alpha is kept
+    [[nodiscard]] std::vector<glm::vec4> Apply(const std::vector<glm::vec4>& image, Operator op, float exposure);
+
+    // Averages an accumulation of RGB sums with the per-pixel sample count in alpha and tonemaps it, like
+    // tonemapping_pass.slang with debugMode None
+    [[nodiscard]] std::vector<glm::vec3> Resolve(const std::vector<glm::vec4>& accumulation, Operator op, float exposure);
+    // Averages without tonemapping
+    [[nodiscard]] std::vector<glm::vec3> ResolveLinear(const std::vector<glm::vec4>& accumulation);
+
+    // Case insensitive operator name ("agx", "aces", ...)
+    [[nodiscard]] bool ParseOperator(const std::string& name, Operator& op);
+    [[nodiscard]] const char* GetOperatorName(Operator op);
+
+    // An operator and exposure baked over log2 encoded RGB, sampled trilinearly by tonemapping_pass.slang instead of
+    // evaluating the operator per pixel. Texels sit on the grid points, so texture coordinates need the half texel
+    // offset; Sample does the same on the CPU
+    struct Lut
+    {
+        static constexpr uint32_t DEFAULT_SIZE = 65;
+        // Range of log2(color * exposure) the LUT covers, everything below is black after any operator
+        static constexpr float MIN_EV = -12.47393f;
+        static constexpr float MAX_EV = 8.0f;
+
+        uint32_t size = 0;
+        float scale = 0.0f; // encoded = saturate(log2(color) * scale + offset)
+        float offset = 0.0f;
+        std::vector<glm::vec4> texels; // red varies fastest, then green, then blue
+
+        [[nodiscard]] glm::vec3 Encode(const glm::vec3& color) const;
+        [[nodiscard]] glm::vec3 Sample(const glm::vec3& color) const;
+    };
+
+    [[nodiscard]] Lut BakeLut(Operator op, float exposure, uint32_t size = Lut::DEFAULT_SIZE);
+    // Largest channel difference between the LUT and Apply over sampleCount HDR colors, after clamping to [0, 1]
+    [[nodiscard]] float GetLutError(const Lut& lut, Operator op, float exposure, uint32_t sampleCount = 1 << 16);
+
+    struct BenchmarkResult
+    {
+        Operator op = Operator::Linear;
+        double scalarMegapixelsPerSecond = 0.0; // Apply per color, one thread
+        double vectorMegapixelsPerSecond = 0.0; // image path, one thread
+        double threadedMegapixelsPerSecond = 0.0; // image path, every worker
+        float maxError = 0.0f; // largest channel difference between the two paths
+        double lutBakeMs = 0.0;
+        float lutMaxError = 0.0f; // GetLutError of a LUT at the default size
+    };
+
+    // Tonemaps a synthetic HDR image with every operator, repetitions times per path
+    [[nodiscard]] std::vector<BenchmarkResult> RunBenchmark(uint32_t width, uint32_t height, uint32_t repetitions);
+    void PrintBenchmark(std::ostream& out, const std::vector<BenchmarkResult>& results);
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// A resource whose contents only matter between two passes, the passes are positions in execution order
+struct TransientResource
+{
+    uint64_t size = 0;
+    uint64_t alignment = 1; // power of two
+    uint32_t firstPass = 0;
+    uint32_t lastPass = 0;
+    uint32_t heapType = 0; // resources only share memory with resources of the same heap type
+};
+
+struct AliasingPlan
+{
+    std::vector<uint64_t> offsets; // per resource, into the heap of its heap type
+    std::vector<uint64_t> heapSizes; // per heap type
+    uint64_t size = 0; // all heaps together
+    uint64_t naiveSize = 0; // every resource in its own allocation
+    uint64_t peakLiveSize = 0; // most memory live during one pass, no placement needs less than this
+};
+
+// Packs resources whose lifetimes don't overlap into the same memory, one heap per heap type. Resources are placed
+// largest first at the lowest offset that doesn't collide with a placed resource that's live at the same time, so
+// the heaps usually end up close to the peak live size. Doesn't touch a device, placing the resources in the heaps
+// and the aliasing barriers between them are up to the backend
+[[nodiscard]] AliasingPlan PlanAliasing(std::span<const TransientResource> resources);
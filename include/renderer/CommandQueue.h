@@ -20,6 +20,8 @@ public:
     bool IsFenceComplete(uint64_t fenceValue) const;
     void WaitForFenceValue(uint64_t fenceValue) const;
     void Flush();
+    // Keeps an object alive until the GPU finished the work submitted so far, so it can be replaced without a flush
+    void Retire(Microsoft::WRL::ComPtr<ID3D12Object> object);
 
     Microsoft::WRL::ComPtr<ID3D12CommandQueue> GetQueue() const;
 
@@ -35,6 +37,12 @@ private:
         Microsoft::WRL::ComPtr<ID3D12CommandAllocator> commandAllocator;
     };
 
+    struct RetiredObject
+    {
+        uint64_t fenceValue;
+        Microsoft::WRL::ComPtr<ID3D12Object> object;
+    };
+
     using CommandAllocatorQueue = std::queue<CommandAllocatorEntry>;
     using CommandListQueue = std::queue<Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList4>>;
 
@@ -47,5 +55,6 @@ private:
 
     CommandAllocatorQueue m_CommandAllocatorQueue;
     CommandListQueue m_CommandListQueue;
+    std::queue<RetiredObject> m_RetiredObjects;
 	std::string m_name;
 };
\ No newline at end of file
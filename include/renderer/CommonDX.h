@@ -9,6 +9,7 @@ class GPUAllocator;
 class CommandQueue;
 class DescriptorHeap;
 class UploadContext;
+class RenderBackend;
 struct ID3D12Device10;
 
 inline constexpr uint8_t NUM_FRAMES_IN_FLIGHT = 3;
@@ -46,4 +47,5 @@ struct RenderContext
     CommandQueue* commandQueue = nullptr;
     DescriptorHeap* descriptorHeap = nullptr;
     UploadContext* uploadContext = nullptr;
+    RenderBackend* backend = nullptr; // the same device behind the portable interface, see RenderBackend
 };
\ No newline at end of file
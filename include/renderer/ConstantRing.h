@@ -0,0 +1,52 @@
+#pragma once
+#include "RenderBackend.h"
+
+#include <string>
+#include <vector>
+
+// Constants written by the CPU every frame, packed into one persistently mapped upload buffer. Each frame in flight
+// owns a slice that's allocated linearly and started over when the frame comes around again, so a frame can push
+// any number of constant blocks without creating or mapping buffers. A frame that doesn't fit its slice moves the
+// ring to a buffer with larger slices, the old buffer is kept until the next BeginFrame
+class ConstantRing
+{
+public:
+    static constexpr uint64_t DEFAULT_FRAME_CAPACITY = 64 * 1024;
+    static constexpr uint64_t ALIGNMENT = 256; // D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT
+
+    ConstantRing(RenderBackend& backend, const char* name, uint32_t frameCount, uint64_t frameCapacity = DEFAULT_FRAME_CAPACITY);
+
+    // Starts the frame's slice over, the GPU has to be done with what was pushed into it the last time. The work
+    // that used the previous frame's constants has to be submitted by now, buffers the ring grew out of are
+    // released here
+    void BeginFrame(uint32_t frameIndex);
+
+    // Copies the data into the current frame's slice, the GPU address stays valid until the slice is started over
+    [[nodiscard]] uint64_t Push(const void* data, uint64_t size);
+    template<typename T>
+    [[nodiscard]] uint64_t Push(const T& data) { return Push(&data, sizeof(T)); }
+
+    [[nodiscard]] uint64_t GetFrameCapacity() const { return m_frameCapacity; }
+    // Bytes pushed this frame, including the padding to the constant buffer alignment
+    [[nodiscard]] uint64_t GetUsed() const { return m_used; }
+    [[nodiscard]] uint64_t GetPeakUsed() const { return m_peakUsed; }
+    [[nodiscard]] uint32_t GetGrowCount() const { return m_growCount; }
+
+private:
+    // Moves to a buffer whose slices fit at least required bytes, the current frame continues at its start
+    void Grow(uint64_t required);
+
+    RenderBackend& m_backend;
+    std::string m_name;
+    BackendResource m_buffer;
+    std::vector<BackendResource> m_retiredBuffers; // may still be read by the current frame
+    uint8_t* m_mapped = nullptr;
+    uint64_t m_gpuAddress = 0;
+    uint32_t m_frameCount;
+    uint64_t m_frameCapacity;
+    uint32_t m_frameIndex = 0;
+    uint64_t m_offset = 0; // into the current frame's slice
+    uint64_t m_used = 0;
+    uint64_t m_peakUsed = 0;
+    uint32_t m_growCount = 0;
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include "RenderBackend.h"
+#include "GPUBuffer.h"
+#include "DescriptorHeap.h"
+#include "CommonDX.h"
+
+#include <queue>
+#include <vector>
+
+// RenderBackend on the renderer's device, allocator and queues. Uploads go through the UploadContext and fences are
+// the main queue's, so resources it creates can be used by command lists recorded on that queue
+class D3D12Backend final : public RenderBackend
+{
+public:
+    explicit D3D12Backend(const RenderContext& context);
+    ~D3D12Backend() override;
+
+    [[nodiscard]] const char* GetName() const override { return "D3D12"; }
+
+    ResourceHandle CreateBuffer(const BufferDesc& desc) override;
+    ResourceHandle CreateTexture(const TextureDesc& desc) override;
+    void Release(ResourceHandle handle) override;
+
+    [[nodiscard]] void* Map(ResourceHandle handle) override;
+    [[nodiscard]] uint64_t GetGPUAddress(ResourceHandle handle) const override;
+    [[nodiscard]] int32_t GetDescriptorIndex(ResourceHandle handle) const override;
+
+    void Upload(ResourceHandle dest, const void* data, uint64_t size) override;
+    void UploadTexture(ResourceHandle dest, const void* data) override;
+
+    // Recorded into one command list on the main queue, executed by Submit
+    ResourceHandle BuildBLAS(const BLASDesc& desc) override;
+    ResourceHandle BuildTLAS(const std::vector<ASInstance>& instances) override;
+
+    // Waits for the uploads recorded so far, then executes the acceleration structure builds and signals the main queue
+    uint64_t Submit() override;
+    [[nodiscard]] bool IsComplete(uint64_t fenceValue) const override;
+    void Wait(uint64_t fenceValue) override;
+
+    // For the D3D12 code that creates views of it or binds it
+    [[nodiscard]] ID3D12Resource* GetResource(ResourceHandle handle) const;
+    [[nodiscard]] const DescriptorHeap::Allocation& GetSRV(ResourceHandle handle) const;
+    [[nodiscard]] static DXGI_FORMAT GetFormat(ResourceFormat format);
+
+private:
+    struct Resource
+    {
+        GPUBuffer buffer;
+        void* mapped = nullptr;
+        TextureDesc texture{}; // width, height, depth and format for texture uploads
+        DescriptorHeap::Allocation srv; // textures only
+        uint64_t size = 0;
+        bool isTexture = false;
+        bool alive = false;
+    };
+
+    ResourceHandle Add(Resource resource);
+    [[nodiscard]] const Resource& Get(ResourceHandle handle) const;
+    ResourceHandle BuildAccelerationStructure(D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS inputs, const char* name);
+    ID3D12GraphicsCommandList4* GetBuildList();
+    void FreeCompleted();
+
+    RenderContext m_context;
+    std::vector<Resource> m_resources; // slot 0 stays unused
+    std::vector<uint32_t> m_freeSlots;
+    std::queue<std::pair<uint64_t, uint32_t>> m_releases; // fence value, slot
+
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList4> m_buildList; // open builds, null if nothing was recorded
+    std::vector<GPUBuffer> m_buildBuffers; // scratch and instances of the open builds
+    std::vector<uint32_t> m_buildReleases; // released while the open builds may still use them
+    std::queue<std::pair<uint64_t, GPUBuffer>> m_submittedBuildBuffers;
+};
@@ -1,42 +1,79 @@
 #pragma once
+#include "IndexAllocator.h"
+
 #include <d3d12.h>
 #include <wrl.h>
+#include <string>
+#include <utility>
 #include <vector>
 
+class CommandQueue;
+
+// Descriptor heap with ranges that can be freed in any order. A growable heap moves to a larger one when it's full,
+// so handles are resolved through the heap on use instead of being stored. Indices never change, so bindless
+// indices stay valid across growth. A heap without a queue to grow on has a fixed size, running out is an error
 class DescriptorHeap
 {
 public:
 	struct Allocation
 	{
-		D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle{};
-		D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle{};
+		DescriptorHeap* heap = nullptr;
 		UINT index = 0;
+		UINT count = 0;
+		UINT generation = 0;
+
+		// Where a view is written, marks the descriptor for the next Commit. Writes to a growable shader visible
+		// heap become visible to the GPU on Commit
+		[[nodiscard]] D3D12_CPU_DESCRIPTOR_HANDLE GetWriteHandle(UINT offset = 0) const;
+		// Only for reading, like binding render targets. Writing through it isn't committed
+		[[nodiscard]] D3D12_CPU_DESCRIPTOR_HANDLE GetCPUHandle(UINT offset = 0) const;
+		[[nodiscard]] D3D12_GPU_DESCRIPTOR_HANDLE GetGPUHandle(UINT offset = 0) const;
+		explicit operator bool() const { return count > 0; }
 	};
 
 	DescriptorHeap(ID3D12Device* device,
 		D3D12_DESCRIPTOR_HEAP_TYPE type,
 		UINT capacity,
 		bool shaderVisible,
-		const wchar_t* name);
+		const wchar_t* name,
+		CommandQueue* growQueue = nullptr); // growable, replaced heaps are retired on the queue that may still use them
 	~DescriptorHeap() = default;
 
 	Allocation Allocate(UINT count = 1);
-	void Free(const Allocation& alloc, UINT count = 1);
+	// Freeing an empty allocation does nothing
+	void Free(const Allocation& alloc);
+	// The live allocation that starts at this handle, for code that only kept the handle
+	[[nodiscard]] Allocation Find(D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle);
+
+	// Copies the descriptors written since the last commit into the shader visible heap. Call before binding the
+	// heap, a growable shader visible heap is written through a CPU only copy because descriptors can't be copied
+	// out of a shader visible heap when it grows
+	void Commit();
 
 	[[nodiscard]] ID3D12DescriptorHeap* GetHeap() const { return m_heap.Get(); }
-	[[nodiscard]] D3D12_CPU_DESCRIPTOR_HANDLE GetCPUHandle(const UINT index) const { return { m_cpuStart.ptr + index * m_incrementSize }; }
-	[[nodiscard]] D3D12_GPU_DESCRIPTOR_HANDLE GetGPUHandle(const UINT index) const { return { m_gpuStart.ptr + index * m_incrementSize }; }
-	[[nodiscard]] D3D12_CPU_DESCRIPTOR_HANDLE GetCPUStartHandle() const { return m_cpuStart; }
-	[[nodiscard]] D3D12_GPU_DESCRIPTOR_HANDLE GetGPUStartHandle() const { return m_gpuStart; }
 	[[nodiscard]] UINT GetIncrementSize() const { return m_incrementSize; }
+	[[nodiscard]] IndexAllocatorStats GetStats() const { return m_allocator.GetStats(); }
+	[[nodiscard]] UINT GetGrowCount() const { return m_growCount; }
 
 private:
+	[[nodiscard]] Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> CreateHeap(UINT capacity, bool shaderVisible, const wchar_t* name) const;
+	void Grow(UINT count);
+	[[nodiscard]] D3D12_CPU_DESCRIPTOR_HANDLE GetWriteHandle(const Allocation& alloc, UINT offset);
+	[[nodiscard]] D3D12_CPU_DESCRIPTOR_HANDLE GetCPUHandle(const Allocation& alloc, UINT offset) const;
+	[[nodiscard]] D3D12_GPU_DESCRIPTOR_HANDLE GetGPUHandle(const Allocation& alloc, UINT offset) const;
+
+	Microsoft::WRL::ComPtr<ID3D12Device> m_device;
 	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_heap;
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_cpuHeap; // only for growable shader visible heaps
 	D3D12_DESCRIPTOR_HEAP_TYPE m_type;
 	D3D12_CPU_DESCRIPTOR_HANDLE m_cpuStart{};
+	D3D12_CPU_DESCRIPTOR_HANDLE m_writeStart{}; // m_cpuHeap if there is one, else m_heap
 	D3D12_GPU_DESCRIPTOR_HANDLE m_gpuStart{};
 	UINT m_incrementSize = 0;
-	UINT m_capacity = 0;
-	UINT m_current = 0;
-	std::vector<UINT> m_freeList;
-};
\ No newline at end of file
+	bool m_shaderVisible;
+	CommandQueue* m_growQueue;
+	UINT m_growCount = 0;
+	std::wstring m_name;
+	IndexAllocator m_allocator;
+	std::vector<std::pair<UINT, UINT>> m_dirty; // index, count, written but not committed yet
+};
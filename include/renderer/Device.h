@@ -15,6 +15,9 @@ public:
 	[[nodiscard]] IDXGIAdapter4* GetAdapter() const { return m_adapter.Get(); }
 	[[nodiscard]] ID3D12Device10* GetDevice() const { return m_device.Get(); }
 
+	// True if any hardware adapter can create a feature level 12_2 device with DXR, without keeping it
+	[[nodiscard]] static bool IsRaytracingSupported();
+
 private:
 	static void EnableDebugLayer();
 	void CreateAdapter();
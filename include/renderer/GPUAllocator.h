@@ -14,6 +14,8 @@ public:
     GPUBuffer CreateTexture(uint32_t width, uint32_t height, DXGI_FORMAT format,
         D3D12_RESOURCE_STATES initialState, D3D12_RESOURCE_FLAGS flags,
         const wchar_t* name = L"Texture") const;
+    GPUBuffer CreateTexture3D(uint32_t width, uint32_t height, uint32_t depth, DXGI_FORMAT format,
+        D3D12_RESOURCE_STATES initialState, const wchar_t* name = L"Texture 3D") const;
 private:
     D3D12MA::Allocator* m_allocator;
 };
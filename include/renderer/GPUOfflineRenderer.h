@@ -0,0 +1,76 @@
+#pragma once
+#include "OfflineRenderer.h"
+#include "StructsDX.h"
+#include "CommonDX.h"
+#include "GPUBuffer.h"
+
+#include <memory>
+
+class Device;
+class CommandQueue;
+class DescriptorHeap;
+class UploadContext;
+class D3D12Backend;
+class GPUAllocator;
+class OutputBuffer;
+class ShaderCompiler;
+class RootSignature;
+class RTPipeline;
+class PostProcessPass;
+class Scene;
+class ConstantRing;
+
+// OfflineRenderer running raytracing.slang through DXR, like Renderer but without a window, swap chain,
+// ImGui or tonemapping pass. Every sample is waited on, and the accumulation is read back on request
+class GPUOfflineRenderer : public OfflineRenderer
+{
+public:
+	explicit GPUOfflineRenderer(bool debug);
+	~GPUOfflineRenderer() override;
+
+	bool LoadModel(const std::string& path) override;
+	bool LoadHDRI(const std::string& path) override;
+	void Reset(uint32_t width, uint32_t height, uint32_t firstSample) override;
+	// raytracing.slang derives the RNG seed and camera ray from the dispatch size, so regions aren't supported
+	bool SetRegion(uint32_t x, uint32_t y, uint32_t width, uint32_t height) override;
+	void RenderSample(const Camera& camera, const CPURenderSettings& settings) override;
+
+	[[nodiscard]] std::vector<glm::vec4> ReadAccumulation() override;
+	[[nodiscard]] FeatureBuffers ReadFeatures() override;
+	[[nodiscard]] uint32_t GetSampleCount() const override { return m_renderData.frame; }
+	[[nodiscard]] std::string GetName() const override;
+	[[nodiscard]] OfflineBackend GetBackend() const override { return OfflineBackend::GPU; }
+
+private:
+	// Copies an output buffer of T sized texels back to the CPU
+	template<typename T>
+	[[nodiscard]] std::vector<T> ReadBuffer(OutputBuffer& buffer);
+
+	std::unique_ptr<Device> m_device;
+	RenderContext m_context;
+	std::unique_ptr<GPUAllocator> m_allocator;
+	std::unique_ptr<CommandQueue> m_commandQueue;
+	std::unique_ptr<DescriptorHeap> m_descriptorHeap;
+	std::unique_ptr<UploadContext> m_uploadContext;
+	std::unique_ptr<D3D12Backend> m_backend;
+
+	std::unique_ptr<ShaderCompiler> m_shaderCompiler;
+	std::unique_ptr<RootSignature> m_rootSignature;
+	std::unique_ptr<RTPipeline> m_rtPipeline;
+	std::unique_ptr<PostProcessPass> m_convergencePass;
+	std::unique_ptr<Scene> m_scene;
+
+	RenderData m_renderData{};
+	CameraData m_previousCamData{}; // camera of the last sample, zero fov until the first one after a reset
+	std::unique_ptr<ConstantRing> m_constants;
+
+	std::unique_ptr<OutputBuffer> m_accumulationBuffer;
+	std::unique_ptr<OutputBuffer> m_momentBuffer;
+	std::unique_ptr<OutputBuffer> m_albedoBuffer;
+	std::unique_ptr<OutputBuffer> m_normalDepthBuffer;
+	std::unique_ptr<OutputBuffer> m_motionBuffer;
+	std::unique_ptr<OutputBuffer> m_idBuffer;
+	GPUBuffer m_readbackBuffer; // sized for the accumulation, the widest format
+	uint32_t m_width = 0;
+	uint32_t m_height = 0;
+};
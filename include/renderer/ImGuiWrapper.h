@@ -18,7 +18,9 @@ public:
     void BeginFrame();
     void EndFrame(ID3D12GraphicsCommandList* cmdList);
 
+    [[nodiscard]] ID3D12DescriptorHeap* GetDescriptorHeap() const { return m_descriptorHeap->GetHeap(); }
+
 private:
 	RenderContext& m_context;
-    DescriptorHeap::Allocation m_fontDescriptor;
+    std::unique_ptr<DescriptorHeap> m_descriptorHeap;
 };
\ No newline at end of file
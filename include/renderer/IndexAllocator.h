@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <set>
+#include <vector>
+
+// Contiguous range of indices. The generation changes every time the range's first index is freed, so a handle
+// kept past its Free is detected instead of silently aliasing whatever was allocated there next
+struct IndexRange
+{
+    uint32_t index = 0;
+    uint32_t count = 0;
+    uint32_t generation = 0;
+
+    explicit operator bool() const { return count > 0; }
+};
+
+struct IndexAllocatorStats
+{
+    uint32_t capacity = 0;
+    uint32_t allocated = 0; // indices in use
+    uint32_t allocations = 0;
+    uint32_t freeRanges = 0;
+    uint32_t largestFreeRange = 0;
+
+    // 0 when all free indices are contiguous, close to 1 when they're scattered in small holes
+    [[nodiscard]] float GetFragmentation() const
+    {
+        const uint32_t free = capacity - allocated;
+        return free > 0 ? 1.0f - static_cast<float>(largestFreeRange) / static_cast<float>(free) : 0.0f;
+    }
+};
+
+// Best fit allocator for ranges of indices into a fixed size array, like a descriptor heap. Free ranges are kept
+// by start and by size, so allocating and freeing are logarithmic and neighbouring free ranges are merged. Ranges
+// never move, fragmentation is only reported
+class IndexAllocator
+{
+public:
+    explicit IndexAllocator(uint32_t capacity);
+
+    // Nothing if there's no free range of count indices
+    [[nodiscard]] std::optional<IndexRange> Allocate(uint32_t count);
+    void Free(const IndexRange& range);
+    // Adds the indices up to capacity to the end
+    void Grow(uint32_t capacity);
+
+    // Whether the range is allocated and wasn't freed since
+    [[nodiscard]] bool IsValid(const IndexRange& range) const;
+    // The allocated range starting at index
+    [[nodiscard]] std::optional<IndexRange> Find(uint32_t index) const;
+
+    [[nodiscard]] uint32_t GetCapacity() const { return m_capacity; }
+    [[nodiscard]] IndexAllocatorStats GetStats() const;
+
+private:
+    void AddFreeRange(uint32_t index, uint32_t count);
+    void RemoveFreeRange(std::map<uint32_t, uint32_t>::iterator it);
+
+    uint32_t m_capacity = 0;
+    uint32_t m_allocated = 0;
+    uint32_t m_allocations = 0;
+    std::map<uint32_t, uint32_t> m_freeByIndex; // index, count
+    std::set<std::pair<uint32_t, uint32_t>> m_freeBySize; // count, index
+    std::vector<uint32_t> m_counts; // per index, the count of the allocation starting there, 0 if none does
+    std::vector<uint32_t> m_generations; // per index
+};
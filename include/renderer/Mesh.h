@@ -1,60 +1,45 @@
 #pragma once
-#include "GPUBuffer.h"
-#include "DescriptorHeap.h"
+#include "RenderBackend.h"
+#include "Geometry.h"
 
-#include <DirectXMath.h>
 #include <string>
 
+// Same layout as the vertices the hit groups read in raytracing.slang
 struct Vertex
 {
-    DirectX::XMFLOAT3 position;
-    DirectX::XMFLOAT3 normal;
-    DirectX::XMFLOAT2 texCoord;
-    DirectX::XMFLOAT4 tangent;
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 texCoord;
+    glm::vec4 tangent;
 };
-
-class CommandQueue;
-class GPUAllocator;
-class UploadContext;
-class BLAS;
+static_assert(sizeof(Vertex) == 48);
 
 class Mesh
 {
 public:
-    Mesh();
-    ~Mesh();
-
-    Mesh(const Mesh&) = delete;
-    Mesh& operator=(const Mesh&) = delete;
-    Mesh(Mesh&& other) noexcept;
-    Mesh& operator=(Mesh&& other) noexcept;
-
-    void Upload(const RenderContext& context, const std::vector<Vertex>& vertices,
+    // Uploads the geometry and records its BLAS build, both done by the backend's next Submit
+    void Upload(RenderBackend& backend, const std::vector<Vertex>& vertices,
                 const std::vector<uint32_t>& indices, const std::string& name);
 
-    void BuildBLAS(RenderContext& context, ID3D12GraphicsCommandList4* commandList);
-
-    [[nodiscard]] D3D12_RAYTRACING_GEOMETRY_DESC GetGeometryDesc() const;
-    [[nodiscard]] ID3D12Resource* GetVertexBuffer() const { return m_vertexBuffer.resource; }
-    [[nodiscard]] ID3D12Resource* GetIndexBuffer() const { return m_indexBuffer.resource; }
+    [[nodiscard]] ResourceHandle GetVertexBuffer() const { return m_vertexBuffer.Get(); }
+    [[nodiscard]] ResourceHandle GetIndexBuffer() const { return m_indexBuffer.Get(); }
+    [[nodiscard]] ResourceHandle GetBLAS() const { return m_blas.Get(); }
     [[nodiscard]] uint32_t GetVertexCount() const { return m_vertexCount; }
     [[nodiscard]] uint32_t GetIndexCount() const { return m_indexCount; }
-    [[nodiscard]] D3D12_VERTEX_BUFFER_VIEW GetVertexBufferView() const;
-    [[nodiscard]] D3D12_INDEX_BUFFER_VIEW GetIndexBufferView() const;
-	[[nodiscard]] DescriptorHeap::Allocation GetVertexSRV() const { return m_vertexSRV; }
-	[[nodiscard]] DescriptorHeap::Allocation GetIndexSRV() const { return m_indexSRV; }
-	[[nodiscard]] D3D12_RAYTRACING_INSTANCE_DESC GetInstanceDesc(UINT instanceId) const;
+    [[nodiscard]] ASInstance GetInstance(uint32_t instanceId) const;
+    [[nodiscard]] const CPUGeometry& GetCPUGeometry() const { return m_cpuGeometry; }
+    [[nodiscard]] const glm::mat4& GetTransformMatrix() const { return m_transform; }
+    [[nodiscard]] const std::string& GetName() const { return m_name; }
 
     int32_t m_materialIndex = -1;
-    DirectX::XMFLOAT4X4 m_transform;
+    glm::mat4 m_transform = glm::mat4(1.0f); // object to world
 
 private:
-    GPUBuffer m_vertexBuffer;
-    GPUBuffer m_indexBuffer;
+    BackendResource m_vertexBuffer;
+    BackendResource m_indexBuffer;
+    BackendResource m_blas;
     uint32_t m_vertexCount = 0;
     uint32_t m_indexCount = 0;
-    std::unique_ptr<BLAS> m_blas = nullptr;
-
-    DescriptorHeap::Allocation m_vertexSRV;
-    DescriptorHeap::Allocation m_indexSRV;
-};
\ No newline at end of file
+    CPUGeometry m_cpuGeometry;
+    std::string m_name;
+};
@@ -1,46 +1,42 @@
 #pragma once
-#include "CommonDX.h"
 #include "Mesh.h"
-#include "Texture.h"
+#include "SceneStructs.h"
 
-#include <DirectXMath.h>
 #include <fastgltf/core.hpp>
 #include <filesystem>
 
-class GPUAllocator;
-struct MaterialData;
-
+// The meshes, textures and materials of one glTF file, uploaded through a RenderBackend
 class Model
 {
 public:
-    Model(RenderContext& context, ID3D12GraphicsCommandList4* commandList, const std::filesystem::path& path);
+    explicit Model(RenderBackend& backend);
     ~Model();
 
     Model(const Model&) = delete;
     Model& operator=(const Model&) = delete;
     Model(Model&&) = default;
-    Model& operator=(Model&&) = default;
+    Model& operator=(Model&&) = delete;
+
+    // Records the uploads and BLAS builds, the caller submits them. Prints the error and returns false on failure
+    bool Load(const std::filesystem::path& path);
 
     [[nodiscard]] const std::vector<Mesh>& GetMeshes() const { return m_meshes; }
-    [[nodiscard]] const std::vector<Texture>& GetTextures() const { return m_textures; }
+    [[nodiscard]] const std::vector<BackendResource>& GetTextures() const { return m_textures; } // empty for images that failed to load
 	[[nodiscard]] const std::vector<MaterialData>& GetMaterials() const { return m_materials; }
     [[nodiscard]] const std::string& GetName() const { return m_name; }
 
 private:
-    void LoadGLTF(ID3D12GraphicsCommandList4* commandList, const std::filesystem::path& path);
-
-    void TraverseNode(ID3D12GraphicsCommandList4* commandList,
-                      const fastgltf::Asset& asset, size_t nodeIndex, const DirectX::XMMATRIX& parentTransform);
+    void TraverseNode(const fastgltf::Asset& asset, size_t nodeIndex, const glm::mat4& parentTransform);
 
-    static DirectX::XMMATRIX GetNodeTransform(const fastgltf::Node& node);
+    static glm::mat4 GetNodeTransform(const fastgltf::Node& node);
 
-    void LoadMesh(ID3D12GraphicsCommandList4* commandList,
-                  const fastgltf::Asset& asset, const fastgltf::Mesh& gltfMesh, const DirectX::XMMATRIX& transform);
+    void LoadMesh(const fastgltf::Asset& asset, const fastgltf::Mesh& gltfMesh, const glm::mat4& transform);
     void LoadMaterials(const fastgltf::Asset& asset);
+    [[nodiscard]] int32_t GetDescriptorIndex(size_t imageIndex) const;
 
-    RenderContext& m_context;
+    RenderBackend& m_backend;
     std::vector<Mesh> m_meshes;
-    std::vector<Texture> m_textures;
+    std::vector<BackendResource> m_textures;
     std::vector<MaterialData> m_materials;
     std::string m_name;
-};
\ No newline at end of file
+};
@@ -0,0 +1,61 @@
+#pragma once
+#include "RenderBackend.h"
+
+#include <deque>
+#include <vector>
+
+// Backend without a device. Resources are plain memory that uploads copy into, and a fence completes once latency
+// more submissions followed it, like a GPU running that many frames behind. Acceleration structures are validated
+// and sized from their triangle and instance counts but never built. Nothing here is platform specific
+class NullBackend final : public RenderBackend
+{
+public:
+    explicit NullBackend(uint32_t latency = 0);
+
+    [[nodiscard]] const char* GetName() const override { return "null"; }
+
+    ResourceHandle CreateBuffer(const BufferDesc& desc) override;
+    ResourceHandle CreateTexture(const TextureDesc& desc) override;
+    void Release(ResourceHandle handle) override;
+
+    [[nodiscard]] void* Map(ResourceHandle handle) override;
+    [[nodiscard]] uint64_t GetGPUAddress(ResourceHandle handle) const override;
+    [[nodiscard]] int32_t GetDescriptorIndex(ResourceHandle handle) const override;
+
+    void Upload(ResourceHandle dest, const void* data, uint64_t size) override;
+    void UploadTexture(ResourceHandle dest, const void* data) override;
+
+    ResourceHandle BuildBLAS(const BLASDesc& desc) override;
+    ResourceHandle BuildTLAS(const std::vector<ASInstance>& instances) override;
+
+    uint64_t Submit() override;
+    [[nodiscard]] bool IsComplete(uint64_t fenceValue) const override;
+    void Wait(uint64_t fenceValue) override;
+
+    // What the resource holds, to check uploads against
+    [[nodiscard]] const std::vector<uint8_t>& GetContents(ResourceHandle handle) const;
+
+private:
+    struct Resource
+    {
+        std::vector<uint8_t> data;
+        uint64_t address = 0;
+        int32_t descriptor = -1;
+        bool alive = false;
+    };
+
+    ResourceHandle Create(uint64_t size);
+    [[nodiscard]] Resource& Get(ResourceHandle handle);
+    [[nodiscard]] const Resource& Get(ResourceHandle handle) const;
+    void FreeCompleted();
+
+    std::vector<Resource> m_resources; // slot 0 stays unused
+    std::vector<uint32_t> m_freeSlots;
+    std::deque<std::pair<uint64_t, uint32_t>> m_releases; // fence value, slot
+    std::vector<int32_t> m_freeDescriptors;
+    int32_t m_nextDescriptor = 0;
+    uint32_t m_latency;
+    uint64_t m_submitted = 0;
+    uint64_t m_completed = 0;
+    uint64_t m_nextAddress;
+};
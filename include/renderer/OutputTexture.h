@@ -18,6 +18,9 @@ public:
     [[nodiscard]] DescriptorHeap::Allocation GetUAV() const { return m_uav; }
     [[nodiscard]] DescriptorHeap::Allocation GetSRV() const { return m_srv; }
     [[nodiscard]] DXGI_FORMAT GetFormat() const { return m_format; }
+    [[nodiscard]] D3D12_RESOURCE_STATES GetState() const { return m_currentState; }
+    // For barriers recorded elsewhere, like by the render graph
+    void SetState(const D3D12_RESOURCE_STATES state) { m_currentState = state; }
 
 private:
     void Create(ID3D12Device* device, uint32_t width, uint32_t height);
@@ -11,6 +11,8 @@ class CommandQueue;
 class PostProcessPass
 {
 public:
+    static constexpr uint32_t MAX_EXTRA_SRVS = 5;
+
     PostProcessPass(RenderContext& context, ShaderCompiler& compiler, const std::string& shaderPath, const std::string& entryPoint);
     ~PostProcessPass();
     PostProcessPass(const PostProcessPass&) = delete;
@@ -20,6 +22,9 @@ public:
     {
         D3D12_GPU_DESCRIPTOR_HANDLE inputSRV;
         D3D12_GPU_DESCRIPTOR_HANDLE outputUAV;
+        // Extra inputs at t1 and up such as feature buffers and lookup tables, unused slots are bound to inputSRV
+        D3D12_GPU_DESCRIPTOR_HANDLE extraSRVs[MAX_EXTRA_SRVS] = {};
+        uint32_t extraSRVCount = 0;
         D3D12_GPU_VIRTUAL_ADDRESS constants[4] = {};
         uint32_t constantCount = 0;
         uint32_t width;
@@ -28,19 +33,21 @@ public:
 
     void Dispatch(ID3D12GraphicsCommandList4* commandList, const PostProcessBindings& bindings) const;
 
+    // Recompiles in the background when a shader file changed and swaps the PSO once that finished
     bool CheckHotReload(CommandQueue& commandQueue);
     [[nodiscard]] bool IsValid() const;
     [[nodiscard]] std::string GetLastCompileError() const;
 
 private:
     void BuildRootSignature();
-    void BuildPSO();
+    [[nodiscard]] Microsoft::WRL::ComPtr<ID3D12PipelineState> CreatePSO(D3D12_SHADER_BYTECODE bytecode) const;
 
     RenderContext& m_context;
     std::unique_ptr<Shader> m_shader;
     std::string m_entryPoint;
     Microsoft::WRL::ComPtr<ID3D12RootSignature> m_rootSignature;
     Microsoft::WRL::ComPtr<ID3D12PipelineState> m_pso;
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> m_pendingPso; // created by the hot reload worker
 
     static constexpr uint32_t THREAD_GROUP_SIZE = 8;
 };
\ No newline at end of file
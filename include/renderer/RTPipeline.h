@@ -1,42 +1,81 @@
 #pragma once
 #include "CommonDX.h"
+#include "Shader.h"
+
+#include <unordered_map>
 
 class ShaderCompiler;
-class Shader;
 class CommandQueue;
 struct HitGroupRecord;
+struct RenderSettings;
+struct ShaderDefine;
+
+// Specialization of raytracing.slang, features that are off are compiled out instead of branched over per hit.
+// See the permutation defines in settings.slang
+struct RTPermutation
+{
+    bool debugViews = false;
+    bool whiteFurnace = false;
+    bool russianRoulette = false;
+
+    [[nodiscard]] static RTPermutation FromSettings(const RenderSettings& settings);
+    [[nodiscard]] uint32_t GetKey() const;
+    [[nodiscard]] std::vector<ShaderDefine> GetDefines() const;
+    [[nodiscard]] std::string GetName() const;
+};
 
 class RTPipeline
 {
 public:
-    RTPipeline(ID3D12Device10* device, ID3D12RootSignature* rootSignature, ShaderCompiler& compiler, const std::vector<HitGroupRecord>& records, const std::string& shaderPath);
+    RTPipeline(ID3D12Device10* device, ID3D12RootSignature* rootSignature, ShaderCompiler& compiler, const std::vector<HitGroupRecord>& records,
+               const std::string& shaderPath, const RTPermutation& permutation = {});
     ~RTPipeline();
 
     void Rebuild(ID3D12Device10* device, const std::vector<HitGroupRecord>& records);
+    // Tables of every permutation, the hit groups are the same for all of them
     void RebuildShaderTables(ID3D12Device10* device, const std::vector<HitGroupRecord>& records);
+	// Recompiles in the background when a shader file changed and swaps the pipeline once that finished, returns
+	// true on the frame it was swapped
 	bool CheckHotReload(ID3D12Device10* device, CommandQueue& commandQueue, const std::vector<HitGroupRecord>& records);
-    
+    // Makes a permutation the active pipeline. It's compiled in the background the first time it's used and kept
+    // afterwards, the current one stays active until it's ready or when it fails. With wait the compile is finished
+    // before returning. Returns true when the active pipeline changed
+    bool SetPermutation(ID3D12Device10* device, CommandQueue& commandQueue, const RTPermutation& permutation,
+                        const std::vector<HitGroupRecord>& records, bool wait = false);
+
 	[[nodiscard]] D3D12_DISPATCH_RAYS_DESC GetDispatchRaysDesc() const;
-    [[nodiscard]] ID3D12StateObject* GetPSO() const { return m_pso.Get(); }
+    [[nodiscard]] ID3D12StateObject* GetPSO() const { return m_active->pso.Get(); }
+    [[nodiscard]] const RTPermutation& GetPermutation() const { return m_active->permutation; }
     [[nodiscard]] bool IsLastCompileSuccesful() const;
     [[nodiscard]] std::string GetLastCompileError() const;
 private:
+    struct Variant
+    {
+        RTPermutation permutation;
+        Microsoft::WRL::ComPtr<ID3D12StateObject> pso;
+        Microsoft::WRL::ComPtr<ID3D12StateObject> pendingPso; // created by the hot reload worker
+        Microsoft::WRL::ComPtr<ID3D12Resource> raygenTable;
+        Microsoft::WRL::ComPtr<ID3D12Resource> missTable;
+        Microsoft::WRL::ComPtr<ID3D12Resource> hitGroupTable;
+        UINT hitGroupCount = 0;
+        std::unique_ptr<Shader> shader; // last, a running reload writes pendingPso
+    };
+
+    // Compiles and builds a permutation, null if it doesn't compile
+    std::unique_ptr<Variant> CreateVariant(ID3D12Device10* device, const RTPermutation& permutation, const std::vector<HitGroupRecord>& records) const;
+    // Compiles the variant's shaders and creates its pendingPso on a worker
+    void StartReload(ID3D12Device10* device, Variant& variant) const;
+    // Swaps in a finished background compile, retiring the pipeline and tables frames in flight may still use
+    Shader::ReloadState PollReload(ID3D12Device10* device, CommandQueue& commandQueue, Variant& variant, const std::vector<HitGroupRecord>& records) const;
     void CreateLocalRootSignature(ID3D12Device10* device);
-    void CreatePSO(ID3D12Device10* device);
-    void CreateShaderTables(ID3D12Device10* device, const std::vector<HitGroupRecord>& hitGroupRecords);
+    [[nodiscard]] Microsoft::WRL::ComPtr<ID3D12StateObject> CreatePSO(ID3D12Device10* device, D3D12_SHADER_BYTECODE bytecode) const;
+    void CreateShaderTables(ID3D12Device10* device, Variant& variant, const std::vector<HitGroupRecord>& hitGroupRecords) const;
 
-    Microsoft::WRL::ComPtr<ID3D12StateObject> m_pso;
+    ShaderCompiler& m_compiler;
+    std::string m_shaderPath;
     ID3D12RootSignature* m_rootSignature;
     Microsoft::WRL::ComPtr<ID3D12RootSignature> m_localRootSignature;
 
-    Microsoft::WRL::ComPtr<ID3D12Resource> m_raygenTable;
-    Microsoft::WRL::ComPtr<ID3D12Resource> m_missTable;
-    Microsoft::WRL::ComPtr<ID3D12Resource> m_hitGroupTable;
-
-    UINT m_raygenRecordSize = 0;
-    UINT m_missRecordSize = 0;
-    UINT m_hitGroupRecordSize = 0;
-    UINT m_hitGroupCount = 0;
-
-    std::unique_ptr<Shader> m_shader;
-};
\ No newline at end of file
+    std::unordered_map<uint32_t, std::unique_ptr<Variant>> m_variants; // by RTPermutation::GetKey
+    Variant* m_active = nullptr;
+};
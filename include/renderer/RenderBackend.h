@@ -0,0 +1,198 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Texel formats, each backend maps them to its own
+enum class ResourceFormat
+{
+    RGBA8,
+    RGBA8_SRGB,
+    RGBA16F,
+    RGBA32F,
+};
+
+enum class MemoryType
+{
+    Default, // device local, filled through Upload
+    Upload, // CPU writable, mapped for its whole lifetime
+    Readback,
+};
+
+struct BufferDesc
+{
+    uint64_t size = 0;
+    MemoryType memory = MemoryType::Default;
+    bool unorderedAccess = false;
+    const char* name = "Buffer";
+};
+
+// Textures get a bindless shader resource view, see GetDescriptorIndex
+struct TextureDesc
+{
+    uint32_t width = 1;
+    uint32_t height = 1;
+    uint32_t depth = 1; // above 1 creates a 3D texture
+    ResourceFormat format = ResourceFormat::RGBA8;
+    bool unorderedAccess = false;
+    const char* name = "Texture";
+};
+
+// Slot in the resource table of the backend that created it, 0 is no resource
+struct ResourceHandle
+{
+    uint32_t index = 0;
+
+    explicit operator bool() const { return index != 0; }
+};
+
+// Triangles of a bottom level acceleration structure. Positions are three floats at the start of each vertex,
+// indices are 32 bit
+struct BLASDesc
+{
+    ResourceHandle vertexBuffer;
+    uint32_t vertexCount = 0;
+    uint32_t vertexStride = 0;
+    ResourceHandle indexBuffer;
+    uint32_t indexCount = 0;
+    const char* name = "BLAS";
+};
+
+// A BLAS placed in the top level acceleration structure
+struct ASInstance
+{
+    ResourceHandle blas;
+    float transform[3][4] = {}; // object to world, the top three rows of a column vector matrix
+    uint32_t instanceId = 0; // also its hit group
+};
+
+struct BackendStats
+{
+    uint64_t buffersCreated = 0;
+    uint64_t texturesCreated = 0;
+    uint64_t resourcesAlive = 0;
+    uint64_t bytesAlive = 0;
+    uint64_t peakBytesAlive = 0;
+    uint64_t uploads = 0;
+    uint64_t bytesUploaded = 0;
+    uint64_t accelerationStructureBuilds = 0;
+    uint64_t submissions = 0;
+    uint64_t blockingWaits = 0; // Wait calls on a fence that hadn't completed yet
+};
+
+[[nodiscard]] constexpr uint32_t GetBytesPerTexel(const ResourceFormat format)
+{
+    switch (format)
+    {
+    case ResourceFormat::RGBA16F: return 8;
+    case ResourceFormat::RGBA32F: return 16;
+    default: return 4;
+    }
+}
+
+// Resource creation, uploads and fences without any D3D12 types, for code that doesn't record command lists
+// itself. D3D12Backend runs it on the device the renderer uses, NullBackend runs it headless on any platform,
+// so loading and frame logic can be benchmarked without a GPU
+class RenderBackend
+{
+public:
+    virtual ~RenderBackend() = default;
+
+    [[nodiscard]] virtual const char* GetName() const = 0;
+
+    virtual ResourceHandle CreateBuffer(const BufferDesc& desc) = 0;
+    virtual ResourceHandle CreateTexture(const TextureDesc& desc) = 0;
+    // Frees the resource once the work submitted so far has finished
+    virtual void Release(ResourceHandle handle) = 0;
+
+    // Upload and readback memory only, the pointer stays valid until the resource is released
+    [[nodiscard]] virtual void* Map(ResourceHandle handle) = 0;
+    [[nodiscard]] virtual uint64_t GetGPUAddress(ResourceHandle handle) const = 0;
+
+    // Index of a texture's view in the bindless descriptor heap, -1 for anything else
+    [[nodiscard]] virtual int32_t GetDescriptorIndex(ResourceHandle handle) const = 0;
+
+    // Copies into default memory, the data can be freed on return. Work submitted after the next Submit sees it
+    virtual void Upload(ResourceHandle dest, const void* data, uint64_t size) = 0;
+    // Tightly packed texels of the whole texture, every depth slice of a 3D one
+    virtual void UploadTexture(ResourceHandle dest, const void* data) = 0;
+
+    // Acceleration structures are built by the next Submit, after the uploads before it. A TLAS is built after
+    // the BLASes recorded before it, the returned handles are released like any other resource
+    virtual ResourceHandle BuildBLAS(const BLASDesc& desc) = 0;
+    virtual ResourceHandle BuildTLAS(const std::vector<ASInstance>& instances) = 0;
+
+    // Returns the fence value that completes once everything submitted so far has finished
+    virtual uint64_t Submit() = 0;
+    [[nodiscard]] virtual bool IsComplete(uint64_t fenceValue) const = 0;
+    virtual void Wait(uint64_t fenceValue) = 0;
+    void Flush() { Wait(Submit()); }
+
+    [[nodiscard]] const BackendStats& GetStats() const { return m_stats; }
+
+protected:
+    void RecordCreate(uint64_t bytes, bool texture);
+    void RecordRelease(uint64_t bytes);
+
+    BackendStats m_stats;
+};
+
+inline void RenderBackend::RecordCreate(const uint64_t bytes, const bool texture)
+{
+    (texture ? m_stats.texturesCreated : m_stats.buffersCreated)++;
+    m_stats.resourcesAlive++;
+    m_stats.bytesAlive += bytes;
+    m_stats.peakBytesAlive = m_stats.bytesAlive > m_stats.peakBytesAlive ? m_stats.bytesAlive : m_stats.peakBytesAlive;
+}
+
+inline void RenderBackend::RecordRelease(const uint64_t bytes)
+{
+    m_stats.resourcesAlive--;
+    m_stats.bytesAlive -= bytes;
+}
+
+// Releases its resource when destroyed, for classes that keep backend resources for their whole lifetime
+class BackendResource
+{
+public:
+    BackendResource() = default;
+    BackendResource(RenderBackend& backend, const ResourceHandle handle) : m_backend(&backend), m_handle(handle) {}
+    ~BackendResource() { Reset(); }
+
+    // Move only
+    BackendResource(const BackendResource&) = delete;
+    BackendResource& operator=(const BackendResource&) = delete;
+
+    BackendResource(BackendResource&& other) noexcept
+        : m_backend(other.m_backend), m_handle(other.m_handle)
+    {
+        other.m_handle = {};
+    }
+
+    BackendResource& operator=(BackendResource&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Reset();
+            m_backend = other.m_backend;
+            m_handle = other.m_handle;
+            other.m_handle = {};
+        }
+        return *this;
+    }
+
+    void Reset()
+    {
+        if (m_handle)
+        {
+            m_backend->Release(m_handle);
+            m_handle = {};
+        }
+    }
+
+    [[nodiscard]] ResourceHandle Get() const { return m_handle; }
+    explicit operator bool() const { return static_cast<bool>(m_handle); }
+
+private:
+    RenderBackend* m_backend = nullptr;
+    ResourceHandle m_handle;
+};
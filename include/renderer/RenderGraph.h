@@ -0,0 +1,162 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+// Resource states the graph tracks, the bits of the read states can be combined like D3D12_RESOURCE_STATES
+enum class ResourceState : uint32_t
+{
+    Common = 0, // also the present state
+    UnorderedAccess = 1 << 0,
+    NonPixelShaderResource = 1 << 1,
+    PixelShaderResource = 1 << 2,
+    RenderTarget = 1 << 3,
+    CopySource = 1 << 4,
+    CopyDest = 1 << 5,
+};
+
+constexpr ResourceState operator|(ResourceState a, ResourceState b)
+{
+    return static_cast<ResourceState>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b));
+}
+
+constexpr bool HasAllStates(ResourceState state, ResourceState required)
+{
+    return (static_cast<uint32_t>(state) & static_cast<uint32_t>(required)) == static_cast<uint32_t>(required);
+}
+
+constexpr bool IsReadState(ResourceState state)
+{
+    constexpr uint32_t readStates = static_cast<uint32_t>(ResourceState::NonPixelShaderResource | ResourceState::PixelShaderResource | ResourceState::CopySource);
+    return state != ResourceState::Common && (static_cast<uint32_t>(state) & ~readStates) == 0;
+}
+
+using RenderGraphResource = uint32_t;
+
+struct RenderGraphBarrier
+{
+    enum class Type
+    {
+        Transition,
+        UAV, // between two passes using the same resource as unordered access where at least one writes
+    };
+
+    Type type;
+    RenderGraphResource resource;
+    ResourceState before;
+    ResourceState after;
+};
+
+// Positions in the execution order of the first and last live pass that uses a resource
+struct RenderGraphLifetime
+{
+    uint32_t firstPass;
+    uint32_t lastPass;
+
+    bool operator==(const RenderGraphLifetime&) const = default;
+};
+
+struct RenderGraphStats
+{
+    uint32_t passes = 0;
+    uint32_t culledPasses = 0;
+    uint32_t transitions = 0;
+    uint32_t uavBarriers = 0;
+    uint32_t skippedTransitions = 0; // reads that were already in a state that includes theirs
+    uint32_t barrierBatches = 0;
+};
+
+// Passes declare the resources they read and write and the state they need them in, the graph derives their
+// dependencies, culls passes nothing needed reads from, and places the barriers between passes: one batch before
+// each pass, with transitions only where the state actually changes. Compiling doesn't touch a device, Execute hands
+// the barrier batches to the backend and runs the passes in order
+class RenderGraph
+{
+public:
+    class PassBuilder
+    {
+    public:
+        PassBuilder& Read(RenderGraphResource resource, ResourceState state);
+        // Writes are also reads, unordered access is read-modify-write
+        PassBuilder& Write(RenderGraphResource resource, ResourceState state = ResourceState::UnorderedAccess);
+        // Never culled, for passes whose results leave the graph some other way
+        PassBuilder& SideEffect();
+        PassBuilder& Execute(std::function<void()> execute);
+
+    private:
+        friend class RenderGraph;
+        PassBuilder(RenderGraph& graph, uint32_t pass) : m_graph(graph), m_pass(pass) {}
+
+        RenderGraph& m_graph;
+        uint32_t m_pass;
+    };
+
+    // A resource that exists outside the graph and is in this state when the graph starts
+    RenderGraphResource Import(const std::string& name, ResourceState state);
+    // A resource without contents, it has to be written before it's read
+    RenderGraphResource Create(const std::string& name);
+    // Keeps the passes that write the resource and leaves it in this state after the last pass
+    void SetOutput(RenderGraphResource resource, ResourceState finalState);
+
+    PassBuilder AddPass(const std::string& name);
+
+    // Culls the passes and computes the barriers, false with the reason on cerr if the graph is invalid. Live passes
+    // run in the order they were added, which already respects their dependencies
+    bool Compile();
+    // Calls submitBarriers with each batch of barriers, then the pass that needs them
+    void Execute(const std::function<void(std::span<const RenderGraphBarrier>)>& submitBarriers) const;
+
+    // The state the resource is left in, for resources whose state is also tracked outside the graph
+    [[nodiscard]] ResourceState GetFinalState(RenderGraphResource resource) const;
+    // Nothing if no live pass uses the resource
+    [[nodiscard]] std::optional<RenderGraphLifetime> GetLifetime(RenderGraphResource resource) const;
+    [[nodiscard]] const std::string& GetName(RenderGraphResource resource) const { return m_resources[resource].name; }
+    // Live passes in execution order, as indices in the order they were added
+    [[nodiscard]] const std::vector<uint32_t>& GetOrder() const { return m_order; }
+    [[nodiscard]] const std::string& GetPassName(uint32_t pass) const { return m_passes[pass].name; }
+    [[nodiscard]] std::span<const RenderGraphBarrier> GetBarriers(uint32_t pass) const { return m_passes[pass].barriers; }
+    [[nodiscard]] std::span<const RenderGraphBarrier> GetFinalBarriers() const { return m_finalBarriers; }
+    [[nodiscard]] const RenderGraphStats& GetStats() const { return m_stats; }
+
+private:
+    struct Access
+    {
+        RenderGraphResource resource;
+        ResourceState state;
+        bool write;
+    };
+
+    struct Pass
+    {
+        std::string name;
+        std::vector<Access> accesses;
+        std::function<void()> execute;
+        bool sideEffect = false;
+        bool live = false;
+        std::vector<RenderGraphBarrier> barriers;
+    };
+
+    struct Resource
+    {
+        std::string name;
+        ResourceState initialState = ResourceState::Common;
+        ResourceState finalState = ResourceState::Common;
+        bool imported = false;
+        bool output = false;
+        ResourceState outputState = ResourceState::Common;
+        std::optional<RenderGraphLifetime> lifetime;
+    };
+
+    [[nodiscard]] bool Validate() const;
+    void Cull();
+    void PlaceBarriers();
+
+    std::vector<Pass> m_passes;
+    std::vector<Resource> m_resources;
+    std::vector<uint32_t> m_order;
+    std::vector<RenderGraphBarrier> m_finalBarriers;
+    RenderGraphStats m_stats;
+};
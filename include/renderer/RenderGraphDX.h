@@ -0,0 +1,11 @@
+#pragma once
+#include "RenderGraph.h"
+#include "CommonDX.h"
+
+#include <span>
+
+[[nodiscard]] D3D12_RESOURCE_STATES ToD3D12State(ResourceState state);
+[[nodiscard]] ResourceState FromD3D12State(D3D12_RESOURCE_STATES state);
+
+// Runs a compiled graph on the command list, one ResourceBarrier call per batch. resources[i] is graph resource i
+void ExecuteRenderGraph(const RenderGraph& graph, ID3D12GraphicsCommandList* commandList, std::span<ID3D12Resource* const> resources);
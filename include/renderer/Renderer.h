@@ -1,10 +1,15 @@
 #pragma once
 #include "StructsDX.h"
 #include "CommonDX.h"
+#include "RenderGraph.h"
+#include "AliasingPlanner.h"
+#include "RenderBackend.h"
 
 #include <d3d12.h>
 #include <d3dx12.h>
 #include <memory>
+#include <utility>
+#include <vector>
 
 class Window;
 class Camera;
@@ -14,6 +19,7 @@ class SwapChain;
 class DescriptorHeap;
 class CommandList;
 class UploadContext;
+class D3D12Backend;
 class GPUAllocator;
 class OutputBuffer;
 class ShaderCompiler;
@@ -22,8 +28,7 @@ class RTPipeline;
 class PostProcessPass;
 class ImGuiWrapper;
 class Scene;
-template<typename T>
-class CBVBuffer;
+class ConstantRing;
 
 class Renderer
 {
@@ -38,8 +43,25 @@ public:
 	void LoadHDRI(const std::string& path);
 	void Resize(int width, int height);
 	void ResetAccumulation() { if (!m_renderSettings.upscaling) m_renderData.frame = 0; }
+	void AnalyzeBVH() const;
+	void BenchmarkBVHUpdates() const;
+	void BenchmarkRaySorting() const;
 
 private:
+	// The frame's buffers as render graph resources
+	struct FrameResources
+	{
+		RenderGraphResource accumulation, moment, albedo, normalDepth, motion, id;
+		RenderGraphResource denoise[2];
+		RenderGraphResource output;
+		RenderGraphResource backBuffer;
+	};
+
+	// Adds the denoise passes over the accumulation and returns the resource holding the result
+	RenderGraphResource AddDenoisePasses(RenderGraph& graph, ID3D12GraphicsCommandList4* commandList, const FrameResources& resources);
+	// Rebakes the tonemapping LUT when the operator, exposure or LUT size changed
+	void UpdateTonemapLut(bool force = false);
+
 	Window& m_window;
 	std::unique_ptr<Device> m_device = nullptr;
 	std::shared_ptr<Camera> m_camera = nullptr;
@@ -50,6 +72,7 @@ private:
 	std::unique_ptr<CommandQueue> m_commandQueue = nullptr;
 	std::unique_ptr<DescriptorHeap> m_descriptorHeap = nullptr;
 	std::unique_ptr<UploadContext> m_uploadContext = nullptr;
+	std::unique_ptr<D3D12Backend> m_backend = nullptr;
 
 	uint64_t m_fenceValues[NUM_FRAMES_IN_FLIGHT] = {};
 	std::unique_ptr<SwapChain> m_swapChain = nullptr;
@@ -62,15 +85,30 @@ private:
 	RenderSettings m_renderSettings{};
 	RenderData m_renderData{};
 	PostProcessSettings m_postProcessSettings{};
-	std::unique_ptr<CBVBuffer<CameraData>> m_cameraCB;
-	std::unique_ptr<CBVBuffer<RenderSettings>> m_renderSettingsCB;
-	std::unique_ptr<CBVBuffer<RenderData>> m_renderDataCB;
-	std::unique_ptr<CBVBuffer<PostProcessSettings>> m_postProcessSettingsCB;
+	DenoiseSettings m_denoiseSettings{};
+	std::unique_ptr<ConstantRing> m_constants;
 
 	std::unique_ptr<OutputBuffer> m_accumulationBuffer;
+	std::unique_ptr<OutputBuffer> m_momentBuffer;
+	std::unique_ptr<OutputBuffer> m_albedoBuffer;
+	std::unique_ptr<OutputBuffer> m_normalDepthBuffer;
+	std::unique_ptr<OutputBuffer> m_motionBuffer;
+	std::unique_ptr<OutputBuffer> m_idBuffer;
+	std::unique_ptr<OutputBuffer> m_denoiseBuffers[2];
 	std::unique_ptr<OutputBuffer> m_outputBuffer;
+	// How the buffers that don't outlive a frame could share memory. Only planned, the buffers keep their own
+	// allocations
+	AliasingPlan m_transientPlan;
+	std::vector<std::pair<RenderGraphResource, RenderGraphLifetime>> m_transientLifetimes; // the plan was made for
+	bool m_transientPlanDirty = true; // the buffers were resized
+
+	BackendResource m_tonemapLut;
+	PostProcessSettings m_bakedLutSettings{}; // settings the LUT was baked with
 
 	std::unique_ptr<PostProcessPass> m_tonemappingPass;
+	std::unique_ptr<PostProcessPass> m_convergencePass;
+	std::unique_ptr<PostProcessPass> m_denoisePreparePass;
+	std::unique_ptr<PostProcessPass> m_denoisePass;
 
 	float m_reloadTimer = 0.0f;
 };
@@ -1,38 +1,36 @@
 #pragma once
-#include "GPUBuffer.h"
-#include "DescriptorHeap.h"
-
-class Model;
-class TLAS;
-class Texture;
-class CommandQueue;
-class GPUAllocator;
-struct HitGroupRecord;
+#include "Model.h"
+#include "Geometry.h"
 
+// The loaded models and environment map on a RenderBackend, with one TLAS instance and hit group per mesh
 class Scene
 {
 public:
-	Scene(RenderContext& context);
+	explicit Scene(RenderBackend& backend);
 	~Scene();
 
+	// Both block until the backend finished the uploads and builds
 	bool LoadModel(const std::string& path);
-	void LoadHDRI(const std::string& path);
+	bool LoadHDRI(const std::string& path);
 
 	[[nodiscard]] const std::vector<Model>& GetModels() const { return m_models; }
-	[[nodiscard]] const TLAS& GetTLAS() const { return *m_tlas; }
-	[[nodiscard]] D3D12_GPU_VIRTUAL_ADDRESS GetTLASAddress() const;
+	[[nodiscard]] uint64_t GetTLASAddress() const; // 0 before a model was loaded
 	[[nodiscard]] std::vector<HitGroupRecord> GetHitGroupRecords() const;
-	[[nodiscard]] D3D12_GPU_VIRTUAL_ADDRESS GetMaterialsBufferAddress() const { return m_materialData.resource->GetGPUVirtualAddress(); }
+	[[nodiscard]] uint64_t GetMaterialsBufferAddress() const;
 	[[nodiscard]] int32_t GetHDRIDescriptorIndex() const;
+	[[nodiscard]] std::vector<CPUInstance> GetCPUInstances() const;
+	[[nodiscard]] const std::vector<std::string>& GetModelPaths() const { return m_modelPaths; }
+	[[nodiscard]] const std::string& GetHDRIPath() const { return m_hdriPath; }
 
 private:
+	void BuildTLAS();
 	void UploadMaterialData();
 
-	RenderContext& m_context;
-	std::unique_ptr<TLAS> m_tlas;
+	RenderBackend& m_backend;
 	std::vector<Model> m_models;
-	std::unique_ptr<Texture> m_hdri;
-	GPUBuffer m_materialData;
-	DescriptorHeap::Allocation m_materialSRV;
+	BackendResource m_tlas;
+	BackendResource m_hdri;
+	BackendResource m_materialData;
+	std::vector<std::string> m_modelPaths; // source files, so CPU tools can load their own copy of the scene
+	std::string m_hdriPath;
 };
-
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+#include <glm/vec3.hpp>
+
+// Shader structs the scene fills in, kept free of D3D12 types so Scene builds on any platform
+
+struct HitGroupRecord
+{
+	uint64_t vertexBuffer; // GPU virtual addresses
+	uint64_t indexBuffer;
+	uint32_t materialIndex;
+	uint32_t _pad0;
+};
+
+struct MaterialData
+{
+	glm::vec3 albedoFactor = glm::vec3(1.0f);
+	int32_t albedoIndex = -1;
+	glm::vec3 emissiveFactor = glm::vec3(1.0f);
+	int32_t emissiveIndex = -1;
+	float metallicFactor = 1.0f;
+	float roughnessFactor = 1.0f;
+	int32_t metallicRoughnessIndex = -1;
+	int32_t normalIndex = -1;
+	uint32_t _pad0;
+	uint32_t _pad1;
+};
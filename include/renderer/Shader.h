@@ -1,21 +1,35 @@
 #pragma once
+#include "ShaderCompiler.h"
+
 #include <d3d12.h>
-#include <filesystem>
+#include <functional>
+#include <future>
 #include <string>
 #include <vector>
 
-class ShaderCompiler;
-
 class Shader
 {
 public:
+    // Without compileNow the shader starts empty, StartReload compiles it
     Shader(ShaderCompiler& compiler, std::string filePath, 
-		   const std::vector<std::string>& entryPoints, bool isRaytracing);
+		   const std::vector<std::string>& entryPoints, bool isRaytracing, std::vector<ShaderDefine> defines = {}, bool compileNow = true);
     ~Shader();
 
+    // True when a file the shader was compiled from changed since, no filesystem access
     bool NeedsReload() const;
     bool Reload();
 
+    // Background hot reload: StartReload compiles on a worker thread and runs prepare there with the new
+    // bytecode, so the owner can build its pipeline off the render thread too. PollReload applies the result once
+    // it is done, until then the previous bytecode stays in place
+    enum class ReloadState { Idle, Compiling, Failed, Reloaded };
+    using PrepareFn = std::function<void(D3D12_SHADER_BYTECODE)>;
+    void StartReload(PrepareFn prepare = {});
+    [[nodiscard]] ReloadState PollReload();
+    [[nodiscard]] bool IsReloading() const { return m_pending.valid(); }
+    // Blocks until a started reload finished, PollReload still applies it
+    void WaitForReload() const;
+
     [[nodiscard]] D3D12_SHADER_BYTECODE GetBytecode() const;
     [[nodiscard]] const std::vector<uint8_t>& GetBlob() const { return m_blob; }
     [[nodiscard]] bool IsValid() const { return !m_blob.empty(); }
@@ -23,13 +37,19 @@ public:
 	[[nodiscard]] std::string GetLastCompileError() const { return m_lastCompileError; }
 
 private:
+    bool Apply(ShaderCompiler::CompilationResult result);
+
     ShaderCompiler& m_compiler;
     std::string m_filePath;
     std::vector<std::string> m_entryPoints;
+    std::vector<ShaderDefine> m_defines;
     std::vector<uint8_t> m_blob;
     bool m_isRaytracing;
 
-    std::filesystem::file_time_type m_lastWriteTime;
+    std::vector<std::string> m_dependencies; // normalized, see ShaderWatcher
+    uint64_t m_compileSequence = 0; // watcher sequence the last compile started at
 	bool m_lastCompileFailed = false;
 	std::string m_lastCompileError;
+
+    std::future<ShaderCompiler::CompilationResult> m_pending; // last, so it's waited for before the rest goes away
 };
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A file an entry was compiled from and the hash of the contents the compiler read from it
+struct ShaderDependency
+{
+    std::string path;
+    uint64_t hash = 0;
+};
+
+// On-disk cache of compiled shader blobs. An entry is found by a key over everything that selects the
+// compilation (entry file, entry points, target and compiler options), and is only used while every source
+// file the compiler read for it, the entry file and all transitive imports, still hashes the same
+class ShaderCache
+{
+public:
+    explicit ShaderCache(std::string directory, std::string extension = ".bin");
+
+    // Returns false and leaves the blob alone on a miss, reason says why. Dependencies are the files the entry was compiled from,
+    // they're also filled when the entry is stale because one of them changed
+    bool Load(uint64_t key, std::vector<uint8_t>& blob, std::vector<ShaderDependency>& dependencies, std::string& reason) const;
+    // The hashes have to be of the contents the compiler read, not of the files after the compile. A file saved while
+    // the compile ran then makes the entry stale instead of serving the blob for the old contents under the new ones
+    void Store(uint64_t key, const std::vector<ShaderDependency>& dependencies, const std::vector<uint8_t>& blob) const;
+
+    [[nodiscard]] const std::string& GetDirectory() const { return m_directory; }
+
+    // 64-bit FNV-1a, passing the previous hash as seed chains it over several values
+    [[nodiscard]] static uint64_t Hash(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
+    [[nodiscard]] static uint64_t Hash(const std::string& s, uint64_t seed = 14695981039346656037ull) { return Hash(s.data(), s.size(), seed); }
+    // 0 if the file can't be read
+    [[nodiscard]] static uint64_t HashFile(const std::string& path);
+
+private:
+    [[nodiscard]] std::string GetEntryPath(uint64_t key) const;
+
+    std::string m_directory;
+    std::string m_extension;
+};
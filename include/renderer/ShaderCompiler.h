@@ -1,15 +1,29 @@
 #pragma once
 #include "CommonDX.h"
+#include "ShaderCache.h"
+#include "ShaderWatcher.h"
 
 #include <slang.h>
 #include <slang-com-ptr.h>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+// Preprocessor define of a shader permutation, applies to the shader and every module it imports
+struct ShaderDefine
+{
+    std::string name;
+    std::string value;
+};
+
 class ShaderCompiler
 {
 public:
-    ShaderCompiler();
+    // Compiled blobs are cached in cacheDirectory and checked modules in its modules folder, an empty one compiles every time
+    explicit ShaderCompiler(std::string cacheDirectory = "shader_cache");
     ~ShaderCompiler();
 
 	struct CompilationResult
@@ -17,14 +31,68 @@ public:
         std::vector<uint8_t> blob;
         bool success = false;
         std::string errorLog;
+        // Files the shader was compiled from, normalized like ShaderWatcher does. After a failed compile it's every
+        // shader in the directory, the file that broke it may not have been read
+        std::vector<std::string> dependencies;
     };
 
-    CompilationResult Compile(const std::string& filePath, const std::vector<std::string>& entryPoints = {}, bool isRaytracing = true) const;
+    // Safe to call from worker threads, compiles are serialized
+    CompilationResult Compile(const std::string& filePath, const std::vector<std::string>& entryPoints = {}, bool isRaytracing = true,
+                              const std::vector<ShaderDefine>& defines = {}) const;
+    // Starts watching a shader directory for hot reload, without it shaders never need reloading
+    void WatchForChanges(const std::string& directory);
+    [[nodiscard]] const ShaderWatcher* GetWatcher() const { return m_watcher.get(); }
+
     ShaderCompiler(const ShaderCompiler&) = delete;
     ShaderCompiler& operator=(const ShaderCompiler&) = delete;
 
 private:
     static void diagnoseIfNeeded(slang::IBlob* diagnosticsBlob, CompilationResult& result);
 
+    // Long-lived session of one search directory, option set and define set. Slang keeps every module it loaded, so shared
+    // imports are parsed and checked once. Modules can't be unloaded, when a file changes the session is rebuilt with the
+    // modules that didn't read it
+    struct CachedSession
+    {
+        std::string key; // directory, options and defines, modules are only valid in a session with the same key
+        // Normalized path to the hash of the contents the session read, a file saved later doesn't change it.
+        // Declared first, the file system writing it is released before it
+        std::unordered_map<std::string, uint64_t> files;
+        Slang::ComPtr<ISlangFileSystem> fileSystem; // fills files as Slang reads them
+        Slang::ComPtr<slang::ISession> session;
+        std::unordered_set<std::string> precompiled; // modules loaded from .slang-module files, nothing to store for them
+    };
+
+    CachedSession& GetSession(const std::string& directory, bool wholeProgram, const std::vector<ShaderDefine>& defines) const;
+    // Moves the modules of previous whose files aren't in changed to cached as serialized IR
+    static void CarryOverModules(const CachedSession& previous, CachedSession& cached, const std::unordered_set<std::string>& changed);
+    // The files with the hashes of what the session read from them, 0 for a file it didn't read so the entry is never valid
+    [[nodiscard]] static std::vector<ShaderDependency> GetDependencies(const CachedSession& cached, const std::vector<std::string>& files);
+
+    // Loads a module and its imports from serialized IR when none of the files they were checked from changed, null
+    // when any of them has to be compiled from source. Imports are loaded first, so the source compile finds them
+    slang::IModule* LoadPrecompiledModule(CachedSession& cached, const std::string& filePath) const;
+    struct ModuleTiming
+    {
+        std::string name;
+        float milliseconds = 0.0f;
+        bool precompiled = false;
+    };
+    // Loads a module after the modules it imports so each timing covers one module, precompiled when unchanged
+    slang::IModule* LoadModule(CachedSession& cached, const std::string& directory, const std::string& filePath,
+                               std::vector<ModuleTiming>& timings, std::unordered_set<std::string>& loading,
+                               CompilationResult& result) const;
+    // Serializes the modules a compile checked from source, starting at the session's firstModule
+    void StorePrecompiledModules(CachedSession& cached, SlangInt firstModule) const;
+    [[nodiscard]] uint64_t GetModuleKey(const CachedSession& cached, const std::string& filePath) const;
+
+    [[nodiscard]] uint64_t GetCacheKey(const std::string& filePath, const std::vector<std::string>& entryPoints, bool wholeProgram,
+                                       const std::vector<ShaderDefine>& defines) const;
+
     Slang::ComPtr<slang::IGlobalSession> m_globalSession;
+    ShaderCache m_cache;
+    ShaderCache m_moduleCache;
+    mutable std::unordered_map<std::string, CachedSession> m_sessions;
+    std::unique_ptr<ShaderWatcher> m_watcher;
+    mutable std::mutex m_mutex; // Slang sessions aren't thread safe
 };
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Watches a shader directory on a background thread and records which .slang files changed, so the render loop
+// never touches the filesystem. Uses ReadDirectoryChangesW on Windows and inotify on Linux, and falls back to
+// polling modification times when neither can be set up. Every change gets a sequence number, a Shader asks
+// whether any file it was compiled from changed after the sequence it was compiled at
+class ShaderWatcher
+{
+public:
+    explicit ShaderWatcher(std::string directory);
+    ~ShaderWatcher();
+    ShaderWatcher(const ShaderWatcher&) = delete;
+    ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+    // Sequence of the latest change, taken before compiling so changes during the compile aren't lost
+    [[nodiscard]] uint64_t GetSequence() const;
+    // Files as normalized by Normalize
+    [[nodiscard]] bool HasChanged(const std::vector<std::string>& files, uint64_t sinceSequence) const;
+
+    // Absolute, lexically normal path, so paths reported by Slang and by the watcher compare equal
+    [[nodiscard]] static std::string Normalize(const std::string& path);
+
+private:
+    void Run();
+    bool RunEvents(); // false when the platform watcher couldn't be set up
+    void RunPolling();
+    void RecordChange(const std::string& path);
+    void RecordOverflow(); // events were lost, everything counts as changed
+
+    std::string m_directory;
+    std::thread m_thread;
+    std::atomic<bool> m_stop = false;
+#ifdef _WIN32
+    void* m_stopEvent = nullptr;
+#else
+    int m_stopPipe[2] = { -1, -1 };
+#endif
+
+    mutable std::mutex m_mutex;
+    uint64_t m_sequence = 0;
+    uint64_t m_overflowSequence = 0;
+    std::unordered_map<std::string, uint64_t> m_changes; // file to the sequence of its last change
+};
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <queue>
+
+// Sub-allocates a fixed size ring, like a persistently mapped upload buffer. Allocations are made in batches: once a
+// batch's work is submitted it's closed with the fence value of that submission, and its space is reclaimed once the
+// fence completed. Only does the bookkeeping, so it works for any memory and without a device
+class StagingRing
+{
+public:
+    explicit StagingRing(uint64_t capacity);
+
+    // Offset into the ring, or nothing if there's no room until older batches completed. Allocations never wrap
+    // around the end, the space skipped at the end belongs to the allocation
+    [[nodiscard]] std::optional<uint64_t> Allocate(uint64_t size, uint64_t alignment);
+    // Everything allocated since the last call is in use until fenceValue completed
+    void Close(uint64_t fenceValue);
+    // Frees the closed batches whose fence is at most completedFenceValue
+    void Reclaim(uint64_t completedFenceValue);
+
+    // Whether an allocation of this size can ever succeed, larger ones have to be staged some other way
+    [[nodiscard]] bool Fits(uint64_t size, uint64_t alignment) const;
+    [[nodiscard]] bool HasOpenAllocations() const { return m_head != m_closed; }
+    // Fence of the oldest batch still in use, 0 if there is none
+    [[nodiscard]] uint64_t GetOldestFence() const { return m_batches.empty() ? 0 : m_batches.front().fenceValue; }
+
+    [[nodiscard]] uint64_t GetCapacity() const { return m_capacity; }
+    [[nodiscard]] uint64_t GetUsed() const { return m_head - m_tail; }
+
+private:
+    struct Batch
+    {
+        uint64_t fenceValue;
+        uint64_t end;
+    };
+
+    // Offsets keep increasing, the position in the ring is the offset modulo the capacity
+    uint64_t m_capacity;
+    uint64_t m_head = 0; // end of the newest allocation
+    uint64_t m_closed = 0; // end of the newest closed batch
+    uint64_t m_tail = 0; // start of the oldest batch still in use
+    std::queue<Batch> m_batches;
+};
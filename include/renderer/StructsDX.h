@@ -1,4 +1,6 @@
 #pragma once
+#include "SceneStructs.h"
+
 #include <d3d12.h>
 #include <glm/vec3.hpp>
 #include <ImReflect.hpp>
@@ -7,6 +9,7 @@ struct RenderData
 {
 	int32_t hdriIndex = -1;
 	uint32_t frame = 0;
+	uint32_t sampleOffset = 0; // added to frame for the RNG seed, so offline runs can render disjoint sample ranges
 };
 
 enum DebugMode
@@ -24,6 +27,13 @@ enum DebugMode
 	TangentW,
 };
 
+// Same as SampleSequence in rng.slang
+enum class SampleSequence : uint32_t
+{
+	Random,
+	Sobol,
+};
+
 struct RenderSettings
 {
 	DebugMode debugMode = None;
@@ -32,8 +42,15 @@ struct RenderSettings
 	float lightIntensity = 1.0f;
 	BOOL whiteFurnace = false;
 	BOOL upscaling = false;
+	BOOL adaptiveSampling = false; // see CPURenderSettings
+	float adaptiveThreshold = 0.02f;
+	uint32_t adaptiveMinSamples = 16;
+	uint32_t adaptiveInterval = 8;
+	SampleSequence sampleSequence = SampleSequence::Random;
+	BOOL russianRoulette = false; // wave coherent path termination, see raytracing.slang
 };
-IMGUI_REFLECT(RenderSettings, debugMode, bounces, skyIntensity, lightIntensity, whiteFurnace, upscaling)
+IMGUI_REFLECT(RenderSettings, debugMode, bounces, skyIntensity, lightIntensity, whiteFurnace, upscaling,
+              adaptiveSampling, adaptiveThreshold, adaptiveMinSamples, adaptiveInterval, sampleSequence, russianRoulette)
 
 enum TonemapOperator
 {
@@ -44,12 +61,47 @@ enum TonemapOperator
 	GT7,
 };
 
+// Shows one of the path tracer's feature buffers instead of the tonemapped radiance
+enum class FeatureView : uint32_t
+{
+	Radiance,
+	Albedo,
+	Normal,
+	Depth,
+	Motion,
+	InstanceID,
+	MaterialID,
+};
+
 struct PostProcessSettings
 {
 	TonemapOperator tonemapper = AgX;
 	float exposure = 25.0f;
+	FeatureView featureView = FeatureView::Radiance;
+	BOOL bakedLut = false; // sample a 3D LUT of the operator instead of evaluating it per pixel
+	uint32_t lutSize = 65;
+	float lutScale = 0.0f; // log2 encoding of the LUT input, set when it is baked
+	float lutOffset = 0.0f;
+};
+IMGUI_REFLECT(PostProcessSettings, tonemapper, exposure, featureView, bakedLut, lutSize)
+
+// Edge-avoiding a-trous filter over the accumulation, see denoise_pass.slang and Denoiser on the CPU
+struct DenoiseSettings
+{
+	BOOL enabled = false;
+	uint32_t iterations = 5; // the kernel footprint doubles with every one
+	float sigmaLuminance = 4.0f; // in standard deviations of the luminance noise
+	float sigmaAlbedo = 0.1f;
+	float sigmaNormal = 128.0f; // exponent of the normal dot product
+	float sigmaDepth = 0.05f; // relative depth difference per pixel of kernel step
+};
+IMGUI_REFLECT(DenoiseSettings, enabled, iterations, sigmaLuminance, sigmaAlbedo, sigmaNormal, sigmaDepth)
+
+struct DenoiseIteration
+{
+	uint32_t stepSize = 1;
+	BOOL last = false;
 };
-IMGUI_REFLECT(PostProcessSettings, tonemapper, exposure)
 
 struct CameraData
 {
@@ -63,25 +115,3 @@ struct CameraData
 	uint32_t _pad2;
 };
 IMGUI_REFLECT(CameraData, position, fov, forward, right, up)
-
-struct HitGroupRecord
-{
-	D3D12_GPU_VIRTUAL_ADDRESS vertexBuffer;
-	D3D12_GPU_VIRTUAL_ADDRESS indexBuffer;
-	uint32_t materialIndex;
-	uint32_t _pad0;
-};
-
-struct MaterialData
-{
-	glm::vec3 albedoFactor = glm::vec3(1.0f);
-	int32_t albedoIndex = -1;
-	glm::vec3 emissiveFactor = glm::vec3(1.0f);
-	int32_t emissiveIndex = -1;
-	float metallicFactor = 1.0f;
-	float roughnessFactor = 1.0f;
-	int32_t metallicRoughnessIndex = -1;
-	int32_t normalIndex = -1;
-	uint32_t _pad0;
-	uint32_t _pad1;
-};
\ No newline at end of file
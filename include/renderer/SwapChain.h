@@ -29,6 +29,9 @@ public:
 	void Resize(uint32_t width, uint32_t height, ID3D12Device* device);
 	void Present();
 	void Transition(ID3D12GraphicsCommandList* commandList, D3D12_RESOURCE_STATES newState);
+	[[nodiscard]] D3D12_RESOURCE_STATES GetState() const { return m_currentState; }
+	// For barriers recorded elsewhere, like by the render graph
+	void SetState(const D3D12_RESOURCE_STATES state) { m_currentState = state; }
 
 private:
 	Window& m_window;
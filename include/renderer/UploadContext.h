@@ -1,21 +1,66 @@
 #pragma once
 #include "GPUBuffer.h"
+#include "StagingRing.h"
 #include "CommonDX.h"
 
+#include <queue>
+
 class GPUAllocator;
 class CommandQueue;
 
+struct UploadStats
+{
+    uint64_t uploads = 0;
+    uint64_t bytesStaged = 0;
+    uint64_t submissions = 0;
+    uint64_t ringWaits = 0; // times the ring was full and the CPU had to wait for the copy queue
+    uint64_t dedicatedBuffers = 0; // uploads too large for the ring
+};
+
+// Copies data into default heap resources on a copy queue. Uploads are staged in a persistently mapped ring and
+// recorded into one command list, which is only submitted on Submit or Flush, or when the ring is full
 class UploadContext
 {
 public:
-    UploadContext(GPUAllocator& allocator, ID3D12Device10* device);
+    static constexpr uint64_t DEFAULT_RING_SIZE = 64ull * 1024 * 1024;
+
+    UploadContext(GPUAllocator& allocator, ID3D12Device10* device, uint64_t ringSize = DEFAULT_RING_SIZE);
     ~UploadContext();
 
     void Upload(const GPUBuffer& dest, const void* data, uint64_t size);
-    void UploadTexture(const GPUBuffer& dest, const void* data, uint32_t width, uint32_t height, DXGI_FORMAT format);
+    // Tightly packed texels of every depth slice, the size has to match the texture's
+    void UploadTexture(const GPUBuffer& dest, const void* data, uint32_t width, uint32_t height, uint32_t depth, DXGI_FORMAT format);
+    // Executes the uploads recorded so far without waiting for them, returns the copy queue's fence value
+    uint64_t Submit();
+    // Submits and waits, after this the uploaded resources can be used on any queue
     void Flush();
+
+    [[nodiscard]] const UploadStats& GetStats() const { return m_stats; }
 private:
+    struct Staging
+    {
+        ID3D12Resource* resource;
+        uint64_t offset;
+        uint8_t* mapped; // already at offset
+    };
+
+    // Staging memory in the ring, submitting the open batch and waiting for older ones when it's full
+    Staging Stage(uint64_t size, uint64_t alignment);
+    ID3D12GraphicsCommandList4* GetCommandList();
+    void ReclaimCompleted();
+
 	GPUAllocator& m_allocator;
+    ID3D12Device10* m_device;
     std::unique_ptr<CommandQueue> m_queue;
-    std::vector<GPUBuffer> m_staged;
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList4> m_commandList; // open batch, null if nothing was recorded
+    uint64_t m_lastFence = 0;
+
+    GPUBuffer m_ring;
+    uint8_t* m_ringMapped = nullptr;
+    StagingRing m_ringAllocator;
+
+    std::vector<GPUBuffer> m_dedicated; // for the open batch
+    std::queue<std::pair<uint64_t, GPUBuffer>> m_submittedDedicated;
+
+    UploadStats m_stats;
 };
@@ -0,0 +1,234 @@
+#include "BackendBenchmark.h"
+#include "NullBackend.h"
+#include "ConstantRing.h"
+#include "Scene.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	double MillisecondsSince(const Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	// Stands in for the renderer's constant structs, which are D3D12 specific
+	struct ConstantBlock
+	{
+		uint32_t frame;
+		uint32_t block;
+		uint64_t sceneAddress;
+		float data[12];
+	};
+
+	BackendStats Subtract(const BackendStats& after, const BackendStats& before)
+	{
+		BackendStats result = after;
+		result.buffersCreated -= before.buffersCreated;
+		result.texturesCreated -= before.texturesCreated;
+		result.uploads -= before.uploads;
+		result.bytesUploaded -= before.bytesUploaded;
+		result.accelerationStructureBuilds -= before.accelerationStructureBuilds;
+		result.submissions -= before.submissions;
+		result.blockingWaits -= before.blockingWaits;
+		return result;
+	}
+
+	void WriteStats(std::ostream& out, const BackendStats& stats)
+	{
+		out << "{ \"buffers_created\": " << stats.buffersCreated << ", \"textures_created\": " << stats.texturesCreated
+			<< ", \"resources_alive\": " << stats.resourcesAlive << ", \"bytes_alive\": " << stats.bytesAlive
+			<< ", \"peak_bytes_alive\": " << stats.peakBytesAlive << ", \"uploads\": " << stats.uploads
+			<< ", \"bytes_uploaded\": " << stats.bytesUploaded << ", \"acceleration_structure_builds\": " << stats.accelerationStructureBuilds
+			<< ", \"submissions\": " << stats.submissions << ", \"blocking_waits\": " << stats.blockingWaits << " }";
+	}
+}
+
+BackendBenchmark::Report BackendBenchmark::Run(RenderBackend& backend, const BackendBenchmarkSettings& settings)
+{
+	Report report;
+	report.backend = backend.GetName();
+	report.settings = settings;
+
+	{
+		Scene scene(backend);
+		Clock::time_point start = Clock::now();
+		for (const std::string& path : settings.modelPaths)
+		{
+			if (!scene.LoadModel(path))
+			{
+				report.failed = true;
+				return report;
+			}
+		}
+		if (!settings.hdriPath.empty() && !scene.LoadHDRI(settings.hdriPath))
+		{
+			report.failed = true;
+			return report;
+		}
+		report.loadMs = MillisecondsSince(start);
+		report.loadStats = backend.GetStats();
+
+		for (const Model& model : scene.GetModels())
+		{
+			report.meshCount += static_cast<uint32_t>(model.GetMeshes().size());
+			report.textureCount += static_cast<uint32_t>(model.GetTextures().size());
+			for (const Mesh& mesh : model.GetMeshes())
+			{
+				report.triangleCount += mesh.GetIndexCount() / 3;
+			}
+		}
+
+		// The renderer's frame loop without the command lists: wait for the frame's slot, query the scene and push
+		// the constants, then submit
+		const uint32_t framesInFlight = std::max(settings.framesInFlight, 1u);
+		ConstantRing constants(backend, "Constant Ring", framesInFlight);
+		std::vector<uint64_t> frameFences(framesInFlight, 0);
+		std::vector<uint64_t> boundAddresses(settings.constantBlocksPerFrame); // what SetRootCBV would get
+
+		const BackendStats beforeFrames = backend.GetStats();
+		start = Clock::now();
+		for (uint32_t frame = 0; frame < settings.frameCount; frame++)
+		{
+			const uint32_t slot = frame % framesInFlight;
+			backend.Wait(frameFences[slot]);
+			constants.BeginFrame(slot);
+
+			ConstantBlock block{};
+			block.frame = frame;
+			block.sceneAddress = scene.GetTLASAddress() + scene.GetMaterialsBufferAddress();
+			block.data[0] = static_cast<float>(scene.GetHDRIDescriptorIndex());
+			for (uint32_t b = 0; b < settings.constantBlocksPerFrame; b++)
+			{
+				block.block = b;
+				boundAddresses[b] = constants.Push(block);
+			}
+			frameFences[slot] = backend.Submit();
+		}
+		backend.Flush();
+		const double frameMs = MillisecondsSince(start);
+		report.frameUs = settings.frameCount > 0 ? frameMs * 1000.0 / settings.frameCount : 0.0;
+		report.frameStats = Subtract(backend.GetStats(), beforeFrames);
+		report.constantBytesPerFrame = constants.GetPeakUsed();
+	}
+
+	// The scene released everything it created
+	backend.Flush();
+	return report;
+}
+
+void BackendBenchmark::Report::Print(std::ostream& out) const
+{
+	std::ios_base::fmtflags flags = out.flags();
+
+	out << "[BackendBenchmark] " << backend << " backend";
+	if (failed)
+	{
+		out << ", failed\n";
+		out.flags(flags);
+		return;
+	}
+	out << ", " << meshCount << " meshes, " << textureCount << " textures, " << triangleCount << " triangles\n";
+	out << std::fixed << std::setprecision(2);
+	out << "  load     " << std::setw(10) << loadMs << " ms, " << loadStats.buffersCreated << " buffers, "
+		<< loadStats.texturesCreated << " textures, " << loadStats.bytesUploaded / (1024.0 * 1024.0) << " MiB in "
+		<< loadStats.uploads << " uploads, " << loadStats.accelerationStructureBuilds << " acceleration structures, "
+		<< loadStats.submissions << " submissions\n";
+	out << "  frame    " << std::setw(10) << frameUs << " us over " << settings.frameCount << " frames, "
+		<< settings.constantBlocksPerFrame << " constant blocks and " << constantBytesPerFrame << " bytes each, "
+		<< frameStats.blockingWaits << " blocking waits\n";
+
+	out.flags(flags);
+}
+
+bool BackendBenchmark::Report::WriteJSON(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file)
+	{
+		std::cerr << "[BackendBenchmark] Failed to write " << path << "\n";
+		return false;
+	}
+
+	file << std::setprecision(9);
+	file << "{\n";
+	file << "  \"backend\": \"" << backend << "\",\n";
+	file << "  \"failed\": " << (failed ? "true" : "false") << ",\n";
+	file << "  \"frames\": " << settings.frameCount << ",\n";
+	file << "  \"frames_in_flight\": " << settings.framesInFlight << ",\n";
+	file << "  \"constant_blocks_per_frame\": " << settings.constantBlocksPerFrame << ",\n";
+	file << "  \"meshes\": " << meshCount << ",\n";
+	file << "  \"textures\": " << textureCount << ",\n";
+	file << "  \"triangles\": " << triangleCount << ",\n";
+	file << "  \"load_ms\": " << loadMs << ",\n";
+	file << "  \"frame_us\": " << frameUs << ",\n";
+	file << "  \"constant_bytes_per_frame\": " << constantBytesPerFrame << ",\n";
+	file << "  \"load_stats\": ";
+	WriteStats(file, loadStats);
+	file << ",\n  \"frame_stats\": ";
+	WriteStats(file, frameStats);
+	file << "\n}\n";
+	return static_cast<bool>(file);
+}
+
+bool BackendBenchmark::IsRequested(const int argc, char* argv[])
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--backend-benchmark") == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+int BackendBenchmark::RunFromCommandLine(const int argc, char* argv[])
+{
+	BackendBenchmarkSettings settings;
+	std::string outputPath;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		const bool hasValue = i + 1 < argc;
+		try
+		{
+			if (arg == "--backend-benchmark") continue;
+			else if (arg == "--hdri" && hasValue) settings.hdriPath = argv[++i];
+			else if (arg == "--frames" && hasValue) settings.frameCount = std::stoul(argv[++i]);
+			else if (arg == "--frames-in-flight" && hasValue) settings.framesInFlight = std::stoul(argv[++i]);
+			else if (arg == "--constant-blocks" && hasValue) settings.constantBlocksPerFrame = std::stoul(argv[++i]);
+			else if (arg == "--latency" && hasValue) settings.latency = std::stoul(argv[++i]);
+			else if ((arg == "--output" || arg == "-o") && hasValue) outputPath = argv[++i];
+			else if (arg[0] != '-') settings.modelPaths.push_back(arg);
+			else
+			{
+				std::cerr << "[BackendBenchmark] Invalid argument: " << arg << "\n";
+				return 1;
+			}
+		}
+		catch (const std::exception&)
+		{
+			std::cerr << "[BackendBenchmark] Invalid value for " << arg << ": " << argv[i] << "\n";
+			return 1;
+		}
+	}
+
+	// Always headless, the D3D12 backend belongs to a renderer and is measured through it
+	NullBackend backend(settings.latency);
+	const Report report = Run(backend, settings);
+	report.Print(std::cout);
+	if (!outputPath.empty() && !report.WriteJSON(outputPath))
+	{
+		return 1;
+	}
+	return report.failed ? 1 : 0;
+}
@@ -0,0 +1,584 @@
+#include "ConvergenceBenchmark.h"
+#include "HeadlessRenderer.h"
+#include "Camera.h"
+#include "ImageIO.h"
+#include "Tonemapping.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	double MillisecondsSince(const Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	std::string GetReferencePath(const ConvergenceCase& testCase, const ConvergenceSettings& settings)
+	{
+		std::ostringstream name;
+		name << testCase.name << "_" << settings.width << "x" << settings.height << "_b" << settings.renderSettings.bounces
+			<< "_" << settings.referenceSampleCount << "spp.pfm";
+		return (std::filesystem::path(settings.referenceDirectory) / name.str()).string();
+	}
+
+	bool LoadScene(OfflineRenderer& renderer, const ConvergenceCase& testCase)
+	{
+		for (const auto& path : testCase.modelPaths)
+		{
+			if (!renderer.LoadModel(path))
+			{
+				std::cerr << "[ConvergenceBenchmark] Failed to load model: " << path << "\n";
+				return false;
+			}
+		}
+		if (!testCase.hdriPath.empty() && !renderer.LoadHDRI(testCase.hdriPath))
+		{
+			std::cerr << "[ConvergenceBenchmark] Failed to load HDRI: " << testCase.hdriPath << "\n";
+			return false;
+		}
+		return true;
+	}
+
+	Camera CreateCamera(const ConvergenceCase& testCase)
+	{
+		Camera camera;
+		camera.SetPosition(testCase.cameraPosition);
+		camera.SetDirection(testCase.cameraDirection);
+		camera.m_fov = testCase.fov;
+		return camera;
+	}
+
+	// Writes both reports of a comparison, the baseline next to the output with a suffix, returns the exit code
+	int WriteComparison(const ConvergenceBenchmark::Report& baseline, const ConvergenceBenchmark::Report& tested,
+		const std::string& outputPath, const std::string& baselineSuffix)
+	{
+		const std::filesystem::path path(outputPath);
+		const std::string baselinePath = (path.parent_path() / (path.stem().string() + baselineSuffix + path.extension().string())).string();
+		if (!baseline.WriteJSON(baselinePath) || !tested.WriteJSON(outputPath))
+		{
+			return 1;
+		}
+		for (size_t c = 0; c < baseline.cases.size() && c < tested.cases.size(); c++)
+		{
+			if (baseline.cases[c].failed || tested.cases[c].failed)
+			{
+				return 1;
+			}
+		}
+		return 0;
+	}
+
+	bool IsCheckpoint(const uint32_t sampleCount)
+	{
+		return (sampleCount & (sampleCount - 1)) == 0;
+	}
+
+	std::string Quoted(const std::string& s)
+	{
+		std::ostringstream out;
+		out << std::quoted(s);
+		return out.str();
+	}
+
+	// Splits on whitespace, double quotes group a path with spaces
+	std::vector<std::string> Tokenize(const std::string& line)
+	{
+		std::vector<std::string> tokens;
+		std::istringstream stream(line);
+		std::string token;
+		while (stream >> std::quoted(token))
+		{
+			tokens.push_back(token);
+		}
+		return tokens;
+	}
+}
+
+double ConvergenceBenchmark::CaseReport::GetEfficiency() const
+{
+	if (points.empty() || points.back().error.relMse <= 0.0 || points.back().renderMs <= 0.0)
+	{
+		return 0.0;
+	}
+	return 1.0 / (points.back().error.relMse * points.back().renderMs / 1000.0);
+}
+
+ConvergenceBenchmark::ErrorMetrics ConvergenceBenchmark::ComputeError(const std::vector<glm::vec3>& image, const std::vector<glm::vec3>& reference)
+{
+	ErrorMetrics metrics;
+	if (image.empty() || image.size() != reference.size())
+	{
+		return metrics;
+	}
+
+	double squaredError = 0.0;
+	double relativeError = 0.0;
+	for (size_t i = 0; i < image.size(); i++)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			const double difference = static_cast<double>(image[i][c]) - reference[i][c];
+			const double referenceValue = reference[i][c];
+			squaredError += difference * difference;
+			relativeError += difference * difference / (referenceValue * referenceValue + 0.01);
+		}
+	}
+
+	const double count = static_cast<double>(image.size()) * 3.0;
+	metrics.rmse = std::sqrt(squaredError / count);
+	metrics.relMse = relativeError / count;
+	return metrics;
+}
+
+ConvergenceBenchmark::Report ConvergenceBenchmark::Run(const std::vector<ConvergenceCase>& cases, const ConvergenceSettings& settings)
+{
+	Report report;
+	report.label = settings.label;
+	report.settings = settings;
+
+	std::error_code error;
+	std::filesystem::create_directories(settings.referenceDirectory, error);
+
+	for (const ConvergenceCase& testCase : cases)
+	{
+		CaseReport& caseReport = report.cases.emplace_back();
+		caseReport.name = testCase.name;
+		caseReport.failed = true;
+
+		// A fresh renderer per case, scenes can't be unloaded
+		std::unique_ptr<OfflineRenderer> renderer = OfflineRenderer::Create(settings.backend, settings.debugLayer);
+		if (!renderer || !LoadScene(*renderer, testCase))
+		{
+			continue;
+		}
+		report.device = renderer->GetName();
+		const Camera camera = CreateCamera(testCase);
+
+		std::vector<glm::vec3> reference;
+		const std::string referencePath = GetReferencePath(testCase, settings);
+		uint32_t referenceWidth = 0;
+		uint32_t referenceHeight = 0;
+		if (!settings.rebuildReferences && std::filesystem::exists(referencePath) &&
+			ImageIO::Read(referencePath, referenceWidth, referenceHeight, reference) &&
+			referenceWidth == settings.width && referenceHeight == settings.height)
+		{
+			caseReport.referenceCached = true;
+		}
+		else
+		{
+			std::cout << "[ConvergenceBenchmark] Rendering " << settings.referenceSampleCount << " spp reference for " << testCase.name << "\n";
+			const auto referenceStart = Clock::now();
+			CPURenderSettings referenceSettings = settings.renderSettings;
+			referenceSettings.adaptiveSampling = false;
+			referenceSettings.sequence = RNG::Sequence::Random;
+			renderer->Reset(settings.width, settings.height, REFERENCE_FIRST_SAMPLE);
+			for (uint32_t i = 0; i < settings.referenceSampleCount; i++)
+			{
+				renderer->RenderSample(camera, referenceSettings);
+			}
+			reference = Tonemapping::ResolveLinear(renderer->ReadAccumulation());
+			caseReport.referenceMs = MillisecondsSince(referenceStart);
+
+			if (!ImageIO::Write(referencePath, settings.width, settings.height, reference))
+			{
+				std::cerr << "[ConvergenceBenchmark] Failed to cache the reference at " << referencePath << "\n";
+			}
+		}
+
+		renderer->Reset(settings.width, settings.height, 0);
+		double renderMs = 0.0;
+		const double budgetMs = settings.timeBudget * 1000.0;
+		while (renderer->GetSampleCount() < settings.maxSampleCount)
+		{
+			const auto sampleStart = Clock::now();
+			renderer->RenderSample(camera, settings.renderSettings);
+			renderMs += MillisecondsSince(sampleStart);
+
+			const uint32_t sampleCount = renderer->GetSampleCount();
+			const bool outOfTime = budgetMs > 0.0 && renderMs >= budgetMs;
+			if (IsCheckpoint(sampleCount) || sampleCount == settings.maxSampleCount || outOfTime)
+			{
+				const std::vector<glm::vec4> accumulation = renderer->ReadAccumulation();
+				Point& point = caseReport.points.emplace_back();
+				point.sampleCount = sampleCount;
+				point.renderMs = renderMs;
+				point.error = ComputeError(Tonemapping::ResolveLinear(accumulation), reference);
+				for (const glm::vec4& pixel : accumulation)
+				{
+					point.averageSampleCount += pixel.w;
+				}
+				point.averageSampleCount /= static_cast<double>(std::max<size_t>(accumulation.size(), 1));
+			}
+			if (outOfTime)
+			{
+				break;
+			}
+		}
+		caseReport.failed = false;
+	}
+	return report;
+}
+
+std::vector<ConvergenceCase> ConvergenceBenchmark::GetDefaultCases()
+{
+	std::vector<ConvergenceCase> cases;
+
+	ConvergenceCase& helmet = cases.emplace_back();
+	helmet.name = "DamagedHelmet";
+	helmet.modelPaths = { "assets/models/DamagedHelmet.glb" };
+	helmet.cameraPosition = { 0.0f, 0.0f, 3.0f };
+	helmet.cameraDirection = { 0.0f, 0.0f, -1.0f };
+
+	ConvergenceCase& chess = cases.emplace_back();
+	chess.name = "ChessSet";
+	chess.modelPaths = { "assets/models/ChessSet/chess_set_2k.gltf" };
+	chess.cameraPosition = { 0.0f, 0.3f, 0.6f };
+	chess.cameraDirection = { 0.0f, -0.4f, -1.0f };
+
+	return cases;
+}
+
+bool ConvergenceBenchmark::LoadCases(const std::string& path, std::vector<ConvergenceCase>& cases)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		std::cerr << "[ConvergenceBenchmark] Failed to open " << path << "\n";
+		return false;
+	}
+
+	std::string line;
+	for (uint32_t lineNumber = 1; std::getline(file, line); lineNumber++)
+	{
+		line = line.substr(0, line.find('#'));
+		std::vector<std::string> tokens = Tokenize(line);
+		if (tokens.empty())
+		{
+			continue;
+		}
+
+		// The name takes the place of argv[0]
+		std::vector<char*> argv;
+		for (auto& token : tokens)
+		{
+			argv.push_back(token.data());
+		}
+
+		HeadlessOptions options;
+		if (!HeadlessOptions::Parse(static_cast<int>(argv.size()), argv.data(), options))
+		{
+			std::cerr << "[ConvergenceBenchmark] Invalid case at " << path << ":" << lineNumber << "\n";
+			return false;
+		}
+
+		ConvergenceCase& testCase = cases.emplace_back();
+		testCase.name = tokens[0];
+		testCase.modelPaths = options.modelPaths;
+		testCase.hdriPath = options.hdriPath;
+		testCase.cameraPosition = options.cameraPosition;
+		testCase.cameraDirection = options.cameraDirection;
+		testCase.fov = options.fov;
+	}
+	return true;
+}
+
+void ConvergenceBenchmark::Report::Print(std::ostream& out) const
+{
+	std::ios_base::fmtflags flags = out.flags();
+
+	out << "[ConvergenceBenchmark] " << (label.empty() ? "unlabeled" : label) << " on " << device << ", "
+		<< settings.width << "x" << settings.height << ", " << settings.renderSettings.bounces << " bounces, "
+		<< RNG::GetSequenceName(settings.renderSettings.sequence) << " sampler, " << settings.referenceSampleCount << " spp references\n";
+	for (const CaseReport& testCase : cases)
+	{
+		if (testCase.failed)
+		{
+			out << "  " << testCase.name << ": failed\n";
+			continue;
+		}
+
+		out << "  " << testCase.name << (testCase.referenceCached ? " (cached reference)" : "") << "\n";
+		out << "       spp   avg spp        ms        RMSE      relMSE\n";
+		for (const Point& point : testCase.points)
+		{
+			out << std::setw(10) << point.sampleCount
+				<< std::fixed << std::setprecision(1) << std::setw(10) << point.averageSampleCount
+				<< std::setw(10) << point.renderMs
+				<< std::scientific << std::setprecision(3) << std::setw(12) << point.error.rmse
+				<< std::setw(12) << point.error.relMse << "\n";
+		}
+		out << "  efficiency (1 / (relMSE * s)): " << std::scientific << std::setprecision(3) << testCase.GetEfficiency() << "\n";
+	}
+
+	out.flags(flags);
+}
+
+void ConvergenceBenchmark::PrintComparison(std::ostream& out, const Report& uniform, const Report& adaptive)
+{
+	std::ios_base::fmtflags flags = out.flags();
+
+	out << "[ConvergenceBenchmark] Equal time comparison, " << uniform.settings.timeBudget << " s per case\n";
+	out << "  case                  uniform relMSE  adaptive relMSE   avg spp      error ratio\n";
+	for (size_t c = 0; c < uniform.cases.size() && c < adaptive.cases.size(); c++)
+	{
+		const CaseReport& uniformCase = uniform.cases[c];
+		const CaseReport& adaptiveCase = adaptive.cases[c];
+		out << "  " << std::left << std::setw(20) << uniformCase.name << std::right;
+		if (uniformCase.failed || adaptiveCase.failed || uniformCase.points.empty() || adaptiveCase.points.empty())
+		{
+			out << "  failed\n";
+			continue;
+		}
+
+		const Point& uniformPoint = uniformCase.points.back();
+		const Point& adaptivePoint = adaptiveCase.points.back();
+		out << std::scientific << std::setprecision(3) << std::setw(16) << uniformPoint.error.relMse
+			<< std::setw(17) << adaptivePoint.error.relMse
+			<< std::fixed << std::setprecision(1) << std::setw(10) << adaptivePoint.averageSampleCount
+			<< std::setprecision(3) << std::setw(17)
+			<< (uniformPoint.error.relMse > 0.0 ? adaptivePoint.error.relMse / uniformPoint.error.relMse : 0.0) << "\n";
+	}
+	out << "  error ratio below 1 means adaptive sampling converges faster\n";
+
+	out.flags(flags);
+}
+
+void ConvergenceBenchmark::PrintSamplerComparison(std::ostream& out, const Report& random, const Report& sobol)
+{
+	std::ios_base::fmtflags flags = out.flags();
+
+	out << "[ConvergenceBenchmark] Equal sample comparison of the random and Sobol sequences\n";
+	for (size_t c = 0; c < random.cases.size() && c < sobol.cases.size(); c++)
+	{
+		const CaseReport& randomCase = random.cases[c];
+		const CaseReport& sobolCase = sobol.cases[c];
+		out << "  " << randomCase.name;
+		if (randomCase.failed || sobolCase.failed)
+		{
+			out << ": failed\n";
+			continue;
+		}
+
+		out << "\n       spp   random relMSE    sobol relMSE     error ratio\n";
+		for (size_t p = 0; p < randomCase.points.size() && p < sobolCase.points.size(); p++)
+		{
+			const Point& randomPoint = randomCase.points[p];
+			const Point& sobolPoint = sobolCase.points[p];
+			out << std::setw(10) << randomPoint.sampleCount
+				<< std::scientific << std::setprecision(3) << std::setw(16) << randomPoint.error.relMse
+				<< std::setw(16) << sobolPoint.error.relMse
+				<< std::fixed << std::setw(16)
+				<< (randomPoint.error.relMse > 0.0 ? sobolPoint.error.relMse / randomPoint.error.relMse : 0.0) << "\n";
+		}
+	}
+	out << "  error ratio below 1 means the Sobol sequence converges faster\n";
+
+	out.flags(flags);
+}
+
+bool ConvergenceBenchmark::Report::WriteJSON(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file)
+	{
+		std::cerr << "[ConvergenceBenchmark] Failed to write " << path << "\n";
+		return false;
+	}
+
+	file << std::setprecision(9);
+	file << "{\n";
+	file << "  \"label\": " << Quoted(label) << ",\n";
+	file << "  \"device\": " << Quoted(device) << ",\n";
+	file << "  \"settings\": {\n";
+	file << "    \"width\": " << settings.width << ",\n";
+	file << "    \"height\": " << settings.height << ",\n";
+	file << "    \"bounces\": " << settings.renderSettings.bounces << ",\n";
+	file << "    \"sky_intensity\": " << settings.renderSettings.skyIntensity << ",\n";
+	file << "    \"light_intensity\": " << settings.renderSettings.lightIntensity << ",\n";
+	file << "    \"reference_spp\": " << settings.referenceSampleCount << ",\n";
+	file << "    \"max_spp\": " << settings.maxSampleCount << ",\n";
+	file << "    \"time_budget_s\": " << settings.timeBudget << ",\n";
+	file << "    \"sampler\": " << Quoted(RNG::GetSequenceName(settings.renderSettings.sequence)) << ",\n";
+	file << "    \"adaptive_threshold\": " << (settings.renderSettings.adaptiveSampling ? settings.renderSettings.adaptiveThreshold : 0.0f) << "\n";
+	file << "  },\n";
+	file << "  \"cases\": [\n";
+	for (size_t c = 0; c < cases.size(); c++)
+	{
+		const CaseReport& testCase = cases[c];
+		file << "    {\n";
+		file << "      \"name\": " << Quoted(testCase.name) << ",\n";
+		file << "      \"failed\": " << (testCase.failed ? "true" : "false") << ",\n";
+		file << "      \"reference_cached\": " << (testCase.referenceCached ? "true" : "false") << ",\n";
+		file << "      \"reference_ms\": " << testCase.referenceMs << ",\n";
+		file << "      \"efficiency\": " << testCase.GetEfficiency() << ",\n";
+		file << "      \"points\": [";
+		for (size_t p = 0; p < testCase.points.size(); p++)
+		{
+			const Point& point = testCase.points[p];
+			file << (p == 0 ? "\n" : ",\n")
+				<< "        { \"spp\": " << point.sampleCount << ", \"avg_spp\": " << point.averageSampleCount << ", \"ms\": " << point.renderMs
+				<< ", \"rmse\": " << point.error.rmse << ", \"relmse\": " << point.error.relMse << " }";
+		}
+		file << (testCase.points.empty() ? "]\n" : "\n      ]\n");
+		file << (c + 1 < cases.size() ? "    },\n" : "    }\n");
+	}
+	file << "  ]\n";
+	file << "}\n";
+	return static_cast<bool>(file);
+}
+
+bool ConvergenceBenchmark::IsRequested(const int argc, char* argv[])
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--convergence") == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+int ConvergenceBenchmark::RunFromCommandLine(const int argc, char* argv[])
+{
+	ConvergenceSettings settings;
+	std::string outputPath = "convergence.json";
+	std::string suitePath;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		const bool hasValue = i + 1 < argc;
+		try
+		{
+			if (arg == "--convergence") continue;
+			else if (arg == "--debuglayer") settings.debugLayer = true;
+			else if (arg == "--rebuild-reference") settings.rebuildReferences = true;
+			else if (arg == "--compare-adaptive") settings.compareAdaptive = true;
+			else if (arg == "--compare-samplers") settings.compareSamplers = true;
+			else if (arg == "--sampler" && hasValue && RNG::ParseSequence(argv[i + 1], settings.renderSettings.sequence)) ++i;
+			else if (arg == "--adaptive" && hasValue)
+			{
+				settings.renderSettings.adaptiveSampling = true;
+				settings.renderSettings.adaptiveThreshold = std::stof(argv[++i]);
+			}
+			else if (arg == "--adaptive-min-spp" && hasValue) settings.renderSettings.adaptiveMinSamples = std::stoul(argv[++i]);
+			else if (arg == "--adaptive-interval" && hasValue) settings.renderSettings.adaptiveInterval = std::stoul(argv[++i]);
+			else if (arg == "--width" && hasValue) settings.width = std::stoul(argv[++i]);
+			else if (arg == "--height" && hasValue) settings.height = std::stoul(argv[++i]);
+			else if (arg == "--spp" && hasValue) settings.maxSampleCount = std::stoul(argv[++i]);
+			else if (arg == "--reference-spp" && hasValue) settings.referenceSampleCount = std::stoul(argv[++i]);
+			else if (arg == "--time" && hasValue) settings.timeBudget = std::stod(argv[++i]);
+			else if (arg == "--bounces" && hasValue) settings.renderSettings.bounces = std::stoul(argv[++i]);
+			else if (arg == "--sky-intensity" && hasValue) settings.renderSettings.skyIntensity = std::stof(argv[++i]);
+			else if (arg == "--light-intensity" && hasValue) settings.renderSettings.lightIntensity = std::stof(argv[++i]);
+			else if (arg == "--reference-dir" && hasValue) settings.referenceDirectory = argv[++i];
+			else if (arg == "--label" && hasValue) settings.label = argv[++i];
+			else if ((arg == "--output" || arg == "-o") && hasValue) outputPath = argv[++i];
+			else if (arg == "--backend" && hasValue && OfflineRenderer::ParseBackend(argv[i + 1], settings.backend)) ++i;
+			else if (arg[0] != '-' && suitePath.empty()) suitePath = arg;
+			else
+			{
+				std::cerr << "[ConvergenceBenchmark] Invalid argument: " << arg << "\n";
+				return 1;
+			}
+		}
+		catch (const std::exception&)
+		{
+			std::cerr << "[ConvergenceBenchmark] Invalid value for " << arg << ": " << argv[i] << "\n";
+			return 1;
+		}
+	}
+
+	if (settings.width == 0 || settings.height == 0 || settings.maxSampleCount == 0 || settings.referenceSampleCount == 0)
+	{
+		std::cerr << "[ConvergenceBenchmark] Resolution and sample counts have to be non-zero\n";
+		return 1;
+	}
+
+	std::vector<ConvergenceCase> cases;
+	if (suitePath.empty())
+	{
+		cases = GetDefaultCases();
+	}
+	else if (!LoadCases(suitePath, cases))
+	{
+		return 1;
+	}
+
+	if (settings.compareAdaptive && settings.compareSamplers)
+	{
+		std::cerr << "[ConvergenceBenchmark] --compare-adaptive and --compare-samplers can't be combined\n";
+		return 1;
+	}
+
+	if (settings.compareAdaptive)
+	{
+		if (settings.timeBudget <= 0.0)
+		{
+			std::cerr << "[ConvergenceBenchmark] --compare-adaptive needs a --time budget\n";
+			return 1;
+		}
+
+		// Only the time budget ends the runs, so both spend the same time on every case
+		settings.maxSampleCount = std::numeric_limits<uint32_t>::max();
+		ConvergenceSettings uniformSettings = settings;
+		uniformSettings.renderSettings.adaptiveSampling = false;
+		uniformSettings.label = settings.label.empty() ? "uniform" : settings.label + ", uniform";
+		settings.renderSettings.adaptiveSampling = true;
+		std::ostringstream label;
+		label << (settings.label.empty() ? "" : settings.label + ", ") << "adaptive " << settings.renderSettings.adaptiveThreshold;
+		settings.label = label.str();
+
+		const Report uniform = Run(cases, uniformSettings);
+		const Report adaptive = Run(cases, settings);
+		uniform.Print(std::cout);
+		adaptive.Print(std::cout);
+		PrintComparison(std::cout, uniform, adaptive);
+		return WriteComparison(uniform, adaptive, outputPath, "_uniform");
+	}
+
+	if (settings.compareSamplers)
+	{
+		// Both stop at the same sample counts, a time budget would end them at different ones
+		settings.timeBudget = 0.0;
+		ConvergenceSettings randomSettings = settings;
+		randomSettings.renderSettings.sequence = RNG::Sequence::Random;
+		randomSettings.label = settings.label.empty() ? "random" : settings.label + ", random";
+		settings.renderSettings.sequence = RNG::Sequence::Sobol;
+		settings.label = settings.label.empty() ? "sobol" : settings.label + ", sobol";
+
+		const Report random = Run(cases, randomSettings);
+		const Report sobol = Run(cases, settings);
+		random.Print(std::cout);
+		sobol.Print(std::cout);
+		PrintSamplerComparison(std::cout, random, sobol);
+		return WriteComparison(random, sobol, outputPath, "_random");
+	}
+
+	Report report = Run(cases, settings);
+	report.Print(std::cout);
+	if (!report.WriteJSON(outputPath))
+	{
+		return 1;
+	}
+
+	for (const CaseReport& testCase : report.cases)
+	{
+		if (testCase.failed)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
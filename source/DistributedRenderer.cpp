@@ -0,0 +1,636 @@
+#include "DistributedRenderer.h"
+#include "ImageIO.h"
+#include "Tonemapping.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	constexpr char PARTIAL_MAGIC[8] = { 'K', 'Y', 'R', 'A', 'P', 'R', 'T', '1' };
+
+	double MillisecondsSince(const Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	std::string Quoted(const std::string& s)
+	{
+		std::ostringstream out;
+		out << std::quoted(s);
+		return out.str();
+	}
+
+	template<typename T>
+	void WriteValue(std::ofstream& file, const T& value)
+	{
+		file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template<typename T>
+	void ReadValue(std::ifstream& file, T& value)
+	{
+		file.read(reinterpret_cast<char*>(&value), sizeof(T));
+	}
+
+	std::string GetExecutablePath()
+	{
+#ifdef _WIN32
+		char path[MAX_PATH];
+		const DWORD length = GetModuleFileNameA(nullptr, path, MAX_PATH);
+		return length > 0 && length < MAX_PATH ? std::string(path, length) : std::string();
+#else
+		std::error_code error;
+		return std::filesystem::read_symlink("/proc/self/exe", error).string();
+#endif
+	}
+
+#ifdef _WIN32
+	// Quotes an argument so CommandLineToArgvW and the CRT split it back into the same string
+	std::string QuoteArgument(const std::string& argument)
+	{
+		if (!argument.empty() && argument.find_first_of(" \t\"") == std::string::npos)
+		{
+			return argument;
+		}
+
+		std::string quoted = "\"";
+		size_t backslashes = 0;
+		for (const char c : argument)
+		{
+			if (c == '\\')
+			{
+				backslashes++;
+				continue;
+			}
+			quoted.append(c == '"' ? backslashes * 2 + 1 : backslashes, '\\');
+			quoted += c;
+			backslashes = 0;
+		}
+		quoted.append(backslashes * 2, '\\');
+		quoted += '"';
+		return quoted;
+	}
+#endif
+
+	// A child process with its stdout and stderr going to a log file
+	class WorkerProcess
+	{
+	public:
+		WorkerProcess() = default;
+		WorkerProcess(const WorkerProcess&) = delete;
+		WorkerProcess& operator=(const WorkerProcess&) = delete;
+
+		~WorkerProcess()
+		{
+#ifdef _WIN32
+			if (m_process)
+			{
+				CloseHandle(m_process);
+			}
+#endif
+		}
+
+		bool Start(const std::string& executable, const std::vector<std::string>& arguments, const std::string& logPath)
+		{
+#ifdef _WIN32
+			std::string commandLine = QuoteArgument(executable);
+			for (const auto& argument : arguments)
+			{
+				commandLine += " " + QuoteArgument(argument);
+			}
+
+			SECURITY_ATTRIBUTES security{ sizeof(security), nullptr, TRUE };
+			HANDLE log = CreateFileA(logPath.c_str(), GENERIC_WRITE, FILE_SHARE_READ, &security, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (log == INVALID_HANDLE_VALUE)
+			{
+				return false;
+			}
+
+			STARTUPINFOA startup{};
+			startup.cb = sizeof(startup);
+			startup.dwFlags = STARTF_USESTDHANDLES;
+			startup.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+			startup.hStdOutput = log;
+			startup.hStdError = log;
+
+			PROCESS_INFORMATION info{};
+			const BOOL created = CreateProcessA(nullptr, commandLine.data(), nullptr, nullptr, TRUE, 0, nullptr, nullptr, &startup, &info);
+			CloseHandle(log);
+			if (!created)
+			{
+				return false;
+			}
+			CloseHandle(info.hThread);
+			m_process = info.hProcess;
+			return true;
+#else
+			std::vector<char*> argv;
+			argv.push_back(const_cast<char*>(executable.c_str()));
+			for (const auto& argument : arguments)
+			{
+				argv.push_back(const_cast<char*>(argument.c_str()));
+			}
+			argv.push_back(nullptr);
+
+			posix_spawn_file_actions_t actions;
+			posix_spawn_file_actions_init(&actions);
+			posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, logPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+			posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+			const int result = posix_spawn(&m_pid, executable.c_str(), &actions, nullptr, argv.data(), environ);
+			posix_spawn_file_actions_destroy(&actions);
+			return result == 0;
+#endif
+		}
+
+		// Returns true once the process has exited
+		bool Poll(int& exitCode)
+		{
+#ifdef _WIN32
+			if (WaitForSingleObject(m_process, 0) != WAIT_OBJECT_0)
+			{
+				return false;
+			}
+			DWORD code = 1;
+			GetExitCodeProcess(m_process, &code);
+			CloseHandle(m_process);
+			m_process = nullptr;
+			exitCode = static_cast<int>(code);
+			return true;
+#else
+			int status = 0;
+			const pid_t result = waitpid(m_pid, &status, WNOHANG);
+			if (result == 0)
+			{
+				return false;
+			}
+			exitCode = result == m_pid && WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+			return true;
+#endif
+		}
+
+	private:
+#ifdef _WIN32
+		HANDLE m_process = nullptr;
+#else
+		pid_t m_pid = -1;
+#endif
+	};
+}
+
+RenderPartial RenderPartial::FromAccumulation(const std::vector<glm::vec4>& accumulation, const uint32_t width, const uint32_t height,
+                                              const glm::uvec4 region, const uint32_t firstSample, const uint32_t sampleCount, const double renderMs)
+{
+	RenderPartial partial;
+	partial.width = width;
+	partial.height = height;
+	partial.region = region;
+	partial.firstSample = firstSample;
+	partial.sampleCount = sampleCount;
+	partial.renderMs = renderMs;
+	partial.sums.resize(static_cast<size_t>(region.z) * region.w);
+	for (uint32_t y = 0; y < region.w; y++)
+	{
+		const auto row = accumulation.begin() + static_cast<size_t>(region.y + y) * width + region.x;
+		std::copy(row, row + region.z, partial.sums.begin() + static_cast<size_t>(y) * region.z);
+	}
+	return partial;
+}
+
+bool RenderPartial::Write(const std::string& path) const
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+	{
+		std::cerr << "[DistributedRenderer] Failed to open " << path << " for writing\n";
+		return false;
+	}
+
+	file.write(PARTIAL_MAGIC, sizeof(PARTIAL_MAGIC));
+	WriteValue(file, width);
+	WriteValue(file, height);
+	WriteValue(file, region);
+	WriteValue(file, firstSample);
+	WriteValue(file, sampleCount);
+	WriteValue(file, renderMs);
+	file.write(reinterpret_cast<const char*>(sums.data()), sums.size() * sizeof(glm::vec4));
+
+	if (!file)
+	{
+		std::cerr << "[DistributedRenderer] Failed to write " << path << "\n";
+		return false;
+	}
+	return true;
+}
+
+bool RenderPartial::Read(const std::string& path, RenderPartial& partial)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		std::cerr << "[DistributedRenderer] Failed to open " << path << "\n";
+		return false;
+	}
+
+	char magic[sizeof(PARTIAL_MAGIC)] = {};
+	file.read(magic, sizeof(magic));
+	ReadValue(file, partial.width);
+	ReadValue(file, partial.height);
+	ReadValue(file, partial.region);
+	ReadValue(file, partial.firstSample);
+	ReadValue(file, partial.sampleCount);
+	ReadValue(file, partial.renderMs);
+	if (!file || memcmp(magic, PARTIAL_MAGIC, sizeof(magic)) != 0 ||
+		partial.region.x + partial.region.z > partial.width || partial.region.y + partial.region.w > partial.height)
+	{
+		std::cerr << "[DistributedRenderer] " << path << " is not a render partial\n";
+		return false;
+	}
+
+	partial.sums.resize(static_cast<size_t>(partial.region.z) * partial.region.w);
+	file.read(reinterpret_cast<char*>(partial.sums.data()), partial.sums.size() * sizeof(glm::vec4));
+	if (!file)
+	{
+		std::cerr << "[DistributedRenderer] " << path << " is truncated\n";
+		return false;
+	}
+	return true;
+}
+
+bool RenderJob::WriteList(const std::string& path, const std::vector<RenderJob>& jobs)
+{
+	std::ofstream file(path);
+	if (!file)
+	{
+		std::cerr << "[DistributedRenderer] Failed to open " << path << " for writing\n";
+		return false;
+	}
+	for (const RenderJob& job : jobs)
+	{
+		file << job.region.x << " " << job.region.y << " " << job.region.z << " " << job.region.w << " "
+			<< job.firstSample << " " << job.sampleCount << " " << job.partialPath << "\n";
+	}
+	if (!file)
+	{
+		std::cerr << "[DistributedRenderer] Failed to write " << path << "\n";
+		return false;
+	}
+	return true;
+}
+
+bool RenderJob::ReadList(const std::string& path, std::vector<RenderJob>& jobs)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		std::cerr << "[DistributedRenderer] Failed to open " << path << "\n";
+		return false;
+	}
+
+	jobs.clear();
+	std::string line;
+	while (std::getline(file, line))
+	{
+		if (line.empty())
+		{
+			continue;
+		}
+		std::istringstream stream(line);
+		RenderJob& job = jobs.emplace_back();
+		const bool parsed = static_cast<bool>(stream >> job.region.x >> job.region.y >> job.region.z >> job.region.w
+		                                                >> job.firstSample >> job.sampleCount >> std::ws);
+		std::getline(stream, job.partialPath);
+		if (!parsed || job.partialPath.empty() || job.region.z == 0 || job.region.w == 0 || job.sampleCount == 0)
+		{
+			std::cerr << "[DistributedRenderer] " << path << " line " << jobs.size() << " is not a render job\n";
+			return false;
+		}
+	}
+	return true;
+}
+
+DistributedRenderer::DistributedRenderer(HeadlessOptions options)
+	: m_options(std::move(options))
+{
+}
+
+int DistributedRenderer::Run()
+{
+	const auto startTime = Clock::now();
+	const uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	m_threadsPerWorker = m_options.threadCount > 0 ? m_options.threadCount : std::max(1u, hardwareThreads / m_options.workerCount);
+
+	const std::filesystem::path output(m_options.outputPath);
+	const std::filesystem::path partialDirectory = output.parent_path() / (output.stem().string() + "_partials");
+	std::error_code error;
+	std::filesystem::create_directories(partialDirectory, error);
+	if (error)
+	{
+		std::cerr << "[DistributedRenderer] Failed to create " << partialDirectory.string() << ": " << error.message() << "\n";
+		return 1;
+	}
+
+	std::vector<Slot> slots(m_options.workerCount);
+	std::vector<Job> jobs = CreateJobs(partialDirectory.string(), slots.size());
+	slots.resize(std::min(slots.size(), jobs.size()));
+	for (const Job& job : jobs)
+	{
+		slots[job.slot].jobCount++;
+	}
+	std::cout << "[DistributedRenderer] " << jobs.size() << (m_options.splitSamples ? " sample ranges" : " tiles") << " on "
+		<< slots.size() << " workers with " << m_threadsPerWorker << " threads each\n";
+
+	const auto renderStart = Clock::now();
+	const bool rendered = RunJobs(jobs, slots);
+	const double renderMs = MillisecondsSince(renderStart);
+	if (!rendered)
+	{
+		std::cerr << "[DistributedRenderer] Render failed, worker logs are in " << partialDirectory.string() << "\n";
+		return 1;
+	}
+
+	std::vector<glm::vec4> accumulation;
+	if (!Merge(jobs, accumulation))
+	{
+		return 1;
+	}
+
+	bool written = ImageIO::Write(m_options.outputPath, m_options.width, m_options.height,
+	                              Tonemapping::Resolve(accumulation, m_options.tonemapper, m_options.exposure));
+	written &= ImageIO::Write(m_options.linearPath, m_options.width, m_options.height,
+	                          Tonemapping::ResolveLinear(accumulation));
+	const double totalMs = MillisecondsSince(startTime);
+
+	PrintSummary(std::cout, jobs, slots, renderMs, totalMs);
+	written &= WriteSummary(m_options.summaryPath, jobs, slots, renderMs, totalMs);
+
+	if (!m_options.keepPartials)
+	{
+		std::filesystem::remove_all(partialDirectory, error);
+	}
+	return written ? 0 : 1;
+}
+
+std::vector<DistributedRenderer::Job> DistributedRenderer::CreateJobs(const std::string& partialDirectory, const size_t slotCount) const
+{
+	std::vector<Job> jobs;
+	if (m_options.splitSamples)
+	{
+		// Contiguous ranges, so every sample index is rendered exactly once
+		const uint32_t jobCount = std::min(m_options.workerCount, m_options.sampleCount);
+		for (uint32_t i = 0; i < jobCount; i++)
+		{
+			const uint32_t begin = static_cast<uint32_t>(static_cast<uint64_t>(m_options.sampleCount) * i / jobCount);
+			const uint32_t end = static_cast<uint32_t>(static_cast<uint64_t>(m_options.sampleCount) * (i + 1) / jobCount);
+			Job& job = jobs.emplace_back();
+			job.region = glm::uvec4(0, 0, m_options.width, m_options.height);
+			job.firstSample = begin;
+			job.sampleCount = end - begin;
+		}
+	}
+	else
+	{
+		const uint32_t tileSize = m_options.tileSize;
+		for (uint32_t y = 0; y < m_options.height; y += tileSize)
+		{
+			for (uint32_t x = 0; x < m_options.width; x += tileSize)
+			{
+				Job& job = jobs.emplace_back();
+				job.region = glm::uvec4(x, y, std::min(tileSize, m_options.width - x), std::min(tileSize, m_options.height - y));
+				job.sampleCount = m_options.sampleCount;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < jobs.size(); i++)
+	{
+		std::ostringstream name;
+		name << "job_" << std::setw(4) << std::setfill('0') << i << ".partial";
+		jobs[i].partialPath = (std::filesystem::path(partialDirectory) / name.str()).string();
+		jobs[i].slot = static_cast<int>(i % slotCount);
+	}
+	return jobs;
+}
+
+std::vector<std::string> DistributedRenderer::GetWorkerArguments(const Slot& slot) const
+{
+	std::vector<std::string> arguments = { "--headless" };
+	arguments.insert(arguments.end(), m_options.sceneArguments.begin(), m_options.sceneArguments.end());
+	arguments.insert(arguments.end(), {
+		"--threads", std::to_string(m_threadsPerWorker),
+		"--jobs", slot.jobListPath
+	});
+	return arguments;
+}
+
+bool DistributedRenderer::RunJobs(const std::vector<Job>& jobs, std::vector<Slot>& slots) const
+{
+	const std::string executable = GetExecutablePath();
+	if (executable.empty())
+	{
+		std::cerr << "[DistributedRenderer] Can't find the path of this executable\n";
+		return false;
+	}
+
+	// Each worker gets its jobs in merge order, next to their partials
+	std::vector<std::vector<RenderJob>> slotJobs(slots.size());
+	for (const Job& job : jobs)
+	{
+		slotJobs[job.slot].push_back(job);
+	}
+
+	struct Running
+	{
+		WorkerProcess process;
+		Clock::time_point start;
+		bool exited = false;
+	};
+	std::vector<Running> workers(slots.size());
+
+	bool succeeded = true;
+	const std::filesystem::path partialDirectory = std::filesystem::path(jobs.front().partialPath).parent_path();
+	for (size_t s = 0; s < slots.size(); s++)
+	{
+		std::ostringstream name;
+		name << "worker_" << std::setw(2) << std::setfill('0') << s;
+		slots[s].jobListPath = (partialDirectory / (name.str() + ".jobs")).string();
+		const std::string logPath = (partialDirectory / (name.str() + ".log")).string();
+
+		workers[s].start = Clock::now();
+		if (!RenderJob::WriteList(slots[s].jobListPath, slotJobs[s]) ||
+			!workers[s].process.Start(executable, GetWorkerArguments(slots[s]), logPath))
+		{
+			std::cerr << "[DistributedRenderer] Failed to start worker " << s << "\n";
+			workers[s].exited = true;
+			succeeded = false;
+		}
+	}
+
+	size_t exitedWorkers = 0;
+	for (const Running& worker : workers)
+	{
+		exitedWorkers += worker.exited ? 1 : 0;
+	}
+	while (exitedWorkers < workers.size())
+	{
+		for (size_t s = 0; s < workers.size(); s++)
+		{
+			Running& worker = workers[s];
+			int exitCode = 0;
+			if (worker.exited || !worker.process.Poll(exitCode))
+			{
+				continue;
+			}
+
+			worker.exited = true;
+			exitedWorkers++;
+			slots[s].busyMs = MillisecondsSince(worker.start);
+			if (exitCode != 0)
+			{
+				std::cerr << "\n[DistributedRenderer] Worker " << s << " exited with code " << exitCode << ", see "
+					<< std::filesystem::path(slots[s].jobListPath).replace_extension(".log").string() << "\n";
+				succeeded = false;
+			}
+			std::cout << "\r[DistributedRenderer] Finished " << exitedWorkers << "/" << workers.size() << " workers" << std::flush;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	}
+	std::cout << "\n";
+	return succeeded;
+}
+
+bool DistributedRenderer::Merge(std::vector<Job>& jobs, std::vector<glm::vec4>& accumulation) const
+{
+	const uint32_t width = m_options.width;
+	accumulation.assign(static_cast<size_t>(width) * m_options.height, glm::vec4(0.0f));
+
+	// Always in job order, so sample range sums round the same way every run
+	for (Job& job : jobs)
+	{
+		RenderPartial partial;
+		if (!RenderPartial::Read(job.partialPath, partial))
+		{
+			return false;
+		}
+		if (partial.width != width || partial.height != m_options.height || partial.region != job.region ||
+			partial.firstSample != job.firstSample || partial.sampleCount != job.sampleCount)
+		{
+			std::cerr << "[DistributedRenderer] " << job.partialPath << " does not match its job\n";
+			return false;
+		}
+		job.renderMs = partial.renderMs;
+
+		const glm::uvec4 region = job.region;
+		for (uint32_t y = 0; y < region.w; y++)
+		{
+			glm::vec4* row = &accumulation[static_cast<size_t>(region.y + y) * width + region.x];
+			const glm::vec4* sums = &partial.sums[static_cast<size_t>(y) * region.z];
+			for (uint32_t x = 0; x < region.z; x++)
+			{
+				row[x] += sums[x];
+			}
+		}
+	}
+	return true;
+}
+
+void DistributedRenderer::PrintSummary(std::ostream& out, const std::vector<Job>& jobs, const std::vector<Slot>& slots,
+                                       const double renderMs, const double totalMs) const
+{
+	const double paths = static_cast<double>(m_options.width) * m_options.height * m_options.sampleCount;
+
+	double busiestMs = 0.0;
+	double totalBusyMs = 0.0;
+	for (const Slot& slot : slots)
+	{
+		busiestMs = std::max(busiestMs, slot.busyMs);
+		totalBusyMs += slot.busyMs;
+	}
+	const double meanBusyMs = totalBusyMs / static_cast<double>(slots.size());
+
+	out << std::fixed << std::setprecision(2);
+	out << "[DistributedRenderer] " << m_options.width << "x" << m_options.height << ", " << m_options.sampleCount << " spp, "
+		<< jobs.size() << (m_options.splitSamples ? " sample ranges" : " tiles") << " on " << slots.size() << " workers\n";
+	out << "  render:   " << std::setw(10) << renderMs << " ms (" << paths / (renderMs * 1000.0) << " Mpaths/s)\n";
+	out << "  total:    " << std::setw(10) << totalMs << " ms\n";
+	out << "  imbalance:" << std::setw(10) << (meanBusyMs > 0.0 ? busiestMs / meanBusyMs : 1.0) << " (busiest worker / mean)\n";
+	for (size_t s = 0; s < slots.size(); s++)
+	{
+		out << "  worker " << std::setw(2) << s << ": " << std::setw(4) << slots[s].jobCount << " jobs, "
+			<< std::setw(10) << slots[s].busyMs << " ms busy\n";
+	}
+	out << "  output:   " << m_options.outputPath << ", " << m_options.linearPath << "\n";
+	out << std::defaultfloat;
+}
+
+bool DistributedRenderer::WriteSummary(const std::string& path, const std::vector<Job>& jobs, const std::vector<Slot>& slots,
+                                       const double renderMs, const double totalMs) const
+{
+	std::ofstream file(path);
+	if (!file)
+	{
+		std::cerr << "[DistributedRenderer] Failed to write " << path << "\n";
+		return false;
+	}
+
+	const double paths = static_cast<double>(m_options.width) * m_options.height * m_options.sampleCount;
+	file << std::setprecision(6);
+	file << "{\n";
+	file << "  \"backend\": " << Quoted(OfflineRenderer::GetBackendName(m_options.backend)) << ",\n";
+	file << "  \"split\": " << Quoted(m_options.splitSamples ? "samples" : "tiles") << ",\n";
+	file << "  \"workers\": " << slots.size() << ",\n";
+	file << "  \"threads_per_worker\": " << m_threadsPerWorker << ",\n";
+	file << "  \"width\": " << m_options.width << ",\n";
+	file << "  \"height\": " << m_options.height << ",\n";
+	file << "  \"spp\": " << m_options.sampleCount << ",\n";
+	file << "  \"bounces\": " << m_options.renderSettings.bounces << ",\n";
+	file << "  \"tonemapper\": " << Quoted(Tonemapping::GetOperatorName(m_options.tonemapper)) << ",\n";
+	file << "  \"exposure\": " << m_options.exposure << ",\n";
+	file << "  \"output\": " << Quoted(m_options.outputPath) << ",\n";
+	file << "  \"linear\": " << Quoted(m_options.linearPath) << ",\n";
+	file << "  \"timings_ms\": {\n";
+	file << "    \"render\": " << renderMs << ",\n";
+	file << "    \"total\": " << totalMs << "\n";
+	file << "  },\n";
+	file << "  \"mpaths_per_s\": " << paths / (renderMs * 1000.0) << ",\n";
+	file << "  \"slots\": [";
+	for (size_t s = 0; s < slots.size(); s++)
+	{
+		file << (s == 0 ? "\n" : ",\n")
+			<< "    { \"jobs\": " << slots[s].jobCount << ", \"busy_ms\": " << slots[s].busyMs << " }";
+	}
+	file << "\n  ],\n";
+	file << "  \"jobs\": [";
+	for (size_t j = 0; j < jobs.size(); j++)
+	{
+		const Job& job = jobs[j];
+		const double jobPaths = static_cast<double>(job.region.z) * job.region.w * job.sampleCount;
+		file << (j == 0 ? "\n" : ",\n")
+			<< "    { \"region\": [" << job.region.x << ", " << job.region.y << ", " << job.region.z << ", " << job.region.w << "]"
+			<< ", \"first_sample\": " << job.firstSample << ", \"spp\": " << job.sampleCount << ", \"slot\": " << job.slot
+			<< ", \"render_ms\": " << job.renderMs
+			<< ", \"mpaths_per_s\": " << (job.renderMs > 0.0 ? jobPaths / (job.renderMs * 1000.0) : 0.0) << " }";
+	}
+	file << "\n  ]\n";
+	file << "}\n";
+	return static_cast<bool>(file);
+}
@@ -0,0 +1,659 @@
+#include "HeadlessRenderer.h"
+#include "Camera.h"
+#include "ImageIO.h"
+#include "DistributedRenderer.h"
+#include "Parallel.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <unordered_set>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	double MillisecondsSince(const Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	std::string ReplaceExtension(const std::string& path, const char* extension)
+	{
+		return std::filesystem::path(path).replace_extension(extension).string();
+	}
+
+	bool HasExtension(const std::string& path, const char* extension)
+	{
+		std::string actual = std::filesystem::path(path).extension().string();
+		for (auto& c : actual) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+		return actual == extension;
+	}
+
+	// Reads the values following argv[i], advancing i past them
+	template<typename T>
+	bool ReadValues(const int argc, char* argv[], int& i, T* values, const int count)
+	{
+		const char* name = argv[i];
+		if (i + count >= argc)
+		{
+			std::cerr << "[HeadlessRenderer] " << name << " expects " << count << (count == 1 ? " value\n" : " values\n");
+			return false;
+		}
+		for (int v = 0; v < count; v++)
+		{
+			std::istringstream stream(argv[++i]);
+			if (!(stream >> values[v]) || !stream.eof())
+			{
+				std::cerr << "[HeadlessRenderer] Invalid value for " << name << ": " << argv[i] << "\n";
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool ReadString(const int argc, char* argv[], int& i, std::string& value)
+	{
+		if (i + 1 >= argc)
+		{
+			std::cerr << "[HeadlessRenderer] " << argv[i] << " expects a value\n";
+			return false;
+		}
+		value = argv[++i];
+		return true;
+	}
+}
+
+bool HeadlessOptions::Parse(const int argc, char* argv[], HeadlessOptions& options)
+{
+	// Arguments that describe what to render, as opposed to how to split and store it
+	static const std::unordered_set<std::string> sceneArguments = {
+		"--debuglayer", "--model", "--hdri", "--camera-pos", "--camera-dir", "--fov", "--width", "--height",
+		"--bounces", "--sky-intensity", "--light-intensity", "--backend", "--adaptive", "--adaptive-min-spp", "--adaptive-interval",
+		"--sampler"
+	};
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const int first = i;
+		const std::string arg = argv[i];
+		bool ok = true;
+		bool isSceneArgument = sceneArguments.contains(arg);
+		if (arg == "--headless")
+		{
+			continue;
+		}
+		else if (arg == "--debuglayer")
+		{
+			options.debugLayer = true;
+		}
+		else if (arg == "--model")
+		{
+			options.modelPaths.emplace_back();
+			ok = ReadString(argc, argv, i, options.modelPaths.back());
+		}
+		else if (arg == "--hdri")
+		{
+			ok = ReadString(argc, argv, i, options.hdriPath);
+		}
+		else if (arg == "--camera-pos")
+		{
+			ok = ReadValues(argc, argv, i, &options.cameraPosition.x, 3);
+		}
+		else if (arg == "--camera-dir")
+		{
+			ok = ReadValues(argc, argv, i, &options.cameraDirection.x, 3);
+		}
+		else if (arg == "--fov")
+		{
+			ok = ReadValues(argc, argv, i, &options.fov, 1);
+		}
+		else if (arg == "--width")
+		{
+			ok = ReadValues(argc, argv, i, &options.width, 1);
+		}
+		else if (arg == "--height")
+		{
+			ok = ReadValues(argc, argv, i, &options.height, 1);
+		}
+		else if (arg == "--spp")
+		{
+			ok = ReadValues(argc, argv, i, &options.sampleCount, 1);
+		}
+		else if (arg == "--time")
+		{
+			ok = ReadValues(argc, argv, i, &options.timeBudget, 1);
+		}
+		else if (arg == "--bounces")
+		{
+			ok = ReadValues(argc, argv, i, &options.renderSettings.bounces, 1);
+		}
+		else if (arg == "--sky-intensity")
+		{
+			ok = ReadValues(argc, argv, i, &options.renderSettings.skyIntensity, 1);
+		}
+		else if (arg == "--light-intensity")
+		{
+			ok = ReadValues(argc, argv, i, &options.renderSettings.lightIntensity, 1);
+		}
+		else if (arg == "--adaptive")
+		{
+			options.renderSettings.adaptiveSampling = true;
+			ok = ReadValues(argc, argv, i, &options.renderSettings.adaptiveThreshold, 1);
+		}
+		else if (arg == "--adaptive-min-spp")
+		{
+			ok = ReadValues(argc, argv, i, &options.renderSettings.adaptiveMinSamples, 1);
+		}
+		else if (arg == "--adaptive-interval")
+		{
+			ok = ReadValues(argc, argv, i, &options.renderSettings.adaptiveInterval, 1);
+		}
+		else if (arg == "--sampler")
+		{
+			std::string name;
+			ok = ReadString(argc, argv, i, name);
+			if (ok && !RNG::ParseSequence(name, options.renderSettings.sequence))
+			{
+				std::cerr << "[HeadlessRenderer] Unknown sampler: " << name << "\n";
+				ok = false;
+			}
+		}
+		else if (arg == "--exposure")
+		{
+			ok = ReadValues(argc, argv, i, &options.exposure, 1);
+		}
+		else if (arg == "--tonemapper")
+		{
+			std::string name;
+			ok = ReadString(argc, argv, i, name);
+			if (ok && !Tonemapping::ParseOperator(name, options.tonemapper))
+			{
+				std::cerr << "[HeadlessRenderer] Unknown tonemapper: " << name << "\n";
+				ok = false;
+			}
+		}
+		else if (arg == "--output" || arg == "-o")
+		{
+			ok = ReadString(argc, argv, i, options.outputPath);
+		}
+		else if (arg == "--linear")
+		{
+			ok = ReadString(argc, argv, i, options.linearPath);
+		}
+		else if (arg == "--summary")
+		{
+			ok = ReadString(argc, argv, i, options.summaryPath);
+		}
+		else if (arg == "--features")
+		{
+			options.writeFeatures = true;
+		}
+		else if (arg == "--denoise")
+		{
+			options.denoise = true;
+		}
+		else if (arg == "--denoise-iterations")
+		{
+			ok = ReadValues(argc, argv, i, &options.denoiseSettings.iterations, 1);
+		}
+		else if (arg == "--backend")
+		{
+			std::string name;
+			ok = ReadString(argc, argv, i, name);
+			if (ok && !OfflineRenderer::ParseBackend(name, options.backend))
+			{
+				std::cerr << "[HeadlessRenderer] Unknown backend: " << name << "\n";
+				ok = false;
+			}
+		}
+		else if (arg == "--threads")
+		{
+			ok = ReadValues(argc, argv, i, &options.threadCount, 1);
+		}
+		else if (arg == "--workers")
+		{
+			ok = ReadValues(argc, argv, i, &options.workerCount, 1);
+		}
+		else if (arg == "--split")
+		{
+			std::string mode;
+			ok = ReadString(argc, argv, i, mode);
+			if (ok && (mode == "tiles" || mode == "samples"))
+			{
+				options.splitSamples = mode == "samples";
+			}
+			else if (ok)
+			{
+				std::cerr << "[HeadlessRenderer] Unknown split mode: " << mode << "\n";
+				ok = false;
+			}
+		}
+		else if (arg == "--tile-size")
+		{
+			ok = ReadValues(argc, argv, i, &options.tileSize, 1);
+		}
+		else if (arg == "--keep-partials")
+		{
+			options.keepPartials = true;
+		}
+		else if (arg == "--jobs")
+		{
+			ok = ReadString(argc, argv, i, options.jobListPath);
+		}
+		else if (HasExtension(arg, ".gltf") || HasExtension(arg, ".glb"))
+		{
+			options.modelPaths.push_back(arg);
+			isSceneArgument = true;
+		}
+		else if (HasExtension(arg, ".hdr"))
+		{
+			options.hdriPath = arg;
+			isSceneArgument = true;
+		}
+		else
+		{
+			std::cerr << "[HeadlessRenderer] Unknown argument: " << arg << "\n";
+			ok = false;
+		}
+
+		if (!ok)
+		{
+			return false;
+		}
+		if (isSceneArgument)
+		{
+			options.sceneArguments.insert(options.sceneArguments.end(), argv + first, argv + i + 1);
+		}
+	}
+
+	if (options.modelPaths.empty())
+	{
+		std::cerr << "[HeadlessRenderer] No model given\n";
+		return false;
+	}
+	if (options.width == 0 || options.height == 0)
+	{
+		std::cerr << "[HeadlessRenderer] Resolution has to be at least 1x1\n";
+		return false;
+	}
+	if (options.workerCount > 0 && (options.sampleCount == 0 || options.timeBudget > 0.0))
+	{
+		std::cerr << "[HeadlessRenderer] Distributed renders need a sample count and can't use a time budget\n";
+		return false;
+	}
+	if (options.workerCount > 0 && (options.writeFeatures || options.denoise))
+	{
+		std::cerr << "[HeadlessRenderer] Feature buffers aren't merged from workers, render them in a single process\n";
+		return false;
+	}
+	if (options.workerCount > 0 && options.tileSize == 0)
+	{
+		std::cerr << "[HeadlessRenderer] Tile size has to be at least 1\n";
+		return false;
+	}
+	if (options.sampleCount == 0 && options.timeBudget <= 0.0)
+	{
+		options.sampleCount = 64;
+	}
+	if (glm::length(options.cameraDirection) == 0.0f)
+	{
+		std::cerr << "[HeadlessRenderer] Camera direction can't be zero\n";
+		return false;
+	}
+	if (options.linearPath.empty())
+	{
+		options.linearPath = ReplaceExtension(options.outputPath, ".pfm");
+	}
+	if (options.summaryPath.empty())
+	{
+		options.summaryPath = ReplaceExtension(options.outputPath, ".json");
+	}
+	for (const auto& path : { options.outputPath, options.linearPath })
+	{
+		if (!ImageIO::IsSupported(path))
+		{
+			std::cerr << "[HeadlessRenderer] Unsupported output format: " << path << "\nPlease use .hdr, .pfm, .bmp or .ppm\n";
+			return false;
+		}
+	}
+	return true;
+}
+
+void HeadlessOptions::PrintUsage(std::ostream& out)
+{
+	out << "Usage: Kyra --headless <model.gltf|.glb>... [environment.hdr] [options]\n"
+		<< "  --model <path>              add a model, same as passing it directly\n"
+		<< "  --hdri <path>               environment map\n"
+		<< "  --camera-pos <x> <y> <z>    camera position (default 0 0 2)\n"
+		<< "  --camera-dir <x> <y> <z>    camera forward direction (default 0 0 -1)\n"
+		<< "  --fov <degrees>             field of view in degrees (default 60)\n"
+		<< "  --width <px> --height <px>  resolution (default 1920x1080)\n"
+		<< "  --spp <count>               samples per pixel (default 64 without --time)\n"
+		<< "  --time <seconds>            render time budget, stops at whichever limit comes first\n"
+		<< "  --bounces <count>           (default 2)\n"
+		<< "  --sky-intensity <value>     (default 1)\n"
+		<< "  --light-intensity <value>   (default 1)\n"
+		<< "  --adaptive <threshold>      stop tracing pixels once their relative error is below the threshold, e.g. 0.02\n"
+		<< "  --adaptive-min-spp <count>  samples before a pixel can converge (default 16)\n"
+		<< "  --adaptive-interval <count> samples between convergence checks (default 8)\n"
+		<< "  --sampler <name>            random or sobol (Owen-scrambled, per-pixel randomized) (default random)\n"
+		<< "  --tonemapper <name>         linear, aces, reinhard, agx or gt7 (default agx)\n"
+		<< "  --exposure <value>          (default 25)\n"
+		<< "  --output, -o <path>         tonemapped image, .bmp .ppm .hdr or .pfm (default render.bmp)\n"
+		<< "  --linear <path>             linear image (default output path with .pfm)\n"
+		<< "  --summary <path>            timing summary (default output path with .json)\n"
+		<< "  --features                  also write first hit albedo, normal, depth, motion and ID .pfm images\n"
+		<< "  --denoise                   run the a-trous denoiser over the render before writing it\n"
+		<< "  --denoise-iterations <n>    1 to 5, the filter footprint doubles with each (default 5)\n"
+		<< "  --backend <auto|gpu|cpu>    auto uses the GPU when DXR is supported (default auto)\n"
+		<< "  --debuglayer                enable the D3D12 debug layer\n"
+		<< "  --threads <count>           CPU threads of this process (default all)\n"
+		<< "  --workers <count>           split the render over worker processes and merge their results\n"
+		<< "  --split <tiles|samples>     tiles match a single process render bit for bit, samples also work on the GPU (default tiles)\n"
+		<< "  --tile-size <px>            (default 256)\n"
+		<< "  --keep-partials             keep the worker results next to the output\n";
+}
+
+HeadlessRenderer::HeadlessRenderer(HeadlessOptions options)
+	: m_options(std::move(options))
+{
+}
+
+HeadlessRenderer::~HeadlessRenderer() = default;
+
+bool HeadlessRenderer::IsRequested(const int argc, char* argv[])
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--headless") == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+int HeadlessRenderer::Run()
+{
+	Timings timings;
+	const auto startTime = Clock::now();
+	g_workerCountLimit = m_options.threadCount;
+
+	auto stepStart = Clock::now();
+	m_renderer = OfflineRenderer::Create(m_options.backend, m_options.debugLayer);
+	if (!m_renderer)
+	{
+		return 1;
+	}
+	timings.setupMs = MillisecondsSince(stepStart);
+	std::cout << "[HeadlessRenderer] Backend: " << m_renderer->GetName() << "\n";
+
+	stepStart = Clock::now();
+	for (const auto& path : m_options.modelPaths)
+	{
+		if (!m_renderer->LoadModel(path))
+		{
+			std::cerr << "[HeadlessRenderer] Failed to load model: " << path << "\n";
+			return 1;
+		}
+	}
+	if (!m_options.hdriPath.empty() && !m_renderer->LoadHDRI(m_options.hdriPath))
+	{
+		std::cerr << "[HeadlessRenderer] Failed to load HDRI: " << m_options.hdriPath << "\n";
+		return 1;
+	}
+	timings.loadMs = MillisecondsSince(stepStart);
+
+	if (!m_options.jobListPath.empty())
+	{
+		return RunJobs(timings, startTime);
+	}
+
+	stepStart = Clock::now();
+	m_renderer->Reset(m_options.width, m_options.height, 0);
+	timings.resetMs = MillisecondsSince(stepStart);
+
+	Camera camera;
+	camera.SetPosition(m_options.cameraPosition);
+	camera.SetDirection(m_options.cameraDirection);
+	camera.m_fov = m_options.fov;
+
+	stepStart = Clock::now();
+	const double budgetMs = m_options.timeBudget * 1000.0;
+	while (true)
+	{
+		const uint32_t samples = m_renderer->GetSampleCount();
+		if (m_options.sampleCount > 0 && samples >= m_options.sampleCount) break;
+		if (budgetMs > 0.0 && samples > 0 && MillisecondsSince(stepStart) >= budgetMs) break;
+
+		m_renderer->RenderSample(camera, m_options.renderSettings);
+		std::cout << "\r[HeadlessRenderer] Sample " << m_renderer->GetSampleCount() << std::flush;
+	}
+	timings.renderMs = MillisecondsSince(stepStart);
+	std::cout << "\n";
+
+	stepStart = Clock::now();
+	std::vector<glm::vec4> accumulation = m_renderer->ReadAccumulation();
+	FeatureBuffers features;
+	if (m_options.writeFeatures || m_options.denoise)
+	{
+		features = m_renderer->ReadFeatures();
+	}
+	timings.readbackMs = MillisecondsSince(stepStart);
+	m_pathCount = 0.0;
+	for (const glm::vec4& pixel : accumulation)
+	{
+		m_pathCount += pixel.w;
+	}
+
+	if (m_options.denoise)
+	{
+		stepStart = Clock::now();
+		accumulation = Denoiser::Denoise(accumulation, features, m_options.width, m_options.height, m_options.denoiseSettings);
+		timings.denoiseMs = MillisecondsSince(stepStart);
+	}
+
+	stepStart = Clock::now();
+	bool written = ImageIO::Write(m_options.outputPath, m_options.width, m_options.height,
+	                              Tonemapping::Resolve(accumulation, m_options.tonemapper, m_options.exposure));
+	written &= ImageIO::Write(m_options.linearPath, m_options.width, m_options.height,
+	                          Tonemapping::ResolveLinear(accumulation));
+	if (m_options.writeFeatures)
+	{
+		written &= WriteFeatures(accumulation, features);
+	}
+	timings.writeMs = MillisecondsSince(stepStart);
+	timings.totalMs = MillisecondsSince(startTime);
+
+	PrintSummary(std::cout, timings);
+	written &= WriteSummary(m_options.summaryPath, timings);
+
+	return written ? 0 : 1;
+}
+
+int HeadlessRenderer::RunJobs(Timings& timings, const Clock::time_point startTime)
+{
+	std::vector<RenderJob> jobs;
+	if (!RenderJob::ReadList(m_options.jobListPath, jobs))
+	{
+		return 1;
+	}
+
+	Camera camera;
+	camera.SetPosition(m_options.cameraPosition);
+	camera.SetDirection(m_options.cameraDirection);
+	camera.m_fov = m_options.fov;
+
+	// The scene stays loaded, only the accumulation is reset between jobs
+	for (size_t j = 0; j < jobs.size(); j++)
+	{
+		const RenderJob& job = jobs[j];
+		auto stepStart = Clock::now();
+		m_renderer->Reset(m_options.width, m_options.height, job.firstSample);
+		if (!m_renderer->SetRegion(job.region.x, job.region.y, job.region.z, job.region.w))
+		{
+			return 1;
+		}
+		timings.resetMs += MillisecondsSince(stepStart);
+
+		stepStart = Clock::now();
+		while (m_renderer->GetSampleCount() < job.sampleCount)
+		{
+			m_renderer->RenderSample(camera, m_options.renderSettings);
+		}
+		const double renderMs = MillisecondsSince(stepStart);
+		timings.renderMs += renderMs;
+
+		stepStart = Clock::now();
+		const std::vector<glm::vec4> accumulation = m_renderer->ReadAccumulation();
+		timings.readbackMs += MillisecondsSince(stepStart);
+		for (const glm::vec4& pixel : accumulation)
+		{
+			m_pathCount += pixel.w;
+		}
+
+		stepStart = Clock::now();
+		const RenderPartial partial = RenderPartial::FromAccumulation(accumulation, m_options.width, m_options.height, job.region,
+		                                                              job.firstSample, m_renderer->GetSampleCount(), renderMs);
+		if (!partial.Write(job.partialPath))
+		{
+			return 1;
+		}
+		timings.writeMs += MillisecondsSince(stepStart);
+		std::cout << "[HeadlessRenderer] Job " << j + 1 << "/" << jobs.size() << " done in " << renderMs << " ms\n";
+	}
+	timings.totalMs = MillisecondsSince(startTime);
+
+	PrintSummary(std::cout, timings);
+	return 0;
+}
+
+void HeadlessRenderer::PrintSummary(std::ostream& out, const Timings& timings) const
+{
+	const uint32_t samples = m_renderer->GetSampleCount();
+
+	out << std::fixed << std::setprecision(2);
+	out << "[HeadlessRenderer] " << m_options.width << "x" << m_options.height << ", " << samples << " spp on " << m_renderer->GetName() << "\n";
+	out << "  setup:    " << std::setw(10) << timings.setupMs << " ms\n";
+	out << "  load:     " << std::setw(10) << timings.loadMs << " ms\n";
+	out << "  reset:    " << std::setw(10) << timings.resetMs << " ms\n";
+	out << "  render:   " << std::setw(10) << timings.renderMs << " ms";
+	if (samples > 0)
+	{
+		out << " (" << timings.renderMs / samples << " ms/sample, "
+			<< m_pathCount / (timings.renderMs * 1000.0) << " Mpaths/s)";
+	}
+	out << "\n";
+	if (m_options.renderSettings.adaptiveSampling)
+	{
+		const double pixels = static_cast<double>(m_options.width) * m_options.height;
+		out << "  adaptive: " << std::setw(10) << m_pathCount / pixels << " spp on average\n";
+	}
+	out << "  readback: " << std::setw(10) << timings.readbackMs << " ms\n";
+	if (m_options.denoise)
+	{
+		out << "  denoise:  " << std::setw(10) << timings.denoiseMs << " ms\n";
+	}
+	out << "  write:    " << std::setw(10) << timings.writeMs << " ms\n";
+	out << "  total:    " << std::setw(10) << timings.totalMs << " ms\n";
+	if (m_options.jobListPath.empty())
+	{
+		out << "  output:   " << m_options.outputPath << ", " << m_options.linearPath << "\n";
+	}
+	else
+	{
+		out << "  jobs:     " << m_options.jobListPath << "\n";
+	}
+	out << std::defaultfloat;
+}
+
+bool HeadlessRenderer::WriteFeatures(const std::vector<glm::vec4>& accumulation, const FeatureBuffers& features) const
+{
+	const size_t pixelCount = accumulation.size();
+	if (features.albedo.size() != pixelCount || features.normalDepth.size() != pixelCount ||
+	    features.motion.size() != pixelCount || features.ids.size() != pixelCount)
+	{
+		std::cerr << "[HeadlessRenderer] Feature buffers don't match the accumulation\n";
+		return false;
+	}
+
+	std::vector<glm::vec3> albedo(pixelCount), normal(pixelCount), depth(pixelCount), motion(pixelCount), ids(pixelCount);
+	for (size_t i = 0; i < pixelCount; i++)
+	{
+		const float sampleCount = std::max(accumulation[i].w, 1.0f);
+		albedo[i] = glm::vec3(features.albedo[i]) / sampleCount;
+		normal[i] = glm::vec3(features.normalDepth[i]) / sampleCount;
+		depth[i] = glm::vec3(features.normalDepth[i].w / sampleCount);
+		motion[i] = glm::vec3(features.motion[i], 0.0f);
+		// Misses are stored as -1
+		ids[i] = glm::vec3(features.ids[i].x == INVALID_FEATURE_ID ? -1.0f : static_cast<float>(features.ids[i].x),
+		                   features.ids[i].y == INVALID_FEATURE_ID ? -1.0f : static_cast<float>(features.ids[i].y), 0.0f);
+	}
+
+	const std::filesystem::path output(m_options.outputPath);
+	auto featurePath = [&](const char* name)
+	{
+		return (output.parent_path() / (output.stem().string() + "_" + name + ".pfm")).string();
+	};
+
+	bool written = true;
+	written &= ImageIO::Write(featurePath("albedo"), m_options.width, m_options.height, albedo);
+	written &= ImageIO::Write(featurePath("normal"), m_options.width, m_options.height, normal);
+	written &= ImageIO::Write(featurePath("depth"), m_options.width, m_options.height, depth);
+	written &= ImageIO::Write(featurePath("motion"), m_options.width, m_options.height, motion);
+	written &= ImageIO::Write(featurePath("ids"), m_options.width, m_options.height, ids);
+	return written;
+}
+
+bool HeadlessRenderer::WriteSummary(const std::string& path, const Timings& timings) const
+{
+	std::ofstream file(path);
+	if (!file)
+	{
+		std::cerr << "[HeadlessRenderer] Failed to write " << path << "\n";
+		return false;
+	}
+
+	auto quoted = [](const std::string& s)
+	{
+		std::ostringstream out;
+		out << std::quoted(s);
+		return out.str();
+	};
+
+	const uint32_t samples = m_renderer->GetSampleCount();
+	file << std::setprecision(6);
+	file << "{\n";
+	file << "  \"backend\": " << quoted(OfflineRenderer::GetBackendName(m_renderer->GetBackend())) << ",\n";
+	file << "  \"device\": " << quoted(m_renderer->GetName()) << ",\n";
+	file << "  \"width\": " << m_options.width << ",\n";
+	file << "  \"height\": " << m_options.height << ",\n";
+	file << "  \"spp\": " << samples << ",\n";
+	file << "  \"average_spp\": " << m_pathCount / (static_cast<double>(m_options.width) * m_options.height) << ",\n";
+	file << "  \"adaptive_threshold\": " << (m_options.renderSettings.adaptiveSampling ? m_options.renderSettings.adaptiveThreshold : 0.0f) << ",\n";
+	file << "  \"bounces\": " << m_options.renderSettings.bounces << ",\n";
+	file << "  \"sampler\": " << quoted(RNG::GetSequenceName(m_options.renderSettings.sequence)) << ",\n";
+	file << "  \"tonemapper\": " << quoted(Tonemapping::GetOperatorName(m_options.tonemapper)) << ",\n";
+	file << "  \"exposure\": " << m_options.exposure << ",\n";
+	file << "  \"denoise_iterations\": " << (m_options.denoise ? m_options.denoiseSettings.iterations : 0) << ",\n";
+	file << "  \"output\": " << quoted(m_options.outputPath) << ",\n";
+	file << "  \"linear\": " << quoted(m_options.linearPath) << ",\n";
+	file << "  \"timings_ms\": {\n";
+	file << "    \"setup\": " << timings.setupMs << ",\n";
+	file << "    \"load\": " << timings.loadMs << ",\n";
+	file << "    \"reset\": " << timings.resetMs << ",\n";
+	file << "    \"render\": " << timings.renderMs << ",\n";
+	file << "    \"per_sample\": " << (samples > 0 ? timings.renderMs / samples : 0.0) << ",\n";
+	file << "    \"readback\": " << timings.readbackMs << ",\n";
+	file << "    \"denoise\": " << timings.denoiseMs << ",\n";
+	file << "    \"write\": " << timings.writeMs << ",\n";
+	file << "    \"total\": " << timings.totalMs << "\n";
+	file << "  }\n";
+	file << "}\n";
+	return static_cast<bool>(file);
+}
@@ -0,0 +1,62 @@
+#include "OfflineRenderer.h"
+#include "CPUOfflineRenderer.h"
+
+#include <iostream>
+
+#ifdef _WIN32
+#include "GPUOfflineRenderer.h"
+#include "Device.h"
+#endif
+
+std::unique_ptr<OfflineRenderer> OfflineRenderer::Create(OfflineBackend backend, const bool debug)
+{
+#ifdef _WIN32
+	const bool gpuSupported = backend != OfflineBackend::CPU && Device::IsRaytracingSupported();
+#else
+	// DXR only, the CPU reference renders everywhere else
+	const bool gpuSupported = false;
+#endif
+	if (backend == OfflineBackend::Auto)
+	{
+		backend = gpuSupported ? OfflineBackend::GPU : OfflineBackend::CPU;
+		if (!gpuSupported)
+		{
+			std::cout << "[OfflineRenderer] No raytracing capable GPU found, using the CPU reference\n";
+		}
+	}
+
+	if (backend == OfflineBackend::CPU)
+	{
+		return std::make_unique<CPUOfflineRenderer>();
+	}
+	if (!gpuSupported)
+	{
+		std::cerr << "[OfflineRenderer] GPU backend requested but no raytracing capable GPU was found\n";
+		return nullptr;
+	}
+#ifdef _WIN32
+	return std::make_unique<GPUOfflineRenderer>(debug);
+#else
+	static_cast<void>(debug);
+	return nullptr;
+#endif
+}
+
+bool OfflineRenderer::ParseBackend(const std::string& name, OfflineBackend& backend)
+{
+	if (name == "auto") backend = OfflineBackend::Auto;
+	else if (name == "gpu") backend = OfflineBackend::GPU;
+	else if (name == "cpu") backend = OfflineBackend::CPU;
+	else return false;
+	return true;
+}
+
+const char* OfflineRenderer::GetBackendName(const OfflineBackend backend)
+{
+	switch (backend)
+	{
+	case OfflineBackend::GPU: return "gpu";
+	case OfflineBackend::CPU: return "cpu";
+	default: return "auto";
+	}
+}
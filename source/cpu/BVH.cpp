@@ -0,0 +1,253 @@
+#include "BVH.h"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+namespace
+{
+    constexpr uint32_t MAX_BINS = 64;
+
+    struct Bin
+    {
+        AABB bounds;
+        uint32_t count = 0;
+    };
+
+    uint32_t GetBinIndex(float centroid, float boundsMin, float scale, uint32_t binCount)
+    {
+        return std::min(binCount - 1, static_cast<uint32_t>(std::max(0.0f, (centroid - boundsMin) * scale)));
+    }
+}
+
+void BVH::Build(const std::vector<AABB>& primitiveBounds, const BVHBuildSettings& settings)
+{
+    m_settings = settings;
+    m_settings.binCount = std::clamp(m_settings.binCount, 2u, MAX_BINS);
+    m_settings.maxLeafSize = std::max(m_settings.maxLeafSize, 1u);
+
+    const uint32_t primCount = static_cast<uint32_t>(primitiveBounds.size());
+    m_nodes.clear();
+    m_buildCost = 0.0f;
+    m_primIndices.resize(primCount);
+    std::iota(m_primIndices.begin(), m_primIndices.end(), 0u);
+    if (primCount == 0) return;
+
+    std::vector<glm::vec3> centroids(primCount);
+    for (uint32_t i = 0; i < primCount; i++)
+    {
+        centroids[i] = primitiveBounds[i].Centroid();
+    }
+
+    m_nodes.reserve(primCount * 2 - 1);
+    m_nodes.push_back({ glm::vec3(0.0f), 0, glm::vec3(0.0f), primCount });
+    UpdateNodeBounds(0, primitiveBounds);
+
+    struct BuildTask
+    {
+        uint32_t nodeIndex;
+        uint32_t depth;
+    };
+    std::vector<BuildTask> tasks = { { 0, 1 } };
+
+    while (!tasks.empty())
+    {
+        BuildTask task = tasks.back();
+        tasks.pop_back();
+
+        BVHNode node = m_nodes[task.nodeIndex];
+        if (node.primCount <= 1 || task.depth >= BVH_MAX_DEPTH) continue;
+
+        Split split = FindBestSplit(node, centroids, primitiveBounds);
+        if (split.axis < 0) continue; // all centroids coincide, nothing to split on
+
+        AABB nodeBounds{ node.aabbMin, node.aabbMax };
+        float leafCost = m_settings.intersectionCost * static_cast<float>(node.primCount) * nodeBounds.SurfaceArea();
+        bool mustSplit = node.primCount > m_settings.maxLeafSize;
+        if (split.cost >= leafCost && !mustSplit) continue;
+
+        // Partition the primitive range around the chosen bin boundary
+        auto first = m_primIndices.begin() + node.leftFirst;
+        auto last = first + node.primCount;
+        auto middle = std::partition(first, last, [&](uint32_t prim)
+        {
+            return GetBinIndex(centroids[prim][split.axis], split.centroidMin, split.scale, m_settings.binCount) < split.bin;
+        });
+
+        uint32_t leftCount = static_cast<uint32_t>(middle - first);
+        if (leftCount == 0 || leftCount == node.primCount) continue;
+
+        uint32_t leftIndex = static_cast<uint32_t>(m_nodes.size());
+        m_nodes.push_back({ glm::vec3(0.0f), node.leftFirst, glm::vec3(0.0f), leftCount });
+        m_nodes.push_back({ glm::vec3(0.0f), node.leftFirst + leftCount, glm::vec3(0.0f), node.primCount - leftCount });
+        UpdateNodeBounds(leftIndex, primitiveBounds);
+        UpdateNodeBounds(leftIndex + 1, primitiveBounds);
+
+        m_nodes[task.nodeIndex].leftFirst = leftIndex;
+        m_nodes[task.nodeIndex].primCount = 0;
+
+        tasks.push_back({ leftIndex, task.depth + 1 });
+        tasks.push_back({ leftIndex + 1, task.depth + 1 });
+    }
+
+    m_nodes.shrink_to_fit();
+    m_buildCost = ComputeSAHCost(m_settings.traversalCost, m_settings.intersectionCost);
+}
+
+void BVH::Refit(const std::vector<AABB>& primitiveBounds)
+{
+    // Children are always allocated after their parent, so a reverse sweep visits them first
+    for (int32_t i = static_cast<int32_t>(m_nodes.size()) - 1; i >= 0; i--)
+    {
+        BVHNode& node = m_nodes[i];
+        if (node.IsLeaf())
+        {
+            UpdateNodeBounds(i, primitiveBounds);
+            continue;
+        }
+
+        const BVHNode& left = m_nodes[node.leftFirst];
+        const BVHNode& right = m_nodes[node.leftFirst + 1];
+        node.aabbMin = glm::min(left.aabbMin, right.aabbMin);
+        node.aabbMax = glm::max(left.aabbMax, right.aabbMax);
+    }
+}
+
+bool BVH::Update(const std::vector<AABB>& primitiveBounds, BVHUpdateMode mode)
+{
+    if (mode == BVHUpdateMode::Rebuild || m_primIndices.size() != primitiveBounds.size())
+    {
+        Build(primitiveBounds, m_settings);
+        return true;
+    }
+
+    Refit(primitiveBounds);
+    if (mode == BVHUpdateMode::Auto &&
+        ComputeSAHCost(m_settings.traversalCost, m_settings.intersectionCost) > m_buildCost * m_settings.rebuildThreshold)
+    {
+        Build(primitiveBounds, m_settings);
+        return true;
+    }
+    return false;
+}
+
+void BVH::UpdateNodeBounds(uint32_t nodeIndex, const std::vector<AABB>& primitiveBounds)
+{
+    BVHNode& node = m_nodes[nodeIndex];
+    AABB bounds;
+    for (uint32_t i = 0; i < node.primCount; i++)
+    {
+        bounds.Grow(primitiveBounds[m_primIndices[node.leftFirst + i]]);
+    }
+    node.aabbMin = bounds.min;
+    node.aabbMax = bounds.max;
+}
+
+BVH::Split BVH::FindBestSplit(const BVHNode& node, const std::vector<glm::vec3>& centroids,
+                              const std::vector<AABB>& primitiveBounds) const
+{
+    AABB centroidBounds;
+    for (uint32_t i = 0; i < node.primCount; i++)
+    {
+        centroidBounds.Grow(centroids[m_primIndices[node.leftFirst + i]]);
+    }
+
+    const uint32_t binCount = m_settings.binCount;
+    const float nodeArea = AABB{ node.aabbMin, node.aabbMax }.SurfaceArea();
+
+    Split best;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        float boundsMin = centroidBounds.min[axis];
+        float extent = centroidBounds.max[axis] - boundsMin;
+        if (extent <= 0.0f) continue;
+
+        float scale = static_cast<float>(binCount) / extent;
+        std::array<Bin, MAX_BINS> bins{};
+        for (uint32_t i = 0; i < node.primCount; i++)
+        {
+            uint32_t prim = m_primIndices[node.leftFirst + i];
+            Bin& bin = bins[GetBinIndex(centroids[prim][axis], boundsMin, scale, binCount)];
+            bin.count++;
+            bin.bounds.Grow(primitiveBounds[prim]);
+        }
+
+        // Sweep from both sides, leftArea[i]/leftCount[i] describe bins [0, i]
+        std::array<float, MAX_BINS> leftArea{}, rightArea{};
+        std::array<uint32_t, MAX_BINS> leftCount{}, rightCount{};
+        AABB leftBox, rightBox;
+        uint32_t leftSum = 0, rightSum = 0;
+        for (uint32_t i = 0; i < binCount - 1; i++)
+        {
+            leftSum += bins[i].count;
+            leftBox.Grow(bins[i].bounds);
+            leftCount[i] = leftSum;
+            leftArea[i] = leftBox.SurfaceArea();
+
+            rightSum += bins[binCount - 1 - i].count;
+            rightBox.Grow(bins[binCount - 1 - i].bounds);
+            rightCount[binCount - 2 - i] = rightSum;
+            rightArea[binCount - 2 - i] = rightBox.SurfaceArea();
+        }
+
+        for (uint32_t i = 0; i < binCount - 1; i++)
+        {
+            if (leftCount[i] == 0 || rightCount[i] == 0) continue;
+            float cost = m_settings.traversalCost * nodeArea + m_settings.intersectionCost *
+                (leftArea[i] * static_cast<float>(leftCount[i]) + rightArea[i] * static_cast<float>(rightCount[i]));
+            if (cost < best.cost)
+            {
+                best.cost = cost;
+                best.axis = axis;
+                best.bin = i + 1;
+                best.centroidMin = boundsMin;
+                best.scale = scale;
+            }
+        }
+    }
+    return best;
+}
+
+float BVH::ComputeSAHCost(float traversalCost, float intersectionCost) const
+{
+    if (m_nodes.empty()) return 0.0f;
+
+    float rootArea = GetBounds().SurfaceArea();
+    if (rootArea <= 0.0f) return intersectionCost * static_cast<float>(m_primIndices.size());
+
+    float cost = 0.0f;
+    for (const BVHNode& node : m_nodes)
+    {
+        float area = AABB{ node.aabbMin, node.aabbMax }.SurfaceArea();
+        cost += node.IsLeaf() ? intersectionCost * static_cast<float>(node.primCount) * area : traversalCost * area;
+    }
+    return cost / rootArea;
+}
+
+uint32_t BVH::ComputeMaxDepth() const
+{
+    if (m_nodes.empty()) return 0;
+
+    uint32_t maxDepth = 0;
+    std::vector<std::pair<uint32_t, uint32_t>> stack = { { 0, 1 } };
+    while (!stack.empty())
+    {
+        auto [nodeIndex, depth] = stack.back();
+        stack.pop_back();
+        maxDepth = std::max(maxDepth, depth);
+
+        const BVHNode& node = m_nodes[nodeIndex];
+        if (!node.IsLeaf())
+        {
+            stack.push_back({ node.leftFirst, depth + 1 });
+            stack.push_back({ node.leftFirst + 1, depth + 1 });
+        }
+    }
+    return maxDepth;
+}
+
+AABB BVH::GetBounds() const
+{
+    if (m_nodes.empty()) return {};
+    return { m_nodes[0].aabbMin, m_nodes[0].aabbMax };
+}
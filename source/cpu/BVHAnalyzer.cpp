@@ -0,0 +1,317 @@
+#include "BVHAnalyzer.h"
+#include "Parallel.h"
+#include "RNG.h"
+#include "Sampling.h"
+#include "PinholeCamera.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <numeric>
+
+namespace
+{
+    struct MeshAccumulator
+    {
+        uint64_t rayEntries = 0;
+        TraversalStats traversal;
+    };
+
+    void Merge(BVHAnalyzer::RayReport& target, const BVHAnalyzer::RayReport& source)
+    {
+        target.rayCount += source.rayCount;
+        target.hitCount += source.hitCount;
+        target.topLevel += source.topLevel;
+        target.bottomLevel += source.bottomLevel;
+    }
+
+    // Two level traversal like SceneBVH::Intersect, but attributing bottom level work to each mesh
+    bool TraceRay(const SceneBVH& bvh, Ray& ray, Hit& hit, BVHAnalyzer::RayReport& rays, std::vector<MeshAccumulator>& meshStats)
+    {
+        bool found = false;
+        bvh.GetTopLevel().Traverse(ray, [&](uint32_t instanceIndex, Ray& r)
+        {
+            const BVHInstance& instance = bvh.GetInstances()[instanceIndex];
+            Ray localRay = SceneBVH::ToObjectSpace(r, instance);
+            TraversalStats stats;
+            if (bvh.GetMeshes()[instance.meshIndex].Intersect(localRay, hit, &stats))
+            {
+                r.tMax = localRay.tMax;
+                hit.instanceIndex = instanceIndex;
+                found = true;
+            }
+            meshStats[instance.meshIndex].rayEntries++;
+            meshStats[instance.meshIndex].traversal += stats;
+            rays.bottomLevel += stats;
+        }, &rays.topLevel);
+
+        rays.rayCount++;
+        if (found) rays.hitCount++;
+        return found;
+    }
+
+    double PerRay(uint64_t value, uint64_t rayCount)
+    {
+        return rayCount > 0 ? static_cast<double>(value) / static_cast<double>(rayCount) : 0.0;
+    }
+
+    void PrintRays(std::ostream& out, const char* label, const BVHAnalyzer::RayReport& rays)
+    {
+        out << "[BVHAnalyzer] " << label << ": " << rays.rayCount << " rays, "
+            << std::setprecision(1) << 100.0 * PerRay(rays.hitCount, rays.rayCount) << "% hit, per ray: "
+            << std::setprecision(2)
+            << PerRay(rays.topLevel.nodeVisits, rays.rayCount) << " top nodes, "
+            << PerRay(rays.topLevel.primitiveTests, rays.rayCount) << " instances, "
+            << PerRay(rays.bottomLevel.nodeVisits, rays.rayCount) << " bottom nodes, "
+            << PerRay(rays.bottomLevel.primitiveTests, rays.rayCount) << " triangle tests\n";
+    }
+}
+
+BVHAnalyzer::Report BVHAnalyzer::Analyze(const std::vector<CPUInstance>& instances, const Camera& camera,
+                                         float aspectRatio, const BVHAnalyzerSettings& settings)
+{
+    Report report;
+    report.reportedMeshes = settings.reportedMeshes;
+    report.instanceCount = static_cast<uint32_t>(instances.size());
+
+    auto buildStart = std::chrono::steady_clock::now();
+    SceneBVH bvh;
+    bvh.Build(instances, settings.build);
+    report.buildTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+
+    const BVHBuildSettings& build = settings.build;
+    const auto& meshes = bvh.GetMeshes();
+    const auto& bvhInstances = bvh.GetInstances();
+
+    // Static per-mesh statistics
+    report.meshes.resize(meshes.size());
+    for (size_t i = 0; i < bvhInstances.size(); i++)
+    {
+        MeshReport& mesh = report.meshes[bvhInstances[i].meshIndex];
+        if (mesh.instanceCount++ == 0) mesh.name = instances[i].name;
+    }
+    ParallelFor(static_cast<uint32_t>(meshes.size()), [&](uint32_t i, uint32_t)
+    {
+        const BVH& meshBVH = meshes[i].GetBVH();
+        MeshReport& mesh = report.meshes[i];
+        mesh.triangleCount = meshes[i].GetTriangleCount();
+        mesh.nodeCount = static_cast<uint32_t>(meshBVH.GetNodes().size());
+        mesh.maxDepth = meshBVH.ComputeMaxDepth();
+        mesh.sahCost = meshBVH.ComputeSAHCost(build.traversalCost, build.intersectionCost);
+
+        for (const BVHNode& node : meshBVH.GetNodes())
+        {
+            if (!node.IsLeaf()) continue;
+            mesh.leafCount++;
+            mesh.leafHistogram[std::min<uint32_t>(node.primCount, 8) - 1]++;
+        }
+
+        float rootArea = meshBVH.GetBounds().SurfaceArea();
+        if (rootArea > 0.0f)
+        {
+            float triangleArea = 0.0f;
+            for (uint32_t t = 0; t < mesh.triangleCount; t++)
+            {
+                const glm::vec3* v = meshes[i].GetTriangle(t);
+                AABB bounds;
+                bounds.Grow(v[0]);
+                bounds.Grow(v[1]);
+                bounds.Grow(v[2]);
+                triangleArea += bounds.SurfaceArea();
+            }
+            mesh.triangleOverlap = triangleArea / rootArea;
+        }
+    });
+
+    // Top level statistics
+    const BVH& topLevel = bvh.GetTopLevel();
+    report.topNodeCount = static_cast<uint32_t>(topLevel.GetNodes().size());
+    report.topMaxDepth = topLevel.ComputeMaxDepth();
+    report.topSAHCost = topLevel.ComputeSAHCost(build.traversalCost, build.intersectionCost);
+
+    float sceneArea = topLevel.GetBounds().SurfaceArea();
+    if (sceneArea > 0.0f)
+    {
+        // Whole-scene cost: the top level with every instance leaf replaced by the cost of its mesh,
+        // weighted by the probability of a ray entering the instance bounds
+        float cost = 0.0f;
+        uint32_t interiorCount = 0;
+        float overlapSum = 0.0f;
+        for (const BVHNode& node : topLevel.GetNodes())
+        {
+            AABB bounds{ node.aabbMin, node.aabbMax };
+            if (node.IsLeaf())
+            {
+                for (uint32_t i = 0; i < node.primCount; i++)
+                {
+                    const BVHInstance& instance = bvhInstances[topLevel.GetPrimitiveIndices()[node.leftFirst + i]];
+                    cost += instance.worldBounds.SurfaceArea() * report.meshes[instance.meshIndex].sahCost;
+                }
+                continue;
+            }
+
+            cost += build.traversalCost * bounds.SurfaceArea();
+
+            const BVHNode& left = topLevel.GetNodes()[node.leftFirst];
+            const BVHNode& right = topLevel.GetNodes()[node.leftFirst + 1];
+            float overlap = AABB::Intersection({ left.aabbMin, left.aabbMax }, { right.aabbMin, right.aabbMax }).SurfaceArea();
+            float ratio = bounds.SurfaceArea() > 0.0f ? overlap / bounds.SurfaceArea() : 0.0f;
+            overlapSum += ratio;
+            report.maxSiblingOverlap = std::max(report.maxSiblingOverlap, ratio);
+            interiorCount++;
+        }
+        report.sceneSAHCost = cost / sceneArea;
+        report.averageSiblingOverlap = interiorCount > 0 ? overlapSum / static_cast<float>(interiorCount) : 0.0f;
+
+        float instanceArea = 0.0f;
+        for (const BVHInstance& instance : bvhInstances)
+        {
+            instanceArea += instance.worldBounds.SurfaceArea();
+        }
+        report.instanceAreaRatio = instanceArea / sceneArea;
+    }
+
+    // Pairwise instance overlap, sweep and prune along x
+    std::vector<uint32_t> order(bvhInstances.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+    {
+        return bvhInstances[a].worldBounds.min.x < bvhInstances[b].worldBounds.min.x;
+    });
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        const AABB& a = bvhInstances[order[i]].worldBounds;
+        for (size_t j = i + 1; j < order.size(); j++)
+        {
+            const AABB& b = bvhInstances[order[j]].worldBounds;
+            if (b.min.x > a.max.x) break;
+            if (AABB::Intersection(a, b).IsValid()) report.overlappingInstancePairs++;
+        }
+    }
+
+    // Sampled rays: one primary ray per grid cell and a cosine weighted bounce from every hit
+    const uint32_t workerCount = GetWorkerCount();
+    std::vector<RayReport> primary(workerCount), secondary(workerCount);
+    std::vector<std::vector<MeshAccumulator>> meshStats(workerCount, std::vector<MeshAccumulator>(meshes.size()));
+
+    auto traceStart = std::chrono::steady_clock::now();
+    ParallelFor(settings.rayHeight, [&](uint32_t y, uint32_t worker)
+    {
+        for (uint32_t x = 0; x < settings.rayWidth; x++)
+        {
+            glm::vec2 uv = (glm::vec2(x, y) + 0.5f) / glm::vec2(settings.rayWidth, settings.rayHeight);
+            Ray ray = GeneratePrimaryRay(camera, uv, aspectRatio);
+            Hit hit;
+            if (!TraceRay(bvh, ray, hit, primary[worker], meshStats[worker])) continue;
+
+            const BVHInstance& instance = bvhInstances[hit.instanceIndex];
+            const glm::vec3* v = meshes[instance.meshIndex].GetTriangle(hit.primitiveIndex);
+            glm::vec3 normal = glm::transpose(glm::mat3(instance.inverseTransform)) * glm::cross(v[1] - v[0], v[2] - v[0]);
+            if (glm::dot(normal, normal) == 0.0f) continue;
+            normal = glm::normalize(normal);
+            if (glm::dot(normal, ray.direction) > 0.0f) normal = -normal;
+
+            glm::vec3 position = ray.origin + ray.direction * hit.t;
+            glm::vec3 absPosition = glm::abs(position);
+            float offset = 1e-4f * std::max(1.0f, std::max(absPosition.x, std::max(absPosition.y, absPosition.z)));
+
+            RNG rng = RNG::Create(glm::uvec2(x, y), settings.rayWidth, 0);
+            glm::vec3 direction = Sampling::TangentToWorld(Sampling::SampleCosineHemisphere(rng.NextFloat2()), normal);
+            Ray bounce(position + normal * offset, glm::normalize(direction));
+            Hit bounceHit;
+            TraceRay(bvh, bounce, bounceHit, secondary[worker], meshStats[worker]);
+        }
+    });
+    report.traceTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - traceStart).count();
+
+    for (uint32_t w = 0; w < workerCount; w++)
+    {
+        Merge(report.primary, primary[w]);
+        Merge(report.secondary, secondary[w]);
+        for (size_t m = 0; m < meshes.size(); m++)
+        {
+            report.meshes[m].rayEntries += meshStats[w][m].rayEntries;
+            report.meshes[m].traversal += meshStats[w][m].traversal;
+        }
+    }
+
+    return report;
+}
+
+void BVHAnalyzer::Report::Print(std::ostream& out) const
+{
+    std::ios_base::fmtflags flags = out.flags();
+    out << std::fixed;
+
+    uint64_t triangleCount = 0;
+    std::array<uint64_t, 8> leafHistogram{};
+    uint64_t bottomNodeVisits = 0;
+    for (const MeshReport& mesh : meshes)
+    {
+        triangleCount += static_cast<uint64_t>(mesh.triangleCount) * mesh.instanceCount;
+        for (size_t i = 0; i < leafHistogram.size(); i++) leafHistogram[i] += mesh.leafHistogram[i];
+        bottomNodeVisits += mesh.traversal.nodeVisits;
+    }
+
+    out << std::setprecision(1)
+        << "[BVHAnalyzer] " << instanceCount << " instances of " << meshes.size() << " meshes, "
+        << triangleCount << " triangles. Built in " << buildTimeMs << " ms, traced in " << traceTimeMs << " ms\n";
+    out << std::setprecision(2)
+        << "[BVHAnalyzer] Top level: " << topNodeCount << " nodes, depth " << topMaxDepth
+        << ", SAH cost " << topSAHCost << ". Whole scene SAH cost " << sceneSAHCost << "\n";
+    out << "[BVHAnalyzer] Instance overlap: " << overlappingInstancePairs << " overlapping pairs, instance area ratio "
+        << instanceAreaRatio << ", sibling overlap avg " << averageSiblingOverlap << " max " << maxSiblingOverlap << "\n";
+    PrintRays(out, "Primary rays", primary);
+    PrintRays(out, "Secondary rays", secondary);
+
+    out << "[BVHAnalyzer] Leaf sizes:";
+    for (size_t i = 0; i < leafHistogram.size(); i++)
+    {
+        out << " " << (i + 1) << (i + 1 == leafHistogram.size() ? "+: " : ": ") << leafHistogram[i];
+    }
+    out << "\n";
+
+    auto printTable = [&](const char* title, std::vector<const MeshReport*> sorted)
+    {
+        out << "[BVHAnalyzer] " << title << "\n";
+        out << "    " << std::left << std::setw(40) << "mesh" << std::right
+            << std::setw(10) << "tris" << std::setw(10) << "nodes" << std::setw(10) << "leaves" << std::setw(7) << "depth"
+            << std::setw(9) << "SAH" << std::setw(10) << "tri ovl" << std::setw(10) << "entries"
+            << std::setw(12) << "nodes/entry" << std::setw(8) << "share" << "  notes\n";
+
+        for (size_t i = 0; i < std::min<size_t>(sorted.size(), reportedMeshes); i++)
+        {
+            const MeshReport& mesh = *sorted[i];
+            std::string name = mesh.name.size() > 38 ? mesh.name.substr(0, 35) + "..." : mesh.name;
+            std::string notes;
+            if (mesh.triangleOverlap > 8.0f) notes += "long/overlapping triangles, spatial splits or re-meshing ";
+            if (mesh.leafHistogram.back() > 0) notes += "oversized leaves (duplicate triangles?) ";
+            if (mesh.maxDepth >= BVH_MAX_DEPTH) notes += "depth limit hit ";
+
+            out << "    " << std::left << std::setw(40) << name << std::right
+                << std::setw(10) << mesh.triangleCount << std::setw(10) << mesh.nodeCount << std::setw(10) << mesh.leafCount
+                << std::setw(7) << mesh.maxDepth << std::setw(9) << std::setprecision(2) << mesh.sahCost
+                << std::setw(10) << std::setprecision(2) << mesh.triangleOverlap << std::setw(10) << mesh.rayEntries
+                << std::setw(12) << std::setprecision(1) << PerRay(mesh.traversal.nodeVisits, mesh.rayEntries)
+                << std::setw(7) << std::setprecision(1) << 100.0 * PerRay(mesh.traversal.nodeVisits, bottomNodeVisits) << "%"
+                << "  " << notes << "\n";
+        }
+    };
+
+    std::vector<const MeshReport*> sorted;
+    for (const MeshReport& mesh : meshes) sorted.push_back(&mesh);
+
+    std::sort(sorted.begin(), sorted.end(), [](const MeshReport* a, const MeshReport* b)
+    {
+        return a->traversal.nodeVisits > b->traversal.nodeVisits;
+    });
+    printTable("Most traversed meshes", sorted);
+
+    std::sort(sorted.begin(), sorted.end(), [](const MeshReport* a, const MeshReport* b)
+    {
+        return a->sahCost > b->sahCost;
+    });
+    printTable("Highest SAH cost meshes", sorted);
+
+    out.flags(flags);
+}
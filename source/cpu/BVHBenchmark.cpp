@@ -0,0 +1,241 @@
+#include "BVHBenchmark.h"
+#include "Parallel.h"
+#include "PinholeCamera.h"
+#include "RNG.h"
+#include "Sampling.h"
+
+#include <chrono>
+#include <iomanip>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace
+{
+    constexpr BVHUpdateMode MODES[] = { BVHUpdateMode::Refit, BVHUpdateMode::Rebuild, BVHUpdateMode::Auto };
+
+    const char* GetModeName(BVHUpdateMode mode)
+    {
+        switch (mode)
+        {
+        case BVHUpdateMode::Refit: return "refit";
+        case BVHUpdateMode::Rebuild: return "rebuild";
+        case BVHUpdateMode::Auto: return "auto";
+        }
+        return "";
+    }
+
+    double ElapsedMs(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void TraceFrame(const SceneBVH& bvh, const Camera& camera, float aspectRatio,
+                    const BVHBenchmarkSettings& settings, BVHBenchmark::Result& result)
+    {
+        std::vector<TraversalStats> stats(GetWorkerCount());
+        auto start = std::chrono::steady_clock::now();
+        ParallelFor(settings.rayHeight, [&](uint32_t y, uint32_t worker)
+        {
+            for (uint32_t x = 0; x < settings.rayWidth; x++)
+            {
+                glm::vec2 uv = (glm::vec2(x, y) + 0.5f) / glm::vec2(settings.rayWidth, settings.rayHeight);
+                Ray ray = GeneratePrimaryRay(camera, uv, aspectRatio);
+                Hit hit;
+                bvh.Intersect(ray, hit, &stats[worker], &stats[worker]);
+            }
+        });
+        result.traceMs += ElapsedMs(start);
+        result.rayCount += static_cast<uint64_t>(settings.rayWidth) * settings.rayHeight;
+        for (const TraversalStats& s : stats) result.nodeVisits += s.nodeVisits;
+    }
+
+    void TraceRandomRays(const SceneBVH& bvh, const BVHBenchmarkSettings& settings, BVHBenchmark::LayoutResult& result)
+    {
+        constexpr uint32_t BATCH_SIZE = 4096;
+        AABB sceneBounds = bvh.GetTopLevel().GetBounds();
+        std::vector<TraversalStats> stats(GetWorkerCount());
+        uint32_t batchCount = (settings.randomRayCount + BATCH_SIZE - 1) / BATCH_SIZE;
+
+        auto start = std::chrono::steady_clock::now();
+        ParallelFor(batchCount, [&](uint32_t batch, uint32_t worker)
+        {
+            uint32_t end = std::min(settings.randomRayCount, (batch + 1) * BATCH_SIZE);
+            for (uint32_t i = batch * BATCH_SIZE; i < end; i++)
+            {
+                RNG rng = RNG::Create(i, 0);
+                glm::vec3 origin = sceneBounds.min + glm::vec3(rng.NextFloat(), rng.NextFloat(), rng.NextFloat()) * sceneBounds.Extent();
+                Ray ray(origin, Sampling::SampleUniformSphere(rng.NextFloat2()));
+                Hit hit;
+                bvh.Intersect(ray, hit, &stats[worker], &stats[worker]);
+            }
+        });
+        result.randomMs = ElapsedMs(start);
+        result.randomRays = settings.randomRayCount;
+        for (const TraversalStats& s : stats) result.randomStats += s;
+    }
+
+    // Deterministic wobble, frame 0 leaves every instance where it started
+    glm::mat4 AnimateInstance(const glm::mat4& transform, uint32_t instanceIndex, float time, float amplitude)
+    {
+        float phase = static_cast<float>(instanceIndex) * 2.39996f;
+        auto offset = [&](float t)
+        {
+            return glm::vec3(glm::sin(t + phase), 0.5f * glm::sin(2.0f * t + phase), glm::cos(t + phase));
+        };
+        glm::vec3 translation = amplitude * (offset(time) - offset(0.0f));
+        float angle = 0.5f * (glm::sin(time + phase) - glm::sin(phase));
+        return glm::translate(glm::mat4(1.0f), translation) * transform * glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+
+    void Deform(const CPUGeometry& source, CPUGeometry& target, float time, float amplitude, float frequency)
+    {
+        for (size_t i = 0; i < source.positions.size(); i++)
+        {
+            const glm::vec3& p = source.positions[i];
+            target.positions[i] = p + glm::vec3(0.0f, amplitude * glm::sin(frequency * (p.x + p.z) + time), 0.0f);
+        }
+    }
+}
+
+BVHBenchmark::Report BVHBenchmark::Run(const std::vector<CPUInstance>& instances, const Camera& camera,
+                                       float aspectRatio, const BVHBenchmarkSettings& settings)
+{
+    Report report;
+    report.frameCount = settings.frameCount;
+    if (instances.empty()) return report;
+
+    auto frameTime = [&](uint32_t frame)
+    {
+        return 6.28318530718f * static_cast<float>(frame) / static_cast<float>(std::max(settings.frameCount, 1u));
+    };
+
+    // Node layouts: the same scene with binary and compressed bottom levels
+    for (bool compressed : { false, true })
+    {
+        BVHBenchmarkSettings layoutSettings = settings;
+        layoutSettings.build.compressed = compressed;
+
+        LayoutResult& layout = report.layouts.emplace_back();
+        layout.compressed = compressed;
+
+        auto start = std::chrono::steady_clock::now();
+        SceneBVH bvh;
+        bvh.Build(instances, layoutSettings.build);
+        layout.buildMs = ElapsedMs(start);
+        for (const MeshBVH& mesh : bvh.GetMeshes()) layout.memoryBytes += mesh.GetMemoryFootprint();
+
+        Result primary;
+        TraceFrame(bvh, camera, aspectRatio, layoutSettings, primary);
+        layout.primaryMs = primary.traceMs;
+        layout.primaryRays = primary.rayCount;
+        layout.primaryStats.nodeVisits = primary.nodeVisits;
+        TraceRandomRays(bvh, layoutSettings, layout);
+    }
+
+    // Top level: every instance moves every frame
+    for (BVHUpdateMode mode : MODES)
+    {
+        SceneBVH bvh;
+        bvh.Build(instances, settings.build);
+        float amplitude = settings.motionScale * glm::length(bvh.GetTopLevel().GetBounds().Extent());
+
+        Result& result = report.instanceMotion.emplace_back();
+        result.mode = mode;
+        for (uint32_t frame = 0; frame < settings.frameCount; frame++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            for (uint32_t i = 0; i < static_cast<uint32_t>(instances.size()); i++)
+            {
+                bvh.SetInstanceTransform(i, AnimateInstance(instances[i].transform, i, frameTime(frame), amplitude));
+            }
+            if (bvh.UpdateTopLevel(mode)) result.rebuildCount++;
+            result.updateMs += ElapsedMs(start);
+
+            TraceFrame(bvh, camera, aspectRatio, settings, result);
+        }
+        result.finalSAHCost = bvh.GetTopLevel().ComputeSAHCost(settings.build.traversalCost, settings.build.intersectionCost);
+    }
+
+    // Bottom level: the largest mesh is deformed every frame
+    size_t largest = 0;
+    for (size_t i = 1; i < instances.size(); i++)
+    {
+        if (instances[i].geometry->GetTriangleCount() > instances[largest].geometry->GetTriangleCount()) largest = i;
+    }
+    const CPUGeometry& source = *instances[largest].geometry;
+    report.deformedMesh = instances[largest].name;
+    report.deformedTriangles = source.GetTriangleCount();
+
+    for (BVHUpdateMode mode : MODES)
+    {
+        SceneBVH bvh;
+        bvh.Build(instances, settings.build);
+        uint32_t meshIndex = bvh.GetInstances()[largest].meshIndex;
+        float amplitude = settings.deformationScale * glm::length(bvh.GetMeshes()[meshIndex].GetBVH().GetBounds().Extent());
+        float frequency = 12.0f / std::max(glm::length(bvh.GetMeshes()[meshIndex].GetBVH().GetBounds().Extent()), 1e-6f);
+        CPUGeometry deformed = source;
+
+        Result& result = report.deformation.emplace_back();
+        result.mode = mode;
+        for (uint32_t frame = 0; frame < settings.frameCount; frame++)
+        {
+            Deform(source, deformed, frameTime(frame), amplitude, frequency);
+
+            auto start = std::chrono::steady_clock::now();
+            if (bvh.UpdateMesh(meshIndex, deformed, mode)) result.rebuildCount++;
+            bvh.UpdateTopLevel(BVHUpdateMode::Refit);
+            result.updateMs += ElapsedMs(start);
+
+            TraceFrame(bvh, camera, aspectRatio, settings, result);
+        }
+        result.finalSAHCost = bvh.GetMeshes()[meshIndex].GetBVH().ComputeSAHCost(settings.build.traversalCost, settings.build.intersectionCost);
+    }
+
+    return report;
+}
+
+void BVHBenchmark::Report::Print(std::ostream& out) const
+{
+    std::ios_base::fmtflags flags = out.flags();
+    out << std::fixed;
+
+    auto printResults = [&](const std::vector<Result>& results)
+    {
+        out << "    " << std::left << std::setw(10) << "mode" << std::right << std::setw(10) << "rebuilds"
+            << std::setw(14) << "update ms/f" << std::setw(14) << "trace ms/f" << std::setw(14) << "Mrays/s"
+            << std::setw(14) << "nodes/ray" << std::setw(12) << "final SAH" << "\n";
+        for (const Result& result : results)
+        {
+            double frames = std::max(frameCount, 1u);
+            out << "    " << std::left << std::setw(10) << GetModeName(result.mode) << std::right
+                << std::setw(10) << result.rebuildCount
+                << std::setw(14) << std::setprecision(3) << result.updateMs / frames
+                << std::setw(14) << std::setprecision(3) << result.traceMs / frames
+                << std::setw(14) << std::setprecision(2) << (result.traceMs > 0.0 ? result.rayCount / (result.traceMs * 1000.0) : 0.0)
+                << std::setw(14) << std::setprecision(1) << (result.rayCount > 0 ? static_cast<double>(result.nodeVisits) / result.rayCount : 0.0)
+                << std::setw(12) << std::setprecision(2) << result.finalSAHCost << "\n";
+        }
+    };
+
+    out << "[BVHBenchmark] Bottom level node layouts\n";
+    out << "    " << std::left << std::setw(12) << "layout" << std::right << std::setw(12) << "memory MB"
+        << std::setw(12) << "build ms" << std::setw(16) << "primary Mrays/s" << std::setw(16) << "random Mrays/s"
+        << std::setw(16) << "boxes/ray (rnd)" << "\n";
+    for (const LayoutResult& layout : layouts)
+    {
+        auto mraysPerSecond = [](uint64_t rays, double ms) { return ms > 0.0 ? static_cast<double>(rays) / (ms * 1000.0) : 0.0; };
+        out << "    " << std::left << std::setw(12) << (layout.compressed ? "compressed" : "binary") << std::right
+            << std::setw(12) << std::setprecision(2) << static_cast<double>(layout.memoryBytes) / (1024.0 * 1024.0)
+            << std::setw(12) << std::setprecision(1) << layout.buildMs
+            << std::setw(16) << std::setprecision(2) << mraysPerSecond(layout.primaryRays, layout.primaryMs)
+            << std::setw(16) << std::setprecision(2) << mraysPerSecond(layout.randomRays, layout.randomMs)
+            << std::setw(16) << std::setprecision(1)
+            << (layout.randomRays > 0 ? static_cast<double>(layout.randomStats.nodeVisits) / static_cast<double>(layout.randomRays) : 0.0) << "\n";
+    }
+
+    out << "[BVHBenchmark] Instance motion, " << frameCount << " frames\n";
+    printResults(instanceMotion);
+    out << "[BVHBenchmark] Deforming " << deformedMesh << " (" << deformedTriangles << " triangles), " << frameCount << " frames\n";
+    printResults(deformation);
+
+    out.flags(flags);
+}
@@ -0,0 +1,40 @@
+#include "CPUOfflineRenderer.h"
+#include "Parallel.h"
+
+bool CPUOfflineRenderer::LoadModel(const std::string& path)
+{
+    m_modelsChanged = true;
+    return m_scene.LoadModel(path);
+}
+
+bool CPUOfflineRenderer::LoadHDRI(const std::string& path)
+{
+    return m_scene.LoadHDRI(path);
+}
+
+void CPUOfflineRenderer::Reset(uint32_t width, uint32_t height, uint32_t firstSample)
+{
+    // Rebuilds the BVH when models were loaded since the last reset, renders of the same scene reuse it
+    if (m_modelsChanged)
+    {
+        m_tracer.SetScene(m_scene);
+        m_modelsChanged = false;
+    }
+    m_tracer.Reset(width, height, firstSample);
+}
+
+bool CPUOfflineRenderer::SetRegion(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+    m_tracer.SetRegion(x, y, width, height);
+    return true;
+}
+
+void CPUOfflineRenderer::RenderSample(const Camera& camera, const CPURenderSettings& settings)
+{
+    m_tracer.RenderSample(camera, settings);
+}
+
+std::string CPUOfflineRenderer::GetName() const
+{
+    return "CPU (" + std::to_string(GetWorkerCount()) + " threads)";
+}
@@ -0,0 +1,423 @@
+#include "CPUPathTracer.h"
+#include "Parallel.h"
+#include "PinholeCamera.h"
+#include "Shading.h"
+
+#include <chrono>
+#include <iomanip>
+
+namespace
+{
+    constexpr uint32_t CHUNK_SIZE = 256; // paths handed to a worker at a time, sorted neighbours stay on one core
+    constexpr float HDRI_CLAMP = 30.0f;
+    constexpr glm::vec3 LUMINANCE_WEIGHTS(0.2126f, 0.7152f, 0.0722f);
+
+    double ElapsedMs(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    uint32_t GetChunkCount(size_t count)
+    {
+        return static_cast<uint32_t>((count + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    }
+
+    glm::vec3 SampleOrDefault(const CPUTexture* texture, glm::vec2 uv, const glm::vec3& factor)
+    {
+        return texture ? glm::vec3(texture->Sample(uv)) * factor : factor;
+    }
+}
+
+void CPURenderStats::Print(std::ostream& out) const
+{
+    std::ios_base::fmtflags flags = out.flags();
+    out << std::fixed;
+
+    out << "    " << std::left << std::setw(8) << "bounce" << std::right << std::setw(12) << "rays"
+        << std::setw(10) << "hit %" << std::setw(10) << "sort ms" << std::setw(12) << "trace ms"
+        << std::setw(10) << "Mrays/s" << std::setw(12) << "nodes/ray" << std::setw(14) << "misses/ray"
+        << std::setw(10) << "miss %" << "\n";
+    for (size_t i = 0; i < bounces.size(); i++)
+    {
+        const CPUBounceStats& bounce = bounces[i];
+        double rays = static_cast<double>(std::max<uint64_t>(bounce.rayCount, 1));
+        out << "    " << std::left << std::setw(8) << i << std::right
+            << std::setw(12) << bounce.rayCount
+            << std::setw(10) << std::setprecision(1) << 100.0 * static_cast<double>(bounce.hitCount) / rays
+            << std::setw(10) << std::setprecision(2) << bounce.sortMs
+            << std::setw(12) << std::setprecision(2) << bounce.traceMs
+            << std::setw(10) << std::setprecision(2) << (bounce.traceMs > 0.0 ? static_cast<double>(bounce.rayCount) / (bounce.traceMs * 1000.0) : 0.0)
+            << std::setw(12) << std::setprecision(1) << static_cast<double>(bounce.traversal.nodeVisits) / rays
+            << std::setw(14) << std::setprecision(2) << static_cast<double>(bounce.cacheMisses) / rays
+            << std::setw(10) << std::setprecision(1)
+            << (bounce.cacheAccesses > 0 ? 100.0 * static_cast<double>(bounce.cacheMisses) / static_cast<double>(bounce.cacheAccesses) : 0.0) << "\n";
+    }
+    out << "    " << sampleCount << " samples in " << std::setprecision(1) << totalMs << " ms\n";
+    if (convergedPixels > 0) out << "    " << convergedPixels << " pixels converged\n";
+
+    out.flags(flags);
+}
+
+void CPUPathTracer::RaySortingComparison::Print(std::ostream& out) const
+{
+    out << "[CPUPathTracer] Unsorted secondary rays\n";
+    unsorted.Print(out);
+    out << "[CPUPathTracer] Sorted secondary rays (origin cell + direction octant)\n";
+    sorted.Print(out);
+    out << "[CPUPathTracer] Accumulation " << (identical ? "identical" : "DIFFERS") << " between both orders\n";
+}
+
+void CPUPathTracer::SetScene(const CPUScene& scene, const BVHBuildSettings& settings)
+{
+    m_scene = &scene;
+    m_bvh.Build(scene.GetInstances(), settings);
+    m_sampleCount = 0;
+    std::fill(m_accumulation.begin(), m_accumulation.end(), glm::vec4(0.0f));
+    std::fill(m_luminanceMoments.begin(), m_luminanceMoments.end(), 0.0f);
+    std::fill(m_converged.begin(), m_converged.end(), uint8_t(0));
+    std::fill(m_features.albedo.begin(), m_features.albedo.end(), glm::vec4(0.0f));
+    std::fill(m_features.normalDepth.begin(), m_features.normalDepth.end(), glm::vec4(0.0f));
+    std::fill(m_features.ids.begin(), m_features.ids.end(), glm::uvec2(INVALID_FEATURE_ID));
+}
+
+void CPUPathTracer::Reset(uint32_t width, uint32_t height, uint32_t firstSample)
+{
+    m_width = width;
+    m_height = height;
+    m_firstSample = firstSample;
+    m_regionMin = glm::uvec2(0);
+    m_regionMax = glm::uvec2(width, height);
+    m_sampleCount = 0;
+    m_accumulation.assign(static_cast<size_t>(width) * height, glm::vec4(0.0f));
+    m_luminanceMoments.assign(m_accumulation.size(), 0.0f);
+    m_converged.assign(m_accumulation.size(), 0);
+    m_features.albedo.assign(m_accumulation.size(), glm::vec4(0.0f));
+    m_features.normalDepth.assign(m_accumulation.size(), glm::vec4(0.0f));
+    m_features.motion.assign(m_accumulation.size(), glm::vec2(0.0f));
+    m_features.ids.assign(m_accumulation.size(), glm::uvec2(INVALID_FEATURE_ID));
+    m_radiance.resize(m_accumulation.size());
+}
+
+void CPUPathTracer::SetRegion(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+    m_regionMin = glm::min(glm::uvec2(x, y), glm::uvec2(m_width, m_height));
+    m_regionMax = glm::min(glm::uvec2(x, y) + glm::uvec2(width, height), glm::uvec2(m_width, m_height));
+}
+
+void CPUPathTracer::RenderSample(const Camera& camera, const CPURenderSettings& settings)
+{
+    if (!m_scene || m_accumulation.empty()) return;
+
+    auto start = std::chrono::steady_clock::now();
+    const uint32_t sampleIndex = m_firstSample + m_sampleCount;
+    const float aspectRatio = static_cast<float>(m_width) / static_cast<float>(m_height);
+    const glm::vec2 size(m_width, m_height);
+    m_cameraForward = camera.GetForward();
+
+    const glm::uvec2 regionSize = m_regionMax - m_regionMin;
+    const bool adaptive = settings.adaptiveSampling;
+
+    // Converged pixels get no path, so every row starts at the prefix sum of the active pixels before it
+    m_rowOffsets.resize(regionSize.y + 1);
+    m_rowOffsets[0] = 0;
+    ParallelFor(regionSize.y, [&](uint32_t row, uint32_t)
+    {
+        const auto begin = m_converged.begin() + (m_regionMin.y + row) * m_width + m_regionMin.x;
+        m_rowOffsets[row + 1] = adaptive ? static_cast<uint32_t>(std::count(begin, begin + regionSize.x, uint8_t(0))) : regionSize.x;
+    });
+    for (uint32_t row = 0; row < regionSize.y; row++) m_rowOffsets[row + 1] += m_rowOffsets[row];
+
+    m_paths.resize(m_rowOffsets[regionSize.y]);
+    ParallelFor(regionSize.y, [&](uint32_t row, uint32_t)
+    {
+        const uint32_t y = m_regionMin.y + row;
+        uint32_t next = m_rowOffsets[row];
+        for (uint32_t x = m_regionMin.x; x < m_regionMax.x; x++)
+        {
+            uint32_t pixel = y * m_width + x;
+            if (adaptive && m_converged[pixel]) continue;
+
+            PathState& path = m_paths[next++];
+            path.pixel = pixel;
+            path.rng = RNG::Create(glm::uvec2(x, y), m_width, sampleIndex, settings.sequence);
+            path.throughput = glm::vec3(1.0f);
+
+            glm::vec2 uv = glm::vec2(x, y) / size + path.rng.NextFloat2() / size;
+            Ray ray = GeneratePrimaryRay(camera, uv, aspectRatio);
+            path.origin = ray.origin;
+            path.direction = ray.direction;
+            m_radiance[pixel] = glm::vec3(0.0f);
+        }
+    });
+
+    if (m_stats.bounces.size() < settings.bounces + 1) m_stats.bounces.resize(settings.bounces + 1);
+    if (settings.simulateCache && m_caches.size() != GetWorkerCount()) m_caches.assign(GetWorkerCount(), CacheSimulator());
+
+    for (uint32_t depth = 0; depth < settings.bounces + 1 && !m_paths.empty(); depth++)
+    {
+        CPUBounceStats& stats = m_stats.bounces[depth];
+        if (settings.sortRays && depth > 0) SortPaths(stats);
+        TraceBounce(settings, stats, depth == 0);
+    }
+
+    ParallelFor(regionSize.y, [&](uint32_t row, uint32_t)
+    {
+        const uint32_t y = m_regionMin.y + row;
+        for (uint32_t pixel = y * m_width + m_regionMin.x; pixel < y * m_width + m_regionMax.x; pixel++)
+        {
+            if (adaptive && m_converged[pixel]) continue;
+
+            glm::vec3 radiance = glm::max(Shading::Sanitize(m_radiance[pixel]), glm::vec3(0.0f));
+            float luminance = glm::dot(radiance, LUMINANCE_WEIGHTS);
+            m_accumulation[pixel] += glm::vec4(radiance, 1.0f);
+            m_luminanceMoments[pixel] += luminance * luminance;
+        }
+    });
+
+    m_sampleCount++;
+    m_stats.sampleCount++;
+    if (adaptive && IsConvergenceUpdate(m_sampleCount, settings.adaptiveMinSamples, settings.adaptiveInterval))
+    {
+        UpdateConvergence(settings);
+    }
+    m_stats.totalMs += ElapsedMs(start);
+}
+
+void CPUPathTracer::UpdateConvergence(const CPURenderSettings& settings)
+{
+    // Per pixel without filtering the mask, so a pixel's samples never depend on its neighbours and tiles
+    // rendered separately still match a full render
+    const glm::uvec2 regionSize = m_regionMax - m_regionMin;
+    std::vector<uint64_t> workerCounts(GetWorkerCount(), 0);
+    ParallelFor(regionSize.y, [&](uint32_t row, uint32_t worker)
+    {
+        const uint32_t y = m_regionMin.y + row;
+        for (uint32_t pixel = y * m_width + m_regionMin.x; pixel < y * m_width + m_regionMax.x; pixel++)
+        {
+            m_converged[pixel] = EstimateRelativeError(m_accumulation[pixel], m_luminanceMoments[pixel]) < settings.adaptiveThreshold;
+            workerCounts[worker] += m_converged[pixel];
+        }
+    });
+
+    m_stats.convergedPixels = 0;
+    for (uint64_t count : workerCounts) m_stats.convergedPixels += count;
+}
+
+void CPUPathTracer::SortPaths(CPUBounceStats& stats)
+{
+    auto start = std::chrono::steady_clock::now();
+    const AABB bounds = m_bvh.GetTopLevel().GetBounds();
+    const size_t count = m_paths.size();
+
+    m_sortKeys.resize(count);
+    ParallelFor(GetChunkCount(count), [&](uint32_t chunk, uint32_t)
+    {
+        size_t end = std::min(count, static_cast<size_t>(chunk + 1) * CHUNK_SIZE);
+        for (size_t i = static_cast<size_t>(chunk) * CHUNK_SIZE; i < end; i++)
+        {
+            m_sortKeys[i] = RaySorter::ComputeKey(m_paths[i].origin, m_paths[i].direction, bounds);
+        }
+    });
+
+    m_sorter.Sort(m_sortKeys, m_sortOrder);
+
+    m_nextPaths.resize(count);
+    ParallelFor(GetChunkCount(count), [&](uint32_t chunk, uint32_t)
+    {
+        size_t end = std::min(count, static_cast<size_t>(chunk + 1) * CHUNK_SIZE);
+        for (size_t i = static_cast<size_t>(chunk) * CHUNK_SIZE; i < end; i++)
+        {
+            m_nextPaths[i] = m_paths[m_sortOrder[i]];
+        }
+    });
+    m_paths.swap(m_nextPaths);
+    stats.sortMs += ElapsedMs(start);
+}
+
+void CPUPathTracer::TraceBounce(const CPURenderSettings& settings, CPUBounceStats& stats, bool primary)
+{
+    auto start = std::chrono::steady_clock::now();
+    const size_t count = m_paths.size();
+    m_alive.resize(count);
+
+    std::vector<CPUBounceStats> workerStats(GetWorkerCount());
+    if (settings.simulateCache)
+    {
+        for (CacheSimulator& cache : m_caches) cache.Reset();
+        for (size_t w = 0; w < workerStats.size(); w++) workerStats[w].traversal.cache = &m_caches[w];
+    }
+
+    ParallelFor(GetChunkCount(count), [&](uint32_t chunk, uint32_t worker)
+    {
+        CPUBounceStats& local = workerStats[worker];
+        size_t end = std::min(count, static_cast<size_t>(chunk + 1) * CHUNK_SIZE);
+        for (size_t i = static_cast<size_t>(chunk) * CHUNK_SIZE; i < end; i++)
+        {
+            PathState& path = m_paths[i];
+            Ray ray(path.origin, path.direction);
+            Hit hit;
+            if (m_bvh.Intersect(ray, hit, &local.traversal, &local.traversal))
+            {
+                local.hitCount++;
+                m_alive[i] = ShadeHit(path, hit, settings, primary);
+            }
+            else
+            {
+                ShadeMiss(path, settings, primary);
+                m_alive[i] = false;
+            }
+        }
+        local.rayCount += end - static_cast<size_t>(chunk) * CHUNK_SIZE;
+    });
+
+    for (size_t w = 0; w < workerStats.size(); w++)
+    {
+        stats.rayCount += workerStats[w].rayCount;
+        stats.hitCount += workerStats[w].hitCount;
+        stats.traversal += workerStats[w].traversal;
+        if (settings.simulateCache)
+        {
+            stats.cacheAccesses += m_caches[w].GetAccesses();
+            stats.cacheMisses += m_caches[w].GetMisses();
+        }
+    }
+
+    // Compact the surviving paths, order is preserved so an unsorted run stays in pixel order
+    m_nextPaths.clear();
+    for (size_t i = 0; i < count; i++)
+    {
+        if (m_alive[i]) m_nextPaths.push_back(m_paths[i]);
+    }
+    m_paths.swap(m_nextPaths);
+    stats.traceMs += ElapsedMs(start);
+}
+
+bool CPUPathTracer::ShadeHit(PathState& path, const Hit& hit, const CPURenderSettings& settings, bool primary)
+{
+    const BVHInstance& instance = m_bvh.GetInstances()[hit.instanceIndex];
+    const CPUMesh& mesh = m_scene->GetMeshes()[hit.instanceIndex];
+    const CPUMaterial& material = m_scene->GetMaterial(mesh.materialIndex);
+
+    uint32_t baseIdx = hit.primitiveIndex * 3;
+    uint32_t i0 = mesh.geometry.indices[baseIdx];
+    uint32_t i1 = mesh.geometry.indices[baseIdx + 1];
+    uint32_t i2 = mesh.geometry.indices[baseIdx + 2];
+
+    glm::vec2 uv = Shading::SampleTriangle(mesh.texCoords[i0], mesh.texCoords[i1], mesh.texCoords[i2], hit.barycentrics);
+
+    glm::vec3 geoNormal = Shading::SampleTriangle(mesh.normals[i0], mesh.normals[i1], mesh.normals[i2], hit.barycentrics);
+    geoNormal = glm::normalize(glm::transpose(glm::mat3(instance.inverseTransform)) * geoNormal);
+    float tangentW = mesh.tangents[i0].w * -1.0f;
+    glm::vec3 tangent = Shading::SampleTriangle(glm::vec3(mesh.tangents[i0]), glm::vec3(mesh.tangents[i1]), glm::vec3(mesh.tangents[i2]), hit.barycentrics);
+    tangent = glm::normalize(glm::mat3(instance.transform) * tangent);
+    glm::vec3 bitangent = glm::cross(geoNormal, tangent) * tangentW;
+
+    glm::vec3 normalMap(0.0f, 0.0f, 1.0f);
+    if (const CPUTexture* normalTexture = m_scene->GetTexture(material.normalIndex))
+    {
+        normalMap = glm::vec3(normalTexture->Sample(uv)) * 2.0f - 1.0f;
+    }
+    glm::vec3 normal = glm::normalize(normalMap.x * tangent + normalMap.y * bitangent + normalMap.z * geoNormal);
+
+    // HIT_KIND_TRIANGLE_BACK_FACE is decided by the object space winding
+    const glm::vec3* v = m_bvh.GetMeshes()[instance.meshIndex].GetTriangle(hit.primitiveIndex);
+    glm::vec3 objectDirection = glm::mat3(instance.inverseTransform) * path.direction;
+    if (glm::dot(glm::cross(v[1] - v[0], v[2] - v[0]), objectDirection) > 0.0f)
+    {
+        normal = -normal;
+        geoNormal = -geoNormal;
+    }
+
+    glm::vec3 hitPoint = path.origin + path.direction * hit.t;
+
+    glm::vec3 albedo = SampleOrDefault(m_scene->GetTexture(material.albedoIndex), uv, material.albedoFactor);
+    if (settings.whiteFurnace) albedo = glm::vec3(1.0f);
+    glm::vec3 emission = SampleOrDefault(m_scene->GetTexture(material.emissiveIndex), uv, material.emissiveFactor);
+    glm::vec3 metallicRoughness = SampleOrDefault(m_scene->GetTexture(material.metallicRoughnessIndex), uv,
+                                                  glm::vec3(1.0f, material.metallicFactor, material.roughnessFactor));
+    float roughness = std::max(metallicRoughness.g, 0.0001f);
+    float metallic = metallicRoughness.b;
+
+    if (primary)
+    {
+        m_features.albedo[path.pixel] += glm::vec4(albedo, 0.0f);
+        m_features.normalDepth[path.pixel] += glm::vec4(normal, hit.t * glm::dot(path.direction, m_cameraForward));
+        m_features.ids[path.pixel] = glm::uvec2(hit.instanceIndex, mesh.materialIndex);
+    }
+
+    glm::vec3& radiance = m_radiance[path.pixel];
+    radiance += emission * path.throughput * settings.lightIntensity;
+
+    glm::vec3 wo;
+    path.throughput *= Shading::PBRIndirect(path.rng, normal, geoNormal, -path.direction, albedo, roughness, metallic, wo);
+    path.direction = wo;
+    path.origin = Shading::OffsetRay(hitPoint, geoNormal);
+
+    return path.throughput != glm::vec3(0.0f);
+}
+
+void CPUPathTracer::ShadeMiss(const PathState& path, const CPURenderSettings& settings, bool primary)
+{
+    if (primary)
+    {
+        m_features.albedo[path.pixel] += glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+        m_features.ids[path.pixel] = glm::uvec2(INVALID_FEATURE_ID);
+    }
+
+    glm::vec3& radiance = m_radiance[path.pixel];
+    if (settings.whiteFurnace)
+    {
+        radiance += path.throughput;
+        return;
+    }
+
+    if (const CPUTexture* hdri = m_scene->GetHDRI())
+    {
+        glm::vec2 uv = Shading::DirectionToEquirectangular(path.direction);
+        glm::vec3 env = glm::min(glm::vec3(hdri->Sample(uv)), glm::vec3(HDRI_CLAMP));
+        radiance += env * settings.skyIntensity * path.throughput;
+    }
+    else
+    {
+        radiance += glm::vec3(0.6f, 0.8f, 1.0f) * settings.skyIntensity * path.throughput * (path.direction.y + 1.1f) / 2.1f;
+    }
+}
+
+CPUPathTracer::RaySortingComparison CPUPathTracer::CompareRaySorting(const CPUScene& scene, const Camera& camera, uint32_t width,
+                                                                     uint32_t height, uint32_t sampleCount, CPURenderSettings settings)
+{
+    RaySortingComparison comparison;
+    CPUPathTracer tracer;
+    tracer.SetScene(scene);
+
+    std::vector<glm::vec4> unsortedImage;
+    for (bool sort : { false, true })
+    {
+        settings.sortRays = sort;
+        CPURenderStats& result = sort ? comparison.sorted : comparison.unsorted;
+
+        // Timed run without the simulator, then a single simulated sample for the miss counts
+        settings.simulateCache = false;
+        tracer.Reset(width, height);
+        tracer.ResetStats();
+        for (uint32_t i = 0; i < sampleCount; i++) tracer.RenderSample(camera, settings);
+        result = tracer.GetStats();
+
+        if (!sort) unsortedImage = tracer.GetAccumulation();
+        else comparison.identical = unsortedImage == tracer.GetAccumulation();
+
+        settings.simulateCache = true;
+        tracer.Reset(width, height);
+        tracer.ResetStats();
+        tracer.RenderSample(camera, settings);
+        const CPURenderStats& cacheStats = tracer.GetStats();
+        for (size_t b = 0; b < result.bounces.size() && b < cacheStats.bounces.size(); b++)
+        {
+            // Scaled to the timed run so misses per ray line up with its ray counts
+            double scale = static_cast<double>(result.bounces[b].rayCount) / static_cast<double>(std::max<uint64_t>(cacheStats.bounces[b].rayCount, 1));
+            result.bounces[b].cacheAccesses = static_cast<uint64_t>(static_cast<double>(cacheStats.bounces[b].cacheAccesses) * scale);
+            result.bounces[b].cacheMisses = static_cast<uint64_t>(static_cast<double>(cacheStats.bounces[b].cacheMisses) * scale);
+        }
+    }
+    return comparison;
+}
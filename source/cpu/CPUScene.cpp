@@ -0,0 +1,405 @@
+#include "CPUScene.h"
+#include "mikktspace.h"
+
+#include <stb_image.h>
+#include <fastgltf/core.hpp>
+#include <fastgltf/glm_element_traits.hpp>
+#include <fastgltf/tools.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <unordered_set>
+
+namespace
+{
+    float SrgbToLinear(uint8_t value)
+    {
+        static const std::array<float, 256> table = []
+        {
+            std::array<float, 256> result{};
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                float srgb = static_cast<float>(i) / 255.0f;
+                result[i] = srgb <= 0.04045f ? srgb / 12.92f : std::pow((srgb + 0.055f) / 1.055f, 2.4f);
+            }
+            return result;
+        }();
+        return table[value];
+    }
+
+    glm::mat4 GetNodeTransform(const fastgltf::Node& node)
+    {
+        return std::visit(fastgltf::visitor{
+            [](const fastgltf::TRS& trs) -> glm::mat4
+            {
+                glm::vec3 translation(trs.translation[0], trs.translation[1], trs.translation[2]);
+                glm::quat rotation(trs.rotation[3], trs.rotation[0], trs.rotation[1], trs.rotation[2]);
+                glm::vec3 scale(trs.scale[0], trs.scale[1], trs.scale[2]);
+                return glm::translate(glm::mat4(1.0f), translation) * glm::mat4_cast(rotation) * glm::scale(glm::mat4(1.0f), scale);
+            },
+            [](const fastgltf::math::fmat4x4& matrix) -> glm::mat4
+            {
+                // Both are column major
+                glm::mat4 result;
+                for (int column = 0; column < 4; column++)
+                    for (int row = 0; row < 4; row++)
+                        result[column][row] = matrix[column][row];
+                return result;
+            }
+        }, node.transform);
+    }
+
+    // Same tangent generation as MikkT::Generate, run on the de-interleaved CPU attributes
+    struct MikkTContext
+    {
+        CPUMesh* mesh;
+
+        [[nodiscard]] uint32_t GetIndex(int face, int vert) const { return mesh->geometry.indices[face * 3 + vert]; }
+    };
+
+    void GenerateTangents(CPUMesh& mesh)
+    {
+        SMikkTSpaceInterface iface{};
+        iface.m_getNumFaces = [](const SMikkTSpaceContext* ctx)
+        {
+            return static_cast<int>(static_cast<MikkTContext*>(ctx->m_pUserData)->mesh->geometry.GetTriangleCount());
+        };
+        iface.m_getNumVerticesOfFace = [](const SMikkTSpaceContext*, int) { return 3; };
+        iface.m_getPosition = [](const SMikkTSpaceContext* ctx, float out[], int face, int vert)
+        {
+            auto* c = static_cast<MikkTContext*>(ctx->m_pUserData);
+            const glm::vec3& p = c->mesh->geometry.positions[c->GetIndex(face, vert)];
+            out[0] = p.x; out[1] = p.y; out[2] = p.z;
+        };
+        iface.m_getNormal = [](const SMikkTSpaceContext* ctx, float out[], int face, int vert)
+        {
+            auto* c = static_cast<MikkTContext*>(ctx->m_pUserData);
+            const glm::vec3& n = c->mesh->normals[c->GetIndex(face, vert)];
+            out[0] = n.x; out[1] = n.y; out[2] = n.z;
+        };
+        iface.m_getTexCoord = [](const SMikkTSpaceContext* ctx, float out[], int face, int vert)
+        {
+            auto* c = static_cast<MikkTContext*>(ctx->m_pUserData);
+            const glm::vec2& uv = c->mesh->texCoords[c->GetIndex(face, vert)];
+            out[0] = uv.x; out[1] = uv.y;
+        };
+        iface.m_setTSpaceBasic = [](const SMikkTSpaceContext* ctx, const float tangent[], float sign, int face, int vert)
+        {
+            auto* c = static_cast<MikkTContext*>(ctx->m_pUserData);
+            c->mesh->tangents[c->GetIndex(face, vert)] = glm::vec4(tangent[0], tangent[1], tangent[2], sign);
+        };
+
+        MikkTContext userData{ &mesh };
+        SMikkTSpaceContext ctx{};
+        ctx.m_pInterface = &iface;
+        ctx.m_pUserData = &userData;
+        genTangSpaceDefault(&ctx);
+    }
+
+    void LoadMesh(const fastgltf::Asset& asset, const fastgltf::Mesh& gltfMesh, const glm::mat4& transform,
+                  uint32_t materialOffset, const std::string& modelName, std::vector<CPUMesh>& meshes)
+    {
+        for (const auto& primitive : gltfMesh.primitives)
+        {
+            if (primitive.type != fastgltf::PrimitiveType::Triangles) continue;
+
+            auto posIt = primitive.findAttribute("POSITION");
+            if (posIt == primitive.attributes.end()) continue;
+
+            // Attributes the primitive lacks stay zero, like the zero-initialized Vertex on the GPU
+            CPUMesh mesh;
+            const auto& posAccessor = asset.accessors[posIt->accessorIndex];
+            mesh.geometry.positions.resize(posAccessor.count);
+            mesh.normals.resize(posAccessor.count, glm::vec3(0.0f));
+            mesh.texCoords.resize(posAccessor.count, glm::vec2(0.0f));
+            mesh.tangents.resize(posAccessor.count, glm::vec4(0.0f));
+
+            fastgltf::copyFromAccessor<glm::vec3>(asset, posAccessor, mesh.geometry.positions.data());
+
+            auto normIt = primitive.findAttribute("NORMAL");
+            if (normIt != primitive.attributes.end())
+            {
+                fastgltf::copyFromAccessor<glm::vec3>(asset, asset.accessors[normIt->accessorIndex], mesh.normals.data());
+            }
+
+            auto texIt = primitive.findAttribute("TEXCOORD_0");
+            if (texIt != primitive.attributes.end())
+            {
+                fastgltf::copyFromAccessor<glm::vec2>(asset, asset.accessors[texIt->accessorIndex], mesh.texCoords.data());
+            }
+
+            if (primitive.indicesAccessor.has_value())
+            {
+                const auto& indexAccessor = asset.accessors[primitive.indicesAccessor.value()];
+                mesh.geometry.indices.resize(indexAccessor.count);
+                fastgltf::copyFromAccessor<uint32_t>(asset, indexAccessor, mesh.geometry.indices.data());
+            }
+            else
+            {
+                mesh.geometry.indices.resize(posAccessor.count);
+                for (size_t i = 0; i < posAccessor.count; i++)
+                    mesh.geometry.indices[i] = static_cast<uint32_t>(i);
+            }
+
+            auto tanIt = primitive.findAttribute("TANGENT");
+            if (tanIt != primitive.attributes.end())
+            {
+                fastgltf::copyFromAccessor<glm::vec4>(asset, asset.accessors[tanIt->accessorIndex], mesh.tangents.data());
+            }
+            else
+            {
+                GenerateTangents(mesh);
+            }
+
+            mesh.materialIndex = primitive.materialIndex.has_value()
+                ? materialOffset + static_cast<uint32_t>(primitive.materialIndex.value()) : 0;
+            mesh.transform = transform;
+            mesh.name = modelName + "_" + std::string(gltfMesh.name) + "_prim" + std::to_string(meshes.size());
+            meshes.push_back(std::move(mesh));
+        }
+    }
+
+    void TraverseNode(const fastgltf::Asset& asset, size_t nodeIndex, const glm::mat4& parentTransform,
+                      uint32_t materialOffset, const std::string& modelName, std::vector<CPUMesh>& meshes)
+    {
+        const auto& node = asset.nodes[nodeIndex];
+        glm::mat4 worldTransform = parentTransform * GetNodeTransform(node);
+
+        if (node.meshIndex.has_value())
+        {
+            LoadMesh(asset, asset.meshes[node.meshIndex.value()], worldTransform, materialOffset, modelName, meshes);
+        }
+
+        for (size_t childIndex : node.children)
+        {
+            TraverseNode(asset, childIndex, worldTransform, materialOffset, modelName, meshes);
+        }
+    }
+
+    stbi_uc* DecodeImage(const fastgltf::Asset& asset, const fastgltf::Image& image, const std::filesystem::path& directory,
+                       int& width, int& height)
+    {
+        int channels;
+        auto fromMemory = [&](const std::byte* bytes, size_t size)
+        {
+            return stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(bytes), static_cast<int>(size), &width, &height, &channels, 4);
+        };
+
+        return std::visit(fastgltf::visitor{
+            [&](const fastgltf::sources::URI& filePath) -> stbi_uc*
+            {
+                const std::string path(filePath.uri.path().begin(), filePath.uri.path().end());
+                return stbi_load((directory / path).string().c_str(), &width, &height, &channels, 4);
+            },
+            [&](const fastgltf::sources::Array& array) -> stbi_uc*
+            {
+                return fromMemory(array.bytes.data(), array.bytes.size());
+            },
+            [&](const fastgltf::sources::Vector& vector) -> stbi_uc*
+            {
+                return fromMemory(vector.bytes.data(), vector.bytes.size());
+            },
+            [&](const fastgltf::sources::BufferView& view) -> stbi_uc*
+            {
+                const auto& bufferView = asset.bufferViews[view.bufferViewIndex];
+                const auto& buffer = asset.buffers[bufferView.bufferIndex];
+                return std::visit(fastgltf::visitor{
+                    [&](const fastgltf::sources::Array& array) -> stbi_uc*
+                    {
+                        return fromMemory(array.bytes.data() + bufferView.byteOffset, bufferView.byteLength);
+                    },
+                    [&](const fastgltf::sources::Vector& vector) -> stbi_uc*
+                    {
+                        return fromMemory(vector.bytes.data() + bufferView.byteOffset, bufferView.byteLength);
+                    },
+                    [&](const fastgltf::sources::ByteView& byteView) -> stbi_uc*
+                    {
+                        return fromMemory(byteView.bytes.data() + bufferView.byteOffset, bufferView.byteLength);
+                    },
+                    [&](auto&) -> stbi_uc* { return nullptr; }
+                }, buffer.data);
+            },
+            [&](auto&) -> stbi_uc* { return nullptr; }
+        }, image.data);
+    }
+
+    int32_t GetImageIndex(const fastgltf::Asset& asset, size_t textureIndex, int32_t textureOffset)
+    {
+        auto imageIndex = asset.textures[textureIndex].imageIndex;
+        return imageIndex.has_value() ? textureOffset + static_cast<int32_t>(imageIndex.value()) : -1;
+    }
+}
+
+glm::vec4 CPUTexture::Fetch(uint32_t x, uint32_t y) const
+{
+    size_t index = static_cast<size_t>(y) * width + x;
+    if (!hdrTexels.empty()) return hdrTexels[index];
+
+    const uint8_t* texel = &ldrTexels[index * 4];
+    if (srgb)
+    {
+        return { SrgbToLinear(texel[0]), SrgbToLinear(texel[1]), SrgbToLinear(texel[2]), texel[3] / 255.0f };
+    }
+    return glm::vec4(texel[0], texel[1], texel[2], texel[3]) / 255.0f;
+}
+
+glm::vec4 CPUTexture::Sample(glm::vec2 uv) const
+{
+    glm::vec2 position = uv * glm::vec2(width, height) - 0.5f;
+    glm::vec2 base = glm::floor(position);
+    glm::vec2 weight = position - base;
+
+    auto wrap = [](int32_t value, uint32_t size)
+    {
+        int32_t wrapped = value % static_cast<int32_t>(size);
+        return static_cast<uint32_t>(wrapped < 0 ? wrapped + static_cast<int32_t>(size) : wrapped);
+    };
+    // Float to int conversion of huge uvs would overflow, reduce them to one period first
+    int32_t x = static_cast<int32_t>(std::fmod(base.x, static_cast<float>(width)));
+    int32_t y = static_cast<int32_t>(std::fmod(base.y, static_cast<float>(height)));
+    uint32_t x0 = wrap(x, width), x1 = wrap(x + 1, width);
+    uint32_t y0 = wrap(y, height), y1 = wrap(y + 1, height);
+
+    glm::vec4 top = glm::mix(Fetch(x0, y0), Fetch(x1, y0), weight.x);
+    glm::vec4 bottom = glm::mix(Fetch(x0, y1), Fetch(x1, y1), weight.x);
+    return glm::mix(top, bottom, weight.y);
+}
+
+bool CPUScene::LoadModel(const std::string& path)
+{
+    std::string extension = path.substr(path.find_last_of('.'));
+    if (extension != ".gltf" && extension != ".glb")
+    {
+        std::cerr << "[CPUScene] Unsupported model format: " << extension << "\n";
+        return false;
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    fastgltf::Parser parser(fastgltf::Extensions::KHR_lights_punctual);
+    auto data = fastgltf::GltfDataBuffer::FromPath(path);
+    if (data.error() != fastgltf::Error::None)
+    {
+        std::cerr << "[CPUScene] Failed to load glTF file: " << path << "\n";
+        return false;
+    }
+
+    std::filesystem::path directory = std::filesystem::path(path).parent_path();
+    constexpr auto options = fastgltf::Options::LoadExternalBuffers | fastgltf::Options::LoadExternalImages;
+    auto asset = parser.loadGltf(data.get(), directory, options);
+    if (asset.error() != fastgltf::Error::None)
+    {
+        std::cerr << "[CPUScene] Failed to parse glTF: " << path << " (" << fastgltf::getErrorMessage(asset.error()) << ")\n";
+        return false;
+    }
+
+    const uint32_t materialOffset = static_cast<uint32_t>(m_materials.size());
+    const int32_t textureOffset = static_cast<int32_t>(m_textures.size());
+    const std::string modelName = std::filesystem::path(path).stem().string();
+
+    const auto& scene = asset->scenes[asset->defaultScene.value_or(0)];
+    for (size_t nodeIndex : scene.nodeIndices)
+    {
+        TraverseNode(asset.get(), nodeIndex, glm::mat4(1.0f), materialOffset, modelName, m_meshes);
+    }
+
+    // Normal, metallic/roughness and occlusion maps hold linear data, everything else is sRGB
+    std::unordered_set<size_t> linearImages;
+    for (const auto& mat : asset->materials)
+    {
+        auto addLinear = [&](size_t textureIndex)
+        {
+            auto imageIndex = asset->textures[textureIndex].imageIndex;
+            if (imageIndex.has_value()) linearImages.insert(imageIndex.value());
+        };
+        if (mat.normalTexture.has_value()) addLinear(mat.normalTexture->textureIndex);
+        if (mat.pbrData.metallicRoughnessTexture.has_value()) addLinear(mat.pbrData.metallicRoughnessTexture->textureIndex);
+        if (mat.occlusionTexture.has_value()) addLinear(mat.occlusionTexture->textureIndex);
+    }
+
+    for (size_t imageIndex = 0; imageIndex < asset->images.size(); imageIndex++)
+    {
+        const auto& image = asset->images[imageIndex];
+        CPUTexture& texture = m_textures.emplace_back();
+
+        int width = 0, height = 0;
+        stbi_uc* pixels = DecodeImage(asset.get(), image, directory, width, height);
+        if (!pixels)
+        {
+            std::cerr << "[CPUScene] Failed to load image: " << image.name << "\n";
+            continue;
+        }
+
+        texture.width = static_cast<uint32_t>(width);
+        texture.height = static_cast<uint32_t>(height);
+        texture.srgb = !linearImages.contains(imageIndex);
+        texture.ldrTexels.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+        stbi_image_free(pixels);
+    }
+
+    for (const auto& mat : asset->materials)
+    {
+        CPUMaterial material;
+        if (mat.pbrData.baseColorTexture.has_value())
+            material.albedoIndex = GetImageIndex(asset.get(), mat.pbrData.baseColorTexture->textureIndex, textureOffset);
+        if (mat.pbrData.metallicRoughnessTexture.has_value())
+            material.metallicRoughnessIndex = GetImageIndex(asset.get(), mat.pbrData.metallicRoughnessTexture->textureIndex, textureOffset);
+        if (mat.normalTexture.has_value())
+            material.normalIndex = GetImageIndex(asset.get(), mat.normalTexture->textureIndex, textureOffset);
+        if (mat.emissiveTexture.has_value())
+            material.emissiveIndex = GetImageIndex(asset.get(), mat.emissiveTexture->textureIndex, textureOffset);
+
+        const auto& albedo = mat.pbrData.baseColorFactor;
+        material.albedoFactor = { albedo[0], albedo[1], albedo[2] };
+        material.metallicFactor = mat.pbrData.metallicFactor;
+        material.roughnessFactor = mat.pbrData.roughnessFactor;
+        material.emissiveFactor = { mat.emissiveFactor[0], mat.emissiveFactor[1], mat.emissiveFactor[2] };
+        m_materials.push_back(material);
+    }
+
+    auto time = std::chrono::steady_clock::now() - startTime;
+    std::cout << "[CPUScene] Loaded model: " << path << ". Took "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(time).count() / 1000.0 << " s.\n";
+    return true;
+}
+
+bool CPUScene::LoadHDRI(const std::string& path)
+{
+    int width, height, channels;
+    float* data = stbi_loadf(path.c_str(), &width, &height, &channels, 4);
+    if (!data)
+    {
+        std::cerr << "[CPUScene] Failed to load HDRI: " << path << "\n";
+        return false;
+    }
+
+    m_hdri = {};
+    m_hdri.width = static_cast<uint32_t>(width);
+    m_hdri.height = static_cast<uint32_t>(height);
+    m_hdri.hdrTexels.resize(static_cast<size_t>(width) * height);
+    std::memcpy(m_hdri.hdrTexels.data(), data, m_hdri.hdrTexels.size() * sizeof(glm::vec4));
+    stbi_image_free(data);
+    return true;
+}
+
+std::vector<CPUInstance> CPUScene::GetInstances() const
+{
+    std::vector<CPUInstance> instances;
+    instances.reserve(m_meshes.size());
+    for (const CPUMesh& mesh : m_meshes)
+    {
+        instances.push_back({ &mesh.geometry, mesh.transform, mesh.name });
+    }
+    return instances;
+}
+
+const CPUMaterial& CPUScene::GetMaterial(uint32_t index) const
+{
+    // Meshes without a material use index 0, which may not exist when the scene has no materials at all
+    static const CPUMaterial defaultMaterial{};
+    return index < m_materials.size() ? m_materials[index] : defaultMaterial;
+}
@@ -0,0 +1,120 @@
+#include "CompressedBVH.h"
+
+#include <algorithm>
+#include <cassert>
+
+void CompressedBVH::Build(const BVH& source, const std::vector<AABB>& primitiveBounds)
+{
+    m_nodes.clear();
+    m_primIndices = source.GetPrimitiveIndices();
+    if (source.IsEmpty()) return;
+
+    m_nodes.reserve(source.GetNodes().size() / 2 + 1);
+    EmitNode(source, primitiveBounds, { MakeChild(source, primitiveBounds, 0) });
+}
+
+CompressedBVH::Child CompressedBVH::MakeChild(const BVH& source, const std::vector<AABB>& primitiveBounds, uint32_t sourceIndex)
+{
+    const BVHNode& node = source.GetNodes()[sourceIndex];
+    Child child{ AABB{ node.aabbMin, node.aabbMax }, sourceIndex, !node.IsLeaf() };
+    if (node.IsLeaf())
+    {
+        child.code = EmitLeafRange(primitiveBounds, node.leftFirst, node.primCount, child.bounds);
+    }
+    return child;
+}
+
+uint32_t CompressedBVH::EmitLeafRange(const std::vector<AABB>& primitiveBounds, uint32_t first, uint32_t count, AABB& bounds)
+{
+    assert(first + count <= LEAF_FIRST_MASK + 1);
+    if (count <= LEAF_MAX_COUNT)
+    {
+        bounds = {};
+        for (uint32_t i = 0; i < count; i++)
+        {
+            bounds.Grow(primitiveBounds[m_primIndices[first + i]]);
+        }
+        return LEAF_FLAG | (count << LEAF_COUNT_SHIFT) | first;
+    }
+
+    // Oversized leaf (coincident centroids or the depth limit), spread it over a node of smaller leaves
+    std::vector<Child> children;
+    uint32_t chunk = (count + 3) / 4;
+    for (uint32_t offset = 0; offset < count; offset += chunk)
+    {
+        Child& child = children.emplace_back();
+        child.pending = false;
+        child.code = EmitLeafRange(primitiveBounds, first + offset, std::min(chunk, count - offset), child.bounds);
+    }
+
+    bounds = {};
+    for (const Child& child : children) bounds.Grow(child.bounds);
+    return EmitNode(BVH{}, primitiveBounds, children);
+}
+
+uint32_t CompressedBVH::EmitNode(const BVH& source, const std::vector<AABB>& primitiveBounds, const std::vector<Child>& initialChildren)
+{
+    uint32_t index = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.emplace_back();
+
+    // Open the largest interior child until the node is full
+    std::vector<Child> children = initialChildren;
+    while (children.size() < 4)
+    {
+        int32_t largest = -1;
+        float largestArea = -1.0f;
+        for (size_t i = 0; i < children.size(); i++)
+        {
+            if (children[i].pending && children[i].bounds.SurfaceArea() > largestArea)
+            {
+                largest = static_cast<int32_t>(i);
+                largestArea = children[i].bounds.SurfaceArea();
+            }
+        }
+        if (largest < 0) break;
+
+        const BVHNode& opened = source.GetNodes()[children[largest].code];
+        children[largest] = MakeChild(source, primitiveBounds, opened.leftFirst);
+        children.push_back(MakeChild(source, primitiveBounds, opened.leftFirst + 1));
+    }
+
+    CompressedBVHNode node{};
+    AABB bounds;
+    for (const Child& child : children) bounds.Grow(child.bounds);
+    node.origin = bounds.min;
+    node.childCount = static_cast<uint8_t>(children.size());
+
+    glm::vec3 scale;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        // Smallest power of two for which 255 steps cover the extent, padded against rounding
+        float extent = bounds.max[axis] - bounds.min[axis];
+        int exponent = -126;
+        if (extent > 0.0f) std::frexp(extent * 1.0001f / 255.0f, &exponent);
+        exponent = std::clamp(exponent, -126, 127);
+        node.exponent[axis] = static_cast<int8_t>(exponent);
+        scale[axis] = std::ldexp(1.0f, exponent);
+    }
+
+    for (size_t c = 0; c < children.size(); c++)
+    {
+        const AABB& childBounds = children[c].bounds;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            // Round outwards so the decoded box always contains the child
+            float origin = node.origin[axis];
+            int lo = std::clamp(static_cast<int>(std::floor((childBounds.min[axis] - origin) / scale[axis])), 0, 255);
+            int hi = std::clamp(static_cast<int>(std::ceil((childBounds.max[axis] - origin) / scale[axis])), 0, 255);
+            while (lo > 0 && origin + static_cast<float>(lo) * scale[axis] > childBounds.min[axis]) lo--;
+            while (hi < 255 && origin + static_cast<float>(hi) * scale[axis] < childBounds.max[axis]) hi++;
+            node.quantMin[axis][c] = static_cast<uint8_t>(lo);
+            node.quantMax[axis][c] = static_cast<uint8_t>(hi);
+        }
+
+        node.children[c] = children[c].pending ? EmitNode(source, primitiveBounds, { MakeChild(source, primitiveBounds, children[c].code) })
+                                               : children[c].code;
+    }
+
+    m_nodes[index] = node;
+    return index;
+}
@@ -0,0 +1,224 @@
+#include "Denoiser.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr float KERNEL[3] = { 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f };
+
+    float Luminance(float r, float g, float b)
+    {
+        return 0.2126f * r + 0.7152f * g + 0.0722f * b;
+    }
+
+    float Sanitize(float x)
+    {
+        return std::isfinite(x) ? x : 0.0f;
+    }
+
+    // Radiance and luminance variance, one plane per channel
+    struct Planes
+    {
+        std::vector<float> r, g, b, variance, luminance;
+
+        void Resize(size_t count)
+        {
+            for (auto* plane : { &r, &g, &b, &variance, &luminance }) plane->resize(count);
+        }
+    };
+
+    // First hit features resolved by the sample count, hit is 1 or 0 so the edge weight needs no branch
+    struct Surfaces
+    {
+        std::vector<float> albedoR, albedoG, albedoB, normalX, normalY, normalZ, depth, hit;
+
+        void Resize(size_t count)
+        {
+            for (auto* plane : { &albedoR, &albedoG, &albedoB, &normalX, &normalY, &normalZ, &depth, &hit }) plane->resize(count);
+        }
+    };
+
+    // Row accumulators of one worker
+    struct Scratch
+    {
+        std::vector<float> weight, r, g, b, variance, scale;
+
+        void Reset(uint32_t width)
+        {
+            for (auto* row : { &weight, &r, &g, &b, &variance }) row->assign(width, 0.0f);
+            scale.resize(width);
+        }
+    };
+
+    // EdgeWeight in denoise_pass.slang: albedo, normal and depth stopping, sky pixels only blend with sky
+    float EdgeWeight(const Surfaces& s, size_t p, size_t q, float stepSize, const Denoiser::Settings& settings)
+    {
+        float same = 1.0f - std::abs(s.hit[p] - s.hit[q]);
+        float albedoR = s.albedoR[p] - s.albedoR[q];
+        float albedoG = s.albedoG[p] - s.albedoG[q];
+        float albedoB = s.albedoB[p] - s.albedoB[q];
+        float albedoWeight = std::exp(-std::sqrt(albedoR * albedoR + albedoG * albedoG + albedoB * albedoB) / settings.sigmaAlbedo);
+        float cosine = std::max(s.normalX[p] * s.normalX[q] + s.normalY[p] * s.normalY[q] + s.normalZ[p] * s.normalZ[q], 0.0f);
+        float normalWeight = std::pow(cosine, settings.sigmaNormal);
+        float depthWeight = std::exp(-std::abs(s.depth[p] - s.depth[q]) / (settings.sigmaDepth * s.depth[p] * stepSize + 1e-6f));
+        return same * (s.hit[p] * albedoWeight * normalWeight * depthWeight + (1.0f - s.hit[p]));
+    }
+
+    // Calls fn(tapX, tapY, firstCenter, firstOther, count, firstX) for the run of pixels of row y whose tap at
+    // (tapX, tapY) * step lies inside the image, taps outside are skipped like in the shader
+    template<typename Fn>
+    void ForEachTap(uint32_t y, int radius, int step, uint32_t width, uint32_t height, Fn&& fn)
+    {
+        for (int tapY = -radius; tapY <= radius; tapY++)
+        {
+            const int otherY = static_cast<int>(y) + tapY * step;
+            if (otherY < 0 || otherY >= static_cast<int>(height)) continue;
+
+            for (int tapX = -radius; tapX <= radius; tapX++)
+            {
+                const int offset = tapX * step;
+                const int begin = std::max(0, -offset);
+                const int end = std::min(static_cast<int>(width), static_cast<int>(width) - offset);
+                if (begin >= end) continue;
+
+                fn(tapX, tapY, static_cast<size_t>(y) * width + begin, static_cast<size_t>(otherY) * width + begin + offset,
+                   static_cast<uint32_t>(end - begin), static_cast<uint32_t>(begin));
+            }
+        }
+    }
+}
+
+std::vector<glm::vec4> Denoiser::Denoise(const std::vector<glm::vec4>& accumulation, const FeatureBuffers& features,
+                                         uint32_t width, uint32_t height, const Settings& settings)
+{
+    const size_t pixelCount = static_cast<size_t>(width) * height;
+    if (accumulation.size() != pixelCount || features.albedo.size() != pixelCount || features.normalDepth.size() != pixelCount)
+    {
+        return accumulation;
+    }
+
+    Surfaces surfaces;
+    surfaces.Resize(pixelCount);
+    Planes planes[2];
+    planes[0].Resize(pixelCount);
+    planes[1].Resize(pixelCount);
+
+    // Resolve the accumulation and features
+    ParallelFor(height, [&](uint32_t y, uint32_t)
+    {
+        for (size_t p = static_cast<size_t>(y) * width; p < static_cast<size_t>(y + 1) * width; p++)
+        {
+            const float sampleCount = std::max(accumulation[p].w, 1.0f);
+            const glm::vec4 normalDepth = features.normalDepth[p] / sampleCount;
+            const float length = glm::length(glm::vec3(normalDepth));
+            const bool hit = normalDepth.w > 0.0f;
+            const glm::vec3 normal = length > 0.0f ? glm::vec3(normalDepth) / length : glm::vec3(0.0f);
+            const glm::vec3 albedo = glm::vec3(features.albedo[p]) / sampleCount;
+
+            surfaces.albedoR[p] = albedo.r;
+            surfaces.albedoG[p] = albedo.g;
+            surfaces.albedoB[p] = albedo.b;
+            surfaces.normalX[p] = normal.x;
+            surfaces.normalY[p] = normal.y;
+            surfaces.normalZ[p] = normal.z;
+            surfaces.depth[p] = normalDepth.w;
+            surfaces.hit[p] = hit ? 1.0f : 0.0f;
+
+            const glm::vec3 mean = glm::vec3(accumulation[p]) / sampleCount;
+            planes[0].r[p] = Sanitize(mean.r);
+            planes[0].g[p] = Sanitize(mean.g);
+            planes[0].b[p] = Sanitize(mean.b);
+            planes[0].luminance[p] = Luminance(planes[0].r[p], planes[0].g[p], planes[0].b[p]);
+        }
+    });
+
+    std::vector<Scratch> scratch(GetWorkerCount());
+
+    // Luminance variance over the 3x3 surface neighbourhood
+    ParallelFor(height, [&](uint32_t y, uint32_t worker)
+    {
+        Scratch& rows = scratch[worker];
+        rows.Reset(width);
+        // r and g sum the first and second luminance moments here
+        const std::vector<float>& luminance = planes[0].luminance;
+        ForEachTap(y, 1, 1, width, height, [&](int, int, size_t p, size_t q, uint32_t count, uint32_t x)
+        {
+            for (uint32_t i = 0; i < count; i++)
+            {
+                const float weight = EdgeWeight(surfaces, p + i, q + i, 1.0f, settings);
+                rows.weight[x + i] += weight;
+                rows.r[x + i] += weight * luminance[q + i];
+                rows.g[x + i] += weight * luminance[q + i] * luminance[q + i];
+            }
+        });
+
+        const size_t row = static_cast<size_t>(y) * width;
+        for (uint32_t x = 0; x < width; x++)
+        {
+            const float moment1 = rows.r[x] / rows.weight[x];
+            const float moment2 = rows.g[x] / rows.weight[x];
+            planes[0].variance[row + x] = std::max(moment2 - moment1 * moment1, 0.0f);
+        }
+    });
+
+    // A-trous iterations, ping-ponging between the planes
+    const uint32_t iterations = std::clamp(settings.iterations, 1u, MAX_ITERATIONS);
+    for (uint32_t iteration = 0; iteration < iterations; iteration++)
+    {
+        const Planes& in = planes[iteration % 2];
+        Planes& out = planes[(iteration + 1) % 2];
+        const int step = 1 << iteration;
+        const float stepSize = static_cast<float>(step);
+
+        ParallelFor(height, [&](uint32_t y, uint32_t worker)
+        {
+            Scratch& rows = scratch[worker];
+            rows.Reset(width);
+            const size_t row = static_cast<size_t>(y) * width;
+            for (uint32_t x = 0; x < width; x++)
+            {
+                rows.scale[x] = settings.sigmaLuminance * std::sqrt(in.variance[row + x]) + 1e-4f;
+            }
+
+            ForEachTap(y, 2, step, width, height, [&](int tapX, int tapY, size_t p, size_t q, uint32_t count, uint32_t x)
+            {
+                const float kernel = KERNEL[std::abs(tapX)] * KERNEL[std::abs(tapY)];
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    const float luminanceWeight = std::exp(-std::abs(in.luminance[p + i] - in.luminance[q + i]) / rows.scale[x + i]);
+                    const float weight = kernel * EdgeWeight(surfaces, p + i, q + i, stepSize, settings) * luminanceWeight;
+                    rows.weight[x + i] += weight;
+                    rows.r[x + i] += weight * in.r[q + i];
+                    rows.g[x + i] += weight * in.g[q + i];
+                    rows.b[x + i] += weight * in.b[q + i];
+                    rows.variance[x + i] += weight * weight * in.variance[q + i];
+                }
+            });
+
+            for (uint32_t x = 0; x < width; x++)
+            {
+                const float weight = rows.weight[x];
+                out.r[row + x] = rows.r[x] / weight;
+                out.g[row + x] = rows.g[x] / weight;
+                out.b[row + x] = rows.b[x] / weight;
+                out.variance[row + x] = rows.variance[x] / (weight * weight);
+                out.luminance[row + x] = Luminance(out.r[row + x], out.g[row + x], out.b[row + x]);
+            }
+        });
+    }
+
+    // Back to the accumulation layout
+    const Planes& result = planes[iterations % 2];
+    std::vector<glm::vec4> denoised(pixelCount);
+    ParallelFor(height, [&](uint32_t y, uint32_t)
+    {
+        for (size_t p = static_cast<size_t>(y) * width; p < static_cast<size_t>(y + 1) * width; p++)
+        {
+            const float sampleCount = accumulation[p].w;
+            denoised[p] = glm::vec4(result.r[p] * sampleCount, result.g[p] * sampleCount, result.b[p] * sampleCount, sampleCount);
+        }
+    });
+    return denoised;
+}
@@ -0,0 +1,208 @@
+#include "ImageIO.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+    std::string GetExtension(const std::string& path)
+    {
+        std::string extension = std::filesystem::path(path).extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return extension;
+    }
+
+    uint8_t ToByte(float value)
+    {
+        if (!(value > 0.0f)) return 0; // also catches NaN
+        return static_cast<uint8_t>(std::min(value, 1.0f) * 255.0f + 0.5f);
+    }
+
+    template<typename T>
+    void WriteValue(std::ofstream& file, const T& value)
+    {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void WritePPM(std::ofstream& file, uint32_t width, uint32_t height, const std::vector<glm::vec3>& pixels)
+    {
+        file << "P6\n" << width << " " << height << "\n255\n";
+        std::vector<uint8_t> row(width * 3);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                const glm::vec3& p = pixels[y * width + x];
+                row[x * 3 + 0] = ToByte(p.r);
+                row[x * 3 + 1] = ToByte(p.g);
+                row[x * 3 + 2] = ToByte(p.b);
+            }
+            file.write(reinterpret_cast<const char*>(row.data()), row.size());
+        }
+    }
+
+    // 24-bit BGR, rows padded to 4 bytes and stored bottom up
+    void WriteBMP(std::ofstream& file, uint32_t width, uint32_t height, const std::vector<glm::vec3>& pixels)
+    {
+        const uint32_t rowSize = (width * 3 + 3) & ~3u;
+        const uint32_t imageSize = rowSize * height;
+        constexpr uint32_t headerSize = 14 + 40;
+
+        file.write("BM", 2);
+        WriteValue<uint32_t>(file, headerSize + imageSize);
+        WriteValue<uint32_t>(file, 0);
+        WriteValue<uint32_t>(file, headerSize);
+
+        WriteValue<uint32_t>(file, 40);
+        WriteValue<int32_t>(file, static_cast<int32_t>(width));
+        WriteValue<int32_t>(file, static_cast<int32_t>(height));
+        WriteValue<uint16_t>(file, 1);
+        WriteValue<uint16_t>(file, 24);
+        WriteValue<uint32_t>(file, 0); // BI_RGB
+        WriteValue<uint32_t>(file, imageSize);
+        WriteValue<int32_t>(file, 2835); // 72 DPI
+        WriteValue<int32_t>(file, 2835);
+        WriteValue<uint32_t>(file, 0);
+        WriteValue<uint32_t>(file, 0);
+
+        std::vector<uint8_t> row(rowSize, 0);
+        for (uint32_t y = height; y-- > 0;)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                const glm::vec3& p = pixels[y * width + x];
+                row[x * 3 + 0] = ToByte(p.b);
+                row[x * 3 + 1] = ToByte(p.g);
+                row[x * 3 + 2] = ToByte(p.r);
+            }
+            file.write(reinterpret_cast<const char*>(row.data()), row.size());
+        }
+    }
+
+    // Little endian (negative scale), rows stored bottom up
+    void WritePFM(std::ofstream& file, uint32_t width, uint32_t height, const std::vector<glm::vec3>& pixels)
+    {
+        file << "PF\n" << width << " " << height << "\n-1.0\n";
+        for (uint32_t y = height; y-- > 0;)
+        {
+            file.write(reinterpret_cast<const char*>(&pixels[y * width]), width * sizeof(glm::vec3));
+        }
+    }
+
+    // Radiance RGBE with flat (not run length encoded) scanlines
+    void WriteHDR(std::ofstream& file, uint32_t width, uint32_t height, const std::vector<glm::vec3>& pixels)
+    {
+        file << "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y " << height << " +X " << width << "\n";
+        std::vector<uint8_t> row(width * 4);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                glm::vec3 p = glm::max(pixels[y * width + x], 0.0f);
+                float maxComponent = std::max(p.r, std::max(p.g, p.b));
+                uint8_t* rgbe = &row[x * 4];
+                if (!(maxComponent >= 1e-32f) || std::isinf(maxComponent))
+                {
+                    rgbe[0] = rgbe[1] = rgbe[2] = rgbe[3] = 0;
+                    continue;
+                }
+
+                int exponent;
+                float scale = std::frexp(maxComponent, &exponent) * 256.0f / maxComponent;
+                rgbe[0] = static_cast<uint8_t>(p.r * scale);
+                rgbe[1] = static_cast<uint8_t>(p.g * scale);
+                rgbe[2] = static_cast<uint8_t>(p.b * scale);
+                rgbe[3] = static_cast<uint8_t>(exponent + 128);
+            }
+            file.write(reinterpret_cast<const char*>(row.data()), row.size());
+        }
+    }
+}
+
+bool ImageIO::Write(const std::string& path, uint32_t width, uint32_t height, const std::vector<glm::vec3>& pixels)
+{
+    if (pixels.size() != static_cast<size_t>(width) * height)
+    {
+        std::cerr << "[ImageIO] Pixel count does not match " << width << "x" << height << " for " << path << "\n";
+        return false;
+    }
+
+    const std::string extension = GetExtension(path);
+    if (!IsSupported(path))
+    {
+        std::cerr << "[ImageIO] Unsupported image format: " << extension << "\nPlease use .hdr, .pfm, .bmp or .ppm\n";
+        return false;
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        std::cerr << "[ImageIO] Failed to open " << path << " for writing\n";
+        return false;
+    }
+
+    if (extension == ".ppm") WritePPM(file, width, height, pixels);
+    else if (extension == ".bmp") WriteBMP(file, width, height, pixels);
+    else if (extension == ".pfm") WritePFM(file, width, height, pixels);
+    else WriteHDR(file, width, height, pixels);
+
+    if (!file)
+    {
+        std::cerr << "[ImageIO] Failed to write " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool ImageIO::Read(const std::string& path, uint32_t& width, uint32_t& height, std::vector<glm::vec3>& pixels)
+{
+    if (GetExtension(path) != ".pfm")
+    {
+        std::cerr << "[ImageIO] Only .pfm images can be read: " << path << "\n";
+        return false;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    std::string magic;
+    float scale = 0.0f;
+    file >> magic >> width >> height >> scale;
+    file.get(); // single whitespace before the raster
+    if (!file || magic != "PF" || width == 0 || height == 0 || scale >= 0.0f)
+    {
+        std::cerr << "[ImageIO] " << path << " is not a little endian RGB .pfm\n";
+        return false;
+    }
+
+    pixels.resize(static_cast<size_t>(width) * height);
+    for (uint32_t y = height; y-- > 0;)
+    {
+        file.read(reinterpret_cast<char*>(&pixels[y * width]), width * sizeof(glm::vec3));
+    }
+    if (!file)
+    {
+        std::cerr << "[ImageIO] " << path << " is truncated\n";
+        return false;
+    }
+    return true;
+}
+
+bool ImageIO::IsSupported(const std::string& path)
+{
+    const std::string extension = GetExtension(path);
+    return extension == ".ppm" || extension == ".bmp" || extension == ".pfm" || extension == ".hdr";
+}
+
+bool ImageIO::IsHDR(const std::string& path)
+{
+    const std::string extension = GetExtension(path);
+    return extension == ".pfm" || extension == ".hdr";
+}
@@ -0,0 +1,67 @@
+#include "MeshBVH.h"
+
+void MeshBVH::Build(const CPUGeometry& geometry, const BVHBuildSettings& settings)
+{
+    std::vector<AABB> bounds = GatherTriangles(geometry);
+    m_bvh.Build(bounds, settings);
+
+    m_compressed.Clear();
+    if (settings.compressed) m_compressed.Build(m_bvh, bounds);
+}
+
+bool MeshBVH::Update(const CPUGeometry& geometry, BVHUpdateMode mode)
+{
+    std::vector<AABB> bounds = GatherTriangles(geometry);
+    bool rebuilt = m_bvh.Update(bounds, mode);
+
+    // Quantized bounds can't be refit in place, re-encode them from the updated binary hierarchy
+    if (m_bvh.GetSettings().compressed) m_compressed.Build(m_bvh, bounds);
+    return rebuilt;
+}
+
+std::vector<AABB> MeshBVH::GatherTriangles(const CPUGeometry& geometry)
+{
+    const uint32_t triangleCount = geometry.GetTriangleCount();
+    m_vertices.resize(triangleCount * 3);
+
+    std::vector<AABB> bounds(triangleCount);
+    for (uint32_t i = 0; i < triangleCount; i++)
+    {
+        for (uint32_t v = 0; v < 3; v++)
+        {
+            m_vertices[i * 3 + v] = geometry.positions[geometry.indices[i * 3 + v]];
+            bounds[i].Grow(m_vertices[i * 3 + v]);
+        }
+    }
+    return bounds;
+}
+
+bool MeshBVH::Intersect(Ray& ray, Hit& hit, TraversalStats* stats) const
+{
+    bool found = false;
+    auto intersectTriangle = [&](uint32_t prim, Ray& r)
+    {
+        const glm::vec3* v = GetTriangle(prim);
+        if (stats && stats->cache) stats->cache->Access(v, 3 * sizeof(glm::vec3));
+        float t;
+        glm::vec2 barycentrics;
+        if (IntersectTriangle(r, v[0], v[1], v[2], t, barycentrics))
+        {
+            r.tMax = t;
+            hit.t = t;
+            hit.barycentrics = barycentrics;
+            hit.primitiveIndex = prim;
+            found = true;
+        }
+    };
+
+    if (IsCompressed())
+    {
+        m_compressed.Traverse(ray, intersectTriangle, stats);
+    }
+    else
+    {
+        m_bvh.Traverse(ray, intersectTriangle, stats);
+    }
+    return found;
+}
@@ -0,0 +1,82 @@
+#include "RaySorter.h"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+namespace
+{
+    constexpr uint32_t RADIX_BITS = 8;
+    constexpr uint32_t RADIX_SIZE = 1u << RADIX_BITS;
+
+    // Spreads the low 10 bits of v so there are two zero bits between each of them
+    uint32_t ExpandBits(uint32_t v)
+    {
+        v = (v * 0x00010001u) & 0xFF0000FFu;
+        v = (v * 0x00000101u) & 0x0F00F00Fu;
+        v = (v * 0x00000011u) & 0xC30C30C3u;
+        v = (v * 0x00000005u) & 0x49249249u;
+        return v;
+    }
+}
+
+uint32_t RaySorter::ComputeKey(const glm::vec3& origin, const glm::vec3& direction, const AABB& bounds)
+{
+    constexpr float cellCount = static_cast<float>(1u << CELL_BITS);
+    glm::vec3 extent = glm::max(bounds.Extent(), glm::vec3(1e-6f));
+    glm::vec3 cell = glm::clamp((origin - bounds.min) / extent * cellCount, glm::vec3(0.0f), glm::vec3(cellCount - 1.0f));
+    uint32_t morton = (ExpandBits(static_cast<uint32_t>(cell.x)) << 2) |
+                      (ExpandBits(static_cast<uint32_t>(cell.y)) << 1) |
+                       ExpandBits(static_cast<uint32_t>(cell.z));
+
+    uint32_t octant = (direction.x < 0.0f ? 4u : 0u) | (direction.y < 0.0f ? 2u : 0u) | (direction.z < 0.0f ? 1u : 0u);
+    return (morton << 3) | octant;
+}
+
+void RaySorter::Sort(const std::vector<uint32_t>& keys, std::vector<uint32_t>& order)
+{
+    const size_t count = keys.size();
+    order.clear();
+    if (count == 0) return;
+
+    for (int i = 0; i < 2; i++)
+    {
+        m_keys[i].resize(count);
+        m_values[i].resize(count);
+    }
+    std::copy(keys.begin(), keys.end(), m_keys[0].begin());
+    std::iota(m_values[0].begin(), m_values[0].end(), 0u);
+
+    uint32_t source = 0;
+    for (uint32_t shift = 0; shift < KEY_BITS; shift += RADIX_BITS)
+    {
+        std::array<uint32_t, RADIX_SIZE> offsets{};
+        for (uint32_t key : m_keys[source])
+        {
+            offsets[(key >> shift) & (RADIX_SIZE - 1)]++;
+        }
+
+        // Every key has the same digit, this pass wouldn't move anything
+        if (offsets[(m_keys[source][0] >> shift) & (RADIX_SIZE - 1)] == count) continue;
+
+        uint32_t sum = 0;
+        for (uint32_t& offset : offsets)
+        {
+            uint32_t digitCount = offset;
+            offset = sum;
+            sum += digitCount;
+        }
+
+        const uint32_t destination = source ^ 1;
+        for (size_t i = 0; i < count; i++)
+        {
+            uint32_t key = m_keys[source][i];
+            uint32_t slot = offsets[(key >> shift) & (RADIX_SIZE - 1)]++;
+            m_keys[destination][slot] = key;
+            m_values[destination][slot] = m_values[source][i];
+        }
+        source = destination;
+    }
+
+    order.swap(m_values[source]);
+}
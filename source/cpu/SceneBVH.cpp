@@ -0,0 +1,103 @@
+#include "SceneBVH.h"
+#include "Parallel.h"
+
+#include <unordered_map>
+
+void SceneBVH::Build(const std::vector<CPUInstance>& instances, const BVHBuildSettings& settings)
+{
+    // Instances sharing a geometry share a bottom level hierarchy
+    std::unordered_map<const CPUGeometry*, uint32_t> meshLookup;
+    std::vector<const CPUGeometry*> geometries;
+    m_instances.clear();
+    m_instances.reserve(instances.size());
+    for (const CPUInstance& instance : instances)
+    {
+        auto [it, inserted] = meshLookup.try_emplace(instance.geometry, static_cast<uint32_t>(geometries.size()));
+        if (inserted) geometries.push_back(instance.geometry);
+
+        BVHInstance& bvhInstance = m_instances.emplace_back();
+        bvhInstance.meshIndex = it->second;
+        bvhInstance.transform = instance.transform;
+        bvhInstance.inverseTransform = glm::inverse(instance.transform);
+    }
+
+    m_meshes.clear();
+    m_meshes.resize(geometries.size());
+    ParallelFor(static_cast<uint32_t>(geometries.size()), [&](uint32_t i, uint32_t)
+    {
+        m_meshes[i].Build(*geometries[i], settings);
+    });
+
+    m_instanceBounds.resize(m_instances.size());
+    for (size_t i = 0; i < m_instances.size(); i++)
+    {
+        BVHInstance& instance = m_instances[i];
+        instance.worldBounds = m_meshes[instance.meshIndex].GetBVH().GetBounds().Transformed(instance.transform);
+        m_instanceBounds[i] = instance.worldBounds;
+    }
+
+    // Instances are few and large, always split them down to single-instance leaves like a TLAS build would
+    BVHBuildSettings topSettings = settings;
+    topSettings.maxLeafSize = 1;
+    m_topLevel.Build(m_instanceBounds, topSettings);
+    m_topLevelDirty = false;
+}
+
+void SceneBVH::SetInstanceTransform(uint32_t instanceIndex, const glm::mat4& transform)
+{
+    BVHInstance& instance = m_instances[instanceIndex];
+    instance.transform = transform;
+    instance.inverseTransform = glm::inverse(transform);
+    instance.worldBounds = m_meshes[instance.meshIndex].GetBVH().GetBounds().Transformed(transform);
+    m_instanceBounds[instanceIndex] = instance.worldBounds;
+    m_topLevelDirty = true;
+}
+
+bool SceneBVH::UpdateMesh(uint32_t meshIndex, const CPUGeometry& geometry, BVHUpdateMode mode)
+{
+    bool rebuilt = m_meshes[meshIndex].Update(geometry, mode);
+
+    AABB meshBounds = m_meshes[meshIndex].GetBVH().GetBounds();
+    for (size_t i = 0; i < m_instances.size(); i++)
+    {
+        BVHInstance& instance = m_instances[i];
+        if (instance.meshIndex != meshIndex) continue;
+        instance.worldBounds = meshBounds.Transformed(instance.transform);
+        m_instanceBounds[i] = instance.worldBounds;
+        m_topLevelDirty = true;
+    }
+    return rebuilt;
+}
+
+bool SceneBVH::UpdateTopLevel(BVHUpdateMode mode)
+{
+    if (!m_topLevelDirty && mode != BVHUpdateMode::Rebuild) return false;
+    m_topLevelDirty = false;
+    return m_topLevel.Update(m_instanceBounds, mode);
+}
+
+bool SceneBVH::Intersect(Ray& ray, Hit& hit, TraversalStats* topStats, TraversalStats* bottomStats) const
+{
+    bool found = false;
+    m_topLevel.Traverse(ray, [&](uint32_t instanceIndex, Ray& r)
+    {
+        const BVHInstance& instance = m_instances[instanceIndex];
+        if (topStats && topStats->cache) topStats->cache->Access(&instance, sizeof(BVHInstance));
+        Ray localRay = ToObjectSpace(r, instance);
+        if (m_meshes[instance.meshIndex].Intersect(localRay, hit, bottomStats))
+        {
+            r.tMax = localRay.tMax;
+            hit.instanceIndex = instanceIndex;
+            found = true;
+        }
+    }, topStats);
+    return found;
+}
+
+Ray SceneBVH::ToObjectSpace(const Ray& ray, const BVHInstance& instance)
+{
+    // The direction is left unnormalized so hit distances stay comparable between spaces
+    glm::vec3 origin = glm::vec3(instance.inverseTransform * glm::vec4(ray.origin, 1.0f));
+    glm::vec3 direction = glm::vec3(instance.inverseTransform * glm::vec4(ray.direction, 0.0f));
+    return Ray(origin, direction, ray.tMax);
+}
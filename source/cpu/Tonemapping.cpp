@@ -0,0 +1,733 @@
+#include "Tonemapping.h"
+#include "Parallel.h"
+#include "RNG.h"
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+
+namespace
+{
+    // Rows of a float3x3 as written in the shaders, so mul(m, v) is three dot products
+    glm::vec3 Mul(const glm::vec3& r0, const glm::vec3& r1, const glm::vec3& r2, const glm::vec3& v)
+    {
+        return { glm::dot(r0, v), glm::dot(r1, v), glm::dot(r2, v) };
+    }
+
+    // aces.slang
+    glm::vec3 RttAndOdtFit(const glm::vec3& v)
+    {
+        glm::vec3 a = v * (v + 0.0245786f) - 0.000090537f;
+        glm::vec3 b = v * (0.983729f * v + 0.4329510f) + 0.238081f;
+        return a / b;
+    }
+
+    glm::vec3 TonemapACES(glm::vec3 color)
+    {
+        color = Mul({ 0.59719f, 0.35458f, 0.04823f },
+                    { 0.07600f, 0.90834f, 0.01566f },
+                    { 0.02840f, 0.13383f, 0.83777f }, color);
+        color = RttAndOdtFit(color);
+        return Mul({ 1.60475f, -0.53108f, -0.07367f },
+                   { -0.10208f, 1.10813f, -0.00605f },
+                   { -0.00327f, -0.07276f, 1.07602f }, color);
+    }
+
+    // reinhard.slang
+    glm::vec3 TonemapReinhard(glm::vec3 color)
+    {
+        color = glm::max(color, 0.0f);
+        return color / (1.0f + color);
+    }
+
+    // agx.slang, default look
+    glm::vec3 AgxDefaultContrastApprox(const glm::vec3& x)
+    {
+        glm::vec3 x2 = x * x;
+        glm::vec3 x4 = x2 * x2;
+
+        return +15.5f * x4 * x2
+               - 40.14f * x4 * x
+               + 31.96f * x4
+               - 6.868f * x2 * x
+               + 0.4298f * x2
+               + 0.1191f * x
+               - 0.00232f;
+    }
+
+    glm::vec3 TonemapAgX(glm::vec3 val)
+    {
+        constexpr float minEv = -12.47393f;
+        constexpr float maxEv = 4.026069f;
+
+        val = Mul({ 0.842479062253094f, 0.0784335999999992f, 0.0792237451477643f },
+                  { 0.0423282422610123f, 0.878468636469772f, 0.0791661274605434f },
+                  { 0.0423756549057051f, 0.0784336f, 0.879142973793104f }, val);
+        val = glm::clamp(glm::log2(val), minEv, maxEv);
+        val = (val - minEv) / (maxEv - minEv);
+        val = AgxDefaultContrastApprox(val);
+
+        // agxLook, slope and power are 1 and offset 0 for the default look
+        constexpr float saturation = 1.15f;
+        float luma = glm::dot(val, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+        val = luma + saturation * (val - luma);
+
+        // agxEotf
+        val = Mul({ 1.19687900512017f, -0.0980208811401368f, -0.0990297440797205f },
+                  { -0.0528968517574562f, 1.15190312990417f, -0.0989611768448433f },
+                  { -0.0529716355144438f, -0.0980434501171241f, 1.15107367264116f }, val);
+        return glm::pow(val, glm::vec3(2.2f));
+    }
+
+    // gt7.slang, ICtCp variant initialized for SDR
+    constexpr float GT7_SDR_PAPER_WHITE = 250.0f;
+    constexpr float GT7_REFERENCE_LUMINANCE = 100.0f;
+
+    float SmoothStep(float x, float edge0, float edge1)
+    {
+        float t = (x - edge0) / (edge1 - edge0);
+        if (x < edge0) return 0.0f;
+        if (x > edge1) return 1.0f;
+        return t * t * (3.0f - 2.0f * t);
+    }
+
+    float EotfSt2084(float n)
+    {
+        constexpr float m1 = 0.1593017578125f;
+        constexpr float m2 = 78.84375f;
+        constexpr float c1 = 0.8359375f;
+        constexpr float c2 = 18.8515625f;
+        constexpr float c3 = 18.6875f;
+        constexpr float pqC = 10000.0f;
+
+        n = std::clamp(n, 0.0f, 1.0f);
+        float np = std::pow(n, 1.0f / m2);
+        float l = std::max(np - c1, 0.0f);
+        l = l / (c2 - c3 * np);
+        l = std::pow(l, 1.0f / m1);
+        return l * pqC / GT7_REFERENCE_LUMINANCE;
+    }
+
+    float InverseEotfSt2084(float v)
+    {
+        constexpr float m1 = 0.1593017578125f;
+        constexpr float m2 = 78.84375f;
+        constexpr float c1 = 0.8359375f;
+        constexpr float c2 = 18.8515625f;
+        constexpr float c3 = 18.6875f;
+        constexpr float pqC = 10000.0f;
+
+        float y = v * GT7_REFERENCE_LUMINANCE / pqC;
+        float ym = std::pow(y, m1);
+        return std::exp2(m2 * (std::log2(c1 + c2 * ym) - std::log2(1.0f + c3 * ym)));
+    }
+
+    glm::vec3 RgbToICtCp(const glm::vec3& rgb)
+    {
+        float l = (rgb.x * 1688.0f + rgb.y * 2146.0f + rgb.z * 262.0f) / 4096.0f;
+        float m = (rgb.x * 683.0f + rgb.y * 2951.0f + rgb.z * 462.0f) / 4096.0f;
+        float s = (rgb.x * 99.0f + rgb.y * 309.0f + rgb.z * 3688.0f) / 4096.0f;
+
+        float lPQ = InverseEotfSt2084(l);
+        float mPQ = InverseEotfSt2084(m);
+        float sPQ = InverseEotfSt2084(s);
+
+        return { (2048.0f * lPQ + 2048.0f * mPQ) / 4096.0f,
+                 (6610.0f * lPQ - 13613.0f * mPQ + 7003.0f * sPQ) / 4096.0f,
+                 (17933.0f * lPQ - 17390.0f * mPQ - 543.0f * sPQ) / 4096.0f };
+    }
+
+    glm::vec3 ICtCpToRgb(const glm::vec3& ictCp)
+    {
+        float l = ictCp.x + 0.00860904f * ictCp.y + 0.11103f * ictCp.z;
+        float m = ictCp.x - 0.00860904f * ictCp.y - 0.11103f * ictCp.z;
+        float s = ictCp.x + 0.560031f * ictCp.y - 0.320627f * ictCp.z;
+
+        float lLin = EotfSt2084(l);
+        float mLin = EotfSt2084(m);
+        float sLin = EotfSt2084(s);
+
+        return { std::max(3.43661f * lLin - 2.50645f * mLin + 0.0698454f * sLin, 0.0f),
+                 std::max(-0.79133f * lLin + 1.9836f * mLin - 0.192271f * sLin, 0.0f),
+                 std::max(-0.0259499f * lLin - 0.0989137f * mLin + 1.12486f * sLin, 0.0f) };
+    }
+
+    // GTToneMappingCurveV2 and GT7ToneMapping::initializeAsSDR, computed once instead of per pixel
+    struct GT7Curve
+    {
+        float peakIntensity = GT7_SDR_PAPER_WHITE / GT7_REFERENCE_LUMINANCE;
+        float midPoint = 0.538f;
+        float linearSection = 0.444f;
+        float toeStrength = 1.280f;
+        float kA, kB, kC;
+        float sdrCorrectionFactor = 1.0f / peakIntensity;
+        float targetUcs;
+        float blendRatio = 0.6f;
+        float fadeStart = 0.98f;
+        float fadeEnd = 1.16f;
+
+        GT7Curve()
+        {
+            constexpr float alpha = 0.25f;
+            float k = (linearSection - 1.0f) / (alpha - 1.0f);
+            kA = peakIntensity * linearSection + peakIntensity * k;
+            kB = -peakIntensity * k * std::exp(linearSection / k);
+            kC = -1.0f / (k * peakIntensity);
+            targetUcs = RgbToICtCp(glm::vec3(peakIntensity)).x;
+        }
+
+        [[nodiscard]] float Evaluate(float x) const
+        {
+            if (x < 0.0f) return 0.0f;
+
+            float weightLinear = SmoothStep(x, 0.0f, midPoint);
+            float weightToe = 1.0f - weightLinear;
+            if (x < linearSection * peakIntensity)
+            {
+                float toeMapped = midPoint * std::pow(x / midPoint, toeStrength);
+                return weightToe * toeMapped + weightLinear * x;
+            }
+            return kA + kB * std::exp(x * kC);
+        }
+    };
+
+    glm::vec3 TonemapGT7(glm::vec3 rgb)
+    {
+        static const GT7Curve curve;
+
+        rgb = Mul({ 0.6274040f, 0.3292820f, 0.0433136f },
+                  { 0.0690970f, 0.9195400f, 0.0113612f },
+                  { 0.0163916f, 0.0880132f, 0.8955950f }, rgb);
+
+        glm::vec3 ucs = RgbToICtCp(rgb);
+        glm::vec3 skewedRgb = { curve.Evaluate(rgb.x), curve.Evaluate(rgb.y), curve.Evaluate(rgb.z) };
+        glm::vec3 skewedUcs = RgbToICtCp(skewedRgb);
+
+        float chromaScale = 1.0f - SmoothStep(ucs.x / curve.targetUcs, curve.fadeStart, curve.fadeEnd);
+        glm::vec3 scaledRgb = ICtCpToRgb({ skewedUcs.x, ucs.y * chromaScale, ucs.z * chromaScale });
+
+        glm::vec3 blended = (1.0f - curve.blendRatio) * skewedRgb + curve.blendRatio * scaledRgb;
+        glm::vec3 result = curve.sdrCorrectionFactor * glm::min(blended, curve.peakIntensity);
+
+        result = Mul({ 1.6604910f, -0.5876411f, -0.0728499f },
+                     { -0.1245505f, 1.1328999f, -0.0083494f },
+                     { -0.0181508f, -0.1005789f, 1.1187297f }, result);
+        return glm::max(result, 0.0f);
+    }
+
+    constexpr const char* OPERATOR_NAMES[] = { "linear", "aces", "reinhard", "agx", "gt7" };
+
+    // Batch path: the operators above rewritten over eight pixels at a time, one array per channel. Every
+    // operation is a fixed length loop without branches, and log2/exp2 are polynomial approximations
+    // instead of library calls, so the compiler turns each loop into SSE/AVX instructions
+    constexpr size_t LANES = 8;
+
+    struct Lanes
+    {
+        float v[LANES];
+
+        Lanes() = default;
+        Lanes(float s) { for (size_t i = 0; i < LANES; i++) v[i] = s; }
+    };
+
+    template<typename Fn>
+    Lanes Map(const Lanes& a, const Lanes& b, Fn&& fn)
+    {
+        Lanes r;
+        for (size_t i = 0; i < LANES; i++) r.v[i] = fn(a.v[i], b.v[i]);
+        return r;
+    }
+
+    Lanes operator+(const Lanes& a, const Lanes& b) { return Map(a, b, [](float x, float y) { return x + y; }); }
+    Lanes operator-(const Lanes& a, const Lanes& b) { return Map(a, b, [](float x, float y) { return x - y; }); }
+    Lanes operator*(const Lanes& a, const Lanes& b) { return Map(a, b, [](float x, float y) { return x * y; }); }
+    Lanes operator/(const Lanes& a, const Lanes& b) { return Map(a, b, [](float x, float y) { return x / y; }); }
+    Lanes Min(const Lanes& a, const Lanes& b) { return Map(a, b, [](float x, float y) { return x < y ? x : y; }); }
+    Lanes Max(const Lanes& a, const Lanes& b) { return Map(a, b, [](float x, float y) { return x > y ? x : y; }); }
+    Lanes Clamp(const Lanes& x, float lo, float hi) { return Min(Max(x, lo), hi); }
+
+    // condition < threshold ? a : b, as a bit mask blend. A conditional choosing between two different arrays
+    // isn't if-converted by every compiler, floating point comparisons could trap
+    Lanes SelectLess(const Lanes& condition, const Lanes& threshold, const Lanes& a, const Lanes& b)
+    {
+        Lanes r;
+        for (size_t i = 0; i < LANES; i++)
+        {
+            const int32_t mask = -static_cast<int32_t>(condition.v[i] < threshold.v[i]);
+            r.v[i] = std::bit_cast<float>((std::bit_cast<int32_t>(a.v[i]) & mask) | (std::bit_cast<int32_t>(b.v[i]) & ~mask));
+        }
+        return r;
+    }
+
+    // Rounds to the nearest integer, splits off the fraction in [-0.5, 0.5] and builds 2^integer from the exponent
+    // bits. Degree 6 Taylor polynomial, relative error below 2e-7. Flushes to 0 below 2^-126
+    Lanes Exp2(const Lanes& x)
+    {
+        const Lanes clamped = Clamp(x, -127.0f, 127.0f);
+        Lanes r;
+        for (size_t i = 0; i < LANES; i++)
+        {
+            const float c = clamped.v[i];
+            // Truncation rounds down once the value is positive
+            const int32_t n = static_cast<int32_t>(c + 128.5f) - 128;
+            const float f = c - static_cast<float>(n);
+            float p = 1.5403530e-4f;
+            p = p * f + 1.3333558e-3f;
+            p = p * f + 9.6181291e-3f;
+            p = p * f + 5.5504109e-2f;
+            p = p * f + 2.4022651e-1f;
+            p = p * f + 6.9314718e-1f;
+            p = p * f + 1.0f;
+            r.v[i] = p * std::bit_cast<float>((n + 127) << 23);
+        }
+        return r;
+    }
+
+    // Exponent from the bits, log2 of the mantissa in [sqrt(1/2), sqrt(2)) from the atanh series, absolute
+    // error below 1e-7. Non-positive inputs give a large negative number where log2 gives -inf or NaN
+    Lanes Log2(const Lanes& x)
+    {
+        const Lanes positive = SelectLess(0.0f, x, x, 1.0f);
+        Lanes r;
+        for (size_t i = 0; i < LANES; i++)
+        {
+            const int32_t bits = std::bit_cast<int32_t>(positive.v[i]);
+            // Moves mantissas above sqrt(2) down an octave so the series argument stays small
+            const int32_t adjusted = bits - 0x3F3504F3;
+            const int32_t exponent = adjusted >> 23;
+            const float m = std::bit_cast<float>((adjusted & 0x007FFFFF) + 0x3F3504F3);
+            const float t = (m - 1.0f) / (m + 1.0f);
+            const float t2 = t * t;
+            float p = 1.0f / 9.0f;
+            p = p * t2 + 1.0f / 7.0f;
+            p = p * t2 + 1.0f / 5.0f;
+            p = p * t2 + 1.0f / 3.0f;
+            p = p * t2 + 1.0f;
+            r.v[i] = static_cast<float>(exponent) + 2.8853900817779268f * t * p; // 2 / ln(2)
+        }
+        return SelectLess(0.0f, x, r, -1000.0f);
+    }
+
+    // pow for non-negative bases, 0 for the rest
+    Lanes Pow(const Lanes& x, const Lanes& y)
+    {
+        const Lanes result = Exp2(y * Log2(x));
+        return SelectLess(0.0f, x, result, 0.0f);
+    }
+
+    Lanes Exp(const Lanes& x) { return Exp2(x * 1.4426950408889634f); }
+
+    struct Block
+    {
+        Lanes r, g, b;
+    };
+
+    // mul(m, v) with the rows of m
+    Block Mul(const glm::vec3& r0, const glm::vec3& r1, const glm::vec3& r2, const Block& c)
+    {
+        return { r0.x * c.r + r0.y * c.g + r0.z * c.b,
+                 r1.x * c.r + r1.y * c.g + r1.z * c.b,
+                 r2.x * c.r + r2.y * c.g + r2.z * c.b };
+    }
+
+    Lanes RttAndOdtFit(const Lanes& v)
+    {
+        Lanes a = v * (v + 0.0245786f) - 0.000090537f;
+        Lanes b = v * (0.983729f * v + 0.4329510f) + 0.238081f;
+        return a / b;
+    }
+
+    Block TonemapACES(Block c)
+    {
+        c = Mul({ 0.59719f, 0.35458f, 0.04823f },
+                { 0.07600f, 0.90834f, 0.01566f },
+                { 0.02840f, 0.13383f, 0.83777f }, c);
+        c = { RttAndOdtFit(c.r), RttAndOdtFit(c.g), RttAndOdtFit(c.b) };
+        return Mul({ 1.60475f, -0.53108f, -0.07367f },
+                   { -0.10208f, 1.10813f, -0.00605f },
+                   { -0.00327f, -0.07276f, 1.07602f }, c);
+    }
+
+    Lanes Reinhard(Lanes x)
+    {
+        x = Max(x, 0.0f);
+        return x / (1.0f + x);
+    }
+
+    Lanes AgxContrast(const Lanes& x)
+    {
+        Lanes x2 = x * x;
+        Lanes x4 = x2 * x2;
+        return 15.5f * x4 * x2 - 40.14f * x4 * x + 31.96f * x4 - 6.868f * x2 * x + 0.4298f * x2 + 0.1191f * x - 0.00232f;
+    }
+
+    Lanes AgxEncode(const Lanes& x)
+    {
+        constexpr float minEv = -12.47393f;
+        constexpr float maxEv = 4.026069f;
+        return AgxContrast((Clamp(Log2(x), minEv, maxEv) - minEv) / (maxEv - minEv));
+    }
+
+    Block TonemapAgX(Block c)
+    {
+        c = Mul({ 0.842479062253094f, 0.0784335999999992f, 0.0792237451477643f },
+                { 0.0423282422610123f, 0.878468636469772f, 0.0791661274605434f },
+                { 0.0423756549057051f, 0.0784336f, 0.879142973793104f }, c);
+        c = { AgxEncode(c.r), AgxEncode(c.g), AgxEncode(c.b) };
+
+        constexpr float saturation = 1.15f;
+        Lanes luma = 0.2126f * c.r + 0.7152f * c.g + 0.0722f * c.b;
+        c = { luma + saturation * (c.r - luma), luma + saturation * (c.g - luma), luma + saturation * (c.b - luma) };
+
+        c = Mul({ 1.19687900512017f, -0.0980208811401368f, -0.0990297440797205f },
+                { -0.0528968517574562f, 1.15190312990417f, -0.0989611768448433f },
+                { -0.0529716355144438f, -0.0980434501171241f, 1.15107367264116f }, c);
+        return { Pow(c.r, 2.2f), Pow(c.g, 2.2f), Pow(c.b, 2.2f) };
+    }
+
+    Lanes SmoothStep(const Lanes& x, float edge0, float edge1)
+    {
+        Lanes t = Clamp((x - edge0) / (edge1 - edge0), 0.0f, 1.0f);
+        return t * t * (3.0f - 2.0f * t);
+    }
+
+    constexpr float PQ_M1 = 0.1593017578125f;
+    constexpr float PQ_M2 = 78.84375f;
+    constexpr float PQ_C1 = 0.8359375f;
+    constexpr float PQ_C2 = 18.8515625f;
+    constexpr float PQ_C3 = 18.6875f;
+    constexpr float PQ_C = 10000.0f;
+
+    Lanes EotfSt2084(const Lanes& n)
+    {
+        Lanes np = Pow(Clamp(n, 0.0f, 1.0f), 1.0f / PQ_M2);
+        Lanes l = Max(np - PQ_C1, 0.0f) / (PQ_C2 - PQ_C3 * np);
+        return Pow(l, 1.0f / PQ_M1) * (PQ_C / GT7_REFERENCE_LUMINANCE);
+    }
+
+    Lanes InverseEotfSt2084(const Lanes& v)
+    {
+        Lanes ym = Pow(v * (GT7_REFERENCE_LUMINANCE / PQ_C), PQ_M1);
+        return Exp2(PQ_M2 * (Log2(PQ_C1 + PQ_C2 * ym) - Log2(1.0f + PQ_C3 * ym)));
+    }
+
+    Block RgbToICtCp(const Block& c)
+    {
+        Lanes l = InverseEotfSt2084((c.r * 1688.0f + c.g * 2146.0f + c.b * 262.0f) / 4096.0f);
+        Lanes m = InverseEotfSt2084((c.r * 683.0f + c.g * 2951.0f + c.b * 462.0f) / 4096.0f);
+        Lanes s = InverseEotfSt2084((c.r * 99.0f + c.g * 309.0f + c.b * 3688.0f) / 4096.0f);
+        return { (2048.0f * l + 2048.0f * m) / 4096.0f,
+                 (6610.0f * l - 13613.0f * m + 7003.0f * s) / 4096.0f,
+                 (17933.0f * l - 17390.0f * m - 543.0f * s) / 4096.0f };
+    }
+
+    Block ICtCpToRgb(const Block& c)
+    {
+        Lanes l = EotfSt2084(c.r + 0.00860904f * c.g + 0.11103f * c.b);
+        Lanes m = EotfSt2084(c.r - 0.00860904f * c.g - 0.11103f * c.b);
+        Lanes s = EotfSt2084(c.r + 0.560031f * c.g - 0.320627f * c.b);
+        return { Max(3.43661f * l - 2.50645f * m + 0.0698454f * s, 0.0f),
+                 Max(-0.79133f * l + 1.9836f * m - 0.192271f * s, 0.0f),
+                 Max(-0.0259499f * l - 0.0989137f * m + 1.12486f * s, 0.0f) };
+    }
+
+    // GT7Curve::Evaluate with both sides of the branches computed
+    Lanes EvaluateGT7Curve(const GT7Curve& curve, const Lanes& x)
+    {
+        Lanes weightLinear = SmoothStep(x, 0.0f, curve.midPoint);
+        Lanes toeMapped = curve.midPoint * Pow(x / curve.midPoint, curve.toeStrength);
+        Lanes toe = (1.0f - weightLinear) * toeMapped + weightLinear * x;
+        Lanes shoulder = curve.kA + curve.kB * Exp(x * curve.kC);
+        Lanes mapped = SelectLess(x, curve.linearSection * curve.peakIntensity, toe, shoulder);
+        return SelectLess(x, 0.0f, 0.0f, mapped);
+    }
+
+    Block TonemapGT7(Block c)
+    {
+        static const GT7Curve curve;
+
+        c = Mul({ 0.6274040f, 0.3292820f, 0.0433136f },
+                { 0.0690970f, 0.9195400f, 0.0113612f },
+                { 0.0163916f, 0.0880132f, 0.8955950f }, c);
+
+        Block ucs = RgbToICtCp(c);
+        Block skewed = { EvaluateGT7Curve(curve, c.r), EvaluateGT7Curve(curve, c.g), EvaluateGT7Curve(curve, c.b) };
+        Block skewedUcs = RgbToICtCp(skewed);
+
+        Lanes chromaScale = 1.0f - SmoothStep(ucs.r / curve.targetUcs, curve.fadeStart, curve.fadeEnd);
+        Block scaled = ICtCpToRgb(Block{ skewedUcs.r, ucs.g * chromaScale, ucs.b * chromaScale });
+
+        auto blend = [&](const Lanes& s, const Lanes& t)
+        {
+            return curve.sdrCorrectionFactor * Min((1.0f - curve.blendRatio) * s + curve.blendRatio * t, curve.peakIntensity);
+        };
+        c = { blend(skewed.r, scaled.r), blend(skewed.g, scaled.g), blend(skewed.b, scaled.b) };
+
+        c = Mul({ 1.6604910f, -0.5876411f, -0.0728499f },
+                { -0.1245505f, 1.1328999f, -0.0083494f },
+                { -0.0181508f, -0.1005789f, 1.1187297f }, c);
+        return { Max(c.r, 0.0f), Max(c.g, 0.0f), Max(c.b, 0.0f) };
+    }
+
+    Block TonemapBlock(const Block& c, Tonemapping::Operator op)
+    {
+        switch (op)
+        {
+            case Tonemapping::Operator::Aces:     return TonemapACES(c);
+            case Tonemapping::Operator::Reinhard: return { Reinhard(c.r), Reinhard(c.g), Reinhard(c.b) };
+            case Tonemapping::Operator::AgX:      return TonemapAgX(c);
+            case Tonemapping::Operator::GT7:      return TonemapGT7(c);
+            default:                              return c;
+        }
+    }
+
+    // Tonemaps count pixels of an RGBA image, dividing by the sample count in alpha first when resolving.
+    // store(index, rgb, alpha) writes one pixel of the result
+    template<typename Store>
+    void TonemapImage(const glm::vec4* image, size_t count, Tonemapping::Operator op, float exposure, bool resolve,
+                      uint32_t workerCount, Store&& store)
+    {
+        constexpr size_t CHUNK_SIZE = 1024;
+
+        const uint32_t chunkCount = static_cast<uint32_t>((count + CHUNK_SIZE - 1) / CHUNK_SIZE);
+        ParallelFor(chunkCount, [&](uint32_t chunk, uint32_t)
+        {
+            const size_t end = std::min(count, (chunk + 1) * CHUNK_SIZE);
+            for (size_t first = chunk * CHUNK_SIZE; first < end; first += LANES)
+            {
+                const size_t lanes = std::min(LANES, end - first);
+                Block block{ 0.0f, 0.0f, 0.0f };
+                for (size_t i = 0; i < lanes; i++)
+                {
+                    const glm::vec4& pixel = image[first + i];
+                    const float scale = resolve ? exposure / std::max(pixel.w, 1.0f) : exposure;
+                    block.r.v[i] = pixel.x * scale;
+                    block.g.v[i] = pixel.y * scale;
+                    block.b.v[i] = pixel.z * scale;
+                }
+
+                block = TonemapBlock(block, op);
+                for (size_t i = 0; i < lanes; i++)
+                {
+                    store(first + i, glm::vec3(block.r.v[i], block.g.v[i], block.b.v[i]), image[first + i].w);
+                }
+            }
+        }, workerCount);
+    }
+
+    // HDR test image: random hues over 16 stops of brightness, a few pixels black or negative
+    std::vector<glm::vec4> CreateBenchmarkImage(size_t count)
+    {
+        std::vector<glm::vec4> image(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            RNG rng = RNG::Create(static_cast<uint32_t>(i), 0);
+            const float brightness = std::exp2(rng.NextFloat() * 16.0f - 12.0f);
+            const glm::vec3 hue = glm::vec3(rng.NextFloat(), rng.NextFloat(), rng.NextFloat());
+            const float special = rng.NextFloat();
+            const glm::vec3 color = special < 0.01f ? glm::vec3(0.0f) : special < 0.02f ? -hue : hue * brightness;
+            image[i] = glm::vec4(color, 1.0f);
+        }
+        return image;
+    }
+}
+
+glm::vec3 Tonemapping::Apply(glm::vec3 color, Operator op, float exposure)
+{
+    color *= exposure;
+
+    switch (op)
+    {
+        case Operator::Linear:   return color;
+        case Operator::Aces:     return TonemapACES(color);
+        case Operator::Reinhard: return TonemapReinhard(color);
+        case Operator::AgX:      return TonemapAgX(color);
+        case Operator::GT7:      return TonemapGT7(color);
+        default:                 return color;
+    }
+}
+
+std::vector<glm::vec4> Tonemapping::Apply(const std::vector<glm::vec4>& image, Operator op, float exposure)
+{
+    std::vector<glm::vec4> result(image.size());
+    TonemapImage(image.data(), image.size(), op, exposure, false, GetWorkerCount(),
+                 [&](size_t i, const glm::vec3& rgb, float alpha) { result[i] = glm::vec4(rgb, alpha); });
+    return result;
+}
+
+std::vector<glm::vec3> Tonemapping::Resolve(const std::vector<glm::vec4>& accumulation, Operator op, float exposure)
+{
+    std::vector<glm::vec3> result(accumulation.size());
+    TonemapImage(accumulation.data(), accumulation.size(), op, exposure, true, GetWorkerCount(),
+                 [&](size_t i, const glm::vec3& rgb, float) { result[i] = rgb; });
+    return result;
+}
+
+glm::vec3 Tonemapping::Lut::Encode(const glm::vec3& color) const
+{
+    return glm::clamp(glm::log2(glm::max(color, 1e-30f)) * scale + offset, 0.0f, 1.0f);
+}
+
+glm::vec3 Tonemapping::Lut::Sample(const glm::vec3& color) const
+{
+    const glm::vec3 position = Encode(color) * static_cast<float>(size - 1);
+    const glm::uvec3 base = glm::min(glm::uvec3(position), glm::uvec3(size - 2));
+    const glm::vec3 t = position - glm::vec3(base);
+
+    auto texel = [&](uint32_t x, uint32_t y, uint32_t z) { return glm::vec3(texels[(static_cast<size_t>(z) * size + y) * size + x]); };
+    glm::vec3 result(0.0f);
+    for (uint32_t corner = 0; corner < 8; corner++)
+    {
+        const glm::uvec3 offset(corner & 1, (corner >> 1) & 1, corner >> 2);
+        const glm::vec3 weight = glm::mix(1.0f - t, t, glm::vec3(offset));
+        result += weight.x * weight.y * weight.z * texel(base.x + offset.x, base.y + offset.y, base.z + offset.z);
+    }
+    return result;
+}
+
+Tonemapping::Lut Tonemapping::BakeLut(Operator op, float exposure, uint32_t size)
+{
+    Lut lut;
+    lut.size = std::max(size, 2u);
+    lut.scale = 1.0f / (Lut::MAX_EV - Lut::MIN_EV);
+    lut.offset = (std::log2(std::max(exposure, 1e-30f)) - Lut::MIN_EV) * lut.scale;
+
+    // Colors at the grid points without exposure, it's applied by the operator like on the GPU
+    std::vector<float> levels(lut.size);
+    for (uint32_t i = 0; i < lut.size; i++)
+    {
+        const float encoded = static_cast<float>(i) / static_cast<float>(lut.size - 1);
+        levels[i] = i == 0 ? 0.0f : std::exp2((encoded - lut.offset) / lut.scale);
+    }
+
+    std::vector<glm::vec4> colors(static_cast<size_t>(lut.size) * lut.size * lut.size);
+    for (size_t i = 0; i < colors.size(); i++)
+    {
+        colors[i] = glm::vec4(levels[i % lut.size], levels[(i / lut.size) % lut.size], levels[i / (lut.size * lut.size)], 1.0f);
+    }
+    lut.texels = Apply(colors, op, exposure);
+    return lut;
+}
+
+float Tonemapping::GetLutError(const Lut& lut, Operator op, float exposure, uint32_t sampleCount)
+{
+    // Radiance is never negative, the LUT clamps it to black
+    const std::vector<glm::vec4> colors = CreateBenchmarkImage(sampleCount);
+    float maxError = 0.0f;
+    for (const glm::vec4& color : colors)
+    {
+        const glm::vec3 radiance = glm::max(glm::vec3(color), 0.0f);
+        const glm::vec3 expected = glm::clamp(Apply(radiance, op, exposure), 0.0f, 1.0f);
+        const glm::vec3 error = glm::abs(expected - glm::clamp(lut.Sample(radiance), 0.0f, 1.0f));
+        if (!glm::any(glm::isnan(expected))) maxError = std::max({ maxError, error.x, error.y, error.z });
+    }
+    return maxError;
+}
+
+std::vector<glm::vec3> Tonemapping::ResolveLinear(const std::vector<glm::vec4>& accumulation)
+{
+    std::vector<glm::vec3> result(accumulation.size());
+    for (size_t i = 0; i < accumulation.size(); i++)
+    {
+        result[i] = glm::vec3(accumulation[i]) / std::max(accumulation[i].w, 1.0f);
+    }
+    return result;
+}
+
+bool Tonemapping::ParseOperator(const std::string& name, Operator& op)
+{
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    for (uint32_t i = 0; i < std::size(OPERATOR_NAMES); i++)
+    {
+        if (lower == OPERATOR_NAMES[i])
+        {
+            op = static_cast<Operator>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* Tonemapping::GetOperatorName(Operator op)
+{
+    uint32_t index = static_cast<uint32_t>(op);
+    return index < std::size(OPERATOR_NAMES) ? OPERATOR_NAMES[index] : "unknown";
+}
+
+std::vector<Tonemapping::BenchmarkResult> Tonemapping::RunBenchmark(uint32_t width, uint32_t height, uint32_t repetitions)
+{
+    using Clock = std::chrono::steady_clock;
+
+    const size_t count = static_cast<size_t>(width) * height;
+    const std::vector<glm::vec4> image = CreateBenchmarkImage(count);
+    std::vector<glm::vec4> scalar(count);
+    std::vector<glm::vec4> vector(count);
+    repetitions = std::max(repetitions, 1u);
+
+    auto megapixelsPerSecond = [&](auto&& fn)
+    {
+        const auto start = Clock::now();
+        for (uint32_t r = 0; r < repetitions; r++) fn();
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        return static_cast<double>(count) * repetitions / (seconds * 1e6);
+    };
+
+    std::vector<BenchmarkResult> results;
+    for (uint32_t o = 0; o < std::size(OPERATOR_NAMES); o++)
+    {
+        const Operator op = static_cast<Operator>(o);
+        BenchmarkResult result;
+        result.op = op;
+        result.scalarMegapixelsPerSecond = megapixelsPerSecond([&]
+        {
+            for (size_t i = 0; i < count; i++) scalar[i] = glm::vec4(Apply(glm::vec3(image[i]), op, 1.0f), image[i].w);
+        });
+        auto store = [&](size_t i, const glm::vec3& rgb, float alpha) { vector[i] = glm::vec4(rgb, alpha); };
+        result.vectorMegapixelsPerSecond = megapixelsPerSecond([&] { TonemapImage(image.data(), count, op, 1.0f, false, 1, store); });
+        result.threadedMegapixelsPerSecond = megapixelsPerSecond([&] { TonemapImage(image.data(), count, op, 1.0f, false, GetWorkerCount(), store); });
+
+        // Compared after clamping to the displayable range, NaN from the scalar pow of negative values counts as 0
+        for (size_t i = 0; i < count; i++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                const float expected = std::isnan(scalar[i][c]) ? 0.0f : std::clamp(scalar[i][c], 0.0f, 1.0f);
+                result.maxError = std::max(result.maxError, std::abs(expected - std::clamp(vector[i][c], 0.0f, 1.0f)));
+            }
+        }
+
+        const auto bakeStart = Clock::now();
+        const Lut lut = BakeLut(op, 1.0f);
+        result.lutBakeMs = std::chrono::duration<double, std::milli>(Clock::now() - bakeStart).count();
+        result.lutMaxError = GetLutError(lut, op, 1.0f);
+        results.push_back(result);
+    }
+    return results;
+}
+
+void Tonemapping::PrintBenchmark(std::ostream& out, const std::vector<BenchmarkResult>& results)
+{
+    std::ios_base::fmtflags flags = out.flags();
+
+    out << "[Tonemapping] Megapixels per second, " << GetWorkerCount() << " threads\n";
+    out << "  operator      scalar     batch  threaded   max error    LUT bake   LUT error\n";
+    for (const BenchmarkResult& result : results)
+    {
+        out << "  " << std::left << std::setw(10) << GetOperatorName(result.op) << std::right
+            << std::fixed << std::setprecision(1) << std::setw(10) << result.scalarMegapixelsPerSecond
+            << std::setw(10) << result.vectorMegapixelsPerSecond
+            << std::setw(10) << result.threadedMegapixelsPerSecond
+            << std::scientific << std::setprecision(2) << std::setw(12) << result.maxError
+            << std::fixed << std::setprecision(2) << std::setw(9) << result.lutBakeMs << " ms"
+            << std::scientific << std::setprecision(2) << std::setw(12) << result.lutMaxError << "\n";
+    }
+    out << "  errors are against the scalar port after clamping to [0, 1], 1 / 255 is one 8-bit step\n";
+    out << "  LUTs are " << Lut::DEFAULT_SIZE << "^3, the batch path bakes them\n";
+
+    out.flags(flags);
+}
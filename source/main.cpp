@@ -1,11 +1,73 @@
-#include <windows.h>
-#include "Application.h"
+#include "HeadlessRenderer.h"
+#include "ConvergenceBenchmark.h"
+#include "BackendBenchmark.h"
+#include "DistributedRenderer.h"
+#include "Tonemapping.h"
 
-#include <windows.h>
+#include <cstring>
 #include <iostream>
 
+#ifdef _WIN32
+#include <windows.h>
+#include "Application.h"
+#endif
+
 int main(int argc, char* argv[])
 {
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--tonemap-benchmark") == 0)
+        {
+            Tonemapping::PrintBenchmark(std::cout, Tonemapping::RunBenchmark(1920, 1080, 4));
+            return 0;
+        }
+    }
+
+    if (BackendBenchmark::IsRequested(argc, argv))
+    {
+        return BackendBenchmark::RunFromCommandLine(argc, argv);
+    }
+
+    if (ConvergenceBenchmark::IsRequested(argc, argv))
+    {
+        try
+        {
+            return ConvergenceBenchmark::RunFromCommandLine(argc, argv);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    if (HeadlessRenderer::IsRequested(argc, argv))
+    {
+        HeadlessOptions options;
+        if (!HeadlessOptions::Parse(argc, argv, options))
+        {
+            HeadlessOptions::PrintUsage(std::cerr);
+            return 1;
+        }
+
+        try
+        {
+            if (options.workerCount > 0)
+            {
+                DistributedRenderer renderer{ std::move(options) };
+                return renderer.Run();
+            }
+            HeadlessRenderer renderer{ std::move(options) };
+            return renderer.Run();
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+#ifdef _WIN32
     try
     {
         bool enableDebug = false;
@@ -26,4 +88,9 @@ int main(int argc, char* argv[])
         MessageBoxA(nullptr, e.what(), "Error", MB_OK | MB_ICONERROR);
         return 1;
     }
+#else
+    // The interactive renderer needs D3D12, the headless modes above render on the CPU
+    std::cerr << "The interactive renderer is only available on Windows, use --headless to render on the CPU\n";
+    return 1;
+#endif
 }
\ No newline at end of file
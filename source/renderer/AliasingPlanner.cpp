@@ -0,0 +1,105 @@
+#include "AliasingPlanner.h"
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+#include <utility>
+
+namespace
+{
+    uint64_t AlignUp(const uint64_t value, const uint64_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    bool Overlaps(const TransientResource& a, const TransientResource& b)
+    {
+        return a.heapType == b.heapType && a.firstPass <= b.lastPass && b.firstPass <= a.lastPass;
+    }
+}
+
+AliasingPlan PlanAliasing(const std::span<const TransientResource> resources)
+{
+    AliasingPlan plan;
+    plan.offsets.resize(resources.size(), 0);
+
+    uint32_t heapTypes = 0;
+    for (const TransientResource& resource : resources)
+    {
+        assert(resource.firstPass <= resource.lastPass && "Transient resource ends before it starts");
+        assert(resource.alignment > 0 && (resource.alignment & (resource.alignment - 1)) == 0 && "Alignment isn't a power of two");
+        heapTypes = std::max(heapTypes, resource.heapType + 1);
+        plan.naiveSize += resource.size;
+    }
+    plan.heapSizes.resize(heapTypes, 0);
+
+    // Largest first, big resources are the hardest to fit into gaps
+    std::vector<uint32_t> order(resources.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](const uint32_t a, const uint32_t b)
+    {
+        if (resources[a].size != resources[b].size)
+        {
+            return resources[a].size > resources[b].size;
+        }
+        return resources[a].firstPass < resources[b].firstPass;
+    });
+
+    std::vector<uint32_t> placed;
+    std::vector<std::pair<uint64_t, uint64_t>> taken; // begin, end of placed resources live at the same time
+    for (const uint32_t index : order)
+    {
+        const TransientResource& resource = resources[index];
+
+        taken.clear();
+        for (const uint32_t other : placed)
+        {
+            if (Overlaps(resource, resources[other]))
+            {
+                taken.emplace_back(plan.offsets[other], plan.offsets[other] + resources[other].size);
+            }
+        }
+        std::sort(taken.begin(), taken.end());
+
+        // Lowest gap between the taken ranges that fits
+        uint64_t offset = 0;
+        for (const auto& [begin, end] : taken)
+        {
+            if (AlignUp(offset, resource.alignment) + resource.size <= begin)
+            {
+                break;
+            }
+            offset = std::max(offset, end);
+        }
+        offset = AlignUp(offset, resource.alignment);
+
+        plan.offsets[index] = offset;
+        plan.heapSizes[resource.heapType] = std::max(plan.heapSizes[resource.heapType], offset + resource.size);
+        placed.push_back(index);
+    }
+
+    for (const uint64_t heapSize : plan.heapSizes)
+    {
+        plan.size += heapSize;
+    }
+
+    // The live size only goes up when a resource starts, so the peak is at one of the starts
+    std::vector<uint64_t> peaks(heapTypes, 0);
+    for (const TransientResource& resource : resources)
+    {
+        uint64_t live = 0;
+        for (const TransientResource& other : resources)
+        {
+            if (other.heapType == resource.heapType && other.firstPass <= resource.firstPass && resource.firstPass <= other.lastPass)
+            {
+                live += other.size;
+            }
+        }
+        peaks[resource.heapType] = std::max(peaks[resource.heapType], live);
+    }
+    for (const uint64_t peak : peaks)
+    {
+        plan.peakLiveSize += peak;
+    }
+    return plan;
+}
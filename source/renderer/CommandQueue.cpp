@@ -48,6 +48,11 @@ void CommandQueue::Flush()
 	WaitForFenceValue(Signal());
 }
 
+void CommandQueue::Retire(ComPtr<ID3D12Object> object)
+{
+    m_RetiredObjects.emplace(RetiredObject{ m_FenceValue, std::move(object) });
+}
+
 ComPtr<ID3D12CommandAllocator> CommandQueue::CreateCommandAllocator() const
 {
     ComPtr<ID3D12CommandAllocator> commandAllocator;
@@ -125,6 +130,11 @@ uint64_t CommandQueue::ExecuteCommandList(const ComPtr<ID3D12GraphicsCommandList
     m_CommandAllocatorQueue.emplace(CommandAllocatorEntry{ fenceValue, commandAllocator });
     m_CommandListQueue.push(commandList);
 
+    while (!m_RetiredObjects.empty() && IsFenceComplete(m_RetiredObjects.front().fenceValue))
+    {
+        m_RetiredObjects.pop();
+    }
+
     // The ownership of the command allocator has been transferred to the ComPtr
     // in the command allocator queue. It is safe to release the reference
     // in this temporary COM pointer here.
@@ -0,0 +1,60 @@
+#include "ConstantRing.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+ConstantRing::ConstantRing(RenderBackend& backend, const char* name, const uint32_t frameCount, const uint64_t frameCapacity)
+    : m_backend(backend), m_name(name), m_frameCount(frameCount), m_frameCapacity(frameCapacity)
+{
+    assert(frameCount > 0 && frameCapacity > 0 && frameCapacity % ALIGNMENT == 0 && "Invalid constant ring size");
+
+    // Stays mapped, the CPU only writes to it
+    m_buffer = BackendResource(backend, backend.CreateBuffer({ .size = frameCapacity * frameCount, .memory = MemoryType::Upload, .name = name }));
+    m_mapped = static_cast<uint8_t*>(backend.Map(m_buffer.Get()));
+    m_gpuAddress = backend.GetGPUAddress(m_buffer.Get());
+}
+
+void ConstantRing::BeginFrame(const uint32_t frameIndex)
+{
+    assert(frameIndex < m_frameCount && "Frame index out of range");
+    m_retiredBuffers.clear();
+    m_frameIndex = frameIndex;
+    m_offset = 0;
+    m_used = 0;
+}
+
+uint64_t ConstantRing::Push(const void* data, const uint64_t size)
+{
+    const uint64_t alignedSize = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    if (m_offset + alignedSize > m_frameCapacity)
+    {
+        Grow(alignedSize);
+    }
+
+    const uint64_t offset = m_frameIndex * m_frameCapacity + m_offset;
+    memcpy(m_mapped + offset, data, size);
+    m_offset += alignedSize;
+    m_used += alignedSize;
+    m_peakUsed = std::max(m_peakUsed, m_used);
+    return m_gpuAddress + offset;
+}
+
+void ConstantRing::Grow(const uint64_t required)
+{
+    // The addresses pushed so far this frame point into the old buffer, it's released once the frame was submitted
+    const uint64_t oldCapacity = m_frameCapacity;
+    while (m_frameCapacity < std::max(required, oldCapacity * 2))
+    {
+        m_frameCapacity *= 2;
+    }
+
+    m_retiredBuffers.push_back(std::move(m_buffer));
+    m_buffer = BackendResource(m_backend, m_backend.CreateBuffer({ .size = m_frameCapacity * m_frameCount, .memory = MemoryType::Upload, .name = m_name.c_str() }));
+    m_mapped = static_cast<uint8_t*>(m_backend.Map(m_buffer.Get()));
+    m_gpuAddress = m_backend.GetGPUAddress(m_buffer.Get());
+    m_offset = 0;
+    m_growCount++;
+    std::cout << "[ConstantRing] Grew from " << oldCapacity << " to " << m_frameCapacity << " bytes per frame\n";
+}
@@ -0,0 +1,343 @@
+#include "D3D12Backend.h"
+#include "GPUAllocator.h"
+#include "CommandQueue.h"
+#include "UploadContext.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+D3D12Backend::D3D12Backend(const RenderContext& context)
+    : m_context(context), m_resources(1)
+{
+}
+
+D3D12Backend::~D3D12Backend()
+{
+    // Everything still alive is released with the GPU idle
+    Flush();
+    m_context.commandQueue->Flush();
+    for (Resource& resource : m_resources)
+    {
+        m_context.descriptorHeap->Free(resource.srv);
+    }
+}
+
+DXGI_FORMAT D3D12Backend::GetFormat(const ResourceFormat format)
+{
+    switch (format)
+    {
+    case ResourceFormat::RGBA8_SRGB: return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+    case ResourceFormat::RGBA16F: return DXGI_FORMAT_R16G16B16A16_FLOAT;
+    case ResourceFormat::RGBA32F: return DXGI_FORMAT_R32G32B32A32_FLOAT;
+    default: return DXGI_FORMAT_R8G8B8A8_UNORM;
+    }
+}
+
+ResourceHandle D3D12Backend::Add(Resource resource)
+{
+    FreeCompleted();
+
+    resource.alive = true;
+    RecordCreate(resource.size, resource.isTexture);
+    if (!m_freeSlots.empty())
+    {
+        const uint32_t slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+        m_resources[slot] = std::move(resource);
+        return ResourceHandle{ slot };
+    }
+    m_resources.push_back(std::move(resource));
+    return ResourceHandle{ static_cast<uint32_t>(m_resources.size() - 1) };
+}
+
+ResourceHandle D3D12Backend::CreateBuffer(const BufferDesc& desc)
+{
+    D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_COMMON;
+    D3D12_HEAP_TYPE heapType = D3D12_HEAP_TYPE_DEFAULT;
+    if (desc.memory == MemoryType::Upload)
+    {
+        state = D3D12_RESOURCE_STATE_GENERIC_READ;
+        heapType = D3D12_HEAP_TYPE_UPLOAD;
+    }
+    else if (desc.memory == MemoryType::Readback)
+    {
+        state = D3D12_RESOURCE_STATE_COPY_DEST;
+        heapType = D3D12_HEAP_TYPE_READBACK;
+    }
+    const D3D12_RESOURCE_FLAGS flags = desc.unorderedAccess ? D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS : D3D12_RESOURCE_FLAG_NONE;
+
+    Resource resource;
+    resource.buffer = m_context.allocator->CreateBuffer(desc.size, state, flags, heapType, desc.name);
+    resource.size = resource.buffer.size;
+    if (desc.memory != MemoryType::Default)
+    {
+        // Mapped once for the resource's lifetime, upload heaps stay write combined
+        ThrowIfFailed(resource.buffer.resource->Map(0, nullptr, &resource.mapped));
+    }
+    return Add(std::move(resource));
+}
+
+ResourceHandle D3D12Backend::CreateTexture(const TextureDesc& desc)
+{
+    const DXGI_FORMAT format = GetFormat(desc.format);
+    const std::wstring name = ToWideString(desc.name);
+
+    Resource resource;
+    if (desc.depth > 1)
+    {
+        resource.buffer = m_context.allocator->CreateTexture3D(desc.width, desc.height, desc.depth, format,
+                                                               D3D12_RESOURCE_STATE_COMMON, name.c_str());
+    }
+    else
+    {
+        const D3D12_RESOURCE_FLAGS flags = desc.unorderedAccess ? D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS : D3D12_RESOURCE_FLAG_NONE;
+        resource.buffer = m_context.allocator->CreateTexture(desc.width, desc.height, format, D3D12_RESOURCE_STATE_COMMON, flags, name.c_str());
+    }
+    resource.texture = desc;
+    resource.size = static_cast<uint64_t>(desc.width) * desc.height * desc.depth * GetBytesPerTexel(desc.format);
+    resource.isTexture = true;
+
+    resource.srv = m_context.descriptorHeap->Allocate();
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc{};
+    srvDesc.Format = format;
+    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    if (desc.depth > 1)
+    {
+        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE3D;
+        srvDesc.Texture3D.MipLevels = 1;
+    }
+    else
+    {
+        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+        srvDesc.Texture2D.MipLevels = 1;
+    }
+    m_context.device->CreateShaderResourceView(resource.buffer.resource, &srvDesc, resource.srv.GetWriteHandle());
+    return Add(std::move(resource));
+}
+
+void D3D12Backend::Release(const ResourceHandle handle)
+{
+    Get(handle);
+    m_resources[handle.index].alive = false;
+    if (m_buildList)
+    {
+        // The open builds may read it, it's queued once they were executed
+        m_buildReleases.push_back(handle.index);
+        return;
+    }
+    // Covers the command lists the renderer executed on the main queue as well
+    m_releases.emplace(m_context.commandQueue->Signal(), handle.index);
+    FreeCompleted();
+}
+
+void* D3D12Backend::Map(const ResourceHandle handle)
+{
+    const Resource& resource = Get(handle);
+    assert(resource.mapped && "Only upload and readback buffers can be mapped");
+    return resource.mapped;
+}
+
+uint64_t D3D12Backend::GetGPUAddress(const ResourceHandle handle) const
+{
+    return Get(handle).buffer.resource->GetGPUVirtualAddress();
+}
+
+int32_t D3D12Backend::GetDescriptorIndex(const ResourceHandle handle) const
+{
+    const Resource& resource = Get(handle);
+    return resource.srv ? static_cast<int32_t>(resource.srv.index) : -1;
+}
+
+void D3D12Backend::Upload(const ResourceHandle dest, const void* data, const uint64_t size)
+{
+    m_context.uploadContext->Upload(Get(dest).buffer, data, size);
+    m_stats.uploads++;
+    m_stats.bytesUploaded += size;
+}
+
+void D3D12Backend::UploadTexture(const ResourceHandle dest, const void* data)
+{
+    const Resource& resource = Get(dest);
+    m_context.uploadContext->UploadTexture(resource.buffer, data, resource.texture.width, resource.texture.height, resource.texture.depth,
+                                           GetFormat(resource.texture.format));
+    m_stats.uploads++;
+    m_stats.bytesUploaded += resource.size;
+}
+
+ResourceHandle D3D12Backend::BuildBLAS(const BLASDesc& desc)
+{
+    assert(desc.vertexStride >= 3 * sizeof(float) && "BLAS vertices need a position");
+    D3D12_RAYTRACING_GEOMETRY_DESC geometry{};
+    geometry.Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
+    geometry.Flags = D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE;
+    geometry.Triangles.VertexBuffer.StartAddress = GetGPUAddress(desc.vertexBuffer);
+    geometry.Triangles.VertexBuffer.StrideInBytes = desc.vertexStride;
+    geometry.Triangles.VertexCount = desc.vertexCount;
+    geometry.Triangles.VertexFormat = DXGI_FORMAT_R32G32B32_FLOAT;
+    geometry.Triangles.IndexBuffer = GetGPUAddress(desc.indexBuffer);
+    geometry.Triangles.IndexCount = desc.indexCount;
+    geometry.Triangles.IndexFormat = DXGI_FORMAT_R32_UINT;
+
+    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS inputs{};
+    inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
+    inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+    inputs.NumDescs = 1;
+    inputs.pGeometryDescs = &geometry;
+    inputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
+    return BuildAccelerationStructure(inputs, desc.name);
+}
+
+ResourceHandle D3D12Backend::BuildTLAS(const std::vector<ASInstance>& instances)
+{
+    const uint64_t instancesSize = std::max<uint64_t>(instances.size(), 1) * sizeof(D3D12_RAYTRACING_INSTANCE_DESC);
+    GPUBuffer instanceBuffer = m_context.allocator->CreateBuffer(
+        instancesSize, D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_FLAG_NONE,
+        D3D12_HEAP_TYPE_UPLOAD, "TLAS Instances Buffer");
+
+    D3D12_RAYTRACING_INSTANCE_DESC* mapped = nullptr;
+    ThrowIfFailed(instanceBuffer.resource->Map(0, nullptr, reinterpret_cast<void**>(&mapped)));
+    for (const ASInstance& instance : instances)
+    {
+        D3D12_RAYTRACING_INSTANCE_DESC desc{};
+        memcpy(desc.Transform, instance.transform, sizeof(desc.Transform));
+        desc.InstanceID = instance.instanceId;
+        desc.InstanceContributionToHitGroupIndex = instance.instanceId;
+        desc.InstanceMask = 0xFF;
+        desc.Flags = D3D12_RAYTRACING_INSTANCE_FLAG_NONE;
+        desc.AccelerationStructure = GetGPUAddress(instance.blas);
+        *mapped++ = desc;
+    }
+    instanceBuffer.resource->Unmap(0, nullptr);
+
+    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS inputs{};
+    inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
+    inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+    inputs.NumDescs = static_cast<UINT>(instances.size());
+    inputs.InstanceDescs = instanceBuffer.resource->GetGPUVirtualAddress();
+    inputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
+    m_buildBuffers.push_back(std::move(instanceBuffer));
+    return BuildAccelerationStructure(inputs, "TLAS");
+}
+
+ResourceHandle D3D12Backend::BuildAccelerationStructure(const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS inputs, const char* name)
+{
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO prebuildInfo{};
+    m_context.device->GetRaytracingAccelerationStructurePrebuildInfo(&inputs, &prebuildInfo);
+
+    Resource resource;
+    resource.buffer = m_context.allocator->CreateBuffer(
+        prebuildInfo.ResultDataMaxSizeInBytes, D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE,
+        D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_HEAP_TYPE_DEFAULT, name);
+    resource.size = resource.buffer.size;
+
+    GPUBuffer scratch = m_context.allocator->CreateBuffer(
+        prebuildInfo.ScratchDataSizeInBytes, D3D12_RESOURCE_STATE_COMMON,
+        D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_HEAP_TYPE_DEFAULT, "Acceleration Structure Scratch Buffer");
+
+    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc{};
+    buildDesc.Inputs = inputs;
+    buildDesc.DestAccelerationStructureData = resource.buffer.resource->GetGPUVirtualAddress();
+    buildDesc.ScratchAccelerationStructureData = scratch.resource->GetGPUVirtualAddress();
+    ID3D12GraphicsCommandList4* commandList = GetBuildList();
+    commandList->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
+
+    // Later builds may read this one, a TLAS the BLASes before it
+    const CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::UAV(nullptr);
+    commandList->ResourceBarrier(1, &barrier);
+
+    m_buildBuffers.push_back(std::move(scratch));
+    m_stats.accelerationStructureBuilds++;
+    return Add(std::move(resource));
+}
+
+ID3D12GraphicsCommandList4* D3D12Backend::GetBuildList()
+{
+    if (!m_buildList)
+    {
+        m_buildList = m_context.commandQueue->GetCommandList();
+    }
+    return m_buildList.Get();
+}
+
+uint64_t D3D12Backend::Submit()
+{
+    // The copy queue isn't synchronized with the main queue, its work has to finish first
+    m_context.uploadContext->Flush();
+    m_stats.submissions++;
+    if (!m_buildList)
+    {
+        const uint64_t fenceValue = m_context.commandQueue->Signal();
+        FreeCompleted();
+        return fenceValue;
+    }
+
+    const uint64_t fenceValue = m_context.commandQueue->ExecuteCommandList(m_buildList);
+    m_buildList.Reset();
+    for (GPUBuffer& buffer : m_buildBuffers)
+    {
+        m_submittedBuildBuffers.emplace(fenceValue, std::move(buffer));
+    }
+    m_buildBuffers.clear();
+    for (const uint32_t slot : m_buildReleases)
+    {
+        m_releases.emplace(fenceValue, slot);
+    }
+    m_buildReleases.clear();
+    FreeCompleted();
+    return fenceValue;
+}
+
+bool D3D12Backend::IsComplete(const uint64_t fenceValue) const
+{
+    return m_context.commandQueue->IsFenceComplete(fenceValue);
+}
+
+void D3D12Backend::Wait(const uint64_t fenceValue)
+{
+    if (!IsComplete(fenceValue))
+    {
+        m_stats.blockingWaits++;
+        m_context.commandQueue->WaitForFenceValue(fenceValue);
+    }
+    FreeCompleted();
+}
+
+ID3D12Resource* D3D12Backend::GetResource(const ResourceHandle handle) const
+{
+    return Get(handle).buffer.resource;
+}
+
+const DescriptorHeap::Allocation& D3D12Backend::GetSRV(const ResourceHandle handle) const
+{
+    const Resource& resource = Get(handle);
+    assert(resource.srv && "Only textures have a shader resource view");
+    return resource.srv;
+}
+
+const D3D12Backend::Resource& D3D12Backend::Get(const ResourceHandle handle) const
+{
+    assert(handle.index != 0 && handle.index < m_resources.size() && m_resources[handle.index].alive && "Invalid or released resource handle");
+    return m_resources[handle.index];
+}
+
+void D3D12Backend::FreeCompleted()
+{
+    while (!m_releases.empty() && IsComplete(m_releases.front().first))
+    {
+        Resource& resource = m_resources[m_releases.front().second];
+        RecordRelease(resource.size);
+        if (resource.mapped)
+        {
+            resource.buffer.resource->Unmap(0, nullptr);
+        }
+        m_context.descriptorHeap->Free(resource.srv);
+        resource = Resource{};
+        m_freeSlots.push_back(m_releases.front().second);
+        m_releases.pop();
+    }
+    while (!m_submittedBuildBuffers.empty() && IsComplete(m_submittedBuildBuffers.front().first))
+    {
+        m_submittedBuildBuffers.pop();
+    }
+}
@@ -1,59 +1,189 @@
 #include "DescriptorHeap.h"
 #include "CommonDX.h"
+#include "CommandQueue.h"
 
 #include <d3dx12.h>
+#include <algorithm>
 #include <cassert>
+#include <iostream>
 
-DescriptorHeap::DescriptorHeap(ID3D12Device* device, const D3D12_DESCRIPTOR_HEAP_TYPE type,
-							   const UINT capacity, const bool shaderVisible, const wchar_t* name)
-	: m_type(type), m_capacity(capacity)
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorHeap::Allocation::GetWriteHandle(const UINT offset) const
 {
-	D3D12_DESCRIPTOR_HEAP_DESC desc{};
-	desc.NumDescriptors = capacity;
-	desc.Type = type;
-	desc.Flags = shaderVisible ? D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE : D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+	return heap->GetWriteHandle(*this, offset);
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorHeap::Allocation::GetCPUHandle(const UINT offset) const
+{
+	return heap->GetCPUHandle(*this, offset);
+}
 
-	ThrowIfFailed(device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&m_heap)));
-	m_heap->SetName(name);
+D3D12_GPU_DESCRIPTOR_HANDLE DescriptorHeap::Allocation::GetGPUHandle(const UINT offset) const
+{
+	return heap->GetGPUHandle(*this, offset);
+}
 
+DescriptorHeap::DescriptorHeap(ID3D12Device* device, const D3D12_DESCRIPTOR_HEAP_TYPE type,
+							   const UINT capacity, const bool shaderVisible, const wchar_t* name, CommandQueue* growQueue)
+	: m_device(device), m_type(type), m_shaderVisible(shaderVisible), m_growQueue(growQueue), m_name(name), m_allocator(capacity)
+{
 	m_incrementSize = device->GetDescriptorHandleIncrementSize(type);
+
+	m_heap = CreateHeap(capacity, shaderVisible, name);
 	m_cpuStart = m_heap->GetCPUDescriptorHandleForHeapStart();
+	m_writeStart = m_cpuStart;
 
 	if (shaderVisible)
 	{
 		m_gpuStart = m_heap->GetGPUDescriptorHandleForHeapStart();
 	}
+
+	if (shaderVisible && growQueue)
+	{
+		m_cpuHeap = CreateHeap(capacity, false, (m_name + L" (CPU)").c_str());
+		m_writeStart = m_cpuHeap->GetCPUDescriptorHandleForHeapStart();
+	}
 }
 
 DescriptorHeap::Allocation DescriptorHeap::Allocate(const UINT count)
 {
-	Allocation alloc;
+	std::optional<IndexRange> range = m_allocator.Allocate(count);
+	if (!range)
+	{
+		if (!m_growQueue)
+		{
+			// Users of a fixed heap keep handles into it, moving to a larger heap would leave them dangling
+			ThrowError("[DescriptorHeap] " + ToNarrowString(m_name) + " is out of descriptors");
+			return {};
+		}
+		Grow(count);
+		range = m_allocator.Allocate(count);
+	}
+
+	return { this, range->index, range->count, range->generation };
+}
 
-	if (count == 1 && !m_freeList.empty())
+void DescriptorHeap::Free(const Allocation& alloc)
+{
+	if (!alloc)
 	{
-		alloc.index = m_freeList.back();
-		m_freeList.pop_back();
+		return;
 	}
-	else
+	assert(alloc.heap == this && "Allocation belongs to another heap");
+	m_allocator.Free({ alloc.index, alloc.count, alloc.generation });
+}
+
+DescriptorHeap::Allocation DescriptorHeap::Find(const D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle)
+{
+	const UINT index = static_cast<UINT>((cpuHandle.ptr - m_writeStart.ptr) / m_incrementSize);
+	const std::optional<IndexRange> range = m_allocator.Find(index);
+	assert(range && "No allocation starts at this handle");
+	return { this, range->index, range->count, range->generation };
+}
+
+void DescriptorHeap::Commit()
+{
+	if (m_dirty.empty())
 	{
-		assert(m_current + count <= m_capacity && "Descriptor heap capacity exceeded!");
+		return;
+	}
 
-		alloc.index = m_current;
-		m_current += count;
+	// Overlapping and neighbouring writes are copied at once
+	std::sort(m_dirty.begin(), m_dirty.end());
+	UINT start = m_dirty[0].first;
+	UINT end = start + m_dirty[0].second;
+	const auto copy = [&]()
+	{
+		m_device->CopyDescriptorsSimple(end - start,
+			CD3DX12_CPU_DESCRIPTOR_HANDLE(m_cpuStart, static_cast<int>(start), m_incrementSize),
+			CD3DX12_CPU_DESCRIPTOR_HANDLE(m_writeStart, static_cast<int>(start), m_incrementSize), m_type);
+	};
+	for (const auto& [index, count] : m_dirty)
+	{
+		if (index > end)
+		{
+			copy();
+			start = index;
+			end = index;
+		}
+		end = std::max(end, index + count);
+	}
+	copy();
+	m_dirty.clear();
+}
+
+Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> DescriptorHeap::CreateHeap(const UINT capacity, const bool shaderVisible, const wchar_t* name) const
+{
+	D3D12_DESCRIPTOR_HEAP_DESC desc{};
+	desc.NumDescriptors = capacity;
+	desc.Type = m_type;
+	desc.Flags = shaderVisible ? D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE : D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> heap;
+	ThrowIfFailed(m_device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&heap)));
+	heap->SetName(name);
+	return heap;
+}
+
+void DescriptorHeap::Grow(const UINT count)
+{
+	const UINT oldCapacity = m_allocator.GetCapacity();
+	const UINT capacity = std::max(oldCapacity * 2, oldCapacity + count);
+
+	// Descriptors are copied out of the CPU only heap, a shader visible one can't be a copy source
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> heap = CreateHeap(capacity, m_shaderVisible, m_name.c_str());
+	if (m_cpuHeap)
+	{
+		Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> cpuHeap = CreateHeap(capacity, false, (m_name + L" (CPU)").c_str());
+		m_device->CopyDescriptorsSimple(oldCapacity, cpuHeap->GetCPUDescriptorHandleForHeapStart(), m_writeStart, m_type);
+		m_cpuHeap = cpuHeap;
+		m_writeStart = m_cpuHeap->GetCPUDescriptorHandleForHeapStart();
+
+		// Everything has to reach the new shader visible heap
+		m_dirty.clear();
+		m_dirty.emplace_back(0, oldCapacity);
+	}
+	else
+	{
+		m_device->CopyDescriptorsSimple(oldCapacity, heap->GetCPUDescriptorHandleForHeapStart(), m_cpuStart, m_type);
 	}
 
-	alloc.cpuHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_cpuStart, static_cast<int>(alloc.index), m_incrementSize);
-	alloc.gpuHandle = m_gpuStart.ptr
-		? CD3DX12_GPU_DESCRIPTOR_HANDLE(m_gpuStart, static_cast<int>(alloc.index), m_incrementSize)
-		: D3D12_GPU_DESCRIPTOR_HANDLE{ 0 };
+	// Work in flight may still have the old heap bound
+	m_growQueue->Retire(m_heap);
+	m_heap = heap;
+	m_cpuStart = m_heap->GetCPUDescriptorHandleForHeapStart();
+	if (!m_cpuHeap)
+	{
+		m_writeStart = m_cpuStart;
+	}
+	if (m_shaderVisible)
+	{
+		m_gpuStart = m_heap->GetGPUDescriptorHandleForHeapStart();
+	}
 
-	return alloc;
+	m_allocator.Grow(capacity);
+	m_growCount++;
+	std::cout << "[DescriptorHeap] Grew from " << oldCapacity << " to " << capacity << " descriptors\n";
 }
 
-void DescriptorHeap::Free(const Allocation& alloc, const UINT count)
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorHeap::GetWriteHandle(const Allocation& alloc, const UINT offset)
 {
-	for (UINT i = 0; i < count; i++)
+	const D3D12_CPU_DESCRIPTOR_HANDLE handle = GetCPUHandle(alloc, offset);
+	if (m_cpuHeap)
 	{
-		m_freeList.push_back(alloc.index + i);
+		m_dirty.emplace_back(alloc.index + offset, 1);
 	}
-}
\ No newline at end of file
+	return handle;
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorHeap::GetCPUHandle(const Allocation& alloc, const UINT offset) const
+{
+	assert(m_allocator.IsValid({ alloc.index, alloc.count, alloc.generation }) && offset < alloc.count && "Stale or freed descriptor allocation");
+	return CD3DX12_CPU_DESCRIPTOR_HANDLE(m_writeStart, static_cast<int>(alloc.index + offset), m_incrementSize);
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE DescriptorHeap::GetGPUHandle(const Allocation& alloc, const UINT offset) const
+{
+	assert(m_allocator.IsValid({ alloc.index, alloc.count, alloc.generation }) && offset < alloc.count && "Stale or freed descriptor allocation");
+	assert(m_shaderVisible && "Only shader visible heaps have GPU handles");
+	return CD3DX12_GPU_DESCRIPTOR_HANDLE(m_gpuStart, static_cast<int>(alloc.index + offset), m_incrementSize);
+}
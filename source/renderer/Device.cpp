@@ -23,6 +23,39 @@ Device::Device(const int width, const int height, const bool debug)
 
 Device::~Device() = default;
 
+bool Device::IsRaytracingSupported()
+{
+    ComPtr<IDXGIFactory4> factory;
+    if (FAILED(CreateDXGIFactory2(0, IID_PPV_ARGS(&factory))))
+    {
+        return false;
+    }
+
+    ComPtr<IDXGIAdapter1> adapter;
+    for (UINT i = 0; factory->EnumAdapters1(i, &adapter) != DXGI_ERROR_NOT_FOUND; ++i)
+    {
+        DXGI_ADAPTER_DESC1 desc;
+        if (FAILED(adapter->GetDesc1(&desc)) || (desc.Flags & DXGI_ADAPTER_FLAG_SOFTWARE) != 0)
+        {
+            continue;
+        }
+
+        ComPtr<ID3D12Device> device;
+        if (FAILED(D3D12CreateDevice(adapter.Get(), D3D_FEATURE_LEVEL_12_2, IID_PPV_ARGS(&device))))
+        {
+            continue;
+        }
+
+        D3D12_FEATURE_DATA_D3D12_OPTIONS5 capabilities = {};
+        if (SUCCEEDED(device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS5, &capabilities, sizeof(capabilities))) &&
+            capabilities.RaytracingTier >= D3D12_RAYTRACING_TIER_1_0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 void Device::EnableDebugLayer()
 {
     ComPtr<ID3D12Debug> debugInterface;
@@ -74,3 +74,31 @@ GPUBuffer GPUAllocator::CreateTexture(const uint32_t width, const uint32_t heigh
     buffer.resource->SetName(name);
     return buffer;
 }
+
+GPUBuffer GPUAllocator::CreateTexture3D(const uint32_t width, const uint32_t height, const uint32_t depth, const DXGI_FORMAT format,
+    const D3D12_RESOURCE_STATES initialState, const wchar_t* name) const
+{
+    D3D12_RESOURCE_DESC resourceDesc = TEXTURE_RESOURCE;
+    resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE3D;
+    resourceDesc.Format = format;
+    resourceDesc.Width = width;
+    resourceDesc.Height = height;
+    resourceDesc.DepthOrArraySize = static_cast<UINT16>(depth);
+
+    D3D12MA::ALLOCATION_DESC allocDesc{};
+    allocDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+
+    GPUBuffer buffer{};
+    buffer.size = 0;
+
+    ThrowIfFailed(m_allocator->CreateResource(
+        &allocDesc,
+        &resourceDesc,
+        initialState,
+        nullptr,
+        &buffer.allocation,
+        IID_PPV_ARGS(&buffer.resource)));
+
+    buffer.resource->SetName(name);
+    return buffer;
+}
@@ -0,0 +1,276 @@
+#include "GPUOfflineRenderer.h"
+#include "Camera.h"
+#include "Device.h"
+#include "CommandQueue.h"
+#include "DescriptorHeap.h"
+#include "GPUAllocator.h"
+#include "ConstantRing.h"
+#include "UploadContext.h"
+#include "D3D12Backend.h"
+#include "OutputTexture.h"
+#include "ShaderCompiler.h"
+#include "RootSignature.h"
+#include "RTPipeline.h"
+#include "PostProcessPass.h"
+#include "Scene.h"
+#include "CPUPathTracer.h"
+
+using namespace Microsoft::WRL;
+
+GPUOfflineRenderer::GPUOfflineRenderer(const bool debug)
+{
+	m_device = std::make_unique<Device>(0, 0, debug);
+	auto device = m_device->GetDevice();
+	m_commandQueue = std::make_unique<CommandQueue>(device, "Offline", D3D12_COMMAND_LIST_TYPE_DIRECT);
+	m_descriptorHeap = std::make_unique<DescriptorHeap>(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 4096, true, L"CBV SRV UAV Descriptor Heap", m_commandQueue.get());
+	m_allocator = std::make_unique<GPUAllocator>(device, m_device->GetAdapter());
+	m_uploadContext = std::make_unique<UploadContext>(*m_allocator, device);
+
+	m_context = { device, m_allocator.get(), m_commandQueue.get(), m_descriptorHeap.get(), m_uploadContext.get() };
+	m_backend = std::make_unique<D3D12Backend>(m_context);
+	m_context.backend = m_backend.get();
+
+	m_scene = std::make_unique<Scene>(*m_backend);
+	m_shaderCompiler = std::make_unique<ShaderCompiler>();
+
+	// Same layout as the Renderer root signature, raytracing.slang is shared
+	m_rootSignature = std::make_unique<RootSignature>();
+	m_rootSignature->AddDescriptorTable(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0, 0, "accumulationBuffer"); // u0:0 accumulation buffer
+	m_rootSignature->AddDescriptorTable(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 1, 0, "momentBuffer");       // u1:0 moment buffer
+	m_rootSignature->AddDescriptorTable(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 2, 0, "albedoBuffer");       // u2:0 albedo buffer
+	m_rootSignature->AddDescriptorTable(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 3, 0, "normalDepthBuffer");  // u3:0 normal depth buffer
+	m_rootSignature->AddDescriptorTable(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 4, 0, "motionBuffer");       // u4:0 motion buffer
+	m_rootSignature->AddDescriptorTable(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 5, 0, "idBuffer");           // u5:0 id buffer
+	m_rootSignature->AddRootSRV(0, 0, "sceneBVH");			 // t0:0 TLAS
+	m_rootSignature->AddRootSRV(1, 0, "materials");			 // t1:0 materials
+	m_rootSignature->AddRootCBV(0, 0, "camera");			 // b0:0 camera
+	m_rootSignature->AddRootCBV(1, 0, "renderSettings");	 // b1:0 render settings
+	m_rootSignature->AddRootCBV(2, 0, "renderData");		 // b2:0 render data
+	m_rootSignature->AddRootCBV(3, 0, "postProcessSettings");// b3:0 post processing settings
+	m_rootSignature->AddRootCBV(4, 0, "previousCamera");	 // b4:0 previous sample camera, for motion vectors
+	m_rootSignature->AddStaticSampler(0);					 // s0:0 linear sampler
+	m_rootSignature->Build(device, L"Offline RT Root Signature");
+
+	m_rtPipeline = std::make_unique<RTPipeline>(device, m_rootSignature->Get(), *m_shaderCompiler,
+	                                            m_scene->GetHitGroupRecords(), "shaders/raytracing.slang");
+	m_convergencePass = std::make_unique<PostProcessPass>(m_context, *m_shaderCompiler, "shaders/convergence_pass.slang", "CSMain");
+
+	m_constants = std::make_unique<ConstantRing>(*m_backend, "Constant Ring", 1);
+}
+
+GPUOfflineRenderer::~GPUOfflineRenderer()
+{
+	m_commandQueue->Flush();
+}
+
+bool GPUOfflineRenderer::LoadModel(const std::string& path)
+{
+	if (!m_scene->LoadModel(path))
+	{
+		return false;
+	}
+	m_rtPipeline->RebuildShaderTables(m_device->GetDevice(), m_scene->GetHitGroupRecords());
+	return true;
+}
+
+bool GPUOfflineRenderer::LoadHDRI(const std::string& path)
+{
+	return m_scene->LoadHDRI(path);
+}
+
+void GPUOfflineRenderer::Reset(const uint32_t width, const uint32_t height, const uint32_t firstSample)
+{
+	m_commandQueue->Flush();
+	m_width = width;
+	m_height = height;
+	m_renderData.frame = 0;
+	m_renderData.sampleOffset = firstSample;
+	m_previousCamData = CameraData{};
+
+	if (m_accumulationBuffer)
+	{
+		m_accumulationBuffer->Resize(m_device->GetDevice(), width, height);
+		m_momentBuffer->Resize(m_device->GetDevice(), width, height);
+		m_albedoBuffer->Resize(m_device->GetDevice(), width, height);
+		m_normalDepthBuffer->Resize(m_device->GetDevice(), width, height);
+		m_motionBuffer->Resize(m_device->GetDevice(), width, height);
+		m_idBuffer->Resize(m_device->GetDevice(), width, height);
+	}
+	else
+	{
+		m_accumulationBuffer = std::make_unique<OutputBuffer>(m_context, DXGI_FORMAT_R32G32B32A32_FLOAT, width, height, L"Accumulation Buffer");
+		m_momentBuffer = std::make_unique<OutputBuffer>(m_context, DXGI_FORMAT_R32G32_FLOAT, width, height, L"Moment Buffer");
+		m_albedoBuffer = std::make_unique<OutputBuffer>(m_context, DXGI_FORMAT_R32G32B32A32_FLOAT, width, height, L"Albedo Buffer");
+		m_normalDepthBuffer = std::make_unique<OutputBuffer>(m_context, DXGI_FORMAT_R32G32B32A32_FLOAT, width, height, L"Normal Depth Buffer");
+		m_motionBuffer = std::make_unique<OutputBuffer>(m_context, DXGI_FORMAT_R32G32_FLOAT, width, height, L"Motion Buffer");
+		m_idBuffer = std::make_unique<OutputBuffer>(m_context, DXGI_FORMAT_R32G32_UINT, width, height, L"ID Buffer");
+	}
+
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
+	UINT64 totalSize = 0;
+	const D3D12_RESOURCE_DESC desc = m_accumulationBuffer->GetResource()->GetDesc();
+	m_device->GetDevice()->GetCopyableFootprints(&desc, 0, 1, 0, &footprint, nullptr, nullptr, &totalSize);
+	m_readbackBuffer = m_allocator->CreateBuffer(totalSize, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_FLAG_NONE,
+	                                             D3D12_HEAP_TYPE_READBACK, "Accumulation Readback");
+}
+
+bool GPUOfflineRenderer::SetRegion(const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height)
+{
+	if (x == 0 && y == 0 && width >= m_width && height >= m_height)
+	{
+		return true;
+	}
+	std::cerr << "[GPUOfflineRenderer] Rendering a region of the image is not supported, split by samples instead\n";
+	return false;
+}
+
+void GPUOfflineRenderer::RenderSample(const Camera& camera, const CPURenderSettings& settings)
+{
+	if (!m_accumulationBuffer || m_scene->GetModels().empty())
+	{
+		return;
+	}
+
+	CameraData camData{};
+	camData.forward = camera.GetForward();
+	camData.right = camera.GetRight();
+	camData.up = camera.GetUp();
+	camData.position = camera.GetPosition();
+	camData.fov = camera.m_fov;
+
+	RenderSettings renderSettings{};
+	renderSettings.bounces = settings.bounces;
+	renderSettings.skyIntensity = settings.skyIntensity;
+	renderSettings.lightIntensity = settings.lightIntensity;
+	renderSettings.whiteFurnace = settings.whiteFurnace;
+	renderSettings.adaptiveSampling = settings.adaptiveSampling;
+	renderSettings.adaptiveThreshold = settings.adaptiveThreshold;
+	renderSettings.adaptiveMinSamples = settings.adaptiveMinSamples;
+	renderSettings.adaptiveInterval = settings.adaptiveInterval;
+	renderSettings.sampleSequence = static_cast<SampleSequence>(settings.sequence);
+
+	// Every sample is waited on, so a single frame of constants is never in flight while it's written
+	m_constants->BeginFrame(0);
+	m_renderData.hdriIndex = m_scene->GetHDRIDescriptorIndex();
+	const D3D12_GPU_VIRTUAL_ADDRESS cameraCB = m_constants->Push(camData);
+	const D3D12_GPU_VIRTUAL_ADDRESS previousCameraCB = m_constants->Push(m_previousCamData.fov > 0.0f ? m_previousCamData : camData);
+	const D3D12_GPU_VIRTUAL_ADDRESS renderSettingsCB = m_constants->Push(renderSettings);
+	const D3D12_GPU_VIRTUAL_ADDRESS renderDataCB = m_constants->Push(m_renderData);
+	const D3D12_GPU_VIRTUAL_ADDRESS postProcessSettingsCB = m_constants->Push(PostProcessSettings{});
+
+	// Every sample has to use the requested permutation, so its compile is waited for
+	m_rtPipeline->SetPermutation(m_device->GetDevice(), *m_commandQueue, RTPermutation::FromSettings(renderSettings), m_scene->GetHitGroupRecords(), true);
+
+	auto commandList = m_commandQueue->GetCommandList();
+
+	m_descriptorHeap->Commit();
+	ID3D12DescriptorHeap* heaps[] = { m_descriptorHeap->GetHeap() };
+	commandList->SetDescriptorHeaps(1, heaps);
+	commandList->SetComputeRootSignature(m_rootSignature->Get());
+	commandList->SetPipelineState1(m_rtPipeline->GetPSO());
+
+	m_accumulationBuffer->Transition(commandList.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_rootSignature->SetDescriptorTable(commandList.Get(), m_accumulationBuffer->GetUAV().GetGPUHandle(), "accumulationBuffer");
+	m_rootSignature->SetDescriptorTable(commandList.Get(), m_momentBuffer->GetUAV().GetGPUHandle(), "momentBuffer");
+	m_rootSignature->SetDescriptorTable(commandList.Get(), m_albedoBuffer->GetUAV().GetGPUHandle(), "albedoBuffer");
+	m_rootSignature->SetDescriptorTable(commandList.Get(), m_normalDepthBuffer->GetUAV().GetGPUHandle(), "normalDepthBuffer");
+	m_rootSignature->SetDescriptorTable(commandList.Get(), m_motionBuffer->GetUAV().GetGPUHandle(), "motionBuffer");
+	m_rootSignature->SetDescriptorTable(commandList.Get(), m_idBuffer->GetUAV().GetGPUHandle(), "idBuffer");
+	m_rootSignature->SetRootSRV(commandList.Get(), m_scene->GetTLASAddress(), "sceneBVH");
+	m_rootSignature->SetRootCBV(commandList.Get(), cameraCB, "camera");
+	m_rootSignature->SetRootCBV(commandList.Get(), renderSettingsCB, "renderSettings");
+	m_rootSignature->SetRootCBV(commandList.Get(), renderDataCB, "renderData");
+	m_rootSignature->SetRootCBV(commandList.Get(), postProcessSettingsCB, "postProcessSettings");
+	m_rootSignature->SetRootCBV(commandList.Get(), previousCameraCB, "previousCamera");
+	m_rootSignature->SetRootSRV(commandList.Get(), m_scene->GetMaterialsBufferAddress(), "materials");
+
+	auto dispatchDesc = m_rtPipeline->GetDispatchRaysDesc();
+	dispatchDesc.Width = m_width;
+	dispatchDesc.Height = m_height;
+	commandList->DispatchRays(&dispatchDesc);
+
+	if (settings.adaptiveSampling && IsConvergenceUpdate(m_renderData.frame + 1, settings.adaptiveMinSamples, settings.adaptiveInterval))
+	{
+		m_accumulationBuffer->Transition(commandList.Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::UAV(m_momentBuffer->GetResource());
+		commandList->ResourceBarrier(1, &barrier);
+
+		PostProcessPass::PostProcessBindings bindings;
+		bindings.inputSRV = m_accumulationBuffer->GetSRV().GetGPUHandle();
+		bindings.outputUAV = m_momentBuffer->GetUAV().GetGPUHandle();
+		bindings.constants[0] = renderSettingsCB;
+		bindings.constantCount = 1;
+		bindings.width = m_width;
+		bindings.height = m_height;
+		m_convergencePass->Dispatch(commandList.Get(), bindings);
+	}
+
+	m_commandQueue->ExecuteCommandList(commandList);
+	m_backend->Flush();
+
+	m_renderData.frame++;
+	m_previousCamData = camData;
+}
+
+template<typename T>
+std::vector<T> GPUOfflineRenderer::ReadBuffer(OutputBuffer& buffer)
+{
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
+	const D3D12_RESOURCE_DESC desc = buffer.GetResource()->GetDesc();
+	m_device->GetDevice()->GetCopyableFootprints(&desc, 0, 1, 0, &footprint, nullptr, nullptr, nullptr);
+
+	auto commandList = m_commandQueue->GetCommandList();
+	buffer.Transition(commandList.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE);
+
+	const CD3DX12_TEXTURE_COPY_LOCATION destination(m_readbackBuffer.resource, footprint);
+	const CD3DX12_TEXTURE_COPY_LOCATION source(buffer.GetResource(), 0);
+	commandList->CopyTextureRegion(&destination, 0, 0, 0, &source, nullptr);
+
+	buffer.Transition(commandList.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_commandQueue->ExecuteCommandList(commandList);
+	m_commandQueue->Flush();
+
+	// Rows are padded to D3D12_TEXTURE_DATA_PITCH_ALIGNMENT in the readback buffer
+	std::vector<T> pixels(static_cast<size_t>(m_width) * m_height);
+	void* mapped = nullptr;
+	ThrowIfFailed(m_readbackBuffer.resource->Map(0, nullptr, &mapped), "Failed to map the readback buffer!");
+	const auto* bytes = static_cast<const uint8_t*>(mapped);
+	for (uint32_t y = 0; y < m_height; y++)
+	{
+		memcpy(&pixels[static_cast<size_t>(y) * m_width], bytes + footprint.Offset + static_cast<size_t>(y) * footprint.Footprint.RowPitch,
+		       m_width * sizeof(T));
+	}
+	const D3D12_RANGE writtenRange = { 0, 0 };
+	m_readbackBuffer.resource->Unmap(0, &writtenRange);
+	return pixels;
+}
+
+std::vector<glm::vec4> GPUOfflineRenderer::ReadAccumulation()
+{
+	if (!m_accumulationBuffer)
+	{
+		return {};
+	}
+	return ReadBuffer<glm::vec4>(*m_accumulationBuffer);
+}
+
+FeatureBuffers GPUOfflineRenderer::ReadFeatures()
+{
+	FeatureBuffers features;
+	if (!m_accumulationBuffer)
+	{
+		return features;
+	}
+	features.albedo = ReadBuffer<glm::vec4>(*m_albedoBuffer);
+	features.normalDepth = ReadBuffer<glm::vec4>(*m_normalDepthBuffer);
+	features.motion = ReadBuffer<glm::vec2>(*m_motionBuffer);
+	features.ids = ReadBuffer<glm::uvec2>(*m_idBuffer);
+	return features;
+}
+
+std::string GPUOfflineRenderer::GetName() const
+{
+	DXGI_ADAPTER_DESC1 desc;
+	ThrowIfFailed(m_device->GetAdapter()->GetDesc1(&desc));
+	return "GPU (" + ToNarrowString(desc.Description) + ")";
+}
@@ -29,8 +29,10 @@ ImGuiWrapper::ImGuiWrapper(const Window& window, RenderContext& context, const D
     initInfo.CommandQueue = m_context.commandQueue->GetQueue().Get();
     initInfo.NumFramesInFlight = static_cast<int>(framesInFlight);
     initInfo.RTVFormat = rtvFormat;
-    initInfo.SrvDescriptorHeap = m_context.descriptorHeap->GetHeap();
-    initInfo.UserData = m_context.descriptorHeap;
+    // Its own heap, ImGui keeps GPU handles in its textures that would go stale when the scene's heap grows
+    m_descriptorHeap = std::make_unique<DescriptorHeap>(m_context.device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 64, true, L"ImGui Descriptor Heap");
+    initInfo.SrvDescriptorHeap = m_descriptorHeap->GetHeap();
+    initInfo.UserData = m_descriptorHeap.get();
 
     initInfo.SrvDescriptorAllocFn = [](ImGui_ImplDX12_InitInfo* info,
         D3D12_CPU_DESCRIPTOR_HANDLE* outCpu,
@@ -38,21 +40,16 @@ ImGuiWrapper::ImGuiWrapper(const Window& window, RenderContext& context, const D
         {
             auto* heap = static_cast<DescriptorHeap*>(info->UserData);
             auto alloc = heap->Allocate();
-            *outCpu = alloc.cpuHandle;
-            *outGpu = alloc.gpuHandle;
+            *outCpu = alloc.GetWriteHandle();
+            *outGpu = alloc.GetGPUHandle();
         };
 
     initInfo.SrvDescriptorFreeFn = [](ImGui_ImplDX12_InitInfo* info,
         D3D12_CPU_DESCRIPTOR_HANDLE cpu,
-        D3D12_GPU_DESCRIPTOR_HANDLE gpu)
+        D3D12_GPU_DESCRIPTOR_HANDLE)
         {
             auto* heap = static_cast<DescriptorHeap*>(info->UserData);
-            // Reconstruct allocation from handles to free
-            DescriptorHeap::Allocation alloc;
-            alloc.cpuHandle = cpu;
-            alloc.gpuHandle = gpu;
-            alloc.index = static_cast<UINT>((cpu.ptr - heap->GetCPUStartHandle().ptr) / heap->GetIncrementSize());
-            heap->Free(alloc);
+            heap->Free(heap->Find(cpu));
         };
 
     ImGui_ImplDX12_Init(&initInfo);
@@ -63,7 +60,6 @@ ImGuiWrapper::~ImGuiWrapper()
     ImGui_ImplDX12_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
-    m_context.descriptorHeap->Free(m_fontDescriptor);
 }
 
 void ImGuiWrapper::BeginFrame()
@@ -0,0 +1,135 @@
+#include "IndexAllocator.h"
+
+#include <cassert>
+#include <iterator>
+
+IndexAllocator::IndexAllocator(const uint32_t capacity)
+{
+    Grow(capacity);
+}
+
+std::optional<IndexRange> IndexAllocator::Allocate(const uint32_t count)
+{
+    assert(count > 0 && "Can't allocate an empty range");
+
+    // Smallest free range that fits, the lowest index among equal sizes
+    const auto best = m_freeBySize.lower_bound({ count, 0 });
+    if (best == m_freeBySize.end())
+    {
+        return std::nullopt;
+    }
+
+    const uint32_t index = best->second;
+    const uint32_t freeCount = best->first;
+    RemoveFreeRange(m_freeByIndex.find(index));
+    if (freeCount > count)
+    {
+        AddFreeRange(index + count, freeCount - count);
+    }
+
+    m_counts[index] = count;
+    m_allocated += count;
+    m_allocations++;
+    return IndexRange{ index, count, m_generations[index] };
+}
+
+void IndexAllocator::Free(const IndexRange& range)
+{
+    assert(IsValid(range) && "Freeing a range that isn't allocated, or was freed already");
+
+    m_counts[range.index] = 0;
+    m_generations[range.index]++;
+    m_allocated -= range.count;
+    m_allocations--;
+
+    uint32_t index = range.index;
+    uint32_t count = range.count;
+
+    auto next = m_freeByIndex.find(index + count);
+    if (next != m_freeByIndex.end())
+    {
+        count += next->second;
+        RemoveFreeRange(next);
+    }
+
+    auto previous = m_freeByIndex.lower_bound(index);
+    if (previous != m_freeByIndex.begin())
+    {
+        --previous;
+        if (previous->first + previous->second == index)
+        {
+            index = previous->first;
+            count += previous->second;
+            RemoveFreeRange(previous);
+        }
+    }
+
+    AddFreeRange(index, count);
+}
+
+void IndexAllocator::Grow(const uint32_t capacity)
+{
+    assert(capacity >= m_capacity && "Index allocators only grow");
+    if (capacity == m_capacity)
+    {
+        return;
+    }
+
+    const uint32_t oldCapacity = m_capacity;
+    m_capacity = capacity;
+    m_counts.resize(capacity, 0);
+    m_generations.resize(capacity, 0);
+
+    // Merge with a free range that reached the old end
+    uint32_t index = oldCapacity;
+    uint32_t count = capacity - oldCapacity;
+    if (!m_freeByIndex.empty())
+    {
+        const auto last = std::prev(m_freeByIndex.end());
+        if (last->first + last->second == oldCapacity)
+        {
+            index = last->first;
+            count += last->second;
+            RemoveFreeRange(last);
+        }
+    }
+    AddFreeRange(index, count);
+}
+
+bool IndexAllocator::IsValid(const IndexRange& range) const
+{
+    return range.count > 0 && range.index < m_capacity &&
+           m_counts[range.index] == range.count && m_generations[range.index] == range.generation;
+}
+
+std::optional<IndexRange> IndexAllocator::Find(const uint32_t index) const
+{
+    if (index >= m_capacity || m_counts[index] == 0)
+    {
+        return std::nullopt;
+    }
+    return IndexRange{ index, m_counts[index], m_generations[index] };
+}
+
+IndexAllocatorStats IndexAllocator::GetStats() const
+{
+    IndexAllocatorStats stats;
+    stats.capacity = m_capacity;
+    stats.allocated = m_allocated;
+    stats.allocations = m_allocations;
+    stats.freeRanges = static_cast<uint32_t>(m_freeByIndex.size());
+    stats.largestFreeRange = m_freeBySize.empty() ? 0 : m_freeBySize.rbegin()->first;
+    return stats;
+}
+
+void IndexAllocator::AddFreeRange(const uint32_t index, const uint32_t count)
+{
+    m_freeByIndex.emplace(index, count);
+    m_freeBySize.emplace(count, index);
+}
+
+void IndexAllocator::RemoveFreeRange(const std::map<uint32_t, uint32_t>::iterator it)
+{
+    m_freeBySize.erase({ it->second, it->first });
+    m_freeByIndex.erase(it);
+}
@@ -1,130 +1,51 @@
 #include "Mesh.h"
-#include "CommandQueue.h"
-#include "GPUAllocator.h"
-#include "UploadContext.h"
-#include "BLAS.h"
 
-Mesh::Mesh() = default;
-
-Mesh::~Mesh() = default;
-
-Mesh::Mesh(Mesh&& other) noexcept
-    : m_materialIndex(other.m_materialIndex), m_transform(other.m_transform), m_vertexBuffer(std::move(other.m_vertexBuffer))
-    , m_indexBuffer(std::move(other.m_indexBuffer)), m_vertexCount(other.m_vertexCount), m_indexCount(other.m_indexCount)
-	, m_blas(std::move(other.m_blas))
-{
-}
-
-Mesh& Mesh::operator=(Mesh&& other) noexcept
-{
-    if (this != &other)
-    {
-        m_vertexBuffer = std::move(other.m_vertexBuffer);
-        m_indexBuffer = std::move(other.m_indexBuffer);
-        m_vertexCount = other.m_vertexCount;
-        m_indexCount = other.m_indexCount;
-        m_materialIndex = other.m_materialIndex;
-        m_transform = other.m_transform;
-		m_blas = std::move(other.m_blas);
-    }
-    return *this;
-}
-
-void Mesh::Upload(const RenderContext& context, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const std::string& name)
+void Mesh::Upload(RenderBackend& backend, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const std::string& name)
 {
     m_vertexCount = static_cast<uint32_t>(vertices.size());
     m_indexCount = static_cast<uint32_t>(indices.size());
+    m_name = name;
 
-    uint64_t verticesSize = vertices.size() * sizeof(Vertex);
-    uint64_t indicesSize = indices.size() * sizeof(uint32_t);
-
-    m_vertexBuffer = context.allocator->CreateBuffer(
-        verticesSize, D3D12_RESOURCE_STATE_COMMON,
-        D3D12_RESOURCE_FLAG_NONE, D3D12_HEAP_TYPE_DEFAULT,
-        (name + "_VB").c_str());
-
-    m_indexBuffer = context.allocator->CreateBuffer(
-        indicesSize, D3D12_RESOURCE_STATE_COMMON,
-        D3D12_RESOURCE_FLAG_NONE, D3D12_HEAP_TYPE_DEFAULT,
-        (name + "_IB").c_str());
-
-    context.uploadContext->Upload(m_vertexBuffer, vertices.data(), verticesSize);
-    context.uploadContext->Upload(m_indexBuffer, indices.data(), indicesSize);
-
-    m_vertexSRV = context.descriptorHeap->Allocate();
-    m_indexSRV = context.descriptorHeap->Allocate();
-
-    D3D12_SHADER_RESOURCE_VIEW_DESC vertexSrvDesc{};
-    vertexSrvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
-    vertexSrvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    vertexSrvDesc.Buffer.NumElements = m_vertexCount;
-    vertexSrvDesc.Buffer.StructureByteStride = sizeof(Vertex);
-    vertexSrvDesc.Format = DXGI_FORMAT_UNKNOWN;
-    context.device->CreateShaderResourceView(m_vertexBuffer.resource, &vertexSrvDesc, m_vertexSRV.cpuHandle);
-
-    D3D12_SHADER_RESOURCE_VIEW_DESC indexSrvDesc{};
-    indexSrvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
-    indexSrvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    indexSrvDesc.Buffer.NumElements = m_indexCount;
-    indexSrvDesc.Format = DXGI_FORMAT_R32_UINT;
-    context.device->CreateShaderResourceView(m_indexBuffer.resource, &indexSrvDesc, m_indexSRV.cpuHandle);
-}
-
-D3D12_RAYTRACING_GEOMETRY_DESC Mesh::GetGeometryDesc() const
-{
-    D3D12_RAYTRACING_GEOMETRY_DESC desc = {};
-    desc.Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
-    desc.Flags = D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE;
-    desc.Triangles.VertexBuffer.StartAddress = m_vertexBuffer.resource->GetGPUVirtualAddress();
-    desc.Triangles.VertexBuffer.StrideInBytes = sizeof(Vertex);
-    desc.Triangles.VertexCount = m_vertexCount;
-    desc.Triangles.VertexFormat = DXGI_FORMAT_R32G32B32_FLOAT;
-    desc.Triangles.IndexBuffer = m_indexBuffer.resource->GetGPUVirtualAddress();
-    desc.Triangles.IndexCount = m_indexCount;
-    desc.Triangles.IndexFormat = DXGI_FORMAT_R32_UINT;
-    return desc;
-}
-
-void Mesh::BuildBLAS(RenderContext& context, ID3D12GraphicsCommandList4* commandList)
-{
-    m_blas = std::make_unique<BLAS>(context);
-    std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> geometries = { GetGeometryDesc() };
-    m_blas->Build(context.device, commandList, geometries);
-}
-
-D3D12_VERTEX_BUFFER_VIEW Mesh::GetVertexBufferView() const
-{
-    return {
-        .BufferLocation = m_vertexBuffer.resource->GetGPUVirtualAddress(),
-        .SizeInBytes = static_cast<UINT>(m_vertexBuffer.size),
-        .StrideInBytes = sizeof(Vertex)
-    };
-}
-
-D3D12_INDEX_BUFFER_VIEW Mesh::GetIndexBufferView() const
-{
-    return {
-        .BufferLocation = m_indexBuffer.resource->GetGPUVirtualAddress(),
-        .SizeInBytes = static_cast<UINT>(m_indexBuffer.size),
-        .Format = DXGI_FORMAT_R32_UINT
-    };
-}
-
-D3D12_RAYTRACING_INSTANCE_DESC Mesh::GetInstanceDesc(const UINT instanceId) const
-{
-    D3D12_RAYTRACING_INSTANCE_DESC desc = {};
-	desc.AccelerationStructure = m_blas->GetResult()->GetGPUVirtualAddress();
-    desc.Flags = D3D12_RAYTRACING_INSTANCE_FLAG_NONE;
-    desc.InstanceMask = 0xFF;
-    desc.InstanceContributionToHitGroupIndex = instanceId;
-    desc.InstanceID = instanceId;
-
-    DirectX::XMMATRIX m = XMLoadFloat4x4(&m_transform);
-    DirectX::XMMATRIX transposed = XMMatrixTranspose(m);
-    DirectX::XMFLOAT4X4 t;
-    DirectX::XMStoreFloat4x4(&t, transposed);
-
-    memcpy(desc.Transform, &t, sizeof(desc.Transform));
-
-    return desc;
+    // Positions and indices stay on the CPU for the CPU ray tracing tools
+    m_cpuGeometry.positions.resize(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        m_cpuGeometry.positions[i] = vertices[i].position;
+    }
+    m_cpuGeometry.indices = indices;
+
+    const uint64_t verticesSize = vertices.size() * sizeof(Vertex);
+    const uint64_t indicesSize = indices.size() * sizeof(uint32_t);
+    const std::string vertexName = name + "_VB";
+    const std::string indexName = name + "_IB";
+
+    m_vertexBuffer = BackendResource(backend, backend.CreateBuffer({ .size = verticesSize, .name = vertexName.c_str() }));
+    m_indexBuffer = BackendResource(backend, backend.CreateBuffer({ .size = indicesSize, .name = indexName.c_str() }));
+    backend.Upload(m_vertexBuffer.Get(), vertices.data(), verticesSize);
+    backend.Upload(m_indexBuffer.Get(), indices.data(), indicesSize);
+
+    BLASDesc blas;
+    blas.vertexBuffer = m_vertexBuffer.Get();
+    blas.vertexCount = m_vertexCount;
+    blas.vertexStride = sizeof(Vertex);
+    blas.indexBuffer = m_indexBuffer.Get();
+    blas.indexCount = m_indexCount;
+    blas.name = name.c_str();
+    m_blas = BackendResource(backend, backend.BuildBLAS(blas));
+}
+
+ASInstance Mesh::GetInstance(const uint32_t instanceId) const
+{
+    ASInstance instance;
+    instance.blas = m_blas.Get();
+    instance.instanceId = instanceId;
+    // glm is column major, the instance takes rows
+    for (int row = 0; row < 3; row++)
+    {
+        for (int column = 0; column < 4; column++)
+        {
+            instance.transform[row][column] = m_transform[column][row];
+        }
+    }
+    return instance;
 }
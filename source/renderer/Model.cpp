@@ -1,34 +1,35 @@
 #include "Model.h"
 #include "MikkT.h"
-#include "GPUAllocator.h"
-#include "CommandQueue.h"
-#include "StructsDX.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 #include <fastgltf/glm_element_traits.hpp>
 #include <fastgltf/tools.hpp>
-#include <stdexcept>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <cassert>
+#include <iostream>
+#include <typeinfo>
+#include <unordered_set>
 #include <vector>
 
-using namespace DirectX;
-
-Model::Model(RenderContext& context, ID3D12GraphicsCommandList4* commandList, const std::filesystem::path& path)
-    : m_context(context), m_name(path.stem().string())
+Model::Model(RenderBackend& backend)
+    : m_backend(backend)
 {
-    LoadGLTF(commandList, path);
 }
 
 Model::~Model() = default;
 
-void Model::LoadGLTF(ID3D12GraphicsCommandList4* commandList, const std::filesystem::path& path)
+bool Model::Load(const std::filesystem::path& path)
 {
+    m_name = path.stem().string();
     fastgltf::Parser parser(fastgltf::Extensions::KHR_lights_punctual);
 
     auto data = fastgltf::GltfDataBuffer::FromPath(path);
     if (data.error() != fastgltf::Error::None)
     {
-        ThrowError("Failed to load glTF file: " + path.string());
+        std::cerr << "[Model] Failed to load glTF file: " << path.string() << "\n";
+        return false;
     }
 
     constexpr auto options =
@@ -38,69 +39,67 @@ void Model::LoadGLTF(ID3D12GraphicsCommandList4* commandList, const std::filesys
     auto asset = parser.loadGltf(data.get(), path.parent_path(), options);
     if (asset.error() != fastgltf::Error::None)
     {
-        ThrowError("Failed to parse glTF: " + path.string());
+        std::cerr << "[Model] Failed to parse glTF: " << path.string() << "\n";
+        return false;
     }
 
     size_t sceneIndex = asset->defaultScene.value_or(0);
-    const auto& scene = asset->scenes[sceneIndex];
-
-    for (size_t nodeIndex : scene.nodeIndices)
+    if (sceneIndex < asset->scenes.size())
     {
-        TraverseNode(commandList, asset.get(), nodeIndex, XMMatrixIdentity());
+        for (size_t nodeIndex : asset->scenes[sceneIndex].nodeIndices)
+        {
+            TraverseNode(asset.get(), nodeIndex, glm::mat4(1.0f));
+        }
     }
 
     LoadMaterials(asset.get());
+    return true;
 }
 
-void Model::TraverseNode(ID3D12GraphicsCommandList4* commandList, const fastgltf::Asset& asset, const size_t nodeIndex, const XMMATRIX& parentTransform)
+void Model::TraverseNode(const fastgltf::Asset& asset, const size_t nodeIndex, const glm::mat4& parentTransform)
 {
     const auto& node = asset.nodes[nodeIndex];
-
-    XMMATRIX localTransform = GetNodeTransform(node);
-    XMMATRIX worldTransform = XMMatrixMultiply(localTransform, parentTransform);
+    const glm::mat4 worldTransform = parentTransform * GetNodeTransform(node);
 
     // Node has mesh
     if (node.meshIndex.has_value())
     {
         const auto& mesh = asset.meshes[node.meshIndex.value()];
-        LoadMesh(commandList, asset, mesh, worldTransform);
+        LoadMesh(asset, mesh, worldTransform);
     }
 
     // TODO: Handle lights when node.lightIndex.has_value()
 
     for (size_t childIndex : node.children)
     {
-        TraverseNode(commandList, asset, childIndex, worldTransform);
+        TraverseNode(asset, childIndex, worldTransform);
     }
 }
 
-XMMATRIX Model::GetNodeTransform(const fastgltf::Node& node)
+glm::mat4 Model::GetNodeTransform(const fastgltf::Node& node)
 {
+    // Same as CPUScene, so both see the same instances
     return std::visit(fastgltf::visitor{
-        [](const fastgltf::TRS& trs) -> XMMATRIX
+        [](const fastgltf::TRS& trs) -> glm::mat4
         {
-            XMVECTOR translation = XMVectorSet(trs.translation[0], trs.translation[1], trs.translation[2], 0.0f);
-            XMVECTOR rotation = XMVectorSet(trs.rotation[0], trs.rotation[1], trs.rotation[2], trs.rotation[3]);
-            XMVECTOR scale = XMVectorSet(trs.scale[0], trs.scale[1], trs.scale[2], 0.0f);
-
-            return XMMatrixScalingFromVector(scale) *
-                   XMMatrixRotationQuaternion(rotation) *
-                   XMMatrixTranslationFromVector(translation);
+            glm::vec3 translation(trs.translation[0], trs.translation[1], trs.translation[2]);
+            glm::quat rotation(trs.rotation[3], trs.rotation[0], trs.rotation[1], trs.rotation[2]);
+            glm::vec3 scale(trs.scale[0], trs.scale[1], trs.scale[2]);
+            return glm::translate(glm::mat4(1.0f), translation) * glm::mat4_cast(rotation) * glm::scale(glm::mat4(1.0f), scale);
         },
-        [](const fastgltf::math::fmat4x4& matrix) -> XMMATRIX
+        [](const fastgltf::math::fmat4x4& matrix) -> glm::mat4
         {
-			// Transpose
-            return XMMATRIX(
-                matrix[0][0], matrix[1][0], matrix[2][0], matrix[3][0],
-                matrix[0][1], matrix[1][1], matrix[2][1], matrix[3][1],
-                matrix[0][2], matrix[1][2], matrix[2][2], matrix[3][2],
-                matrix[0][3], matrix[1][3], matrix[2][3], matrix[3][3]
-            );
+            // Both are column major
+            glm::mat4 result;
+            for (int column = 0; column < 4; column++)
+                for (int row = 0; row < 4; row++)
+                    result[column][row] = matrix[column][row];
+            return result;
         }
         }, node.transform);
 }
 
-void Model::LoadMesh(ID3D12GraphicsCommandList4* commandList, const fastgltf::Asset& asset, const fastgltf::Mesh& gltfMesh, const XMMATRIX& transform)
+void Model::LoadMesh(const fastgltf::Asset& asset, const fastgltf::Mesh& gltfMesh, const glm::mat4& transform)
 {
     for (const auto& primitive : gltfMesh.primitives)
     {
@@ -125,7 +124,7 @@ void Model::LoadMesh(ID3D12GraphicsCommandList4* commandList, const fastgltf::As
         fastgltf::iterateAccessorWithIndex<fastgltf::math::fvec3>(asset, posAccessor,
             [&](const fastgltf::math::fvec3& pos, size_t idx)
             {
-                vertices[idx].position = XMFLOAT3(pos.x(), pos.y(), pos.z());
+                vertices[idx].position = glm::vec3(pos.x(), pos.y(), pos.z());
             }
         );
 
@@ -137,7 +136,7 @@ void Model::LoadMesh(ID3D12GraphicsCommandList4* commandList, const fastgltf::As
             fastgltf::iterateAccessorWithIndex<fastgltf::math::fvec3>(asset, normAccessor,
                 [&](const fastgltf::math::fvec3& norm, size_t idx)
                 {
-                    vertices[idx].normal = XMFLOAT3(norm.x(), norm.y(), norm.z());
+                    vertices[idx].normal = glm::vec3(norm.x(), norm.y(), norm.z());
                 }
             );
         }
@@ -150,7 +149,7 @@ void Model::LoadMesh(ID3D12GraphicsCommandList4* commandList, const fastgltf::As
             fastgltf::iterateAccessorWithIndex<fastgltf::math::fvec2>(asset, texAccessor,
                 [&](const fastgltf::math::fvec2& uv, size_t idx)
                 {
-                    vertices[idx].texCoord = XMFLOAT2(uv.x(), uv.y());
+                    vertices[idx].texCoord = glm::vec2(uv.x(), uv.y());
                 }
             );
         }
@@ -182,7 +181,7 @@ void Model::LoadMesh(ID3D12GraphicsCommandList4* commandList, const fastgltf::As
             fastgltf::iterateAccessorWithIndex<fastgltf::math::fvec4>(asset, tanAccessor,
                 [&](const fastgltf::math::fvec4& tan, size_t idx)
                 {
-                    vertices[idx].tangent = XMFLOAT4(tan.x(), tan.y(), tan.z(), tan.w());
+                    vertices[idx].tangent = glm::vec4(tan.x(), tan.y(), tan.z(), tan.w());
                 }
             );
         }
@@ -195,13 +194,12 @@ void Model::LoadMesh(ID3D12GraphicsCommandList4* commandList, const fastgltf::As
         mesh.m_materialIndex = primitive.materialIndex.has_value()
             ? static_cast<int32_t>(primitive.materialIndex.value()) : -1;
 
-        XMStoreFloat4x4(&mesh.m_transform, transform);
+        mesh.m_transform = transform;
 
         std::string meshName = m_name + "_" + std::string(gltfMesh.name) +
             "_prim" + std::to_string(m_meshes.size());
 
-        mesh.Upload(m_context, vertices, indices, meshName);
-        mesh.BuildBLAS(m_context, commandList);
+        mesh.Upload(m_backend, vertices, indices, meshName);
         m_meshes.push_back(std::move(mesh));
     }
 }
@@ -233,7 +231,7 @@ void Model::LoadMaterials(const fastgltf::Asset& asset)
     int index = 0;
     for (auto& image : asset.images)
     {
-        auto tex = Texture();
+        BackendResource texture;
 
         int width, height, nrChannels;
         unsigned char* data = nullptr;
@@ -290,10 +288,13 @@ void Model::LoadMaterials(const fastgltf::Asset& asset)
 
         if (data)
         {
-            DXGI_FORMAT fmt = linearImages.count(index)
-                ? DXGI_FORMAT_R8G8B8A8_UNORM
-                : DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
-            tex.Create(m_context, data, width, height, fmt, image.name.c_str());
+            TextureDesc desc;
+            desc.width = static_cast<uint32_t>(width);
+            desc.height = static_cast<uint32_t>(height);
+            desc.format = linearImages.count(index) ? ResourceFormat::RGBA8 : ResourceFormat::RGBA8_SRGB;
+            desc.name = image.name.c_str();
+            texture = BackendResource(m_backend, m_backend.CreateTexture(desc));
+            m_backend.UploadTexture(texture.Get(), data);
             stbi_image_free(data);
         }
         else
@@ -301,7 +302,7 @@ void Model::LoadMaterials(const fastgltf::Asset& asset)
             std::cerr << "[Model] Failed to load image: " << image.name << "\n";
         }
 
-        m_textures.push_back(std::move(tex));
+        m_textures.push_back(std::move(texture));
         index++;
     }
 
@@ -312,25 +313,25 @@ void Model::LoadMaterials(const fastgltf::Asset& asset)
         if (mat.pbrData.baseColorTexture.has_value())
         {
             auto texIndex = asset.textures[mat.pbrData.baseColorTexture->textureIndex].imageIndex.value();
-            matData.albedoIndex = m_textures[texIndex].GetDescriptorIndex();
+            matData.albedoIndex = GetDescriptorIndex(texIndex);
         }
 
         if (mat.pbrData.metallicRoughnessTexture.has_value())
         {
             auto texIndex = asset.textures[mat.pbrData.metallicRoughnessTexture->textureIndex].imageIndex.value();
-            matData.metallicRoughnessIndex = m_textures[texIndex].GetDescriptorIndex();
+            matData.metallicRoughnessIndex = GetDescriptorIndex(texIndex);
         }
 
         if (mat.normalTexture.has_value())
         {
             auto texIndex = asset.textures[mat.normalTexture->textureIndex].imageIndex.value();
-            matData.normalIndex = m_textures[texIndex].GetDescriptorIndex();
+            matData.normalIndex = GetDescriptorIndex(texIndex);
         }
 
         if (mat.emissiveTexture.has_value())
         {
             auto texIndex = asset.textures[mat.emissiveTexture->textureIndex].imageIndex.value();
-            matData.emissiveIndex = m_textures[texIndex].GetDescriptorIndex();
+            matData.emissiveIndex = GetDescriptorIndex(texIndex);
         }
 
         auto& aFactor = mat.pbrData.baseColorFactor;
@@ -342,4 +343,10 @@ void Model::LoadMaterials(const fastgltf::Asset& asset)
 
         m_materials.push_back(matData);
     }
-}
\ No newline at end of file
+}
+
+int32_t Model::GetDescriptorIndex(const size_t imageIndex) const
+{
+    const BackendResource& texture = m_textures[imageIndex];
+    return texture ? m_backend.GetDescriptorIndex(texture.Get()) : -1;
+}
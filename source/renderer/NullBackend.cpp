@@ -0,0 +1,196 @@
+#include "NullBackend.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <utility>
+
+namespace
+{
+    // Same as D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT, so addresses look like the ones a device hands out
+    constexpr uint64_t ADDRESS_ALIGNMENT = 64 * 1024;
+    // Rough acceleration structure sizes, in the range drivers report for fast trace builds
+    constexpr uint64_t BLAS_BYTES_PER_TRIANGLE = 64;
+    constexpr uint64_t TLAS_BYTES_PER_INSTANCE = 128;
+}
+
+NullBackend::NullBackend(const uint32_t latency)
+    : m_resources(1), m_latency(latency), m_nextAddress(ADDRESS_ALIGNMENT)
+{
+}
+
+ResourceHandle NullBackend::Create(const uint64_t size)
+{
+    FreeCompleted();
+
+    uint32_t slot;
+    if (!m_freeSlots.empty())
+    {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else
+    {
+        slot = static_cast<uint32_t>(m_resources.size());
+        m_resources.emplace_back();
+    }
+
+    Resource& resource = m_resources[slot];
+    resource.data.assign(std::max<uint64_t>(size, 1), 0);
+    resource.address = m_nextAddress;
+    resource.alive = true;
+    m_nextAddress += (resource.data.size() + ADDRESS_ALIGNMENT - 1) / ADDRESS_ALIGNMENT * ADDRESS_ALIGNMENT;
+    return ResourceHandle{ slot };
+}
+
+ResourceHandle NullBackend::CreateBuffer(const BufferDesc& desc)
+{
+    const ResourceHandle handle = Create(desc.size);
+    RecordCreate(Get(handle).data.size(), false);
+    return handle;
+}
+
+ResourceHandle NullBackend::CreateTexture(const TextureDesc& desc)
+{
+    const uint64_t size = static_cast<uint64_t>(desc.width) * desc.height * desc.depth * GetBytesPerTexel(desc.format);
+    const ResourceHandle handle = Create(size);
+    Resource& resource = Get(handle);
+    if (!m_freeDescriptors.empty())
+    {
+        resource.descriptor = m_freeDescriptors.back();
+        m_freeDescriptors.pop_back();
+    }
+    else
+    {
+        resource.descriptor = m_nextDescriptor++;
+    }
+    RecordCreate(resource.data.size(), true);
+    return handle;
+}
+
+void NullBackend::Release(const ResourceHandle handle)
+{
+    // Handles are invalid from here on, the memory is only reused once the fence passed
+    Get(handle).alive = false;
+    m_releases.emplace_back(m_submitted, handle.index);
+    FreeCompleted();
+}
+
+void* NullBackend::Map(const ResourceHandle handle)
+{
+    return Get(handle).data.data();
+}
+
+uint64_t NullBackend::GetGPUAddress(const ResourceHandle handle) const
+{
+    return Get(handle).address;
+}
+
+int32_t NullBackend::GetDescriptorIndex(const ResourceHandle handle) const
+{
+    return Get(handle).descriptor;
+}
+
+void NullBackend::Upload(const ResourceHandle dest, const void* data, const uint64_t size)
+{
+    Resource& resource = Get(dest);
+    assert(size <= resource.data.size() && "Upload larger than the resource");
+    memcpy(resource.data.data(), data, size);
+    m_stats.uploads++;
+    m_stats.bytesUploaded += size;
+}
+
+void NullBackend::UploadTexture(const ResourceHandle dest, const void* data)
+{
+    Resource& resource = Get(dest);
+    memcpy(resource.data.data(), data, resource.data.size());
+    m_stats.uploads++;
+    m_stats.bytesUploaded += resource.data.size();
+}
+
+ResourceHandle NullBackend::BuildBLAS(const BLASDesc& desc)
+{
+    assert(desc.vertexStride >= 3 * sizeof(float) && "BLAS vertices need a position");
+    assert(static_cast<uint64_t>(desc.vertexCount) * desc.vertexStride <= Get(desc.vertexBuffer).data.size() && "BLAS vertices outside the buffer");
+    assert(static_cast<uint64_t>(desc.indexCount) * sizeof(uint32_t) <= Get(desc.indexBuffer).data.size() && "BLAS indices outside the buffer");
+    assert(desc.indexCount % 3 == 0 && "BLAS index count isn't a multiple of three");
+
+    const ResourceHandle handle = Create(desc.indexCount / 3 * BLAS_BYTES_PER_TRIANGLE);
+    RecordCreate(Get(handle).data.size(), false);
+    m_stats.accelerationStructureBuilds++;
+    return handle;
+}
+
+ResourceHandle NullBackend::BuildTLAS(const std::vector<ASInstance>& instances)
+{
+    for (const ASInstance& instance : instances)
+    {
+        static_cast<void>(Get(instance.blas)); // asserts on released BLASes
+    }
+
+    const ResourceHandle handle = Create(instances.size() * TLAS_BYTES_PER_INSTANCE);
+    RecordCreate(Get(handle).data.size(), false);
+    m_stats.accelerationStructureBuilds++;
+    return handle;
+}
+
+uint64_t NullBackend::Submit()
+{
+    m_submitted++;
+    m_stats.submissions++;
+    if (m_submitted > m_latency)
+    {
+        m_completed = std::max(m_completed, m_submitted - m_latency);
+    }
+    FreeCompleted();
+    return m_submitted;
+}
+
+bool NullBackend::IsComplete(const uint64_t fenceValue) const
+{
+    return fenceValue <= m_completed;
+}
+
+void NullBackend::Wait(const uint64_t fenceValue)
+{
+    if (IsComplete(fenceValue))
+    {
+        return;
+    }
+    // The simulated GPU catches up to the fence, values past the last submission would never complete
+    m_stats.blockingWaits++;
+    m_completed = std::min(fenceValue, m_submitted);
+    FreeCompleted();
+}
+
+const std::vector<uint8_t>& NullBackend::GetContents(const ResourceHandle handle) const
+{
+    return Get(handle).data;
+}
+
+NullBackend::Resource& NullBackend::Get(const ResourceHandle handle)
+{
+    return const_cast<Resource&>(std::as_const(*this).Get(handle));
+}
+
+const NullBackend::Resource& NullBackend::Get(const ResourceHandle handle) const
+{
+    assert(handle.index != 0 && handle.index < m_resources.size() && m_resources[handle.index].alive && "Invalid or released resource handle");
+    return m_resources[handle.index];
+}
+
+void NullBackend::FreeCompleted()
+{
+    while (!m_releases.empty() && IsComplete(m_releases.front().first))
+    {
+        Resource& resource = m_resources[m_releases.front().second];
+        RecordRelease(resource.data.size());
+        if (resource.descriptor >= 0)
+        {
+            m_freeDescriptors.push_back(resource.descriptor);
+        }
+        resource = Resource{};
+        m_freeSlots.push_back(m_releases.front().second);
+        m_releases.pop_front();
+    }
+}
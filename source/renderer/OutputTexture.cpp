@@ -40,8 +40,8 @@ void OutputBuffer::Create(ID3D12Device* device, const uint32_t width, const uint
     srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
     srvDesc.Texture2D.MipLevels = 1;
 
-    device->CreateUnorderedAccessView(m_resource.resource, nullptr, &uavDesc, m_uav.cpuHandle);
-    device->CreateShaderResourceView(m_resource.resource, &srvDesc, m_srv.cpuHandle);
+    device->CreateUnorderedAccessView(m_resource.resource, nullptr, &uavDesc, m_uav.GetWriteHandle());
+    device->CreateShaderResourceView(m_resource.resource, &srvDesc, m_srv.GetWriteHandle());
 
     m_initialized = true;
 }
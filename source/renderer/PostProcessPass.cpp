@@ -17,7 +17,7 @@ PostProcessPass::PostProcessPass(RenderContext& context, ShaderCompiler& compile
     }
 
     BuildRootSignature();
-    BuildPSO();
+    m_pso = CreatePSO(m_shader->GetBytecode());
 }
 
 PostProcessPass::~PostProcessPass() = default;
@@ -30,13 +30,20 @@ void PostProcessPass::BuildRootSignature()
     CD3DX12_DESCRIPTOR_RANGE1 uavRange;
     uavRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0, 0);
 
-    CD3DX12_ROOT_PARAMETER1 params[6] = {};
+    CD3DX12_DESCRIPTOR_RANGE1 extraRanges[MAX_EXTRA_SRVS];
+
+    CD3DX12_ROOT_PARAMETER1 params[6 + MAX_EXTRA_SRVS] = {};
     params[0].InitAsDescriptorTable(1, &srvRange);  // t0:0
     params[1].InitAsDescriptorTable(1, &uavRange);  // u0:0
     params[2].InitAsConstantBufferView(0, 0);       // b0:0
     params[3].InitAsConstantBufferView(1, 0);       // b1:0
     params[4].InitAsConstantBufferView(2, 0);       // b2:0
     params[5].InitAsConstantBufferView(3, 0);       // b3:0
+    for (uint32_t i = 0; i < MAX_EXTRA_SRVS; i++)
+    {
+        extraRanges[i].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 1 + i, 0);
+        params[6 + i].InitAsDescriptorTable(1, &extraRanges[i]); // t1:0 and up
+    }
 
     D3D12_STATIC_SAMPLER_DESC sampler{};
     sampler.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
@@ -52,7 +59,7 @@ void PostProcessPass::BuildRootSignature()
     sampler.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
 
     CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC desc;
-    desc.Init_1_1(6, params, 1, &sampler);
+    desc.Init_1_1(static_cast<UINT>(std::size(params)), params, 1, &sampler);
 
     ComPtr<ID3DBlob> sigBlob, errorBlob;
     HRESULT hr = D3DX12SerializeVersionedRootSignature(&desc, D3D_ROOT_SIGNATURE_VERSION_1_1, &sigBlob, &errorBlob);
@@ -68,14 +75,16 @@ void PostProcessPass::BuildRootSignature()
     m_rootSignature->SetName(L"Post-Process Root Signature");
 }
 
-void PostProcessPass::BuildPSO()
+ComPtr<ID3D12PipelineState> PostProcessPass::CreatePSO(const D3D12_SHADER_BYTECODE bytecode) const
 {
     D3D12_COMPUTE_PIPELINE_STATE_DESC desc{};
     desc.pRootSignature = m_rootSignature.Get();
-    desc.CS = m_shader->GetBytecode();
+    desc.CS = bytecode;
 
-    ThrowIfFailed(m_context.device->CreateComputePipelineState(&desc, IID_PPV_ARGS(&m_pso)));
-    m_pso->SetName(L"Post-Process PSO");
+    ComPtr<ID3D12PipelineState> pso;
+    ThrowIfFailed(m_context.device->CreateComputePipelineState(&desc, IID_PPV_ARGS(&pso)));
+    pso->SetName(L"Post-Process PSO");
+    return pso;
 }
 
 void PostProcessPass::Dispatch(ID3D12GraphicsCommandList4* commandList, const PostProcessBindings& bindings) const
@@ -89,6 +98,10 @@ void PostProcessPass::Dispatch(ID3D12GraphicsCommandList4* commandList, const Po
     {
 	    commandList->SetComputeRootConstantBufferView(2 + i, bindings.constants[i]);
     }
+    for (uint32_t i = 0; i < MAX_EXTRA_SRVS; i++)
+    {
+        commandList->SetComputeRootDescriptorTable(6 + i, i < bindings.extraSRVCount ? bindings.extraSRVs[i] : bindings.inputSRV);
+    }
 
     uint32_t groupsX = (bindings.width + THREAD_GROUP_SIZE - 1) / THREAD_GROUP_SIZE;
     uint32_t groupsY = (bindings.height + THREAD_GROUP_SIZE - 1) / THREAD_GROUP_SIZE;
@@ -97,20 +110,26 @@ void PostProcessPass::Dispatch(ID3D12GraphicsCommandList4* commandList, const Po
 
 bool PostProcessPass::CheckHotReload(CommandQueue& commandQueue)
 {
-    if (!m_shader->NeedsReload())
-    {
-	    return false;
-    }
-
-    if (!m_shader->Reload())
+    switch (m_shader->PollReload())
     {
+    case Shader::ReloadState::Idle:
+        if (m_shader->NeedsReload())
+        {
+            m_shader->StartReload([this](D3D12_SHADER_BYTECODE bytecode) { m_pendingPso = CreatePSO(bytecode); });
+        }
+        return false;
+    case Shader::ReloadState::Compiling:
+        return false;
+    case Shader::ReloadState::Failed:
         std::cerr << "[PostProcessPass] Hot reload failed, keeping previous shader\n";
         return false;
+    case Shader::ReloadState::Reloaded:
+        break;
     }
 
-    commandQueue.Flush();
-    m_pso.Reset();
-    BuildPSO();
+    // Frames in flight may still use the old PSO
+    commandQueue.Retire(m_pso);
+    m_pso = std::move(m_pendingPso);
     std::cout << "[PostProcessPass] Hot reload successful\n";
 
     return true;
@@ -10,31 +10,175 @@
 
 using namespace Microsoft::WRL;
 
-RTPipeline::RTPipeline(ID3D12Device10* device, ID3D12RootSignature* rootSignature, ShaderCompiler& compiler, const std::vector<HitGroupRecord>& records, const std::string& shaderPath)
-	: m_rootSignature(rootSignature)
+namespace
 {
-	std::vector<std::string> entryPoints = {};
-    m_shader = std::make_unique<Shader>(compiler, shaderPath, entryPoints, true);
-    if (!m_shader->IsValid())
+    constexpr UINT Align(UINT size, UINT alignment)
     {
-        ThrowError("Failed to compile RT shaders: " + shaderPath);
+        return (size + alignment - 1) & ~(alignment - 1);
     }
 
+    constexpr UINT SHADER_ID_SIZE = D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES;
+    constexpr UINT RAYGEN_RECORD_SIZE = Align(SHADER_ID_SIZE, D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT);
+    constexpr UINT MISS_RECORD_SIZE = Align(SHADER_ID_SIZE, D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT);
+    constexpr UINT HIT_GROUP_RECORD_SIZE = Align(SHADER_ID_SIZE + sizeof(HitGroupRecord), D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT);
+}
+
+RTPermutation RTPermutation::FromSettings(const RenderSettings& settings)
+{
+    RTPermutation permutation;
+    permutation.debugViews = settings.debugMode != None;
+    permutation.whiteFurnace = settings.whiteFurnace;
+    permutation.russianRoulette = settings.russianRoulette;
+    return permutation;
+}
+
+uint32_t RTPermutation::GetKey() const
+{
+    return (debugViews ? 1u : 0u) | (whiteFurnace ? 2u : 0u) | (russianRoulette ? 4u : 0u);
+}
+
+std::vector<ShaderDefine> RTPermutation::GetDefines() const
+{
+    return {
+        { "ENABLE_DEBUG_VIEWS", debugViews ? "1" : "0" },
+        { "ENABLE_WHITE_FURNACE", whiteFurnace ? "1" : "0" },
+        { "ENABLE_RUSSIAN_ROULETTE", russianRoulette ? "1" : "0" },
+    };
+}
+
+std::string RTPermutation::GetName() const
+{
+    std::string name;
+    if (debugViews) name += "debug views, ";
+    if (whiteFurnace) name += "white furnace, ";
+    if (russianRoulette) name += "russian roulette, ";
+    return name.empty() ? "production" : name.substr(0, name.size() - 2);
+}
+
+RTPipeline::RTPipeline(ID3D12Device10* device, ID3D12RootSignature* rootSignature, ShaderCompiler& compiler, const std::vector<HitGroupRecord>& records,
+                       const std::string& shaderPath, const RTPermutation& permutation)
+	: m_compiler(compiler), m_shaderPath(shaderPath), m_rootSignature(rootSignature)
+{
     CreateLocalRootSignature(device);
-    CreatePSO(device);
-    CreateShaderTables(device, records);
+
+    std::unique_ptr<Variant> variant = CreateVariant(device, permutation, records);
+    if (!variant)
+    {
+        ThrowError("Failed to compile RT shaders: " + shaderPath);
+    }
+    m_active = variant.get();
+    m_variants[permutation.GetKey()] = std::move(variant);
 }
 
 RTPipeline::~RTPipeline() = default;
 
 bool RTPipeline::IsLastCompileSuccesful() const
 {
-	return !m_shader->LastCompileFailed();
+	return !m_active->shader->LastCompileFailed();
 }
 
 std::string RTPipeline::GetLastCompileError() const
 {
-	return m_shader->GetLastCompileError();
+	return m_active->shader->GetLastCompileError();
+}
+
+std::unique_ptr<RTPipeline::Variant> RTPipeline::CreateVariant(ID3D12Device10* device, const RTPermutation& permutation,
+                                                               const std::vector<HitGroupRecord>& records) const
+{
+    auto variant = std::make_unique<Variant>();
+    variant->permutation = permutation;
+    variant->shader = std::make_unique<Shader>(m_compiler, m_shaderPath, std::vector<std::string>{}, true, permutation.GetDefines());
+    if (!variant->shader->IsValid())
+    {
+        return nullptr;
+    }
+
+    variant->pso = CreatePSO(device, variant->shader->GetBytecode());
+    CreateShaderTables(device, *variant, records);
+    return variant;
+}
+
+bool RTPipeline::SetPermutation(ID3D12Device10* device, CommandQueue& commandQueue, const RTPermutation& permutation,
+                                const std::vector<HitGroupRecord>& records, const bool wait)
+{
+    if (permutation.GetKey() == m_active->permutation.GetKey())
+    {
+        return false;
+    }
+
+    auto it = m_variants.find(permutation.GetKey());
+    if (it == m_variants.end())
+    {
+        auto variant = std::make_unique<Variant>();
+        variant->permutation = permutation;
+        variant->shader = std::make_unique<Shader>(m_compiler, m_shaderPath, std::vector<std::string>{}, true, permutation.GetDefines(), false);
+        StartReload(device, *variant);
+        std::cout << "[RTPipeline] Compiling the " << permutation.GetName() << " permutation in the background\n";
+        it = m_variants.emplace(permutation.GetKey(), std::move(variant)).first;
+    }
+    else if (!it->second->shader->IsReloading() && it->second->shader->NeedsReload())
+    {
+        // Shaders changed while it wasn't active
+        StartReload(device, *it->second);
+        std::cout << "[RTPipeline] Recompiling the " << permutation.GetName() << " permutation in the background\n";
+    }
+
+    Variant& variant = *it->second;
+    if (wait)
+    {
+        variant.shader->WaitForReload();
+    }
+    switch (PollReload(device, commandQueue, variant, records))
+    {
+    case Shader::ReloadState::Compiling:
+        return false;
+    case Shader::ReloadState::Failed:
+        std::cerr << "[RTPipeline] Failed to compile the " << permutation.GetName() << " permutation, keeping "
+            << m_active->permutation.GetName() << "\n";
+        return false;
+    case Shader::ReloadState::Reloaded:
+        std::cout << "[RTPipeline] Compiled the " << permutation.GetName() << " permutation\n";
+        break;
+    case Shader::ReloadState::Idle:
+        break;
+    }
+
+    // A permutation that never compiled waits for its shaders to change
+    if (!variant.pso)
+    {
+        return false;
+    }
+    m_active = &variant;
+    return true;
+}
+
+void RTPipeline::StartReload(ID3D12Device10* device, Variant& variant) const
+{
+    // The device is free threaded, so the state object is created on the worker too
+    variant.shader->StartReload([this, device, &variant](D3D12_SHADER_BYTECODE bytecode) { variant.pendingPso = CreatePSO(device, bytecode); });
+}
+
+Shader::ReloadState RTPipeline::PollReload(ID3D12Device10* device, CommandQueue& commandQueue, Variant& variant,
+                                           const std::vector<HitGroupRecord>& records) const
+{
+    const Shader::ReloadState state = variant.shader->PollReload();
+    if (state != Shader::ReloadState::Reloaded)
+    {
+        return state;
+    }
+
+    // Frames in flight may still use the old pipeline and tables, the queue releases them once they're done
+    for (const ComPtr<ID3D12Object> object : { ComPtr<ID3D12Object>(variant.pso), ComPtr<ID3D12Object>(variant.raygenTable),
+                                               ComPtr<ID3D12Object>(variant.missTable), ComPtr<ID3D12Object>(variant.hitGroupTable) })
+    {
+        if (object)
+        {
+            commandQueue.Retire(object);
+        }
+    }
+    variant.pso = std::move(variant.pendingPso);
+    CreateShaderTables(device, variant, records);
+    return state;
 }
 
 void RTPipeline::CreateLocalRootSignature(ID3D12Device10* device)
@@ -53,12 +197,11 @@ void RTPipeline::CreateLocalRootSignature(ID3D12Device10* device)
 	m_localRootSignature->SetName(L"RT Local Root Signature");
 }
 
-void RTPipeline::CreatePSO(ID3D12Device10* device)
+ComPtr<ID3D12StateObject> RTPipeline::CreatePSO(ID3D12Device10* device, D3D12_SHADER_BYTECODE bytecode) const
 {
     CD3DX12_STATE_OBJECT_DESC psoDesc(D3D12_STATE_OBJECT_TYPE_RAYTRACING_PIPELINE);
 
     auto lib = psoDesc.CreateSubobject<CD3DX12_DXIL_LIBRARY_SUBOBJECT>();
-    auto bytecode = m_shader->GetBytecode();
     lib->SetDXILLibrary(&bytecode);
 
     // Hit group
@@ -86,116 +229,116 @@ void RTPipeline::CreatePSO(ID3D12Device10* device)
     auto pipelineConfig = psoDesc.CreateSubobject<CD3DX12_RAYTRACING_PIPELINE_CONFIG_SUBOBJECT>();
     pipelineConfig->Config(2); // max recursion depth
 
-    ThrowIfFailed(device->CreateStateObject(psoDesc, IID_PPV_ARGS(&m_pso)));
-	m_pso->SetName(L"RT PSO");
+    ComPtr<ID3D12StateObject> pso;
+    ThrowIfFailed(device->CreateStateObject(psoDesc, IID_PPV_ARGS(&pso)));
+	pso->SetName(L"RT PSO");
+    return pso;
 }
 
-void RTPipeline::CreateShaderTables(ID3D12Device10* device, const std::vector<HitGroupRecord>& hitGroupRecords)
+void RTPipeline::CreateShaderTables(ID3D12Device10* device, Variant& variant, const std::vector<HitGroupRecord>& hitGroupRecords) const
 {
     ComPtr<ID3D12StateObjectProperties> props;
-    ThrowIfFailed(m_pso.As(&props));
-
-    constexpr UINT shaderIdSize = D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES;
-    auto Align = [](UINT size, UINT alignment) -> UINT
-    {
-        return (size + alignment - 1) & ~(alignment - 1);
-    };
+    ThrowIfFailed(variant.pso.As(&props));
 
-    m_raygenRecordSize = Align(shaderIdSize, D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT);
-    m_missRecordSize = Align(shaderIdSize, D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT);
-    m_hitGroupRecordSize = Align(shaderIdSize + sizeof(HitGroupRecord), D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT);
-    m_hitGroupCount = static_cast<UINT>(hitGroupRecords.size());
+    constexpr UINT shaderIdSize = SHADER_ID_SIZE;
+    const UINT hitGroupCount = static_cast<UINT>(hitGroupRecords.size());
+    variant.hitGroupCount = hitGroupCount;
 
     // Raygen table
     {
-        UINT tableSize = Align(m_raygenRecordSize, D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT);
+        UINT tableSize = Align(RAYGEN_RECORD_SIZE, D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT);
         auto heapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
         auto bufDesc = CD3DX12_RESOURCE_DESC::Buffer(tableSize);
         ThrowIfFailed(device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE,
-					  &bufDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&m_raygenTable)));
-        m_raygenTable->SetName(L"Raygen Table");
+					  &bufDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&variant.raygenTable)));
+        variant.raygenTable->SetName(L"Raygen Table");
 
         void* mapped = nullptr;
-        m_raygenTable->Map(0, nullptr, &mapped);
+        variant.raygenTable->Map(0, nullptr, &mapped);
         memcpy(mapped, props->GetShaderIdentifier(L"RayGen"), shaderIdSize);
-        m_raygenTable->Unmap(0, nullptr);
+        variant.raygenTable->Unmap(0, nullptr);
     }
 
     // Miss table
     {
-        UINT tableSize = Align(m_missRecordSize, D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT);
+        UINT tableSize = Align(MISS_RECORD_SIZE, D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT);
         auto heapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
         auto bufDesc = CD3DX12_RESOURCE_DESC::Buffer(tableSize);
         ThrowIfFailed(device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE,
-					  &bufDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&m_missTable)));
-		m_missTable->SetName(L"Miss Table");
+					  &bufDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&variant.missTable)));
+		variant.missTable->SetName(L"Miss Table");
 
         void* mapped = nullptr;
-        m_missTable->Map(0, nullptr, &mapped);
+        variant.missTable->Map(0, nullptr, &mapped);
         memcpy(mapped, props->GetShaderIdentifier(L"Miss"), shaderIdSize);
-        m_missTable->Unmap(0, nullptr);
+        variant.missTable->Unmap(0, nullptr);
     }
 
     // Hit group table
     {
-        UINT tableSize = Align(m_hitGroupRecordSize * m_hitGroupCount, D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT);
+        UINT tableSize = Align(HIT_GROUP_RECORD_SIZE * hitGroupCount, D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT);
         auto heapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
         auto bufDesc = BUFFER_RESOURCE;
-		bufDesc.Width = std::max(1u, m_hitGroupRecordSize * m_hitGroupCount);
+		bufDesc.Width = std::max(1u, HIT_GROUP_RECORD_SIZE * hitGroupCount);
         ThrowIfFailed(device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE,
-					  &bufDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&m_hitGroupTable)));
-		m_hitGroupTable->SetName(L"Hit Group Table");
+					  &bufDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&variant.hitGroupTable)));
+		variant.hitGroupTable->SetName(L"Hit Group Table");
 
         void* mapped = nullptr;
-        m_hitGroupTable->Map(0, nullptr, &mapped);
+        variant.hitGroupTable->Map(0, nullptr, &mapped);
         auto* dst = static_cast<uint8_t*>(mapped);
         auto* shaderId = props->GetShaderIdentifier(L"HitGroup");
 
-        for (UINT i = 0; i < m_hitGroupCount; i++)
+        for (UINT i = 0; i < hitGroupCount; i++)
         {
-            auto* record = dst + i * m_hitGroupRecordSize;
+            auto* record = dst + i * HIT_GROUP_RECORD_SIZE;
             memcpy(record, shaderId, shaderIdSize);
             memcpy(record + shaderIdSize, &hitGroupRecords[i], sizeof(HitGroupRecord));
         }
 
-        m_hitGroupTable->Unmap(0, nullptr);
+        variant.hitGroupTable->Unmap(0, nullptr);
     }
 }
 
 void RTPipeline::Rebuild(ID3D12Device10* device, const std::vector<HitGroupRecord>& records)
 {
-    m_pso.Reset();
-    m_raygenTable.Reset();
-    m_missTable.Reset();
-    m_hitGroupTable.Reset();
-
-    CreatePSO(device);
-    CreateShaderTables(device, records);
+    m_active->pso = CreatePSO(device, m_active->shader->GetBytecode());
+    CreateShaderTables(device, *m_active, records);
 }
 
 void RTPipeline::RebuildShaderTables(ID3D12Device10* device, const std::vector<HitGroupRecord>& records)
 {
-    m_raygenTable.Reset();
-    m_missTable.Reset();
-    m_hitGroupTable.Reset();
-	CreateShaderTables(device, records);
+    for (auto& [key, variant] : m_variants)
+    {
+        // Still compiling or failed, it gets tables once its pipeline exists
+        if (variant->pso)
+        {
+	        CreateShaderTables(device, *variant, records);
+        }
+    }
 }
 
 bool RTPipeline::CheckHotReload(ID3D12Device10* device, CommandQueue& commandQueue, const std::vector<HitGroupRecord>& records)
 {
-    if (!m_shader->NeedsReload())
-    {
-	    return false;
-    }
-
-    if (!m_shader->Reload())
+    // Only the active permutation, the others are reloaded when they're selected again
+    Variant& variant = *m_active;
+    switch (PollReload(device, commandQueue, variant, records))
     {
+    case Shader::ReloadState::Idle:
+        if (variant.shader->NeedsReload())
+        {
+            StartReload(device, variant);
+            std::cout << "[RTPipeline] Recompiling in the background\n";
+        }
+        return false;
+    case Shader::ReloadState::Compiling:
+        return false;
+    case Shader::ReloadState::Failed:
         std::cerr << "[RTPipeline] Hot reload failed, keeping previous shaders\n";
         return false;
+    case Shader::ReloadState::Reloaded:
+        break;
     }
-
-    commandQueue.Flush();
-    Rebuild(device, records);
     std::cout << "[RTPipeline] Hot reload successful\n";
 
     return true;
@@ -205,16 +348,16 @@ D3D12_DISPATCH_RAYS_DESC RTPipeline::GetDispatchRaysDesc() const
 {
     D3D12_DISPATCH_RAYS_DESC desc{};
 
-    desc.RayGenerationShaderRecord.StartAddress = m_raygenTable->GetGPUVirtualAddress();
-    desc.RayGenerationShaderRecord.SizeInBytes = m_raygenRecordSize;
+    desc.RayGenerationShaderRecord.StartAddress = m_active->raygenTable->GetGPUVirtualAddress();
+    desc.RayGenerationShaderRecord.SizeInBytes = RAYGEN_RECORD_SIZE;
 
-    desc.MissShaderTable.StartAddress = m_missTable->GetGPUVirtualAddress();
-    desc.MissShaderTable.SizeInBytes = m_missRecordSize;
-    desc.MissShaderTable.StrideInBytes = m_missRecordSize;
+    desc.MissShaderTable.StartAddress = m_active->missTable->GetGPUVirtualAddress();
+    desc.MissShaderTable.SizeInBytes = MISS_RECORD_SIZE;
+    desc.MissShaderTable.StrideInBytes = MISS_RECORD_SIZE;
 
-    desc.HitGroupTable.StartAddress = m_hitGroupTable->GetGPUVirtualAddress();
-    desc.HitGroupTable.SizeInBytes = m_hitGroupRecordSize * m_hitGroupCount;
-    desc.HitGroupTable.StrideInBytes = m_hitGroupRecordSize;
+    desc.HitGroupTable.StartAddress = m_active->hitGroupTable->GetGPUVirtualAddress();
+    desc.HitGroupTable.SizeInBytes = HIT_GROUP_RECORD_SIZE * m_active->hitGroupCount;
+    desc.HitGroupTable.StrideInBytes = HIT_GROUP_RECORD_SIZE;
 
     desc.Width = 0;
     desc.Height = 0;
@@ -0,0 +1,322 @@
+#include "RenderGraph.h"
+
+#include <cassert>
+#include <iostream>
+
+namespace
+{
+    // The state a pass needs a resource in, combining all of its accesses to it
+    struct Usage
+    {
+        RenderGraphResource resource;
+        ResourceState state;
+        bool write;
+    };
+
+    // False if the accesses can't be satisfied by a single state
+    bool Combine(std::vector<Usage>& usages, const RenderGraphResource resource, const ResourceState state, const bool write)
+    {
+        for (Usage& usage : usages)
+        {
+            if (usage.resource != resource)
+            {
+                continue;
+            }
+            if (usage.state != state)
+            {
+                if (usage.write || write || !IsReadState(usage.state) || !IsReadState(state))
+                {
+                    return false;
+                }
+                usage.state = usage.state | state;
+            }
+            usage.write |= write;
+            return true;
+        }
+        usages.push_back({ resource, state, write });
+        return true;
+    }
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::Read(const RenderGraphResource resource, const ResourceState state)
+{
+    m_graph.m_passes[m_pass].accesses.push_back({ resource, state, false });
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::Write(const RenderGraphResource resource, const ResourceState state)
+{
+    m_graph.m_passes[m_pass].accesses.push_back({ resource, state, true });
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::SideEffect()
+{
+    m_graph.m_passes[m_pass].sideEffect = true;
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::Execute(std::function<void()> execute)
+{
+    m_graph.m_passes[m_pass].execute = std::move(execute);
+    return *this;
+}
+
+RenderGraphResource RenderGraph::Import(const std::string& name, const ResourceState state)
+{
+    Resource resource;
+    resource.name = name;
+    resource.initialState = state;
+    resource.imported = true;
+    m_resources.push_back(resource);
+    return static_cast<RenderGraphResource>(m_resources.size() - 1);
+}
+
+RenderGraphResource RenderGraph::Create(const std::string& name)
+{
+    Resource resource;
+    resource.name = name;
+    m_resources.push_back(resource);
+    return static_cast<RenderGraphResource>(m_resources.size() - 1);
+}
+
+void RenderGraph::SetOutput(const RenderGraphResource resource, const ResourceState finalState)
+{
+    assert(resource < m_resources.size() && "Invalid render graph resource");
+    m_resources[resource].output = true;
+    m_resources[resource].outputState = finalState;
+}
+
+RenderGraph::PassBuilder RenderGraph::AddPass(const std::string& name)
+{
+    Pass pass;
+    pass.name = name;
+    m_passes.push_back(std::move(pass));
+    return PassBuilder(*this, static_cast<uint32_t>(m_passes.size() - 1));
+}
+
+bool RenderGraph::Compile()
+{
+    m_order.clear();
+    m_finalBarriers.clear();
+    m_stats = {};
+    for (Resource& resource : m_resources)
+    {
+        resource.lifetime.reset();
+    }
+    for (Pass& pass : m_passes)
+    {
+        pass.live = false;
+        pass.barriers.clear();
+    }
+
+    if (!Validate())
+    {
+        return false;
+    }
+
+    Cull();
+    PlaceBarriers();
+    return true;
+}
+
+void RenderGraph::Execute(const std::function<void(std::span<const RenderGraphBarrier>)>& submitBarriers) const
+{
+    for (const uint32_t index : m_order)
+    {
+        const Pass& pass = m_passes[index];
+        if (!pass.barriers.empty())
+        {
+            submitBarriers(pass.barriers);
+        }
+        if (pass.execute)
+        {
+            pass.execute();
+        }
+    }
+    if (!m_finalBarriers.empty())
+    {
+        submitBarriers(m_finalBarriers);
+    }
+}
+
+ResourceState RenderGraph::GetFinalState(const RenderGraphResource resource) const
+{
+    assert(resource < m_resources.size() && "Invalid render graph resource");
+    return m_resources[resource].finalState;
+}
+
+std::optional<RenderGraphLifetime> RenderGraph::GetLifetime(const RenderGraphResource resource) const
+{
+    assert(resource < m_resources.size() && "Invalid render graph resource");
+    return m_resources[resource].lifetime;
+}
+
+bool RenderGraph::Validate() const
+{
+    std::vector<bool> written(m_resources.size(), false);
+    for (const Pass& pass : m_passes)
+    {
+        std::vector<Usage> usages;
+        for (const Access& access : pass.accesses)
+        {
+            if (access.resource >= m_resources.size())
+            {
+                std::cerr << "[RenderGraph] " << pass.name << " uses resource " << access.resource << ", which doesn't exist\n";
+                return false;
+            }
+
+            const Resource& resource = m_resources[access.resource];
+            if (access.write && (IsReadState(access.state) || access.state == ResourceState::Common))
+            {
+                std::cerr << "[RenderGraph] " << pass.name << " writes " << resource.name << " in a state that can't be written\n";
+                return false;
+            }
+            if (!Combine(usages, access.resource, access.state, access.write))
+            {
+                std::cerr << "[RenderGraph] " << pass.name << " needs " << resource.name << " in two states at once\n";
+                return false;
+            }
+        }
+
+        for (const Usage& usage : usages)
+        {
+            if (!m_resources[usage.resource].imported && !written[usage.resource] && !usage.write)
+            {
+                std::cerr << "[RenderGraph] " << pass.name << " reads " << m_resources[usage.resource].name << " before anything wrote it\n";
+                return false;
+            }
+            written[usage.resource] = written[usage.resource] || usage.write;
+        }
+    }
+    return true;
+}
+
+void RenderGraph::Cull()
+{
+    // Backwards from the outputs, a pass is needed if it writes something a needed pass or the output reads
+    std::vector<bool> needed(m_resources.size(), false);
+    for (size_t i = 0; i < m_resources.size(); i++)
+    {
+        needed[i] = m_resources[i].output;
+    }
+
+    for (size_t i = m_passes.size(); i-- > 0;)
+    {
+        Pass& pass = m_passes[i];
+        pass.live = pass.sideEffect;
+        for (const Access& access : pass.accesses)
+        {
+            pass.live = pass.live || (access.write && needed[access.resource]);
+        }
+        if (!pass.live)
+        {
+            continue;
+        }
+        for (const Access& access : pass.accesses)
+        {
+            needed[access.resource] = true;
+        }
+    }
+
+    // Passes only depend on passes added before them, so the order they were added in is a valid order
+    m_stats.passes = static_cast<uint32_t>(m_passes.size());
+    for (uint32_t i = 0; i < m_passes.size(); i++)
+    {
+        if (m_passes[i].live)
+        {
+            m_order.push_back(i);
+        }
+        else
+        {
+            m_stats.culledPasses++;
+        }
+    }
+}
+
+void RenderGraph::PlaceBarriers()
+{
+    std::vector<ResourceState> states(m_resources.size());
+    // Whether the last access to each resource was unordered access, and whether it wrote
+    std::vector<bool> previousUAV(m_resources.size(), false);
+    std::vector<bool> previousUAVWrite(m_resources.size(), false);
+    for (size_t i = 0; i < m_resources.size(); i++)
+    {
+        states[i] = m_resources[i].initialState;
+    }
+
+    // Moves a resource into the state, or leaves it if it's in a read state that covers this one already
+    const auto transition = [&](std::vector<RenderGraphBarrier>& barriers, const RenderGraphResource resource, const ResourceState state)
+    {
+        ResourceState& current = states[resource];
+        if (current == state || (IsReadState(current) && IsReadState(state) && HasAllStates(current, state)))
+        {
+            if (current != state)
+            {
+                m_stats.skippedTransitions++;
+            }
+            return false;
+        }
+
+        // Reads that follow each other keep the earlier read states, so going back to them needs no barrier
+        const ResourceState after = IsReadState(current) && IsReadState(state) ? current | state : state;
+        barriers.push_back({ RenderGraphBarrier::Type::Transition, resource, current, after });
+        m_stats.transitions++;
+        current = after;
+        return true;
+    };
+
+    for (uint32_t position = 0; position < m_order.size(); position++)
+    {
+        Pass& pass = m_passes[m_order[position]];
+        std::vector<Usage> usages;
+        for (const Access& access : pass.accesses)
+        {
+            Combine(usages, access.resource, access.state, access.write);
+
+            std::optional<RenderGraphLifetime>& lifetime = m_resources[access.resource].lifetime;
+            if (!lifetime)
+            {
+                lifetime = RenderGraphLifetime{ position, position };
+            }
+            lifetime->lastPass = position;
+        }
+
+        for (const Usage& usage : usages)
+        {
+            const bool transitioned = transition(pass.barriers, usage.resource, usage.state);
+            // Unordered accesses in a row only need no barrier if neither writes, a write after a read could
+            // overwrite data the reading dispatch hasn't read yet
+            const bool uav = usage.state == ResourceState::UnorderedAccess;
+            if (!transitioned && uav && previousUAV[usage.resource] && (previousUAVWrite[usage.resource] || usage.write))
+            {
+                pass.barriers.push_back({ RenderGraphBarrier::Type::UAV, usage.resource, usage.state, usage.state });
+                m_stats.uavBarriers++;
+            }
+            previousUAV[usage.resource] = uav;
+            previousUAVWrite[usage.resource] = uav && usage.write;
+        }
+
+        if (!pass.barriers.empty())
+        {
+            m_stats.barrierBatches++;
+        }
+    }
+
+    for (size_t i = 0; i < m_resources.size(); i++)
+    {
+        if (m_resources[i].output)
+        {
+            transition(m_finalBarriers, static_cast<RenderGraphResource>(i), m_resources[i].outputState);
+        }
+    }
+    if (!m_finalBarriers.empty())
+    {
+        m_stats.barrierBatches++;
+    }
+
+    for (size_t i = 0; i < m_resources.size(); i++)
+    {
+        m_resources[i].finalState = states[i];
+    }
+}
@@ -0,0 +1,68 @@
+#include "RenderGraphDX.h"
+
+#include <cassert>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    constexpr std::pair<ResourceState, D3D12_RESOURCE_STATES> STATES[] = {
+        { ResourceState::UnorderedAccess, D3D12_RESOURCE_STATE_UNORDERED_ACCESS },
+        { ResourceState::NonPixelShaderResource, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE },
+        { ResourceState::PixelShaderResource, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE },
+        { ResourceState::RenderTarget, D3D12_RESOURCE_STATE_RENDER_TARGET },
+        { ResourceState::CopySource, D3D12_RESOURCE_STATE_COPY_SOURCE },
+        { ResourceState::CopyDest, D3D12_RESOURCE_STATE_COPY_DEST },
+    };
+}
+
+D3D12_RESOURCE_STATES ToD3D12State(const ResourceState state)
+{
+    D3D12_RESOURCE_STATES result = D3D12_RESOURCE_STATE_COMMON;
+    for (const auto& [graphState, d3d12State] : STATES)
+    {
+        if (HasAllStates(state, graphState))
+        {
+            result |= d3d12State;
+        }
+    }
+    return result;
+}
+
+ResourceState FromD3D12State(const D3D12_RESOURCE_STATES state)
+{
+    ResourceState result = ResourceState::Common;
+    D3D12_RESOURCE_STATES remaining = state;
+    for (const auto& [graphState, d3d12State] : STATES)
+    {
+        if ((state & d3d12State) == d3d12State)
+        {
+            result = result | graphState;
+            remaining &= ~d3d12State;
+        }
+    }
+    assert(remaining == 0 && "Resource is in a state the render graph doesn't track");
+    return result;
+}
+
+void ExecuteRenderGraph(const RenderGraph& graph, ID3D12GraphicsCommandList* commandList, const std::span<ID3D12Resource* const> resources)
+{
+    std::vector<D3D12_RESOURCE_BARRIER> barriers;
+    graph.Execute([&](const std::span<const RenderGraphBarrier> batch)
+    {
+        barriers.clear();
+        for (const RenderGraphBarrier& barrier : batch)
+        {
+            ID3D12Resource* resource = resources[barrier.resource];
+            if (barrier.type == RenderGraphBarrier::Type::UAV)
+            {
+                barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(resource));
+            }
+            else
+            {
+                barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource, ToD3D12State(barrier.before), ToD3D12State(barrier.after)));
+            }
+        }
+        commandList->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+    });
+}
@@ -5,8 +5,9 @@
 #include "CommandQueue.h"
 #include "DescriptorHeap.h"
 #include "GPUAllocator.h"
-#include "CBVBuffer.h"
+#include "ConstantRing.h"
 #include "UploadContext.h"
+#include "D3D12Backend.h"
 #include "SwapChain.h"
 #include "OutputTexture.h"
 #include "ShaderCompiler.h"
@@ -17,8 +18,15 @@
 #include "Scene.h"
 #include "StructsDX.h"
 #include "CommonDX.h"
+#include "BVHAnalyzer.h"
+#include "BVHBenchmark.h"
+#include "CPUPathTracer.h"
+#include "Denoiser.h"
+#include "Tonemapping.h"
+#include "RenderGraphDX.h"
 
 #include <imgui.h>
+#include <algorithm>
 #include <iostream>
 #include <chrono>
 
@@ -35,44 +43,64 @@ Renderer::Renderer(Window& window, bool debug)
 	auto device = m_device->GetDevice();
 	m_commandQueue = std::make_unique<CommandQueue>(m_device->GetDevice(), "Main", D3D12_COMMAND_LIST_TYPE_DIRECT);
 	auto commandList = m_commandQueue->GetCommandList();
-	m_descriptorHeap = std::make_unique<DescriptorHeap>(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 4096, true, L"CBV SRV UAV Descriptor Heap");
+	m_descriptorHeap = std::make_unique<DescriptorHeap>(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 4096, true, L"CBV SRV UAV Descriptor Heap", m_commandQueue.get());
 	m_allocator = std::make_unique<GPUAllocator>(device, m_device->GetAdapter());
 	m_uploadContext = std::make_unique<UploadContext>(*m_allocator, device);
 
 	m_context = { device, m_allocator.get(), m_commandQueue.get(), m_descriptorHeap.get(), m_uploadContext.get() };
+	m_backend = std::make_unique<D3D12Backend>(m_context);
+	m_context.backend = m_backend.get();
 
 	m_swapChain = std::make_unique<SwapChain>(window, device, m_device->GetAdapter(), m_commandQueue.get());
 	m_imgui = std::make_unique<ImGuiWrapper>(window, m_context, m_swapChain->GetFormat(), NUM_FRAMES_IN_FLIGHT);
 
-	m_scene = std::make_unique<Scene>(m_context);
+	m_scene = std::make_unique<Scene>(*m_backend);
 
 	m_shaderCompiler = std::make_unique<ShaderCompiler>();
+	m_shaderCompiler->WatchForChanges("shaders");
 
 	const int width = window.GetWidth();
 	const int height = window.GetHeight();
 	m_accumulationBuffer = std::make_unique<OutputBuffer>(m_context, DXGI_FORMAT_R32G32B32A32_FLOAT, width, height, L"Accumulation Buffer");
+	m_momentBuffer = std::make_unique<OutputBuffer>(m_context, DXGI_FORMAT_R32G32_FLOAT, width, height, L"Moment Buffer");
+	m_albedoBuffer = std::make_unique<OutputBuffer>(m_context, DXGI_FORMAT_R32G32B32A32_FLOAT, width, height, L"Albedo Buffer");
+	m_normalDepthBuffer = std::make_unique<OutputBuffer>(m_context, DXGI_FORMAT_R32G32B32A32_FLOAT, width, height, L"Normal Depth Buffer");
+	m_motionBuffer = std::make_unique<OutputBuffer>(m_context, DXGI_FORMAT_R32G32_FLOAT, width, height, L"Motion Buffer");
+	m_idBuffer = std::make_unique<OutputBuffer>(m_context, DXGI_FORMAT_R32G32_UINT, width, height, L"ID Buffer");
+	m_denoiseBuffers[0] = std::make_unique<OutputBuffer>(m_context, DXGI_FORMAT_R32G32B32A32_FLOAT, width, height, L"Denoise Buffer 0");
+	m_denoiseBuffers[1] = std::make_unique<OutputBuffer>(m_context, DXGI_FORMAT_R32G32B32A32_FLOAT, width, height, L"Denoise Buffer 1");
 	m_outputBuffer = std::make_unique<OutputBuffer>(m_context, DXGI_FORMAT_R10G10B10A2_UNORM, width, height, L"RT Output Buffer");
 
 	m_rootSignature = std::make_unique<RootSignature>();
 	m_rootSignature->AddDescriptorTable(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0, 0, "accumulationBuffer"); // u0:0 accumulation buffer
+	m_rootSignature->AddDescriptorTable(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 1, 0, "momentBuffer");       // u1:0 moment buffer
+	m_rootSignature->AddDescriptorTable(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 2, 0, "albedoBuffer");       // u2:0 albedo buffer
+	m_rootSignature->AddDescriptorTable(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 3, 0, "normalDepthBuffer");  // u3:0 normal depth buffer
+	m_rootSignature->AddDescriptorTable(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 4, 0, "motionBuffer");       // u4:0 motion buffer
+	m_rootSignature->AddDescriptorTable(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 5, 0, "idBuffer");           // u5:0 id buffer
 	m_rootSignature->AddRootSRV(0, 0, "sceneBVH");			 // t0:0 TLAS
 	m_rootSignature->AddRootSRV(1, 0, "materials");			 // t1:0 materials
 	m_rootSignature->AddRootCBV(0, 0, "camera");			 // b0:0 camera
 	m_rootSignature->AddRootCBV(1, 0, "renderSettings");	 // b1:0 render settings
 	m_rootSignature->AddRootCBV(2, 0, "renderData");		 // b2:0 render data
 	m_rootSignature->AddRootCBV(3, 0, "postProcessSettings");// b3:0 post processing settings
+	m_rootSignature->AddRootCBV(4, 0, "previousCamera");	 // b4:0 previous frame camera, for motion vectors
 	m_rootSignature->AddStaticSampler(0);					 // s0:0 linear sampler
 	m_rootSignature->Build(device, L"RT Root Signature");
 
 	m_rtPipeline = std::make_unique<RTPipeline>(device, m_rootSignature->Get(), *m_shaderCompiler,
-	                                            m_scene->GetHitGroupRecords(), "shaders/raytracing.slang");
+	                                            m_scene->GetHitGroupRecords(), "shaders/raytracing.slang",
+	                                            RTPermutation::FromSettings(m_renderSettings));
 
 	m_tonemappingPass = std::make_unique<PostProcessPass>(m_context, *m_shaderCompiler, "shaders/tonemapping_pass.slang", "CSMain");
+	m_convergencePass = std::make_unique<PostProcessPass>(m_context, *m_shaderCompiler, "shaders/convergence_pass.slang", "CSMain");
+	m_denoisePreparePass = std::make_unique<PostProcessPass>(m_context, *m_shaderCompiler, "shaders/denoise_pass.slang", "Prepare");
+	m_denoisePass = std::make_unique<PostProcessPass>(m_context, *m_shaderCompiler, "shaders/denoise_pass.slang", "Filter");
 
-	m_cameraCB = std::make_unique<CBVBuffer<CameraData>>(*m_allocator, "Camera CB");
-	m_renderSettingsCB = std::make_unique<CBVBuffer<RenderSettings>>(*m_allocator, "Render Settings CB");
-	m_renderDataCB = std::make_unique<CBVBuffer<RenderData>>(*m_allocator, "Render Data CB");
-	m_postProcessSettingsCB = std::make_unique<CBVBuffer<PostProcessSettings>>(*m_allocator, "Post Process Settings CB");
+	m_constants = std::make_unique<ConstantRing>(*m_backend, "Constant Ring", NUM_FRAMES_IN_FLIGHT);
+
+	// Baked up front, so the tonemapping pass always has a LUT bound
+	UpdateTonemapLut(true);
 
 	m_commandQueue->ExecuteCommandList(commandList);
 	m_commandQueue->Flush();
@@ -99,8 +127,51 @@ void Renderer::LoadModel(const std::string& path)
 
 void Renderer::LoadHDRI(const std::string& path)
 {
-	m_scene->LoadHDRI(path);
-	ResetAccumulation();
+	if (m_scene->LoadHDRI(path))
+	{
+		ResetAccumulation();
+	}
+}
+
+void Renderer::AnalyzeBVH() const
+{
+	const auto& viewport = m_swapChain->GetViewport();
+	BVHAnalyzer::Report report = BVHAnalyzer::Analyze(m_scene->GetCPUInstances(), *m_camera, viewport.Width / viewport.Height);
+	report.Print(std::cout);
+}
+
+void Renderer::BenchmarkBVHUpdates() const
+{
+	const auto& viewport = m_swapChain->GetViewport();
+	BVHBenchmark::Report report = BVHBenchmark::Run(m_scene->GetCPUInstances(), *m_camera, viewport.Width / viewport.Height);
+	report.Print(std::cout);
+}
+
+void Renderer::BenchmarkRaySorting() const
+{
+	CPUScene scene;
+	for (const auto& path : m_scene->GetModelPaths())
+	{
+		scene.LoadModel(path);
+	}
+	if (!m_scene->GetHDRIPath().empty())
+	{
+		scene.LoadHDRI(m_scene->GetHDRIPath());
+	}
+
+	CPURenderSettings settings;
+	settings.bounces = m_renderSettings.bounces;
+	settings.skyIntensity = m_renderSettings.skyIntensity;
+	settings.lightIntensity = m_renderSettings.lightIntensity;
+	settings.whiteFurnace = m_renderSettings.whiteFurnace;
+	settings.sequence = static_cast<RNG::Sequence>(m_renderSettings.sampleSequence);
+
+	// Quarter resolution keeps the CPU runs short
+	const auto& viewport = m_swapChain->GetViewport();
+	uint32_t width = std::max(1u, static_cast<uint32_t>(viewport.Width) / 4);
+	uint32_t height = std::max(1u, static_cast<uint32_t>(viewport.Height) / 4);
+	CPUPathTracer::RaySortingComparison comparison = CPUPathTracer::CompareRaySorting(scene, *m_camera, width, height, 4, settings);
+	comparison.Print(std::cout);
 }
 
 void Renderer::Resize(const int width, const int height)
@@ -116,6 +187,97 @@ void Renderer::Resize(const int width, const int height)
 	m_swapChain->Resize(width, height, m_device->GetDevice());
 	m_outputBuffer->Resize(m_device->GetDevice(), width, height);
 	m_accumulationBuffer->Resize(m_device->GetDevice(), width, height);
+	m_momentBuffer->Resize(m_device->GetDevice(), width, height);
+	m_albedoBuffer->Resize(m_device->GetDevice(), width, height);
+	m_normalDepthBuffer->Resize(m_device->GetDevice(), width, height);
+	m_motionBuffer->Resize(m_device->GetDevice(), width, height);
+	m_idBuffer->Resize(m_device->GetDevice(), width, height);
+	m_denoiseBuffers[0]->Resize(m_device->GetDevice(), width, height);
+	m_denoiseBuffers[1]->Resize(m_device->GetDevice(), width, height);
+	m_transientPlanDirty = true;
+}
+
+void Renderer::UpdateTonemapLut(const bool force)
+{
+	m_postProcessSettings.lutSize = std::clamp(m_postProcessSettings.lutSize, 2u, 129u);
+	const bool changed = m_postProcessSettings.tonemapper != m_bakedLutSettings.tonemapper ||
+		m_postProcessSettings.exposure != m_bakedLutSettings.exposure ||
+		m_postProcessSettings.lutSize != m_bakedLutSettings.lutSize;
+	if (!force && (!m_postProcessSettings.bakedLut || !changed))
+	{
+		return;
+	}
+
+	const auto start = std::chrono::high_resolution_clock::now();
+	const auto op = static_cast<Tonemapping::Operator>(m_postProcessSettings.tonemapper);
+	const uint32_t size = m_postProcessSettings.lutSize;
+	const Tonemapping::Lut lut = Tonemapping::BakeLut(op, m_postProcessSettings.exposure, size);
+	const float bakeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	const float maxError = Tonemapping::GetLutError(lut, op, m_postProcessSettings.exposure);
+
+	// The previous LUT is released once the frames in flight are done with it
+	TextureDesc desc;
+	desc.width = desc.height = desc.depth = size;
+	desc.format = ResourceFormat::RGBA32F;
+	desc.name = "Tonemap LUT";
+	m_tonemapLut = BackendResource(*m_backend, m_backend->CreateTexture(desc));
+	m_backend->UploadTexture(m_tonemapLut.Get(), lut.texels.data());
+	m_backend->Submit();
+
+	m_postProcessSettings.lutScale = lut.scale;
+	m_postProcessSettings.lutOffset = lut.offset;
+	m_bakedLutSettings = m_postProcessSettings;
+	std::cout << "[Renderer] Baked " << Tonemapping::GetOperatorName(op) << " LUT (" << size << "^3) in " << bakeMs
+		<< " ms, max error " << maxError << "\n";
+}
+
+RenderGraphResource Renderer::AddDenoisePasses(RenderGraph& graph, ID3D12GraphicsCommandList4* commandList, const FrameResources& resources)
+{
+	const uint32_t iterations = std::clamp(m_denoiseSettings.iterations, 1u, Denoiser::MAX_ITERATIONS);
+
+	PostProcessPass::PostProcessBindings bindings;
+	bindings.extraSRVs[0] = m_albedoBuffer->GetSRV().GetGPUHandle();
+	bindings.extraSRVs[1] = m_normalDepthBuffer->GetSRV().GetGPUHandle();
+	bindings.extraSRVs[2] = m_accumulationBuffer->GetSRV().GetGPUHandle();
+	bindings.extraSRVCount = 3;
+	bindings.constants[0] = m_constants->Push(m_denoiseSettings);
+	bindings.constantCount = 2;
+	bindings.width = static_cast<uint32_t>(m_swapChain->GetViewport().Width);
+	bindings.height = static_cast<uint32_t>(m_swapChain->GetViewport().Height);
+
+	bindings.inputSRV = m_accumulationBuffer->GetSRV().GetGPUHandle();
+	bindings.outputUAV = m_denoiseBuffers[0]->GetUAV().GetGPUHandle();
+	// Prepare sees the same iteration constants as the first filter pass
+	bindings.constants[1] = m_constants->Push(DenoiseIteration{ 1u, iterations == 1 });
+	graph.AddPass("Denoise Prepare")
+		.Read(resources.albedo, ResourceState::NonPixelShaderResource)
+		.Read(resources.normalDepth, ResourceState::NonPixelShaderResource)
+		.Read(resources.accumulation, ResourceState::NonPixelShaderResource)
+		.Write(resources.denoise[0])
+		.Execute([this, commandList, bindings]() { m_denoisePreparePass->Dispatch(commandList, bindings); });
+
+	for (uint32_t i = 0; i < iterations; i++)
+	{
+		const uint32_t input = i % 2;
+		const uint32_t output = (i + 1) % 2;
+
+		DenoiseIteration iteration;
+		iteration.stepSize = 1u << i;
+		iteration.last = i + 1 == iterations;
+
+		bindings.inputSRV = m_denoiseBuffers[input]->GetSRV().GetGPUHandle();
+		bindings.outputUAV = m_denoiseBuffers[output]->GetUAV().GetGPUHandle();
+		bindings.constants[1] = m_constants->Push(iteration);
+		graph.AddPass("Denoise")
+			.Read(resources.albedo, ResourceState::NonPixelShaderResource)
+			.Read(resources.normalDepth, ResourceState::NonPixelShaderResource)
+			.Read(resources.accumulation, ResourceState::NonPixelShaderResource)
+			.Read(resources.denoise[input], ResourceState::NonPixelShaderResource)
+			.Write(resources.denoise[output])
+			.Execute([this, commandList, bindings]() { m_denoisePass->Dispatch(commandList, bindings); });
+	}
+
+	return resources.denoise[iterations % 2];
 }
 
 void Renderer::Render(const float deltaTime)
@@ -125,6 +287,7 @@ void Renderer::Render(const float deltaTime)
 	auto commandList = m_commandQueue->GetCommandList();
 	auto commandQueue = m_commandQueue->GetQueue();
 
+	// The watcher records changes in the background, the interval only debounces editors that save in several writes
 	if (m_reloadTimer >= 0.5f)
 	{
 		if (m_rtPipeline->CheckHotReload(m_device->GetDevice(), *m_commandQueue, m_scene->GetHitGroupRecords()))
@@ -132,6 +295,9 @@ void Renderer::Render(const float deltaTime)
 			ResetAccumulation();
 		}
 		m_tonemappingPass->CheckHotReload(*m_commandQueue);
+		m_convergencePass->CheckHotReload(*m_commandQueue);
+		m_denoisePreparePass->CheckHotReload(*m_commandQueue);
+		m_denoisePass->CheckHotReload(*m_commandQueue);
 		m_reloadTimer = 0.0f;
 	}
 	else
@@ -149,8 +315,6 @@ void Renderer::Render(const float deltaTime)
 	// Begin frame
 	{
 		m_imgui->BeginFrame();
-		m_outputBuffer->Transition(commandList.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-		m_swapChain->Transition(commandList.Get(), D3D12_RESOURCE_STATE_RENDER_TARGET);
 	}
 
 	// ImGui window
@@ -181,8 +345,14 @@ void Renderer::Render(const float deltaTime)
 		ImGui::Begin("Debug");
 		ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
 		ImGui::Text("Frame: %u", m_renderData.frame);
+		const IndexAllocatorStats descriptors = m_descriptorHeap->GetStats();
+		ImGui::Text("Descriptors: %u / %u, %.0f%% fragmented", descriptors.allocated, descriptors.capacity, descriptors.GetFragmentation() * 100.0f);
+		ImGui::Text("Transient buffers: %.1f MiB aliased, %.1f MiB dedicated", m_transientPlan.size / (1024.0 * 1024.0),
+			m_transientPlan.naiveSize / (1024.0 * 1024.0));
+		ImGui::Text("Constants: %.1f / %.1f KiB per frame", m_constants->GetPeakUsed() / 1024.0, m_constants->GetFrameCapacity() / 1024.0);
 		auto responseRender = ImReflect::Input("Render Settings", m_renderSettings, config);
 		auto responsePost = ImReflect::Input("Post Process Settings", m_postProcessSettings, config);
+		ImReflect::Input("Denoise Settings", m_denoiseSettings, config2);
 		auto responseCamera = ImReflect::Input("Camera", camData, config2);
 		if (responseRender.get<RenderSettings>().is_changed())
 		{
@@ -195,84 +365,228 @@ void Renderer::Render(const float deltaTime)
 			m_camera->SetDirection(camData.forward);
 			m_camera->m_fov = camData.fov;
 		}
+		if (ImGui::Button("Analyze BVH"))
+		{
+			AnalyzeBVH();
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Benchmark BVH Updates"))
+		{
+			BenchmarkBVHUpdates();
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Benchmark Ray Sorting"))
+		{
+			BenchmarkRaySorting();
+		}
 		
 		ImGui::End();
 	}
 
-	m_renderData.hdriIndex = m_scene->GetHDRIDescriptorIndex();
-	m_renderSettingsCB->Update(backBufferIndex, m_renderSettings);
-	m_renderDataCB->Update(backBufferIndex, m_renderData);
-	m_postProcessSettingsCB->Update(backBufferIndex, m_postProcessSettings);
-	m_cameraCB->Update(backBufferIndex, camData);
+	// Features that are off are compiled out, a setting that needs a new permutation compiles it in the background once
+	// and the current one renders until it's ready
+	if (m_rtPipeline->SetPermutation(m_device->GetDevice(), *m_commandQueue, RTPermutation::FromSettings(m_renderSettings), m_scene->GetHitGroupRecords()))
+	{
+		ResetAccumulation();
+	}
 
-	// Record commands
+	// This back buffer's last frame was waited on, so its constants can be written over
+	m_constants->BeginFrame(backBufferIndex);
+	m_renderData.hdriIndex = m_scene->GetHDRIDescriptorIndex();
+	const D3D12_GPU_VIRTUAL_ADDRESS renderSettingsCB = m_constants->Push(m_renderSettings);
+	const D3D12_GPU_VIRTUAL_ADDRESS renderDataCB = m_constants->Push(m_renderData);
+	UpdateTonemapLut();
+	const D3D12_GPU_VIRTUAL_ADDRESS postProcessSettingsCB = m_constants->Push(m_postProcessSettings);
+	const D3D12_GPU_VIRTUAL_ADDRESS cameraCB = m_constants->Push(camData);
+	// No previous frame yet on the first one, motion is zero then
+	const D3D12_GPU_VIRTUAL_ADDRESS previousCameraCB = m_constants->Push(m_prevCamData.fov > 0.0f ? m_prevCamData : camData);
+
+	// Record commands, the passes declare what they access and the render graph places the barriers between them
 	{
-		// Raytracing pass
+		// Everything is imported in the state it was left in, the passes' accesses move it to the states they need
+		RenderGraph graph;
+		std::vector<ID3D12Resource*> graphResources;
+		std::vector<std::pair<RenderGraphResource, OutputBuffer*>> graphBuffers;
+		const auto import = [&](OutputBuffer* buffer, const char* name)
+		{
+			const RenderGraphResource resource = graph.Import(name, FromD3D12State(buffer->GetState()));
+			graphResources.push_back(buffer->GetResource());
+			graphBuffers.emplace_back(resource, buffer);
+			return resource;
+		};
+
+		FrameResources resources;
+		resources.accumulation = import(m_accumulationBuffer.get(), "Accumulation");
+		resources.moment = import(m_momentBuffer.get(), "Moment");
+		resources.albedo = import(m_albedoBuffer.get(), "Albedo");
+		resources.normalDepth = import(m_normalDepthBuffer.get(), "Normal Depth");
+		resources.motion = import(m_motionBuffer.get(), "Motion");
+		resources.id = import(m_idBuffer.get(), "ID");
+		resources.denoise[0] = import(m_denoiseBuffers[0].get(), "Denoise 0");
+		resources.denoise[1] = import(m_denoiseBuffers[1].get(), "Denoise 1");
+		resources.output = import(m_outputBuffer.get(), "Output");
+		resources.backBuffer = graph.Import("Back Buffer", FromD3D12State(m_swapChain->GetState()));
+		graphResources.push_back(backBuffer);
+
+		// Read by the next frame's raytracing pass
+		const RenderGraphResource history[] = { resources.accumulation, resources.moment, resources.albedo, resources.normalDepth, resources.motion, resources.id };
+		for (const RenderGraphResource resource : history)
 		{
-			ID3D12DescriptorHeap* heaps[] = { m_descriptorHeap->GetHeap() };
-			commandList->SetDescriptorHeaps(1, heaps);
-			commandList->SetComputeRootSignature(m_rootSignature->Get());
-			commandList->SetPipelineState1(m_rtPipeline->GetPSO());
-
-			m_rootSignature->SetDescriptorTable(commandList.Get(), m_accumulationBuffer->GetUAV().gpuHandle, "accumulationBuffer");
-			m_rootSignature->SetRootSRV(commandList.Get(), m_scene->GetTLASAddress(), "sceneBVH");
-			m_rootSignature->SetRootCBV(commandList.Get(), m_cameraCB->GetGPUAddress(backBufferIndex), "camera");
-			m_rootSignature->SetRootCBV(commandList.Get(), m_renderSettingsCB->GetGPUAddress(backBufferIndex), "renderSettings");
-			m_rootSignature->SetRootCBV(commandList.Get(), m_renderDataCB->GetGPUAddress(backBufferIndex), "renderData");
-			m_rootSignature->SetRootCBV(commandList.Get(), m_postProcessSettingsCB->GetGPUAddress(backBufferIndex), "postProcessSettings");
-			m_rootSignature->SetRootSRV(commandList.Get(), m_scene->GetMaterialsBufferAddress(), "materials");
-
-			auto dispatchDesc = m_rtPipeline->GetDispatchRaysDesc();
-			dispatchDesc.Width = static_cast<UINT>(m_swapChain->GetViewport().Width);
-			dispatchDesc.Height = static_cast<UINT>(m_swapChain->GetViewport().Height);
-			commandList->DispatchRays(&dispatchDesc);
+			graph.SetOutput(resource, ResourceState::UnorderedAccess);
 		}
+		graph.SetOutput(resources.backBuffer, ResourceState::Common);
 
-		// Tonemapping pass
+		// Raytracing pass
+		graph.AddPass("Raytracing")
+			.Write(resources.accumulation).Write(resources.moment).Write(resources.albedo)
+			.Write(resources.normalDepth).Write(resources.motion).Write(resources.id)
+			.Execute([&]()
+			{
+				// Views written since the last frame, and all of them after the heap grew
+				m_descriptorHeap->Commit();
+				ID3D12DescriptorHeap* heaps[] = { m_descriptorHeap->GetHeap() };
+				commandList->SetDescriptorHeaps(1, heaps);
+				commandList->SetComputeRootSignature(m_rootSignature->Get());
+				commandList->SetPipelineState1(m_rtPipeline->GetPSO());
+
+				m_rootSignature->SetDescriptorTable(commandList.Get(), m_accumulationBuffer->GetUAV().GetGPUHandle(), "accumulationBuffer");
+				m_rootSignature->SetDescriptorTable(commandList.Get(), m_momentBuffer->GetUAV().GetGPUHandle(), "momentBuffer");
+				m_rootSignature->SetDescriptorTable(commandList.Get(), m_albedoBuffer->GetUAV().GetGPUHandle(), "albedoBuffer");
+				m_rootSignature->SetDescriptorTable(commandList.Get(), m_normalDepthBuffer->GetUAV().GetGPUHandle(), "normalDepthBuffer");
+				m_rootSignature->SetDescriptorTable(commandList.Get(), m_motionBuffer->GetUAV().GetGPUHandle(), "motionBuffer");
+				m_rootSignature->SetDescriptorTable(commandList.Get(), m_idBuffer->GetUAV().GetGPUHandle(), "idBuffer");
+				m_rootSignature->SetRootSRV(commandList.Get(), m_scene->GetTLASAddress(), "sceneBVH");
+				m_rootSignature->SetRootCBV(commandList.Get(), cameraCB, "camera");
+				m_rootSignature->SetRootCBV(commandList.Get(), renderSettingsCB, "renderSettings");
+				m_rootSignature->SetRootCBV(commandList.Get(), renderDataCB, "renderData");
+				m_rootSignature->SetRootCBV(commandList.Get(), postProcessSettingsCB, "postProcessSettings");
+				m_rootSignature->SetRootCBV(commandList.Get(), previousCameraCB, "previousCamera");
+				m_rootSignature->SetRootSRV(commandList.Get(), m_scene->GetMaterialsBufferAddress(), "materials");
+
+				auto dispatchDesc = m_rtPipeline->GetDispatchRaysDesc();
+				dispatchDesc.Width = static_cast<UINT>(m_swapChain->GetViewport().Width);
+				dispatchDesc.Height = static_cast<UINT>(m_swapChain->GetViewport().Height);
+				commandList->DispatchRays(&dispatchDesc);
+			});
+
+		// Convergence pass, refreshes the mask of pixels adaptive sampling stops tracing
+		if (m_renderSettings.adaptiveSampling &&
+			IsConvergenceUpdate(m_renderData.frame + 1, m_renderSettings.adaptiveMinSamples, m_renderSettings.adaptiveInterval))
 		{
-			m_accumulationBuffer->Transition(commandList.Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-			m_outputBuffer->Transition(commandList.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-
-			PostProcessPass::PostProcessBindings bindings;
-			bindings.inputSRV = m_accumulationBuffer->GetSRV().gpuHandle;
-			bindings.outputUAV = m_outputBuffer->GetUAV().gpuHandle;
-			bindings.constants[0] = m_renderSettingsCB->GetGPUAddress(backBufferIndex);
-			bindings.constants[1] = m_renderDataCB->GetGPUAddress(backBufferIndex);
-			bindings.constants[2] = m_postProcessSettingsCB->GetGPUAddress(backBufferIndex);
-			bindings.constantCount = 3;
-			bindings.width = static_cast<uint32_t>(m_swapChain->GetViewport().Width);
-			bindings.height = static_cast<uint32_t>(m_swapChain->GetViewport().Height);
-
-			m_tonemappingPass->Dispatch(commandList.Get(), bindings);
-
-			m_accumulationBuffer->Transition(commandList.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+			graph.AddPass("Convergence")
+				.Read(resources.accumulation, ResourceState::NonPixelShaderResource)
+				.Write(resources.moment)
+				.Execute([&]()
+				{
+					PostProcessPass::PostProcessBindings bindings;
+					bindings.inputSRV = m_accumulationBuffer->GetSRV().GetGPUHandle();
+					bindings.outputUAV = m_momentBuffer->GetUAV().GetGPUHandle();
+					bindings.constants[0] = renderSettingsCB;
+					bindings.constantCount = 1;
+					bindings.width = static_cast<uint32_t>(m_swapChain->GetViewport().Width);
+					bindings.height = static_cast<uint32_t>(m_swapChain->GetViewport().Height);
+
+					m_convergencePass->Dispatch(commandList.Get(), bindings);
+				});
 		}
-	}
 
-	// End frame
-	{
-		m_outputBuffer->Transition(commandList.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE);
-		m_swapChain->Transition(commandList.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
-		commandList->CopyResource(backBuffer, m_outputBuffer->GetResource());
-
-		// ImGui
+		// Denoise passes, the feature views show the raw accumulation
+		RenderGraphResource radiance = resources.accumulation;
+		if (m_denoiseSettings.enabled && m_postProcessSettings.featureView == FeatureView::Radiance)
 		{
-			m_swapChain->Transition(commandList.Get(), D3D12_RESOURCE_STATE_RENDER_TARGET);
-
-			D3D12_CPU_DESCRIPTOR_HANDLE rtv = m_swapChain->GetCurrentBackBufferRtv().cpuHandle;
-			commandList->OMSetRenderTargets(1, &rtv, FALSE, nullptr);
-
-			ID3D12DescriptorHeap* heaps[] = { m_descriptorHeap->GetHeap() };
-			commandList->SetDescriptorHeaps(1, heaps);
-
-			m_imgui->EndFrame(commandList.Get());
+			radiance = AddDenoisePasses(graph, commandList.Get(), resources);
+		}
+		// The buffers were imported first, so their resources index graphBuffers
+		OutputBuffer* radianceBuffer = graphBuffers[radiance].second;
+
+		// Tonemapping pass, also shows the feature buffers
+		OutputBuffer* features[] = { m_albedoBuffer.get(), m_normalDepthBuffer.get(), m_motionBuffer.get(), m_idBuffer.get() };
+		graph.AddPass("Tonemapping")
+			.Read(radiance, ResourceState::NonPixelShaderResource)
+			.Read(resources.albedo, ResourceState::NonPixelShaderResource)
+			.Read(resources.normalDepth, ResourceState::NonPixelShaderResource)
+			.Read(resources.motion, ResourceState::NonPixelShaderResource)
+			.Read(resources.id, ResourceState::NonPixelShaderResource)
+			.Write(resources.output)
+			.Execute([&]()
+			{
+				PostProcessPass::PostProcessBindings bindings;
+				bindings.inputSRV = radianceBuffer->GetSRV().GetGPUHandle();
+				bindings.outputUAV = m_outputBuffer->GetUAV().GetGPUHandle();
+				for (OutputBuffer* feature : features)
+				{
+					bindings.extraSRVs[bindings.extraSRVCount++] = feature->GetSRV().GetGPUHandle();
+				}
+				bindings.extraSRVs[bindings.extraSRVCount++] = m_backend->GetSRV(m_tonemapLut.Get()).GetGPUHandle();
+				bindings.constants[0] = renderSettingsCB;
+				bindings.constants[1] = renderDataCB;
+				bindings.constants[2] = postProcessSettingsCB;
+				bindings.constantCount = 3;
+				bindings.width = static_cast<uint32_t>(m_swapChain->GetViewport().Width);
+				bindings.height = static_cast<uint32_t>(m_swapChain->GetViewport().Height);
+
+				m_tonemappingPass->Dispatch(commandList.Get(), bindings);
+			});
+
+		graph.AddPass("Copy To Back Buffer")
+			.Read(resources.output, ResourceState::CopySource)
+			.Write(resources.backBuffer, ResourceState::CopyDest)
+			.Execute([&]() { commandList->CopyResource(backBuffer, m_outputBuffer->GetResource()); });
+
+		graph.AddPass("ImGui")
+			.Write(resources.backBuffer, ResourceState::RenderTarget)
+			.Execute([&]()
+			{
+				D3D12_CPU_DESCRIPTOR_HANDLE rtv = m_swapChain->GetCurrentBackBufferRtv().GetCPUHandle();
+				commandList->OMSetRenderTargets(1, &rtv, FALSE, nullptr);
+
+				ID3D12DescriptorHeap* heaps[] = { m_imgui->GetDescriptorHeap() };
+				commandList->SetDescriptorHeaps(1, heaps);
+
+				m_imgui->EndFrame(commandList.Get());
+			});
+
+		[[maybe_unused]] const bool compiled = graph.Compile();
+		assert(compiled && "Invalid render graph");
+		ExecuteRenderGraph(graph, commandList.Get(), graphResources);
+
+		for (const auto& [resource, buffer] : graphBuffers)
+		{
+			buffer->SetState(ToD3D12State(graph.GetFinalState(resource)));
 		}
+		m_swapChain->SetState(ToD3D12State(graph.GetFinalState(resources.backBuffer)));
 
-		m_swapChain->Transition(commandList.Get(), D3D12_RESOURCE_STATE_PRESENT);
+		// The denoise and output buffers don't carry anything into the next frame. Their lifetimes only change with
+		// the passes and their sizes with the resolution, so the plan is only redone then
+		std::vector<std::pair<RenderGraphResource, RenderGraphLifetime>> lifetimes;
+		for (const RenderGraphResource resource : { resources.denoise[0], resources.denoise[1], resources.output })
+		{
+			if (const std::optional<RenderGraphLifetime> lifetime = graph.GetLifetime(resource))
+			{
+				lifetimes.emplace_back(resource, *lifetime);
+			}
+		}
+		if (m_transientPlanDirty || lifetimes != m_transientLifetimes)
+		{
+			std::vector<TransientResource> transients;
+			for (const auto& [resource, lifetime] : lifetimes)
+			{
+				const D3D12_RESOURCE_DESC desc = graphBuffers[resource].second->GetResource()->GetDesc();
+				const D3D12_RESOURCE_ALLOCATION_INFO info = m_device->GetDevice()->GetResourceAllocationInfo(0, 1, &desc);
+				transients.push_back({ info.SizeInBytes, info.Alignment, lifetime.firstPass, lifetime.lastPass });
+			}
+			m_transientPlan = PlanAliasing(transients);
+			m_transientLifetimes = std::move(lifetimes);
+			m_transientPlanDirty = false;
+		}
+	}
 
-		m_fenceValues[backBufferIndex] = m_commandQueue->ExecuteCommandList(commandList);
+	// End frame
+	{
+		m_commandQueue->ExecuteCommandList(commandList);
+		m_fenceValues[backBufferIndex] = m_backend->Submit();
 		m_swapChain->Present();
-		m_commandQueue->WaitForFenceValue(m_fenceValues[m_swapChain->GetCurrentBackBufferIndex()]);
+		m_backend->Wait(m_fenceValues[m_swapChain->GetCurrentBackBufferIndex()]);
 		
 		m_renderData.frame++;
 		if (camData.position != m_prevCamData.position || camData.forward != m_prevCamData.forward)
@@ -1,17 +1,11 @@
 #include "Scene.h"
-#include "Model.h"
-#include "Mesh.h"
-#include "TLAS.h"
-#include "Texture.h"
-#include "CommandQueue.h"
-#include "UploadContext.h"
-#include "GPUAllocator.h"
-#include "StructsDX.h"
 
 #include <stb_image.h>
+#include <chrono>
+#include <iostream>
 
-Scene::Scene(RenderContext& context)
-	: m_context(context)
+Scene::Scene(RenderBackend& backend)
+	: m_backend(backend)
 {
 }
 
@@ -19,7 +13,8 @@ Scene::~Scene() = default;
 
 bool Scene::LoadModel(const std::string& path)
 {
-	std::string extension = path.substr(path.find_last_of('.'));
+	const size_t dot = path.find_last_of('.');
+	const std::string extension = dot == std::string::npos ? "" : path.substr(dot);
 	if (extension != ".gltf" && extension != ".glb")
 	{
 		std::cerr << "Unsupported model format: " << extension << "\nPlease use .gltf or .glb\n";
@@ -28,50 +23,45 @@ bool Scene::LoadModel(const std::string& path)
 
 	std::cout << "Loading model: " << path;
 	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	const BackendStats statsStart = m_backend.GetStats();
 
-	auto commandList = m_context.commandQueue->GetCommandList();
-	m_models.emplace_back(m_context, commandList.Get(), path);
-
-	m_context.uploadContext->Flush();
-
-	m_context.commandQueue->ExecuteCommandList(commandList);
-	m_context.commandQueue->Flush();
-
-	std::vector<D3D12_RAYTRACING_INSTANCE_DESC> instances = {};
-	int instanceId = 0;
-	for (const auto& model : m_models)
+	Model model(m_backend);
+	if (!model.Load(path))
 	{
-		for (const auto& mesh : model.GetMeshes())
-		{
-			instances.emplace_back(mesh.GetInstanceDesc(instanceId++));
-		}
+		std::cout << "\n";
+		return false;
 	}
-	m_tlas = std::make_unique<TLAS>(m_context);
-	m_tlas->Build(m_context.device, instances);
+	m_models.push_back(std::move(model));
+	m_modelPaths.push_back(path);
 
+	BuildTLAS();
 	UploadMaterialData();
+	m_backend.Flush();
 
-	m_context.uploadContext->Flush();
+	auto time = std::chrono::steady_clock::now() - startTime;
+	const BackendStats& statsEnd = m_backend.GetStats();
+	std::cout << "\r";
+	std::cout << "Loaded model: " << path << ". Took " << std::chrono::duration_cast<std::chrono::milliseconds>(time).count() / 1000.0 << " s.\n";
+	std::cout << "[Scene] Uploaded " << (statsEnd.bytesUploaded - statsStart.bytesUploaded) / (1024.0 * 1024.0) << " MiB in "
+		<< statsEnd.uploads - statsStart.uploads << " uploads and built "
+		<< statsEnd.accelerationStructureBuilds - statsStart.accelerationStructureBuilds << " acceleration structures\n";
 
-	commandList = m_context.commandQueue->GetCommandList();
+	return true;
+}
 
-	auto& newModel = m_models.back();
-	for (auto& tex : newModel.GetTextures())
+void Scene::BuildTLAS()
+{
+	// Instance IDs index the hit group records
+	std::vector<ASInstance> instances;
+	uint32_t instanceId = 0;
+	for (const auto& model : m_models)
 	{
-		if (tex.GetResource())
+		for (const auto& mesh : model.GetMeshes())
 		{
-			TransitionResource(commandList.Get(), tex.GetResource(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+			instances.push_back(mesh.GetInstance(instanceId++));
 		}
 	}
-
-	m_context.commandQueue->ExecuteCommandList(commandList);
-	m_context.commandQueue->Flush();
-
-	auto time = std::chrono::steady_clock::now() - startTime;
-	std::cout << "\r";
-	std::cout << "Loaded model: " << path << ". Took " << std::chrono::duration_cast<std::chrono::milliseconds>(time).count() / 1000.0 << " s.\n";
-
-	return true;
+	m_tlas = BackendResource(m_backend, m_backend.BuildTLAS(instances));
 }
 
 void Scene::UploadMaterialData()
@@ -79,44 +69,41 @@ void Scene::UploadMaterialData()
 	std::vector<MaterialData> materials;
 	for (const auto& model : m_models)
 	{
-		for (const auto& texture : model.GetMaterials())
-		{
-			materials.push_back({
-				texture.albedoFactor,
-				texture.albedoIndex,
-				texture.emissiveFactor,
-				texture.emissiveIndex,
-				texture.metallicFactor,
-				texture.roughnessFactor,
-				texture.metallicRoughnessIndex,
-				texture.normalIndex
-			});
-		}
+		materials.insert(materials.end(), model.GetMaterials().begin(), model.GetMaterials().end());
+	}
+	// Meshes without a material use the first one
+	if (materials.empty())
+	{
+		materials.emplace_back();
 	}
 
-	uint64_t size = materials.size() * sizeof(MaterialData);
-	m_materialData = m_context.allocator->CreateBuffer(
-		size, D3D12_RESOURCE_STATE_COMMON,
-		D3D12_RESOURCE_FLAG_NONE, D3D12_HEAP_TYPE_DEFAULT, "Materials");
-	m_context.uploadContext->Upload(m_materialData, materials.data(), size);
+	const uint64_t size = materials.size() * sizeof(MaterialData);
+	m_materialData = BackendResource(m_backend, m_backend.CreateBuffer({ .size = size, .name = "Materials" }));
+	m_backend.Upload(m_materialData.Get(), materials.data(), size);
+}
 
-	if (m_materialSRV.cpuHandle.ptr != 0)
+std::vector<CPUInstance> Scene::GetCPUInstances() const
+{
+	// Same order as the TLAS instance IDs
+	std::vector<CPUInstance> instances;
+	for (const auto& model : m_models)
 	{
-		m_context.descriptorHeap->Free(m_materialSRV);
+		for (const auto& mesh : model.GetMeshes())
+		{
+			instances.push_back({ &mesh.GetCPUGeometry(), mesh.GetTransformMatrix(), mesh.GetName() });
+		}
 	}
-	m_materialSRV = m_context.descriptorHeap->Allocate();
-	D3D12_SHADER_RESOURCE_VIEW_DESC desc{};
-	desc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
-	desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-	desc.Buffer.NumElements = static_cast<UINT>(materials.size());
-	desc.Buffer.StructureByteStride = sizeof(MaterialData);
-	desc.Format = DXGI_FORMAT_UNKNOWN;
-	m_context.device->CreateShaderResourceView(m_materialData.resource, &desc, m_materialSRV.cpuHandle);
+	return instances;
 }
 
-D3D12_GPU_VIRTUAL_ADDRESS Scene::GetTLASAddress() const
+uint64_t Scene::GetTLASAddress() const
 {
-	return m_tlas->GetResource().resource->GetGPUVirtualAddress();
+	return m_tlas ? m_backend.GetGPUAddress(m_tlas.Get()) : 0;
+}
+
+uint64_t Scene::GetMaterialsBufferAddress() const
+{
+	return m_materialData ? m_backend.GetGPUAddress(m_materialData.Get()) : 0;
 }
 
 std::vector<HitGroupRecord> Scene::GetHitGroupRecords() const
@@ -128,8 +115,8 @@ std::vector<HitGroupRecord> Scene::GetHitGroupRecords() const
 		for (const auto& mesh : model.GetMeshes())
 		{
 			HitGroupRecord rec{};
-			rec.vertexBuffer = mesh.GetVertexBuffer()->GetGPUVirtualAddress();
-			rec.indexBuffer = mesh.GetIndexBuffer()->GetGPUVirtualAddress();
+			rec.vertexBuffer = m_backend.GetGPUAddress(mesh.GetVertexBuffer());
+			rec.indexBuffer = m_backend.GetGPUAddress(mesh.GetIndexBuffer());
 			rec.materialIndex = mesh.m_materialIndex >= 0
 				? materialOffset + static_cast<uint32_t>(mesh.m_materialIndex)
 				: 0;
@@ -140,34 +127,43 @@ std::vector<HitGroupRecord> Scene::GetHitGroupRecords() const
 	return records;
 }
 
-void Scene::LoadHDRI(const std::string& path)
+bool Scene::LoadHDRI(const std::string& path)
 {
-	std::string extension = path.substr(path.find_last_of('.'));
+	const size_t dot = path.find_last_of('.');
+	const std::string extension = dot == std::string::npos ? "" : path.substr(dot);
 	if (extension != ".hdr")
 	{
 		std::cerr << "Unsupported HDRI format: " << extension << "\nPlease use .hdr\n";
-		return;
+		return false;
 	}
-	
-	m_hdri = std::make_unique<Texture>();
 
 	std::cout << "Loading HDRI: " << path << "\r";
 	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
 	int width, height, nrChannels;
 	float* data = stbi_loadf(path.c_str(), &width, &height, &nrChannels, 4);
-	if (data)
-	{
-		m_hdri->Create(m_context, data, width, height, DXGI_FORMAT_R32G32B32A32_FLOAT, path);
-	}
-	else
+	if (!data)
 	{
-		ThrowError("Failed to load HDRI: " + path);
+		std::cerr << "Failed to load HDRI: " << path << "\n";
+		return false;
 	}
+
+	TextureDesc desc;
+	desc.width = static_cast<uint32_t>(width);
+	desc.height = static_cast<uint32_t>(height);
+	desc.format = ResourceFormat::RGBA32F;
+	desc.name = path.c_str();
+	m_hdri = BackendResource(m_backend, m_backend.CreateTexture(desc));
+	m_backend.UploadTexture(m_hdri.Get(), data);
+	stbi_image_free(data);
+	m_backend.Flush();
+	m_hdriPath = path;
+
 	auto time = std::chrono::steady_clock::now() - startTime;
 	std::cout << "Loaded HDRI: " << path << ". Took " << std::chrono::duration_cast<std::chrono::milliseconds>(time).count() / 1000.0 << " s.\n";
+	return true;
 }
 
 int32_t Scene::GetHDRIDescriptorIndex() const
 {
-	return m_hdri ? m_hdri->GetDescriptorIndex() : -1;
-}
\ No newline at end of file
+	return m_hdri ? m_backend.GetDescriptorIndex(m_hdri.Get()) : -1;
+}
@@ -4,55 +4,96 @@
 
 #include <iostream>
 
-Shader::Shader(ShaderCompiler& compiler, std::string filePath, const std::vector<std::string>& entryPoints, const bool isRaytracing)
-	: m_compiler(compiler), m_filePath(std::move(filePath)), m_entryPoints(entryPoints), m_isRaytracing(isRaytracing)
+Shader::Shader(ShaderCompiler& compiler, std::string filePath, const std::vector<std::string>& entryPoints, const bool isRaytracing,
+               std::vector<ShaderDefine> defines, const bool compileNow)
+	: m_compiler(compiler), m_filePath(std::move(filePath)), m_entryPoints(entryPoints), m_defines(std::move(defines)), m_isRaytracing(isRaytracing)
 {
-    if (std::filesystem::exists(m_filePath))
+    if (compileNow)
     {
-        m_lastWriteTime = std::filesystem::file_time_type::clock::now();
+        Reload();
     }
-
-    Reload();
 }
 
 Shader::~Shader() = default;
 
 bool Shader::NeedsReload() const
 {
-    try
+    const ShaderWatcher* watcher = m_compiler.GetWatcher();
+    return watcher && watcher->HasChanged(m_dependencies, m_compileSequence);
+}
+
+bool Shader::Reload()
+{
+    const ShaderWatcher* watcher = m_compiler.GetWatcher();
+    m_compileSequence = watcher ? watcher->GetSequence() : 0;
+    return Apply(m_compiler.Compile(m_filePath, m_entryPoints, m_isRaytracing, m_defines));
+}
+
+void Shader::StartReload(PrepareFn prepare)
+{
+    if (IsReloading())
+    {
+        return;
+    }
+
+    const ShaderWatcher* watcher = m_compiler.GetWatcher();
+    m_compileSequence = watcher ? watcher->GetSequence() : 0;
+    m_pending = std::async(std::launch::async, [this, prepare = std::move(prepare)]
     {
-        for (const auto& entry : std::filesystem::recursive_directory_iterator("shaders/")) {
-            if (entry.is_regular_file() && entry.last_write_time() > m_lastWriteTime) {
-                auto ext = entry.path().extension();
-                if (ext == ".slang" )
-                {
-					return true;
-                }
+        ShaderCompiler::CompilationResult result = m_compiler.Compile(m_filePath, m_entryPoints, m_isRaytracing, m_defines);
+        if (result.success && prepare)
+        {
+            try
+            {
+                prepare({ result.blob.data(), result.blob.size() });
+            }
+            catch (const std::exception& e)
+            {
+                result.success = false;
+                result.errorLog = std::string("Failed to create the pipeline: ") + e.what();
             }
         }
-        return false;
+        return result;
+    });
+}
+
+void Shader::WaitForReload() const
+{
+    if (IsReloading())
+    {
+        m_pending.wait();
     }
-    catch (const std::filesystem::filesystem_error&)
+}
+
+Shader::ReloadState Shader::PollReload()
+{
+    if (!IsReloading())
     {
-        return false;
+        return ReloadState::Idle;
+    }
+    if (m_pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+        return ReloadState::Compiling;
     }
+    return Apply(m_pending.get()) ? ReloadState::Reloaded : ReloadState::Failed;
 }
 
-bool Shader::Reload()
+bool Shader::Apply(ShaderCompiler::CompilationResult result)
 {
-    auto result = m_compiler.Compile(m_filePath, m_entryPoints, m_isRaytracing);
+    if (!result.dependencies.empty())
+    {
+        m_dependencies = std::move(result.dependencies);
+    }
 
     if (!result.success)
     {
         std::cerr << "Failed to compile shader: " << m_filePath << "\n" << result.errorLog << "\n";
-        m_lastWriteTime = std::filesystem::file_time_type::clock::now();
 		m_lastCompileError = result.errorLog;
 		m_lastCompileFailed = true;
         return false;
     }
 
     m_blob = std::move(result.blob);
-    m_lastWriteTime = std::filesystem::file_time_type::clock::now();
 	m_lastCompileFailed = false;
     return true;
 }
@@ -0,0 +1,181 @@
+#include "ShaderCache.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+
+namespace
+{
+    constexpr char CACHE_MAGIC[4] = { 'K', 'S', 'C', '1' };
+
+    template<typename T>
+    void WriteValue(std::ofstream& file, const T& value)
+    {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template<typename T>
+    void ReadValue(std::ifstream& file, T& value)
+    {
+        file.read(reinterpret_cast<char*>(&value), sizeof(T));
+    }
+}
+
+ShaderCache::ShaderCache(std::string directory, std::string extension)
+    : m_directory(std::move(directory)), m_extension(std::move(extension))
+{
+}
+
+uint64_t ShaderCache::Hash(const void* data, const size_t size, uint64_t seed)
+{
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+        seed ^= bytes[i];
+        seed *= 1099511628211ull;
+    }
+    return seed;
+}
+
+uint64_t ShaderCache::HashFile(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return 0;
+    }
+    const std::vector<char> contents{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+    return Hash(contents.data(), contents.size());
+}
+
+std::string ShaderCache::GetEntryPath(const uint64_t key) const
+{
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << key << m_extension;
+    return (std::filesystem::path(m_directory) / name.str()).string();
+}
+
+bool ShaderCache::Load(const uint64_t key, std::vector<uint8_t>& blob, std::vector<ShaderDependency>& dependencies, std::string& reason) const
+{
+    std::ifstream file(GetEntryPath(key), std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        reason = "not cached";
+        return false;
+    }
+
+    // Sizes read from the entry are checked against what's left of it, a corrupt one never allocates more than that
+    const std::streamoff fileSize = file.tellg();
+    file.seekg(0);
+    const auto fits = [&](const uint64_t size)
+    {
+        const std::streamoff position = file.tellg();
+        return position >= 0 && size <= static_cast<uint64_t>(fileSize - position);
+    };
+
+    char magic[sizeof(CACHE_MAGIC)] = {};
+    file.read(magic, sizeof(magic));
+    uint32_t dependencyCount = 0;
+    ReadValue(file, dependencyCount);
+    if (!file || !std::equal(std::begin(magic), std::end(magic), std::begin(CACHE_MAGIC)))
+    {
+        reason = "unreadable entry";
+        return false;
+    }
+
+    std::vector<ShaderDependency> read;
+    for (uint32_t i = 0; i < dependencyCount; i++)
+    {
+        uint32_t length = 0;
+        ReadValue(file, length);
+        if (!file || !fits(length))
+        {
+            reason = "unreadable entry";
+            return false;
+        }
+        ShaderDependency dependency;
+        dependency.path.resize(length);
+        file.read(dependency.path.data(), length);
+        ReadValue(file, dependency.hash);
+        if (!file)
+        {
+            reason = "unreadable entry";
+            return false;
+        }
+        read.push_back(std::move(dependency));
+    }
+    for (const ShaderDependency& dependency : read)
+    {
+        if (HashFile(dependency.path) != dependency.hash)
+        {
+            reason = dependency.path + " changed";
+            dependencies = std::move(read);
+            return false;
+        }
+    }
+
+    uint64_t size = 0;
+    ReadValue(file, size);
+    if (!file || size == 0 || !fits(size))
+    {
+        reason = "unreadable entry";
+        return false;
+    }
+    std::vector<uint8_t> cached(size);
+    file.read(reinterpret_cast<char*>(cached.data()), static_cast<std::streamsize>(size));
+    if (!file)
+    {
+        reason = "unreadable entry";
+        return false;
+    }
+
+    blob = std::move(cached);
+    dependencies = std::move(read);
+    return true;
+}
+
+void ShaderCache::Store(const uint64_t key, const std::vector<ShaderDependency>& dependencies, const std::vector<uint8_t>& blob) const
+{
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+
+    // Written next to the entry and renamed over it, so a reader never sees half of one
+    const std::string path = GetEntryPath(key);
+    const std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary);
+        if (!file)
+        {
+            std::cerr << "[ShaderCache] Failed to open " << temporaryPath << " for writing\n";
+            return;
+        }
+
+        file.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        WriteValue(file, static_cast<uint32_t>(dependencies.size()));
+        for (const ShaderDependency& dependency : dependencies)
+        {
+            WriteValue(file, static_cast<uint32_t>(dependency.path.size()));
+            file.write(dependency.path.data(), static_cast<std::streamsize>(dependency.path.size()));
+            WriteValue(file, dependency.hash);
+        }
+        WriteValue(file, static_cast<uint64_t>(blob.size()));
+        file.write(reinterpret_cast<const char*>(blob.data()), static_cast<std::streamsize>(blob.size()));
+
+        if (!file)
+        {
+            std::cerr << "[ShaderCache] Failed to write " << temporaryPath << "\n";
+            return;
+        }
+    }
+
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error)
+    {
+        std::cerr << "[ShaderCache] Failed to store " << path << ": " << error.message() << "\n";
+        std::filesystem::remove(temporaryPath, error);
+    }
+}
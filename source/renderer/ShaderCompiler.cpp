@@ -5,9 +5,188 @@
 #include <fstream>
 #include <stdexcept>
 #include <iostream>
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iterator>
+#include <regex>
 
-ShaderCompiler::ShaderCompiler()
+namespace
+{
+    constexpr const char* PROFILE = "sm_6_6";
+
+    bool IsSameGuid(const SlangUUID& a, const SlangUUID& b)
+    {
+        return memcmp(&a, &b, sizeof(SlangUUID)) == 0;
+    }
+
+    // Gives Slang the files it asks for and hashes exactly the contents it got. Hashing after the compile would
+    // pair a file saved during a background compile with a blob built from its old contents
+    class HashingFileSystem final : public ISlangFileSystem
+    {
+    public:
+        explicit HashingFileSystem(std::unordered_map<std::string, uint64_t>& hashes) : m_hashes(hashes) {}
+
+        SLANG_NO_THROW SlangResult SLANG_MCALL queryInterface(const SlangUUID& uuid, void** outObject) override
+        {
+            *outObject = castAs(uuid);
+            if (!*outObject)
+            {
+                return SLANG_E_NO_INTERFACE;
+            }
+            addRef();
+            return SLANG_OK;
+        }
+
+        SLANG_NO_THROW uint32_t SLANG_MCALL addRef() override { return ++m_refCount; }
+
+        SLANG_NO_THROW uint32_t SLANG_MCALL release() override
+        {
+            const uint32_t refCount = --m_refCount;
+            if (refCount == 0)
+            {
+                delete this;
+            }
+            return refCount;
+        }
+
+        SLANG_NO_THROW void* SLANG_MCALL castAs(const SlangUUID& guid) override
+        {
+            if (IsSameGuid(guid, ISlangUnknown::getTypeGuid()) || IsSameGuid(guid, ISlangCastable::getTypeGuid()) ||
+                IsSameGuid(guid, ISlangFileSystem::getTypeGuid()))
+            {
+                return static_cast<ISlangFileSystem*>(this);
+            }
+            return nullptr;
+        }
+
+        SLANG_NO_THROW SlangResult SLANG_MCALL loadFile(const char* path, ISlangBlob** outBlob) override
+        {
+            std::ifstream file(path, std::ios::binary);
+            if (!file)
+            {
+                return SLANG_E_NOT_FOUND;
+            }
+            const std::vector<char> contents{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+
+            // The first read is what the session's modules were checked from
+            m_hashes.try_emplace(ShaderWatcher::Normalize(path), ShaderCache::Hash(contents.data(), contents.size()));
+            *outBlob = slang_createBlob(contents.data(), contents.size());
+            return *outBlob ? SLANG_OK : SLANG_FAIL;
+        }
+
+    private:
+        std::unordered_map<std::string, uint64_t>& m_hashes;
+        std::atomic<uint32_t> m_refCount = 0;
+    };
+
+    // Files a module was checked from, its imports first in the order the session loaded them, then the module itself and
+    // anything else it read. Loading the imports in that order before the module reproduces the session it was checked in
+    std::vector<std::string> GetModuleFiles(slang::ISession* session, slang::IModule* module)
+    {
+        std::vector<std::string> read;
+        for (SlangInt32 i = 0; i < module->getDependencyFileCount(); i++)
+        {
+            const std::string path = ShaderWatcher::Normalize(module->getDependencyFilePath(i));
+            if (std::find(read.begin(), read.end(), path) == read.end())
+            {
+                read.push_back(path);
+            }
+        }
+
+        std::vector<std::string> files;
+        auto take = [&](const std::string& path)
+        {
+            auto it = std::find(read.begin(), read.end(), path);
+            if (it == read.end()) return false;
+            read.erase(it);
+            files.push_back(path);
+            return true;
+        };
+        for (SlangInt i = 0; i < session->getLoadedModuleCount(); i++)
+        {
+            slang::IModule* loaded = session->getLoadedModule(i);
+            if (loaded != module && loaded->getFilePath())
+            {
+                take(ShaderWatcher::Normalize(loaded->getFilePath()));
+            }
+        }
+        const std::string self = ShaderWatcher::Normalize(module->getFilePath());
+        if (!take(self))
+        {
+            files.push_back(self);
+        }
+        files.insert(files.end(), read.begin(), read.end());
+        return files;
+    }
+
+    slang::IModule* FindLoadedModule(slang::ISession* session, const std::string& path)
+    {
+        for (SlangInt i = 0; i < session->getLoadedModuleCount(); i++)
+        {
+            slang::IModule* loaded = session->getLoadedModule(i);
+            if (loaded->getFilePath() && ShaderWatcher::Normalize(loaded->getFilePath()) == path)
+            {
+                return loaded;
+            }
+        }
+        return nullptr;
+    }
+
+    // Files of the modules a shader imports, resolved like Slang does: next to the importing file, then in the search
+    // directory, with `a.b` naming a/b.slang. Imports that don't resolve are left for Slang to report
+    std::vector<std::string> FindImports(const std::string& path, const std::string& directory)
+    {
+        static const std::regex importPattern(R"re(^\s*(?:__exported\s+)?import\s+(?:"([^"]+)"|([A-Za-z_][\w.\-]*))\s*;)re");
+
+        std::vector<std::string> imports;
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line))
+        {
+            std::smatch match;
+            if (!std::regex_search(line, match, importPattern))
+            {
+                continue;
+            }
+
+            std::vector<std::string> names;
+            if (match[1].matched)
+            {
+                names.push_back(match[1].str());
+            }
+            else
+            {
+                std::string name = match[2].str();
+                std::replace(name.begin(), name.end(), '.', '/');
+                names.push_back(name + ".slang");
+                std::replace(name.begin(), name.end(), '_', '-');
+                names.push_back(name + ".slang");
+            }
+
+            for (const auto& root : { std::filesystem::path(path).parent_path(), std::filesystem::path(directory) })
+            {
+                const auto found = std::find_if(names.begin(), names.end(), [&](const std::string& name)
+                {
+                    std::error_code error;
+                    return std::filesystem::is_regular_file(root / name, error);
+                });
+                if (found != names.end())
+                {
+                    imports.push_back(ShaderWatcher::Normalize((root / *found).string()));
+                    break;
+                }
+            }
+        }
+        return imports;
+    }
+}
+
+ShaderCompiler::ShaderCompiler(std::string cacheDirectory)
+    : m_cache(std::move(cacheDirectory)),
+      m_moduleCache(m_cache.GetDirectory().empty() ? "" : (std::filesystem::path(m_cache.GetDirectory()) / "modules").string(), ".slang-module")
 {
     slang::createGlobalSession(m_globalSession.writeRef());
     if (!m_globalSession)
@@ -18,6 +197,11 @@ ShaderCompiler::ShaderCompiler()
 
 ShaderCompiler::~ShaderCompiler() = default;
 
+void ShaderCompiler::WatchForChanges(const std::string& directory)
+{
+    m_watcher = std::make_unique<ShaderWatcher>(directory);
+}
+
 void ShaderCompiler::diagnoseIfNeeded(slang::IBlob* diagnosticsBlob, CompilationResult& result)
 {
     if (diagnosticsBlob != nullptr)
@@ -27,20 +211,37 @@ void ShaderCompiler::diagnoseIfNeeded(slang::IBlob* diagnosticsBlob, Compilation
     }
 }
 
-ShaderCompiler::CompilationResult ShaderCompiler::Compile(const std::string& filePath, const std::vector<std::string>& entryPoints, bool isRaytracing) const
+ShaderCompiler::CachedSession& ShaderCompiler::GetSession(const std::string& directory, const bool wholeProgram,
+                                                         const std::vector<ShaderDefine>& defines) const
 {
-    CompilationResult result;
-
-    std::vector<std::string> epNames = entryPoints.empty()
-        ? std::vector<std::string>{"RayGen", "ClosestHit", "Miss"}
-		: entryPoints;
-
-    bool wholeProgram = isRaytracing;
+    std::string sessionKey = directory + (wholeProgram ? "|whole program" : "|entry points");
+    for (const auto& define : defines)
+    {
+        sessionKey += "|" + define.name + "=" + define.value;
+    }
+    std::unordered_set<std::string> changed;
+    auto it = m_sessions.find(sessionKey);
+    if (it != m_sessions.end())
+    {
+        for (const auto& [path, hash] : it->second.files)
+        {
+            if (ShaderCache::HashFile(path) != hash)
+            {
+                changed.insert(path);
+            }
+        }
+        if (changed.empty())
+        {
+            return it->second;
+        }
+    }
+    // Extracting keeps the old session where its file system expects it until the unaffected modules are moved over
+    auto previous = it != m_sessions.end() ? m_sessions.extract(it) : decltype(m_sessions)::node_type{};
 
     slang::SessionDesc sessionDesc{};
     slang::TargetDesc targetDesc{};
     targetDesc.format = SLANG_DXIL;
-    targetDesc.profile = m_globalSession->findProfile("sm_6_6");
+    targetDesc.profile = m_globalSession->findProfile(PROFILE);
 
     std::array<slang::CompilerOptionEntry, 1> options = { {{
         slang::CompilerOptionName::GenerateWholeProgram,
@@ -53,19 +254,325 @@ ShaderCompiler::CompilationResult ShaderCompiler::Compile(const std::string& fil
     sessionDesc.targets = &targetDesc;
     sessionDesc.targetCount = 1;
 
-    std::string directory = std::filesystem::path(filePath).parent_path().string();
     const char* searchPaths[] = { directory.c_str() };
     sessionDesc.searchPaths = searchPaths;
     sessionDesc.searchPathCount = 1;
 
-    Slang::ComPtr<slang::ISession> session;
-    m_globalSession->createSession(sessionDesc, session.writeRef());
+    std::vector<slang::PreprocessorMacroDesc> macros;
+    for (const auto& define : defines)
+    {
+        macros.push_back({ define.name.c_str(), define.value.c_str() });
+    }
+    sessionDesc.preprocessorMacros = macros.data();
+    sessionDesc.preprocessorMacroCount = static_cast<SlangInt>(macros.size());
+
+    // Sessions are nodes of the map, the file system can keep a reference to the hashes
+    CachedSession& cached = m_sessions[sessionKey];
+    cached.key = sessionKey;
+    cached.fileSystem = new HashingFileSystem(cached.files);
+    sessionDesc.fileSystem = cached.fileSystem.get();
+    m_globalSession->createSession(sessionDesc, cached.session.writeRef());
+    if (!previous.empty())
+    {
+        CarryOverModules(previous.mapped(), cached, changed);
+    }
+    return cached;
+}
+
+void ShaderCompiler::CarryOverModules(const CachedSession& previous, CachedSession& cached, const std::unordered_set<std::string>& changed)
+{
+    // Load order puts imports first, a module depending on a dropped one read the changed file too
+    const SlangInt loadedModules = previous.session->getLoadedModuleCount();
+    for (SlangInt i = 0; i < loadedModules; i++)
+    {
+        slang::IModule* module = previous.session->getLoadedModule(i);
+        if (!module->getFilePath())
+        {
+            continue;
+        }
+
+        std::vector<std::string> files;
+        for (SlangInt32 j = 0; j < module->getDependencyFileCount(); j++)
+        {
+            files.push_back(ShaderWatcher::Normalize(module->getDependencyFilePath(j)));
+        }
+        if (std::any_of(files.begin(), files.end(), [&](const std::string& file) { return changed.contains(file); }))
+        {
+            continue;
+        }
+
+        Slang::ComPtr<slang::IBlob> serialized;
+        if (SLANG_FAILED(module->serialize(serialized.writeRef())) || !serialized)
+        {
+            continue;
+        }
+        Slang::ComPtr<slang::IBlob> diagnostics;
+        if (!cached.session->loadModuleFromIRBlob(module->getName(), module->getFilePath(), serialized.get(), diagnostics.writeRef()))
+        {
+            continue;
+        }
+
+        // Still checked from the contents the previous session read
+        const std::string path = ShaderWatcher::Normalize(module->getFilePath());
+        cached.precompiled.insert(path);
+        for (const std::string& file : files)
+        {
+            if (const auto hash = previous.files.find(file); hash != previous.files.end())
+            {
+                cached.files.try_emplace(file, hash->second);
+            }
+        }
+    }
+
+    std::string changedFiles;
+    for (const std::string& file : changed)
+    {
+        changedFiles += (changedFiles.empty() ? "" : ", ") + std::filesystem::path(file).filename().string();
+    }
+    std::cout << "[ShaderCompiler] " << changedFiles << " changed, kept " << cached.session->getLoadedModuleCount() << " of "
+        << loadedModules << " loaded modules\n";
+}
+
+std::vector<ShaderDependency> ShaderCompiler::GetDependencies(const CachedSession& cached, const std::vector<std::string>& files)
+{
+    std::vector<ShaderDependency> dependencies;
+    for (const std::string& file : files)
+    {
+        const auto it = cached.files.find(ShaderWatcher::Normalize(file));
+        dependencies.push_back({ file, it != cached.files.end() ? it->second : 0 });
+    }
+    return dependencies;
+}
+
+uint64_t ShaderCompiler::GetModuleKey(const CachedSession& cached, const std::string& filePath) const
+{
+    uint64_t key = ShaderCache::Hash(m_globalSession->getBuildTagString());
+    key = ShaderCache::Hash(cached.key, key);
+    return ShaderCache::Hash(ShaderWatcher::Normalize(filePath), key);
+}
+
+slang::IModule* ShaderCompiler::LoadPrecompiledModule(CachedSession& cached, const std::string& filePath) const
+{
+    const std::string path = ShaderWatcher::Normalize(filePath);
+    slang::ISession* session = cached.session.get();
+    if (slang::IModule* loaded = FindLoadedModule(session, path))
+    {
+        return loaded;
+    }
+
+    // Checks the hashes of the module's file and of everything it imports
+    std::vector<uint8_t> data;
+    std::vector<ShaderDependency> files;
+    std::string reason;
+    const bool valid = m_moduleCache.Load(GetModuleKey(cached, path), data, files, reason);
+
+    // A stale module still lists its imports, the ones that didn't change are loaded so only this one is compiled
+    bool importsLoaded = true;
+    for (const ShaderDependency& file : files)
+    {
+        if (file.path == path) break;
+        importsLoaded = LoadPrecompiledModule(cached, file.path) && importsLoaded;
+    }
+    if (!valid || !importsLoaded)
+    {
+        return nullptr;
+    }
+
+    Slang::ComPtr<slang::IBlob> blob;
+    blob.attach(slang_createBlob(data.data(), data.size()));
+    if (!blob || !session->isBinaryModuleUpToDate(path.c_str(), blob.get()))
+    {
+        return nullptr;
+    }
 
     Slang::ComPtr<slang::IBlob> diagnostics;
+    const std::string name = std::filesystem::path(path).stem().string();
+    slang::IModule* module = session->loadModuleFromIRBlob(name.c_str(), path.c_str(), blob.get(), diagnostics.writeRef());
+    if (!module)
+    {
+        std::cerr << "[ShaderCompiler] Failed to load precompiled " << name << ", compiling it from source\n";
+        if (diagnostics) std::cerr << static_cast<const char*>(diagnostics->getBufferPointer()) << "\n";
+        return nullptr;
+    }
+    cached.precompiled.insert(path);
 
-    slang::IModule* module = session->loadModule(filePath.c_str(), diagnostics.writeRef());
-    diagnoseIfNeeded(diagnostics.get(), result);
-    if (!module) { return result; }
+    // Load just checked these hashes against the files, unless Slang read them itself since
+    for (const ShaderDependency& file : files)
+    {
+        cached.files.try_emplace(ShaderWatcher::Normalize(file.path), file.hash);
+    }
+    return module;
+}
+
+slang::IModule* ShaderCompiler::LoadModule(CachedSession& cached, const std::string& directory, const std::string& filePath,
+                                           std::vector<ModuleTiming>& timings, std::unordered_set<std::string>& loading,
+                                           CompilationResult& result) const
+{
+    const std::string path = ShaderWatcher::Normalize(filePath);
+    slang::ISession* session = cached.session.get();
+    if (slang::IModule* loaded = FindLoadedModule(session, path))
+    {
+        return loaded;
+    }
+
+    loading.insert(path);
+    for (const std::string& import : FindImports(path, directory))
+    {
+        // A cyclic import is Slang's to report
+        if (!loading.contains(import) && !LoadModule(cached, directory, import, timings, loading, result))
+        {
+            return nullptr;
+        }
+    }
+
+    // Imports are loaded, the time is only this module's
+    const auto start = std::chrono::high_resolution_clock::now();
+    const size_t precompiledBefore = cached.precompiled.size();
+    slang::IModule* module = !m_moduleCache.GetDirectory().empty() ? LoadPrecompiledModule(cached, path) : nullptr;
+    if (!module)
+    {
+        Slang::ComPtr<slang::IBlob> diagnostics;
+        module = session->loadModule(path.c_str(), diagnostics.writeRef());
+        diagnoseIfNeeded(diagnostics.get(), result);
+    }
+    if (module)
+    {
+        const auto end = std::chrono::high_resolution_clock::now();
+        timings.push_back({ module->getName(), std::chrono::duration<float, std::milli>(end - start).count(),
+                            cached.precompiled.size() > precompiledBefore });
+    }
+    return module;
+}
+
+void ShaderCompiler::StorePrecompiledModules(CachedSession& cached, const SlangInt firstModule) const
+{
+    slang::ISession* session = cached.session.get();
+    for (SlangInt i = firstModule; i < session->getLoadedModuleCount(); i++)
+    {
+        slang::IModule* module = session->getLoadedModule(i);
+        if (!module->getFilePath() || cached.precompiled.contains(ShaderWatcher::Normalize(module->getFilePath())))
+        {
+            continue;
+        }
+
+        Slang::ComPtr<slang::IBlob> serialized;
+        if (SLANG_FAILED(module->serialize(serialized.writeRef())) || !serialized)
+        {
+            continue;
+        }
+        const auto* bytes = static_cast<const uint8_t*>(serialized->getBufferPointer());
+        const std::vector<uint8_t> data(bytes, bytes + serialized->getBufferSize());
+        m_moduleCache.Store(GetModuleKey(cached, module->getFilePath()), GetDependencies(cached, GetModuleFiles(session, module)), data);
+    }
+}
+
+uint64_t ShaderCompiler::GetCacheKey(const std::string& filePath, const std::vector<std::string>& entryPoints, const bool wholeProgram,
+                                     const std::vector<ShaderDefine>& defines) const
+{
+    // Everything that selects the compilation, a new Slang build invalidates the whole cache
+    uint64_t key = ShaderCache::Hash(m_globalSession->getBuildTagString());
+    std::error_code error;
+    key = ShaderCache::Hash(std::filesystem::absolute(filePath, error).lexically_normal().string(), key);
+    for (const auto& name : entryPoints)
+    {
+        key = ShaderCache::Hash(name.c_str(), name.size() + 1, key);
+    }
+    for (const auto& define : defines)
+    {
+        key = ShaderCache::Hash(define.name.c_str(), define.name.size() + 1, key);
+        key = ShaderCache::Hash(define.value.c_str(), define.value.size() + 1, key);
+    }
+    key = ShaderCache::Hash(PROFILE, key);
+    const uint32_t target[] = { static_cast<uint32_t>(SLANG_DXIL), wholeProgram ? 1u : 0u };
+    return ShaderCache::Hash(target, sizeof(target), key);
+}
+
+ShaderCompiler::CompilationResult ShaderCompiler::Compile(const std::string& filePath, const std::vector<std::string>& entryPoints, bool isRaytracing,
+                                                         const std::vector<ShaderDefine>& defines) const
+{
+    std::lock_guard lock(m_mutex);
+    CompilationResult result;
+
+    std::vector<std::string> epNames = entryPoints.empty()
+        ? std::vector<std::string>{"RayGen", "ClosestHit", "Miss"}
+		: entryPoints;
+
+    bool wholeProgram = isRaytracing;
+
+    const std::string shaderName = std::filesystem::path(filePath).filename().string();
+    const bool useCache = !m_cache.GetDirectory().empty();
+    const uint64_t cacheKey = useCache ? GetCacheKey(filePath, epNames, wholeProgram, defines) : 0;
+    if (useCache)
+    {
+        std::string reason;
+        std::vector<ShaderDependency> dependencies;
+        if (m_cache.Load(cacheKey, result.blob, dependencies, reason))
+        {
+            for (const ShaderDependency& dependency : dependencies)
+            {
+                result.dependencies.push_back(ShaderWatcher::Normalize(dependency.path));
+            }
+            std::cout << "[ShaderCache] Hit " << shaderName << "\n";
+            result.success = true;
+            return result;
+        }
+        std::cout << "[ShaderCache] Miss " << shaderName << ", " << reason << "\n";
+    }
+    const auto compileStart = std::chrono::high_resolution_clock::now();
+
+    const std::string directory = std::filesystem::path(filePath).parent_path().string();
+    CachedSession& cached = GetSession(directory, wholeProgram, defines);
+    slang::ISession* session = cached.session.get();
+    const SlangInt reusedModules = session->getLoadedModuleCount();
+
+    Slang::ComPtr<slang::IBlob> diagnostics;
+
+    // Unchanged modules, the shader's own included, skip parsing and checking. Whatever is left is compiled from source
+    std::vector<ModuleTiming> timings;
+    std::unordered_set<std::string> loading;
+    slang::IModule* module = LoadModule(cached, directory, filePath, timings, loading, result);
+    if (!module)
+    {
+        std::error_code error;
+        for (auto it = std::filesystem::recursive_directory_iterator(directory, error);
+             it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+        {
+            if (it->path().extension() == ".slang")
+            {
+                result.dependencies.push_back(ShaderWatcher::Normalize(it->path().string()));
+            }
+        }
+        return result;
+    }
+
+    // The module reports every file it read, imports included
+    std::vector<std::string> dependencies = { filePath };
+    for (SlangInt32 i = 0; i < module->getDependencyFileCount(); i++)
+    {
+        const std::string dependency = module->getDependencyFilePath(i);
+        if (std::find(dependencies.begin(), dependencies.end(), dependency) == dependencies.end())
+        {
+            dependencies.push_back(dependency);
+        }
+    }
+    for (const auto& dependency : dependencies)
+    {
+        result.dependencies.push_back(ShaderWatcher::Normalize(dependency));
+    }
+
+    // Modules loaded for this shader in load order, the rest came from the session
+    const auto loadEnd = std::chrono::high_resolution_clock::now();
+    std::cout << "[ShaderCompiler] " << shaderName << ": loaded " << timings.size() << " modules in "
+        << std::chrono::duration<float, std::milli>(loadEnd - compileStart).count() << " ms, reused " << reusedModules << "\n";
+    for (const ModuleTiming& timing : timings)
+    {
+        std::cout << "[ShaderCompiler]     " << timing.name << ": " << timing.milliseconds << " ms"
+            << (timing.precompiled ? " (precompiled)" : "") << "\n";
+    }
+    if (!m_moduleCache.GetDirectory().empty())
+    {
+        StorePrecompiledModules(cached, reusedModules);
+    }
 
     std::vector<slang::IComponentType*> components;
     components.push_back(module);
@@ -110,5 +617,15 @@ ShaderCompiler::CompilationResult ShaderCompiler::Compile(const std::string& fil
     result.blob.resize(code->getBufferSize());
     memcpy(result.blob.data(), code->getBufferPointer(), code->getBufferSize());
     result.success = true;
+
+    const auto codegenEnd = std::chrono::high_resolution_clock::now();
+    std::cout << "[ShaderCompiler] " << shaderName << ": linked and generated code in "
+        << std::chrono::duration<float, std::milli>(codegenEnd - loadEnd).count() << " ms, "
+        << std::chrono::duration<float, std::milli>(codegenEnd - compileStart).count() << " ms total\n";
+
+    if (useCache)
+    {
+        m_cache.Store(cacheKey, GetDependencies(cached, dependencies), result.blob);
+    }
     return result;
 }
\ No newline at end of file
@@ -0,0 +1,284 @@
+#include "ShaderWatcher.h"
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <poll.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+#endif
+
+namespace
+{
+    constexpr auto POLL_INTERVAL = std::chrono::milliseconds(500);
+
+    bool IsShaderFile(const std::filesystem::path& path)
+    {
+        return path.extension() == ".slang";
+    }
+}
+
+ShaderWatcher::ShaderWatcher(std::string directory)
+    : m_directory(Normalize(directory))
+{
+#ifdef _WIN32
+    m_stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+#else
+    if (pipe(m_stopPipe) != 0)
+    {
+        m_stopPipe[0] = m_stopPipe[1] = -1;
+    }
+#endif
+    m_thread = std::thread(&ShaderWatcher::Run, this);
+}
+
+ShaderWatcher::~ShaderWatcher()
+{
+    m_stop = true;
+#ifdef _WIN32
+    SetEvent(m_stopEvent);
+#else
+    if (m_stopPipe[1] >= 0)
+    {
+        const char wake = 0;
+        [[maybe_unused]] const ssize_t written = write(m_stopPipe[1], &wake, 1);
+    }
+#endif
+    m_thread.join();
+#ifdef _WIN32
+    CloseHandle(m_stopEvent);
+#else
+    for (int fd : m_stopPipe)
+    {
+        if (fd >= 0) close(fd);
+    }
+#endif
+}
+
+std::string ShaderWatcher::Normalize(const std::string& path)
+{
+    std::error_code error;
+    const std::filesystem::path absolute = std::filesystem::absolute(path, error);
+    return (error ? std::filesystem::path(path) : absolute).lexically_normal().string();
+}
+
+uint64_t ShaderWatcher::GetSequence() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_sequence;
+}
+
+bool ShaderWatcher::HasChanged(const std::vector<std::string>& files, const uint64_t sinceSequence) const
+{
+    std::lock_guard lock(m_mutex);
+    if (m_overflowSequence > sinceSequence)
+    {
+        return true;
+    }
+    for (const std::string& file : files)
+    {
+        auto it = m_changes.find(file);
+        if (it != m_changes.end() && it->second > sinceSequence)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ShaderWatcher::RecordChange(const std::string& path)
+{
+    std::lock_guard lock(m_mutex);
+    m_changes[Normalize(path)] = ++m_sequence;
+}
+
+void ShaderWatcher::RecordOverflow()
+{
+    std::lock_guard lock(m_mutex);
+    m_overflowSequence = ++m_sequence;
+}
+
+void ShaderWatcher::Run()
+{
+    if (!RunEvents() && !m_stop)
+    {
+        std::cout << "[ShaderWatcher] No change notifications for " << m_directory << ", polling instead\n";
+        RunPolling();
+    }
+}
+
+#ifdef _WIN32
+bool ShaderWatcher::RunEvents()
+{
+    const std::wstring directory = std::filesystem::path(m_directory).wstring();
+    HANDLE handle = CreateFileW(directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    if (handle == INVALID_HANDLE_VALUE || !m_stopEvent)
+    {
+        return false;
+    }
+
+    OVERLAPPED overlapped{};
+    overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    alignas(DWORD) uint8_t buffer[16 * 1024];
+    constexpr DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME;
+
+    bool watching = true;
+    while (!m_stop)
+    {
+        ResetEvent(overlapped.hEvent);
+        if (!ReadDirectoryChangesW(handle, buffer, sizeof(buffer), TRUE, filter, nullptr, &overlapped, nullptr))
+        {
+            watching = false;
+            break;
+        }
+
+        HANDLE events[] = { overlapped.hEvent, m_stopEvent };
+        if (WaitForMultipleObjects(2, events, FALSE, INFINITE) != WAIT_OBJECT_0)
+        {
+            CancelIo(handle);
+            GetOverlappedResult(handle, &overlapped, nullptr, TRUE);
+            break;
+        }
+
+        DWORD bytes = 0;
+        if (!GetOverlappedResult(handle, &overlapped, &bytes, FALSE))
+        {
+            watching = false;
+            break;
+        }
+        if (bytes == 0)
+        {
+            RecordOverflow();
+            continue;
+        }
+
+        for (auto* info = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(buffer);;
+             info = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(reinterpret_cast<uint8_t*>(info) + info->NextEntryOffset))
+        {
+            const std::filesystem::path path = std::filesystem::path(directory) /
+                std::wstring(info->FileName, info->FileNameLength / sizeof(WCHAR));
+            if (IsShaderFile(path))
+            {
+                RecordChange(path.string());
+            }
+            if (info->NextEntryOffset == 0) break;
+        }
+    }
+
+    CloseHandle(overlapped.hEvent);
+    CloseHandle(handle);
+    return watching || m_stop;
+}
+#elif defined(__linux__)
+bool ShaderWatcher::RunEvents()
+{
+    const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0 || m_stopPipe[0] < 0)
+    {
+        if (fd >= 0) close(fd);
+        return false;
+    }
+
+    // inotify isn't recursive, every directory gets its own watch
+    constexpr uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE | IN_CREATE;
+    std::unordered_map<int, std::filesystem::path> directories;
+    auto addWatch = [&](const std::filesystem::path& directory)
+    {
+        const int wd = inotify_add_watch(fd, directory.c_str(), mask);
+        if (wd >= 0) directories[wd] = directory;
+        return wd >= 0;
+    };
+
+    bool watching = addWatch(m_directory);
+    std::error_code error;
+    for (auto it = std::filesystem::recursive_directory_iterator(m_directory, error);
+         watching && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+    {
+        if (it->is_directory()) addWatch(it->path());
+    }
+
+    alignas(inotify_event) char buffer[16 * 1024];
+    while (watching && !m_stop)
+    {
+        pollfd fds[] = { { fd, POLLIN, 0 }, { m_stopPipe[0], POLLIN, 0 } };
+        if (poll(fds, 2, -1) < 0 || (fds[1].revents & POLLIN))
+        {
+            break;
+        }
+
+        ssize_t length;
+        while ((length = read(fd, buffer, sizeof(buffer))) > 0)
+        {
+            for (char* p = buffer; p < buffer + length;)
+            {
+                const auto* event = reinterpret_cast<const inotify_event*>(p);
+                p += sizeof(inotify_event) + event->len;
+
+                if (event->mask & IN_Q_OVERFLOW)
+                {
+                    RecordOverflow();
+                    continue;
+                }
+                auto directory = directories.find(event->wd);
+                if (directory == directories.end() || event->len == 0) continue;
+
+                const std::filesystem::path path = directory->second / event->name;
+                if ((event->mask & IN_CREATE) && (event->mask & IN_ISDIR))
+                {
+                    addWatch(path);
+                }
+                else if (IsShaderFile(path))
+                {
+                    RecordChange(path.string());
+                }
+            }
+        }
+    }
+
+    close(fd);
+    return watching || m_stop;
+}
+#else
+bool ShaderWatcher::RunEvents()
+{
+    return false;
+}
+#endif
+
+void ShaderWatcher::RunPolling()
+{
+    std::unordered_map<std::string, std::filesystem::file_time_type> writeTimes;
+    bool first = true;
+    while (!m_stop)
+    {
+        std::error_code error;
+        for (auto it = std::filesystem::recursive_directory_iterator(m_directory, error);
+             it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+        {
+            if (!it->is_regular_file() || !IsShaderFile(it->path())) continue;
+
+            const std::string path = it->path().string();
+            const auto writeTime = it->last_write_time(error);
+            auto [entry, inserted] = writeTimes.try_emplace(path, writeTime);
+            if ((inserted && !first) || entry->second != writeTime)
+            {
+                entry->second = writeTime;
+                RecordChange(path);
+            }
+        }
+        first = false;
+
+        // Sleeps in steps so the destructor doesn't wait out a whole interval
+        for (auto waited = std::chrono::milliseconds(0); waited < POLL_INTERVAL && !m_stop; waited += std::chrono::milliseconds(50))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#include "StagingRing.h"
+
+#include <cassert>
+
+namespace
+{
+    uint64_t AlignUp(const uint64_t value, const uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+StagingRing::StagingRing(const uint64_t capacity)
+    : m_capacity(capacity)
+{
+    assert(capacity > 0 && "Staging ring needs a capacity");
+}
+
+std::optional<uint64_t> StagingRing::Allocate(const uint64_t size, const uint64_t alignment)
+{
+    assert(m_capacity % alignment == 0 && "Alignment has to divide the capacity");
+    if (!Fits(size, alignment))
+    {
+        return std::nullopt;
+    }
+
+    uint64_t start = AlignUp(m_head, alignment);
+    if (start % m_capacity + size > m_capacity)
+    {
+        // Doesn't fit before the end, continue at the start of the ring
+        start = AlignUp(start, m_capacity);
+    }
+    if (start + size - m_tail > m_capacity)
+    {
+        return std::nullopt;
+    }
+
+    m_head = start + size;
+    return start % m_capacity;
+}
+
+void StagingRing::Close(const uint64_t fenceValue)
+{
+    if (!HasOpenAllocations())
+    {
+        return;
+    }
+    assert((m_batches.empty() || m_batches.back().fenceValue <= fenceValue) && "Fence values have to increase");
+    m_batches.push({ fenceValue, m_head });
+    m_closed = m_head;
+}
+
+void StagingRing::Reclaim(const uint64_t completedFenceValue)
+{
+    while (!m_batches.empty() && m_batches.front().fenceValue <= completedFenceValue)
+    {
+        m_tail = m_batches.front().end;
+        m_batches.pop();
+    }
+    if (m_batches.empty() && !HasOpenAllocations())
+    {
+        // Idle, so the next allocations don't have to wrap around
+        m_head = m_closed = m_tail = AlignUp(m_head, m_capacity);
+    }
+}
+
+bool StagingRing::Fits(const uint64_t size, const uint64_t alignment) const
+{
+    return AlignUp(size, alignment) <= m_capacity;
+}
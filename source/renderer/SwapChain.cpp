@@ -172,7 +172,7 @@ void SwapChain::CreateBackBuffers(ID3D12Device* device)
 	{
 		ThrowIfFailed(m_swapChain->GetBuffer(i, IID_PPV_ARGS(&m_backBuffers[i])));
 		m_backBufferRtvs[i] = m_rtvHeap->Allocate();
-		device->CreateRenderTargetView(m_backBuffers[i].Get(), &rtvDesc, m_backBufferRtvs[i].cpuHandle);
+		device->CreateRenderTargetView(m_backBuffers[i].Get(), &rtvDesc, m_backBufferRtvs[i].GetWriteHandle());
 		m_backBuffers[i]->SetName(L"Back buffer");
 	}
 }
@@ -3,10 +3,23 @@
 #include "CommandQueue.h"
 #include "CommonDX.h"
 
-UploadContext::UploadContext(GPUAllocator& allocator, ID3D12Device10* device)
-    : m_allocator(allocator)
+#include <algorithm>
+#include <cassert>
+
+UploadContext::UploadContext(GPUAllocator& allocator, ID3D12Device10* device, const uint64_t ringSize)
+    : m_allocator(allocator), m_device(device), m_ringAllocator(ringSize)
 {
     m_queue = std::make_unique<CommandQueue>(device, "UploadContext", D3D12_COMMAND_LIST_TYPE_COPY);
+
+    m_ring = m_allocator.CreateBuffer(
+        ringSize, D3D12_RESOURCE_STATE_GENERIC_READ,
+        D3D12_RESOURCE_FLAG_NONE, D3D12_HEAP_TYPE_UPLOAD, "Upload Staging Ring");
+
+    // Stays mapped, the CPU only writes to it
+    D3D12_RANGE readRange{ 0, 0 };
+    void* mapped = nullptr;
+    ThrowIfFailed(m_ring.resource->Map(0, &readRange, &mapped));
+    m_ringMapped = static_cast<uint8_t*>(mapped);
 }
 
 UploadContext::~UploadContext()
@@ -16,32 +29,28 @@ UploadContext::~UploadContext()
 
 void UploadContext::Upload(const GPUBuffer& dest, const void* data, const uint64_t size)
 {
-    GPUBuffer staging = m_allocator.CreateBuffer(
-        size, D3D12_RESOURCE_STATE_GENERIC_READ,
-        D3D12_RESOURCE_FLAG_NONE, D3D12_HEAP_TYPE_UPLOAD, "Upload Staging Buffer");
-
-    void* mapped = nullptr;
-    D3D12_RANGE readRange{ 0, 0 };
-    ThrowIfFailed(staging.resource->Map(0, &readRange, &mapped));
-    memcpy(mapped, data, size);
-    staging.resource->Unmap(0, nullptr);
+    if (size == 0)
+        return;
 
-    auto cmdList = m_queue->GetCommandList();
-    cmdList->CopyBufferRegion(dest.resource, 0, staging.resource, 0, size);
-    m_queue->ExecuteCommandList(cmdList);
+    const Staging staging = Stage(size, D3D12_RAW_UAV_SRV_BYTE_ALIGNMENT);
+    memcpy(staging.mapped, data, size);
+    GetCommandList()->CopyBufferRegion(dest.resource, 0, staging.resource, staging.offset, size);
 
-    m_staged.push_back(std::move(staging));
+    m_stats.uploads++;
+    m_stats.bytesStaged += size;
 }
 
-void UploadContext::UploadTexture(const GPUBuffer& dest, const void* data, const uint32_t width, const uint32_t height, const DXGI_FORMAT format)
+void UploadContext::UploadTexture(const GPUBuffer& dest, const void* data, const uint32_t width, const uint32_t height, const uint32_t depth,
+                                  const DXGI_FORMAT format)
 {
-    auto commandList = m_queue->GetCommandList();
-
-    const UINT64 uploadSize = GetRequiredIntermediateSize(dest.resource, 0, 1);
-
-    GPUBuffer staging =
-        m_allocator.CreateBuffer(uploadSize, D3D12_RESOURCE_STATE_GENERIC_READ, 
-        D3D12_RESOURCE_FLAG_NONE, D3D12_HEAP_TYPE_UPLOAD, "Texture Upload Staging Buffer");
+    const D3D12_RESOURCE_DESC desc = dest.resource->GetDesc();
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint{};
+    UINT rowCount = 0;
+    UINT64 rowSize = 0;
+    UINT64 uploadSize = 0;
+    m_device->GetCopyableFootprints(&desc, 0, 1, 0, &footprint, &rowCount, &rowSize, &uploadSize);
+    assert(footprint.Footprint.Width == width && footprint.Footprint.Height == height && footprint.Footprint.Depth == depth
+        && "Texel data doesn't match the texture's size");
 
     UINT bytesPerPixel = 4;
     switch (format)
@@ -57,24 +66,115 @@ void UploadContext::UploadTexture(const GPUBuffer& dest, const void* data, const
         break;
     }
 
+    // Rows in the staging memory are padded to D3D12_TEXTURE_DATA_PITCH_ALIGNMENT, the source is tightly packed
+    const Staging staging = Stage(uploadSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+    const uint64_t sourceRowPitch = static_cast<uint64_t>(width) * bytesPerPixel;
+    const uint64_t sourceSlicePitch = sourceRowPitch * height;
+    const uint64_t stagingSlicePitch = static_cast<uint64_t>(footprint.Footprint.RowPitch) * rowCount;
+    const uint64_t copySize = std::min<uint64_t>(rowSize, sourceRowPitch);
+    const auto* source = static_cast<const uint8_t*>(data);
+    for (UINT slice = 0; slice < depth; slice++)
+    {
+        for (UINT row = 0; row < rowCount; row++)
+        {
+            memcpy(staging.mapped + slice * stagingSlicePitch + row * footprint.Footprint.RowPitch,
+                   source + slice * sourceSlicePitch + row * sourceRowPitch, copySize);
+        }
+    }
 
-    D3D12_SUBRESOURCE_DATA subresourceData{};
-    subresourceData.pData = data;
-    subresourceData.RowPitch = static_cast<LONG_PTR>(width) * bytesPerPixel;
-    subresourceData.SlicePitch = subresourceData.RowPitch * height;
-
-    UpdateSubresources(commandList.Get(), dest.resource, staging.resource, 0, 0, 1, &subresourceData);
+    footprint.Offset = staging.offset;
+    const CD3DX12_TEXTURE_COPY_LOCATION destLocation(dest.resource, 0);
+    const CD3DX12_TEXTURE_COPY_LOCATION sourceLocation(staging.resource, footprint);
+    GetCommandList()->CopyTextureRegion(&destLocation, 0, 0, 0, &sourceLocation, nullptr);
 
-    m_queue->ExecuteCommandList(commandList);
-    m_staged.push_back(std::move(staging));
+    m_stats.uploads++;
+    m_stats.bytesStaged += uploadSize;
 }
 
+uint64_t UploadContext::Submit()
+{
+    if (!m_commandList)
+        return m_lastFence;
+
+    m_lastFence = m_queue->ExecuteCommandList(m_commandList);
+    m_commandList.Reset();
+    m_stats.submissions++;
+
+    m_ringAllocator.Close(m_lastFence);
+    for (GPUBuffer& buffer : m_dedicated)
+    {
+        m_submittedDedicated.emplace(m_lastFence, std::move(buffer));
+    }
+    m_dedicated.clear();
+
+    return m_lastFence;
+}
 
 void UploadContext::Flush()
 {
-    if (m_staged.empty())
-        return;
+    Submit();
+    m_queue->WaitForFenceValue(m_lastFence);
+    ReclaimCompleted();
+}
+
+UploadContext::Staging UploadContext::Stage(const uint64_t size, const uint64_t alignment)
+{
+    ReclaimCompleted();
+
+    if (!m_ringAllocator.Fits(size, alignment))
+    {
+        GPUBuffer buffer = m_allocator.CreateBuffer(
+            size, D3D12_RESOURCE_STATE_GENERIC_READ,
+            D3D12_RESOURCE_FLAG_NONE, D3D12_HEAP_TYPE_UPLOAD, "Upload Staging Buffer");
+
+        // Released without unmapping once the copy completed
+        D3D12_RANGE readRange{ 0, 0 };
+        void* mapped = nullptr;
+        ThrowIfFailed(buffer.resource->Map(0, &readRange, &mapped));
+
+        const Staging staging{ buffer.resource, 0, static_cast<uint8_t*>(mapped) };
+        m_dedicated.push_back(std::move(buffer));
+        m_stats.dedicatedBuffers++;
+        return staging;
+    }
+
+    std::optional<uint64_t> offset = m_ringAllocator.Allocate(size, alignment);
+    if (!offset)
+    {
+        // Full, the open batch may hold most of the ring so it goes first
+        Submit();
+        while (!(offset = m_ringAllocator.Allocate(size, alignment)))
+        {
+            const uint64_t oldestFence = m_ringAllocator.GetOldestFence();
+            if (!m_queue->IsFenceComplete(oldestFence))
+            {
+                m_stats.ringWaits++;
+                m_queue->WaitForFenceValue(oldestFence);
+            }
+            m_ringAllocator.Reclaim(oldestFence);
+        }
+    }
+
+    return { m_ring.resource, *offset, m_ringMapped + *offset };
+}
 
-    m_queue->Flush();
-    m_staged.clear();
+ID3D12GraphicsCommandList4* UploadContext::GetCommandList()
+{
+    if (!m_commandList)
+    {
+        m_commandList = m_queue->GetCommandList();
+    }
+    return m_commandList.Get();
+}
+
+void UploadContext::ReclaimCompleted()
+{
+    while (m_ringAllocator.GetOldestFence() != 0 && m_queue->IsFenceComplete(m_ringAllocator.GetOldestFence()))
+    {
+        m_ringAllocator.Reclaim(m_ringAllocator.GetOldestFence());
+    }
+    while (!m_submittedDedicated.empty() && m_queue->IsFenceComplete(m_submittedDedicated.front().first))
+    {
+        m_submittedDedicated.pop();
+    }
 }
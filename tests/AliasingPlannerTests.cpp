@@ -0,0 +1,162 @@
+#include "Check.h"
+#include "AliasingPlanner.h"
+#include "RenderGraph.h"
+
+#include <vector>
+
+namespace
+{
+	// A transient with the lifetime the graph gave the resource
+	TransientResource FromGraph(const RenderGraph& graph, const RenderGraphResource resource, const uint64_t size, const uint64_t alignment = 1)
+	{
+		const RenderGraphLifetime lifetime = graph.GetLifetime(resource).value_or(RenderGraphLifetime{ 0, 0 });
+		return { size, alignment, lifetime.firstPass, lifetime.lastPass };
+	}
+
+	void TestChain()
+	{
+		// Each pass reads what the previous one wrote, so only neighbouring resources are live at the same time
+		RenderGraph graph;
+		const RenderGraphResource output = graph.Import("Output", ResourceState::UnorderedAccess);
+		const RenderGraphResource a = graph.Create("A");
+		const RenderGraphResource b = graph.Create("B");
+		const RenderGraphResource c = graph.Create("C");
+		graph.SetOutput(output, ResourceState::UnorderedAccess);
+		graph.AddPass("Write A").Write(a);
+		graph.AddPass("A To B").Read(a, ResourceState::NonPixelShaderResource).Write(b);
+		graph.AddPass("B To C").Read(b, ResourceState::NonPixelShaderResource).Write(c);
+		graph.AddPass("Resolve").Read(c, ResourceState::NonPixelShaderResource).Write(output);
+		CHECK(graph.Compile());
+
+		const std::vector<TransientResource> transients = { FromGraph(graph, a, 100), FromGraph(graph, b, 100), FromGraph(graph, c, 100) };
+		CHECK_EQ(transients[0].lastPass, 1u);
+		CHECK_EQ(transients[2].firstPass, 2u);
+
+		const AliasingPlan plan = PlanAliasing(transients);
+		CHECK_EQ(plan.offsets.size(), 3u);
+		CHECK_EQ(plan.offsets[0], 0u);
+		CHECK_EQ(plan.offsets[1], 100u);
+		CHECK_EQ(plan.offsets[2], 0u);
+		CHECK_EQ(plan.heapSizes.size(), 1u);
+		CHECK_EQ(plan.size, 200u);
+		CHECK_EQ(plan.naiveSize, 300u);
+		CHECK_EQ(plan.peakLiveSize, 200u);
+	}
+
+	void TestCulledResource()
+	{
+		RenderGraph graph;
+		const RenderGraphResource output = graph.Import("Output", ResourceState::UnorderedAccess);
+		const RenderGraphResource used = graph.Create("Used");
+		const RenderGraphResource unused = graph.Create("Unused");
+		graph.SetOutput(output, ResourceState::UnorderedAccess);
+		graph.AddPass("Write Used").Write(used);
+		graph.AddPass("Write Unused").Write(unused);
+		graph.AddPass("Resolve").Read(used, ResourceState::NonPixelShaderResource).Write(output);
+		CHECK(graph.Compile());
+
+		// Culled passes don't count, so the resolve is the second pass
+		CHECK(!graph.GetLifetime(unused).has_value());
+		const TransientResource transient = FromGraph(graph, used, 64);
+		CHECK_EQ(transient.firstPass, 0u);
+		CHECK_EQ(transient.lastPass, 1u);
+
+		const AliasingPlan plan = PlanAliasing(std::span(&transient, 1));
+		CHECK_EQ(plan.size, 64u);
+		CHECK_EQ(plan.peakLiveSize, 64u);
+	}
+
+	void TestLowestGap()
+	{
+		// The first two are placed one after the other, the last one fits below the second
+		const std::vector<TransientResource> transients = {
+			{ .size = 100, .firstPass = 0, .lastPass = 0 },
+			{ .size = 100, .firstPass = 0, .lastPass = 3 },
+			{ .size = 50, .firstPass = 1, .lastPass = 2 },
+		};
+		const AliasingPlan plan = PlanAliasing(transients);
+		CHECK_EQ(plan.offsets[0], 0u);
+		CHECK_EQ(plan.offsets[1], 100u);
+		CHECK_EQ(plan.offsets[2], 0u);
+		CHECK_EQ(plan.size, 200u);
+		CHECK_EQ(plan.naiveSize, 250u);
+		CHECK_EQ(plan.peakLiveSize, 200u);
+	}
+
+	void TestLargestFirst()
+	{
+		const std::vector<TransientResource> transients = {
+			{ .size = 10, .firstPass = 0, .lastPass = 1 },
+			{ .size = 1000, .firstPass = 1, .lastPass = 2 },
+		};
+		const AliasingPlan plan = PlanAliasing(transients);
+		CHECK_EQ(plan.offsets[1], 0u);
+		CHECK_EQ(plan.offsets[0], 1000u);
+		CHECK_EQ(plan.size, 1010u);
+	}
+
+	void TestAlignment()
+	{
+		const std::vector<TransientResource> transients = {
+			{ .size = 100, .alignment = 1, .firstPass = 0, .lastPass = 1 },
+			{ .size = 10, .alignment = 64, .firstPass = 1, .lastPass = 1 },
+		};
+		const AliasingPlan plan = PlanAliasing(transients);
+		CHECK_EQ(plan.offsets[0], 0u);
+		CHECK_EQ(plan.offsets[1], 128u);
+		CHECK_EQ(plan.size, 138u);
+
+		// The last one fits in the 100 free bytes between the other two live ones, but not at a multiple of 128
+		const std::vector<TransientResource> gap = {
+			{ .size = 200, .alignment = 1, .firstPass = 0, .lastPass = 0 },
+			{ .size = 100, .alignment = 1, .firstPass = 0, .lastPass = 2 },
+			{ .size = 100, .alignment = 1, .firstPass = 1, .lastPass = 2 },
+			{ .size = 100, .alignment = 128, .firstPass = 2, .lastPass = 2 },
+		};
+		const AliasingPlan gapPlan = PlanAliasing(gap);
+		CHECK_EQ(gapPlan.offsets[1], 200u);
+		CHECK_EQ(gapPlan.offsets[2], 0u);
+		CHECK_EQ(gapPlan.offsets[3], 384u);
+		CHECK_EQ(gapPlan.size, 484u);
+	}
+
+	void TestHeapTypes()
+	{
+		const std::vector<TransientResource> transients = {
+			{ .size = 100, .firstPass = 0, .lastPass = 1, .heapType = 0 },
+			{ .size = 50, .firstPass = 0, .lastPass = 1, .heapType = 1 },
+			{ .size = 30, .firstPass = 2, .lastPass = 2, .heapType = 1 },
+		};
+		const AliasingPlan plan = PlanAliasing(transients);
+		CHECK_EQ(plan.heapSizes.size(), 2u);
+		CHECK_EQ(plan.offsets[0], 0u);
+		CHECK_EQ(plan.offsets[1], 0u);
+		CHECK_EQ(plan.offsets[2], 0u);
+		CHECK_EQ(plan.heapSizes[0], 100u);
+		CHECK_EQ(plan.heapSizes[1], 50u);
+		CHECK_EQ(plan.size, 150u);
+		CHECK_EQ(plan.peakLiveSize, 150u);
+	}
+
+	void TestEmpty()
+	{
+		const AliasingPlan plan = PlanAliasing({});
+		CHECK(plan.offsets.empty());
+		CHECK(plan.heapSizes.empty());
+		CHECK_EQ(plan.size, 0u);
+		CHECK_EQ(plan.naiveSize, 0u);
+		CHECK_EQ(plan.peakLiveSize, 0u);
+	}
+}
+
+int main()
+{
+	RUN_TEST(TestChain);
+	RUN_TEST(TestCulledResource);
+	RUN_TEST(TestLowestGap);
+	RUN_TEST(TestLargestFirst);
+	RUN_TEST(TestAlignment);
+	RUN_TEST(TestHeapTypes);
+	RUN_TEST(TestEmpty);
+	return TEST_RESULT();
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <iostream>
+
+// Checks for the tests in this directory. A failed check is reported and counted, the test keeps going so one run
+// shows every failure
+
+namespace Check
+{
+	inline int failures = 0;
+}
+
+#define CHECK(condition) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed\n"; \
+			Check::failures++; \
+		} \
+	} while (false)
+
+#define CHECK_EQ(actual, expected) \
+	do \
+	{ \
+		const auto& checkActual = (actual); \
+		const auto& checkExpected = (expected); \
+		if (!(checkActual == checkExpected)) \
+		{ \
+			std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK_EQ(" #actual ", " #expected ") failed, " \
+				<< checkActual << " != " << checkExpected << "\n"; \
+			Check::failures++; \
+		} \
+	} while (false)
+
+#define RUN_TEST(test) \
+	do \
+	{ \
+		const int checkBefore = Check::failures; \
+		test(); \
+		std::cout << (Check::failures == checkBefore ? "[PASS] " : "[FAIL] ") << #test << "\n"; \
+	} while (false)
+
+#define TEST_RESULT() (Check::failures == 0 ? 0 : 1)
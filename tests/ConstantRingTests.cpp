@@ -0,0 +1,130 @@
+#include "Check.h"
+#include "ConstantRing.h"
+#include "NullBackend.h"
+
+#include <cstring>
+
+namespace
+{
+	// Handles are slots in creation order, the ring's first buffer is the first one a new backend creates
+	constexpr ResourceHandle FIRST_BUFFER{ 1 };
+	constexpr ResourceHandle SECOND_BUFFER{ 2 };
+
+	struct Block
+	{
+		uint32_t values[4];
+	};
+
+	bool Contains(const NullBackend& backend, const ResourceHandle buffer, const uint64_t offset, const Block& block)
+	{
+		const std::vector<uint8_t>& contents = backend.GetContents(buffer);
+		return offset + sizeof(Block) <= contents.size() && memcmp(contents.data() + offset, &block, sizeof(Block)) == 0;
+	}
+
+	void TestPush()
+	{
+		NullBackend backend;
+		ConstantRing ring(backend, "Constants", 2, 1024);
+		const uint64_t base = backend.GetGPUAddress(FIRST_BUFFER);
+
+		ring.BeginFrame(0);
+		const Block first = { { 1, 2, 3, 4 } };
+		CHECK_EQ(ring.Push(first), base);
+		// Padded to the constant buffer alignment
+		const uint8_t large[300] = {};
+		CHECK_EQ(ring.Push(large, sizeof(large)), base + 256);
+		const Block second = { { 5, 6, 7, 8 } };
+		CHECK_EQ(ring.Push(second), base + 768);
+		CHECK_EQ(ring.GetUsed(), 1024u);
+
+		CHECK(Contains(backend, FIRST_BUFFER, 0, first));
+		CHECK(Contains(backend, FIRST_BUFFER, 768, second));
+		CHECK_EQ(backend.GetStats().buffersCreated, 1u);
+	}
+
+	void TestWrapAround()
+	{
+		NullBackend backend;
+		ConstantRing ring(backend, "Constants", 2, 512);
+		const uint64_t base = backend.GetGPUAddress(FIRST_BUFFER);
+
+		ring.BeginFrame(0);
+		CHECK_EQ(ring.Push(Block{ { 1 } }), base);
+		CHECK_EQ(ring.Push(Block{ { 2 } }), base + 256);
+		ring.BeginFrame(1);
+		CHECK_EQ(ring.Push(Block{ { 3 } }), base + 512);
+		CHECK_EQ(ring.GetUsed(), 256u);
+
+		// The first frame's slice is started over, the second frame's constants stay
+		ring.BeginFrame(0);
+		CHECK_EQ(ring.GetUsed(), 0u);
+		const Block again = { { 4 } };
+		CHECK_EQ(ring.Push(again), base);
+		CHECK(Contains(backend, FIRST_BUFFER, 0, again));
+		CHECK(Contains(backend, FIRST_BUFFER, 512, Block{ { 3 } }));
+		CHECK_EQ(ring.GetPeakUsed(), 512u);
+		CHECK_EQ(ring.GetGrowCount(), 0u);
+	}
+
+	void TestOverflowGrows()
+	{
+		NullBackend backend;
+		ConstantRing ring(backend, "Constants", 2, 512);
+
+		ring.BeginFrame(1);
+		const Block first = { { 1 } };
+		static_cast<void>(ring.Push(first));
+		static_cast<void>(ring.Push(Block{ { 2 } }));
+		CHECK_EQ(ring.GetGrowCount(), 0u);
+
+		// Doesn't fit the slice anymore, continues at the start of the frame's slice in a larger buffer
+		const Block third = { { 3 } };
+		const uint64_t address = ring.Push(third);
+		CHECK_EQ(ring.GetGrowCount(), 1u);
+		CHECK_EQ(ring.GetFrameCapacity(), 1024u);
+		CHECK_EQ(address, backend.GetGPUAddress(SECOND_BUFFER) + 1024);
+		CHECK_EQ(backend.GetContents(SECOND_BUFFER).size(), 2048u);
+		CHECK(Contains(backend, SECOND_BUFFER, 1024, third));
+		CHECK_EQ(ring.GetUsed(), 768u);
+		CHECK_EQ(ring.GetPeakUsed(), 768u);
+
+		// What was pushed before is still there for the frame's work
+		CHECK_EQ(backend.GetStats().resourcesAlive, 2u);
+		CHECK(Contains(backend, FIRST_BUFFER, 512, first));
+
+		// Released once the next frame begins, after the frame was submitted
+		backend.Submit();
+		ring.BeginFrame(0);
+		CHECK_EQ(backend.GetStats().resourcesAlive, 1u);
+		CHECK_EQ(ring.Push(Block{}), backend.GetGPUAddress(SECOND_BUFFER));
+	}
+
+	void TestOversizePush()
+	{
+		NullBackend backend;
+		ConstantRing ring(backend, "Constants", 1, 256);
+
+		ring.BeginFrame(0);
+		// Larger than twice the capacity, grows until it fits
+		const uint8_t large[3000] = { 7 };
+		static_cast<void>(ring.Push(large, sizeof(large)));
+		CHECK_EQ(ring.GetGrowCount(), 1u);
+		CHECK_EQ(ring.GetFrameCapacity(), 4096u);
+		CHECK_EQ(ring.GetUsed(), 3072u);
+		CHECK_EQ(backend.GetContents(SECOND_BUFFER)[0], 7u);
+
+		// Fits from now on
+		ring.BeginFrame(0);
+		static_cast<void>(ring.Push(large, sizeof(large)));
+		CHECK_EQ(ring.GetGrowCount(), 1u);
+	}
+}
+
+int main()
+{
+	RUN_TEST(TestPush);
+	RUN_TEST(TestWrapAround);
+	RUN_TEST(TestOverflowGrows);
+	RUN_TEST(TestOversizePush);
+	return TEST_RESULT();
+}
@@ -0,0 +1,174 @@
+#include "Check.h"
+#include "IndexAllocator.h"
+
+namespace
+{
+	IndexRange AllocateOrEmpty(IndexAllocator& allocator, const uint32_t count)
+	{
+		return allocator.Allocate(count).value_or(IndexRange{});
+	}
+
+	void TestBestFit()
+	{
+		IndexAllocator allocator(100);
+		AllocateOrEmpty(allocator, 10);
+		const IndexRange twenty = AllocateOrEmpty(allocator, 20);
+		AllocateOrEmpty(allocator, 5);
+		const IndexRange thirty = AllocateOrEmpty(allocator, 30);
+		AllocateOrEmpty(allocator, 10);
+		CHECK_EQ(twenty.index, 10u);
+		CHECK_EQ(thirty.index, 35u);
+
+		// Free holes of 20 at 10, 30 at 35 and 25 at the end at 75
+		allocator.Free(twenty);
+		allocator.Free(thirty);
+		CHECK_EQ(AllocateOrEmpty(allocator, 18).index, 10u);
+		CHECK_EQ(AllocateOrEmpty(allocator, 22).index, 75u);
+		CHECK_EQ(AllocateOrEmpty(allocator, 26).index, 35u);
+		CHECK(!allocator.Allocate(5).has_value());
+		CHECK_EQ(AllocateOrEmpty(allocator, 4).index, 61u);
+	}
+
+	void TestBestFitLowestIndex()
+	{
+		IndexAllocator allocator(40);
+		IndexRange ranges[4];
+		for (IndexRange& range : ranges)
+		{
+			range = AllocateOrEmpty(allocator, 10);
+		}
+		allocator.Free(ranges[2]);
+		allocator.Free(ranges[0]);
+
+		// Both holes fit exactly, the lower one is used first
+		CHECK_EQ(AllocateOrEmpty(allocator, 10).index, 0u);
+		CHECK_EQ(AllocateOrEmpty(allocator, 10).index, 20u);
+	}
+
+	void TestMergeNeighbours()
+	{
+		IndexAllocator allocator(50);
+		IndexRange ranges[5];
+		for (IndexRange& range : ranges)
+		{
+			range = AllocateOrEmpty(allocator, 10);
+		}
+
+		allocator.Free(ranges[1]);
+		allocator.Free(ranges[3]);
+		CHECK_EQ(allocator.GetStats().freeRanges, 2u);
+		CHECK_EQ(allocator.GetStats().largestFreeRange, 10u);
+
+		// Merges with the free range after it
+		allocator.Free(ranges[0]);
+		CHECK_EQ(allocator.GetStats().freeRanges, 2u);
+		CHECK_EQ(allocator.GetStats().largestFreeRange, 20u);
+
+		// Merges with the free range before it
+		allocator.Free(ranges[4]);
+		CHECK_EQ(allocator.GetStats().freeRanges, 2u);
+		CHECK_EQ(allocator.GetStats().largestFreeRange, 20u);
+
+		// Merges with both
+		allocator.Free(ranges[2]);
+		CHECK_EQ(allocator.GetStats().freeRanges, 1u);
+		CHECK_EQ(allocator.GetStats().largestFreeRange, 50u);
+		CHECK_EQ(AllocateOrEmpty(allocator, 50).index, 0u);
+	}
+
+	void TestGrow()
+	{
+		IndexAllocator allocator(10);
+		const IndexRange first = AllocateOrEmpty(allocator, 10);
+		CHECK(!allocator.Allocate(1).has_value());
+
+		allocator.Grow(20);
+		CHECK_EQ(allocator.GetCapacity(), 20u);
+		CHECK_EQ(AllocateOrEmpty(allocator, 10).index, 10u);
+		// Existing ranges stay valid
+		CHECK(allocator.IsValid(first));
+
+		// A free range at the old end is merged with the new indices
+		IndexAllocator partial(10);
+		AllocateOrEmpty(partial, 6);
+		partial.Grow(16);
+		CHECK_EQ(partial.GetStats().freeRanges, 1u);
+		CHECK_EQ(partial.GetStats().largestFreeRange, 10u);
+		CHECK_EQ(AllocateOrEmpty(partial, 10).index, 6u);
+
+		partial.Grow(16);
+		CHECK_EQ(partial.GetCapacity(), 16u);
+	}
+
+	void TestStaleGeneration()
+	{
+		IndexAllocator allocator(16);
+		const IndexRange old = AllocateOrEmpty(allocator, 4);
+		CHECK(allocator.IsValid(old));
+		allocator.Free(old);
+		CHECK(!allocator.IsValid(old));
+
+		// Same indices again, but the old handle doesn't alias the new allocation
+		const IndexRange current = AllocateOrEmpty(allocator, 4);
+		CHECK_EQ(current.index, old.index);
+		CHECK(current.generation != old.generation);
+		CHECK(allocator.IsValid(current));
+		CHECK(!allocator.IsValid(old));
+
+		const std::optional<IndexRange> found = allocator.Find(current.index);
+		CHECK(found.has_value());
+		CHECK_EQ(found.value_or(IndexRange{}).count, 4u);
+		CHECK_EQ(found.value_or(IndexRange{}).generation, current.generation);
+
+		// Only the first index of a range is found, and nothing past the end
+		CHECK(!allocator.Find(current.index + 1).has_value());
+		CHECK(!allocator.Find(16).has_value());
+		CHECK(!allocator.IsValid({ current.index, 3, current.generation }));
+		CHECK(!allocator.IsValid({ 100, 4, 0 }));
+		CHECK(!allocator.IsValid({}));
+	}
+
+	void TestStats()
+	{
+		IndexAllocator allocator(100);
+		CHECK_EQ(allocator.GetStats().capacity, 100u);
+		CHECK_EQ(allocator.GetStats().allocated, 0u);
+		CHECK_EQ(allocator.GetStats().freeRanges, 1u);
+		CHECK_EQ(allocator.GetStats().GetFragmentation(), 0.0f);
+
+		IndexRange ranges[10];
+		for (IndexRange& range : ranges)
+		{
+			range = AllocateOrEmpty(allocator, 10);
+		}
+		IndexAllocatorStats stats = allocator.GetStats();
+		CHECK_EQ(stats.allocated, 100u);
+		CHECK_EQ(stats.allocations, 10u);
+		CHECK_EQ(stats.freeRanges, 0u);
+		CHECK_EQ(stats.largestFreeRange, 0u);
+		CHECK_EQ(stats.GetFragmentation(), 0.0f);
+
+		// Four holes of 10, the largest is a quarter of the free indices
+		for (int i = 0; i < 10; i += 3)
+		{
+			allocator.Free(ranges[i]);
+		}
+		stats = allocator.GetStats();
+		CHECK_EQ(stats.allocated, 60u);
+		CHECK_EQ(stats.allocations, 6u);
+		CHECK_EQ(stats.freeRanges, 4u);
+		CHECK_EQ(stats.largestFreeRange, 10u);
+		CHECK_EQ(stats.GetFragmentation(), 0.75f);
+	}
+}
+
+int main()
+{
+	RUN_TEST(TestBestFit);
+	RUN_TEST(TestBestFitLowestIndex);
+	RUN_TEST(TestMergeNeighbours);
+	RUN_TEST(TestGrow);
+	RUN_TEST(TestStaleGeneration);
+	RUN_TEST(TestStats);
+	return TEST_RESULT();
+}
@@ -0,0 +1,143 @@
+#include "Check.h"
+#include "NullBackend.h"
+
+#include <cstring>
+#include <utility>
+
+namespace
+{
+	void TestUploadAndMap()
+	{
+		NullBackend backend;
+		const ResourceHandle buffer = backend.CreateBuffer({ .size = 16 });
+		const ResourceHandle upload = backend.CreateBuffer({ .size = 8, .memory = MemoryType::Upload });
+
+		const uint8_t data[16] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+		backend.Upload(buffer, data, sizeof(data));
+		CHECK(memcmp(backend.GetContents(buffer).data(), data, sizeof(data)) == 0);
+		CHECK_EQ(backend.GetStats().uploads, 1u);
+		CHECK_EQ(backend.GetStats().bytesUploaded, 16u);
+
+		memcpy(backend.Map(upload), data, 8);
+		CHECK(memcmp(backend.GetContents(upload).data(), data, 8) == 0);
+
+		CHECK(backend.GetGPUAddress(buffer) != 0);
+		CHECK(backend.GetGPUAddress(buffer) != backend.GetGPUAddress(upload));
+		CHECK_EQ(backend.GetGPUAddress(upload) % (64 * 1024), 0u);
+		CHECK_EQ(backend.GetDescriptorIndex(buffer), -1);
+	}
+
+	void TestReleaseWaitsForFence()
+	{
+		NullBackend backend(2);
+		const ResourceHandle first = backend.CreateBuffer({ .size = 100 });
+		backend.Submit();
+		backend.Release(first);
+		CHECK_EQ(backend.GetStats().resourcesAlive, 1u);
+		CHECK_EQ(backend.GetStats().bytesAlive, 100u);
+
+		// The release waits for the submission before it, which completes two submissions later
+		backend.Submit();
+		CHECK_EQ(backend.GetStats().resourcesAlive, 1u);
+		backend.Submit();
+		CHECK_EQ(backend.GetStats().resourcesAlive, 0u);
+		CHECK_EQ(backend.GetStats().bytesAlive, 0u);
+		CHECK_EQ(backend.GetStats().peakBytesAlive, 100u);
+
+		const ResourceHandle second = backend.CreateBuffer({ .size = 4 });
+		CHECK_EQ(second.index, first.index);
+	}
+
+	void TestWait()
+	{
+		NullBackend backend(5);
+		const uint64_t fence = backend.Submit();
+		CHECK(!backend.IsComplete(fence));
+		backend.Wait(fence);
+		CHECK(backend.IsComplete(fence));
+		CHECK_EQ(backend.GetStats().blockingWaits, 1u);
+
+		backend.Wait(fence);
+		CHECK_EQ(backend.GetStats().blockingWaits, 1u);
+		CHECK(!backend.IsComplete(fence + 1));
+	}
+
+	void TestTextures()
+	{
+		NullBackend backend;
+		const ResourceHandle first = backend.CreateTexture({ .width = 4, .height = 2 });
+		const ResourceHandle volume = backend.CreateTexture({ .width = 2, .height = 2, .depth = 2, .format = ResourceFormat::RGBA32F });
+		CHECK_EQ(backend.GetContents(first).size(), 4u * 2 * 4);
+		CHECK_EQ(backend.GetContents(volume).size(), 2u * 2 * 2 * 16);
+		CHECK_EQ(backend.GetStats().texturesCreated, 2u);
+
+		const int32_t firstIndex = backend.GetDescriptorIndex(first);
+		CHECK(firstIndex >= 0);
+		CHECK(backend.GetDescriptorIndex(volume) != firstIndex);
+
+		float texels[8 * 4] = {};
+		texels[31] = 1.0f;
+		backend.UploadTexture(volume, texels);
+		CHECK(memcmp(backend.GetContents(volume).data(), texels, sizeof(texels)) == 0);
+
+		// The descriptor is only handed out again once the texture was freed
+		backend.Release(first);
+		backend.Flush();
+		const ResourceHandle reused = backend.CreateTexture({});
+		CHECK_EQ(backend.GetDescriptorIndex(reused), firstIndex);
+	}
+
+	void TestAccelerationStructures()
+	{
+		NullBackend backend;
+		const ResourceHandle vertices = backend.CreateBuffer({ .size = 6 * 48 });
+		const ResourceHandle indices = backend.CreateBuffer({ .size = 6 * sizeof(uint32_t) });
+
+		BLASDesc desc;
+		desc.vertexBuffer = vertices;
+		desc.vertexCount = 6;
+		desc.vertexStride = 48;
+		desc.indexBuffer = indices;
+		desc.indexCount = 6;
+		const ResourceHandle blas = backend.BuildBLAS(desc);
+
+		std::vector<ASInstance> instances(3);
+		for (ASInstance& instance : instances)
+		{
+			instance.blas = blas;
+		}
+		const ResourceHandle tlas = backend.BuildTLAS(instances);
+
+		CHECK_EQ(backend.GetStats().accelerationStructureBuilds, 2u);
+		CHECK(backend.GetContents(tlas).size() > backend.GetContents(blas).size());
+		CHECK(backend.GetGPUAddress(tlas) != 0);
+	}
+
+	void TestBackendResource()
+	{
+		NullBackend backend;
+		{
+			BackendResource first(backend, backend.CreateBuffer({ .size = 8 }));
+			BackendResource second = std::move(first);
+			CHECK(!first);
+			CHECK(second);
+			CHECK_EQ(backend.GetStats().resourcesAlive, 1u);
+
+			second = BackendResource(backend, backend.CreateBuffer({ .size = 8 }));
+			CHECK_EQ(backend.GetStats().resourcesAlive, 1u);
+		}
+		CHECK_EQ(backend.GetStats().resourcesAlive, 0u);
+		CHECK_EQ(backend.GetStats().buffersCreated, 2u);
+	}
+}
+
+int main()
+{
+	RUN_TEST(TestUploadAndMap);
+	RUN_TEST(TestReleaseWaitsForFence);
+	RUN_TEST(TestWait);
+	RUN_TEST(TestTextures);
+	RUN_TEST(TestAccelerationStructures);
+	RUN_TEST(TestBackendResource);
+	return TEST_RESULT();
+}
@@ -0,0 +1,319 @@
+#include "Check.h"
+#include "RenderGraph.h"
+
+#include <string>
+#include <vector>
+
+namespace
+{
+	std::ostream& operator<<(std::ostream& stream, const ResourceState state)
+	{
+		return stream << static_cast<uint32_t>(state);
+	}
+
+	bool IsTransition(const RenderGraphBarrier& barrier, const RenderGraphResource resource, const ResourceState before, const ResourceState after)
+	{
+		return barrier.type == RenderGraphBarrier::Type::Transition && barrier.resource == resource &&
+			barrier.before == before && barrier.after == after;
+	}
+
+	// The barriers of a pass that affect one resource
+	std::vector<RenderGraphBarrier> GetBarriers(const RenderGraph& graph, const uint32_t pass, const RenderGraphResource resource)
+	{
+		std::vector<RenderGraphBarrier> barriers;
+		for (const RenderGraphBarrier& barrier : graph.GetBarriers(pass))
+		{
+			if (barrier.resource == resource)
+			{
+				barriers.push_back(barrier);
+			}
+		}
+		return barriers;
+	}
+
+	void TestCulling()
+	{
+		RenderGraph graph;
+		const RenderGraphResource output = graph.Import("Output", ResourceState::UnorderedAccess);
+		const RenderGraphResource used = graph.Create("Used");
+		const RenderGraphResource unused = graph.Create("Unused");
+		const RenderGraphResource unusedResult = graph.Create("Unused Result");
+		graph.SetOutput(output, ResourceState::UnorderedAccess);
+
+		std::vector<std::string> executed;
+		graph.AddPass("Write Used").Write(used).Execute([&]() { executed.push_back("Write Used"); });
+		graph.AddPass("Write Unused").Write(unused).Execute([&]() { executed.push_back("Write Unused"); });
+		graph.AddPass("Read Unused").Read(unused, ResourceState::NonPixelShaderResource).Write(unusedResult)
+			.Execute([&]() { executed.push_back("Read Unused"); });
+		graph.AddPass("Resolve").Read(used, ResourceState::NonPixelShaderResource).Write(output)
+			.Execute([&]() { executed.push_back("Resolve"); });
+		graph.AddPass("Capture").Read(used, ResourceState::CopySource).SideEffect()
+			.Execute([&]() { executed.push_back("Capture"); });
+
+		CHECK(graph.Compile());
+		CHECK_EQ(graph.GetOrder().size(), 3u);
+		CHECK_EQ(graph.GetStats().passes, 5u);
+		CHECK_EQ(graph.GetStats().culledPasses, 2u);
+		CHECK(!graph.GetLifetime(unused).has_value());
+		CHECK(!graph.GetLifetime(unusedResult).has_value());
+
+		graph.Execute([](std::span<const RenderGraphBarrier>) {});
+		CHECK_EQ(executed.size(), 3u);
+		if (executed.size() == 3)
+		{
+			CHECK_EQ(executed[0], "Write Used");
+			CHECK_EQ(executed[1], "Resolve");
+			CHECK_EQ(executed[2], "Capture");
+		}
+
+		const std::optional<RenderGraphLifetime> lifetime = graph.GetLifetime(used);
+		CHECK(lifetime.has_value());
+		CHECK_EQ(lifetime.value_or(RenderGraphLifetime{}).firstPass, 0u);
+		CHECK_EQ(lifetime.value_or(RenderGraphLifetime{}).lastPass, 2u);
+	}
+
+	void TestNothingNeeded()
+	{
+		RenderGraph graph;
+		const RenderGraphResource resource = graph.Import("Resource", ResourceState::Common);
+		graph.AddPass("Write").Write(resource, ResourceState::CopyDest);
+
+		CHECK(graph.Compile());
+		CHECK(graph.GetOrder().empty());
+		CHECK_EQ(graph.GetFinalState(resource), ResourceState::Common);
+	}
+
+	void TestMergedReadStates()
+	{
+		RenderGraph graph;
+		const RenderGraphResource texture = graph.Import("Texture", ResourceState::UnorderedAccess);
+		const RenderGraphResource output = graph.Import("Output", ResourceState::UnorderedAccess);
+		graph.SetOutput(output, ResourceState::UnorderedAccess);
+
+		graph.AddPass("Compute").Read(texture, ResourceState::NonPixelShaderResource).Write(output);
+		graph.AddPass("Pixel").Read(texture, ResourceState::PixelShaderResource).Write(output);
+		// Covered by the merged state, no barrier
+		graph.AddPass("Compute Again").Read(texture, ResourceState::NonPixelShaderResource).Write(output);
+		// Two read states in one pass are one transition
+		graph.AddPass("Both")
+			.Read(texture, ResourceState::CopySource)
+			.Read(texture, ResourceState::NonPixelShaderResource)
+			.Write(output);
+
+		CHECK(graph.Compile());
+		const std::vector<uint32_t>& order = graph.GetOrder();
+		CHECK_EQ(order.size(), 4u);
+		if (order.size() != 4)
+		{
+			return;
+		}
+
+		constexpr ResourceState shaderResource = ResourceState::NonPixelShaderResource | ResourceState::PixelShaderResource;
+		const std::vector<RenderGraphBarrier> compute = GetBarriers(graph, order[0], texture);
+		CHECK_EQ(compute.size(), 1u);
+		CHECK(!compute.empty() && IsTransition(compute[0], texture, ResourceState::UnorderedAccess, ResourceState::NonPixelShaderResource));
+
+		const std::vector<RenderGraphBarrier> pixel = GetBarriers(graph, order[1], texture);
+		CHECK_EQ(pixel.size(), 1u);
+		CHECK(!pixel.empty() && IsTransition(pixel[0], texture, ResourceState::NonPixelShaderResource, shaderResource));
+
+		CHECK(GetBarriers(graph, order[2], texture).empty());
+
+		const std::vector<RenderGraphBarrier> both = GetBarriers(graph, order[3], texture);
+		CHECK_EQ(both.size(), 1u);
+		CHECK(!both.empty() && IsTransition(both[0], texture, shaderResource, shaderResource | ResourceState::CopySource));
+
+		CHECK_EQ(graph.GetStats().transitions, 3u);
+		CHECK_EQ(graph.GetStats().skippedTransitions, 1u);
+		// The output is written by every pass
+		CHECK_EQ(graph.GetStats().uavBarriers, 3u);
+		CHECK_EQ(graph.GetFinalState(texture), shaderResource | ResourceState::CopySource);
+	}
+
+	void TestUAVBarriers()
+	{
+		RenderGraph graph;
+		const RenderGraphResource buffer = graph.Import("Buffer", ResourceState::UnorderedAccess);
+		graph.SetOutput(buffer, ResourceState::CopySource);
+
+		graph.AddPass("First").Write(buffer);
+		graph.AddPass("Second").Write(buffer);
+		// Reading as unordered access still has to wait for the write
+		graph.AddPass("Read").Read(buffer, ResourceState::UnorderedAccess).SideEffect();
+		graph.AddPass("Read Again").Read(buffer, ResourceState::UnorderedAccess).SideEffect();
+		graph.AddPass("Third").Write(buffer);
+
+		CHECK(graph.Compile());
+		const std::vector<uint32_t>& order = graph.GetOrder();
+		CHECK_EQ(order.size(), 5u);
+		if (order.size() != 5)
+		{
+			return;
+		}
+
+		const auto isUAVBarrier = [&](const uint32_t pass)
+		{
+			const std::span<const RenderGraphBarrier> barriers = graph.GetBarriers(pass);
+			return barriers.size() == 1 && barriers[0].type == RenderGraphBarrier::Type::UAV && barriers[0].resource == buffer;
+		};
+		// Already in the state, the first write needs nothing
+		CHECK(graph.GetBarriers(order[0]).empty());
+		CHECK(isUAVBarrier(order[1]));
+		CHECK(isUAVBarrier(order[2]));
+		// Reads in a row don't wait on each other
+		CHECK(graph.GetBarriers(order[3]).empty());
+		// The write can't start before the reads finished
+		CHECK(isUAVBarrier(order[4]));
+		CHECK_EQ(graph.GetStats().uavBarriers, 3u);
+
+		// Left in the output state after the last pass
+		const std::span<const RenderGraphBarrier> final = graph.GetFinalBarriers();
+		CHECK_EQ(final.size(), 1u);
+		CHECK(!final.empty() && IsTransition(final[0], buffer, ResourceState::UnorderedAccess, ResourceState::CopySource));
+		CHECK_EQ(graph.GetFinalState(buffer), ResourceState::CopySource);
+		CHECK_EQ(graph.GetStats().barrierBatches, 4u);
+	}
+
+	void TestWriteAfterUAVRead()
+	{
+		RenderGraph graph;
+		const RenderGraphResource buffer = graph.Import("Buffer", ResourceState::UnorderedAccess);
+		const RenderGraphResource output = graph.Import("Output", ResourceState::UnorderedAccess);
+		graph.SetOutput(buffer, ResourceState::UnorderedAccess);
+		graph.SetOutput(output, ResourceState::UnorderedAccess);
+
+		graph.AddPass("Write").Write(buffer);
+		graph.AddPass("Read").Read(buffer, ResourceState::UnorderedAccess).Write(output);
+		graph.AddPass("Write Again").Write(buffer);
+
+		CHECK(graph.Compile());
+		const std::vector<uint32_t>& order = graph.GetOrder();
+		CHECK_EQ(order.size(), 3u);
+		if (order.size() != 3)
+		{
+			return;
+		}
+		CHECK_EQ(GetBarriers(graph, order[1], buffer).size(), 1u);
+		const std::vector<RenderGraphBarrier> writeAgain = GetBarriers(graph, order[2], buffer);
+		CHECK_EQ(writeAgain.size(), 1u);
+		CHECK(!writeAgain.empty() && writeAgain[0].type == RenderGraphBarrier::Type::UAV);
+		// The output is only written once
+		CHECK(GetBarriers(graph, order[2], output).empty());
+	}
+
+	void TestTransitionClearsUAVBarrier()
+	{
+		RenderGraph graph;
+		const RenderGraphResource buffer = graph.Import("Buffer", ResourceState::UnorderedAccess);
+		graph.SetOutput(buffer, ResourceState::UnorderedAccess);
+
+		graph.AddPass("Write").Write(buffer);
+		graph.AddPass("Copy").Write(buffer, ResourceState::CopyDest);
+		graph.AddPass("Write Again").Write(buffer);
+
+		CHECK(graph.Compile());
+		CHECK_EQ(graph.GetStats().uavBarriers, 0u);
+		CHECK_EQ(graph.GetStats().transitions, 2u);
+		CHECK(graph.GetFinalBarriers().empty());
+	}
+
+	void TestBarriersSubmittedBeforePass()
+	{
+		RenderGraph graph;
+		const RenderGraphResource backBuffer = graph.Import("Back Buffer", ResourceState::Common);
+		graph.SetOutput(backBuffer, ResourceState::Common);
+
+		std::vector<std::string> events;
+		graph.AddPass("Copy").Write(backBuffer, ResourceState::CopyDest).Execute([&]() { events.push_back("Copy"); });
+		graph.AddPass("UI").Write(backBuffer, ResourceState::RenderTarget).Execute([&]() { events.push_back("UI"); });
+
+		CHECK(graph.Compile());
+		graph.Execute([&](const std::span<const RenderGraphBarrier> barriers)
+		{
+			for (const RenderGraphBarrier& barrier : barriers)
+			{
+				events.push_back("Barrier " + std::to_string(static_cast<uint32_t>(barrier.after)));
+			}
+		});
+
+		const std::vector<std::string> expected = {
+			"Barrier " + std::to_string(static_cast<uint32_t>(ResourceState::CopyDest)), "Copy",
+			"Barrier " + std::to_string(static_cast<uint32_t>(ResourceState::RenderTarget)), "UI",
+			"Barrier " + std::to_string(static_cast<uint32_t>(ResourceState::Common)),
+		};
+		CHECK(events == expected);
+	}
+
+	void TestValidationErrors()
+	{
+		{
+			RenderGraph graph;
+			graph.AddPass("Missing").Write(5);
+			CHECK(!graph.Compile());
+		}
+		{
+			RenderGraph graph;
+			const RenderGraphResource texture = graph.Import("Texture", ResourceState::Common);
+			graph.AddPass("Read Only Write").Write(texture, ResourceState::PixelShaderResource);
+			CHECK(!graph.Compile());
+		}
+		{
+			RenderGraph graph;
+			const RenderGraphResource texture = graph.Import("Texture", ResourceState::Common);
+			graph.AddPass("Common Write").Write(texture, ResourceState::Common);
+			CHECK(!graph.Compile());
+		}
+		{
+			RenderGraph graph;
+			const RenderGraphResource texture = graph.Import("Texture", ResourceState::Common);
+			graph.AddPass("Two States").Read(texture, ResourceState::NonPixelShaderResource).Write(texture);
+			CHECK(!graph.Compile());
+		}
+		{
+			RenderGraph graph;
+			const RenderGraphResource texture = graph.Import("Texture", ResourceState::Common);
+			graph.AddPass("Two Writes").Write(texture).Write(texture, ResourceState::CopyDest);
+			CHECK(!graph.Compile());
+		}
+		{
+			RenderGraph graph;
+			const RenderGraphResource created = graph.Create("Created");
+			const RenderGraphResource output = graph.Import("Output", ResourceState::UnorderedAccess);
+			graph.SetOutput(output, ResourceState::UnorderedAccess);
+			graph.AddPass("Read Before Write").Read(created, ResourceState::NonPixelShaderResource).Write(output);
+			graph.AddPass("Write").Write(created);
+			CHECK(!graph.Compile());
+			CHECK(graph.GetOrder().empty());
+		}
+	}
+
+	void TestRecompile()
+	{
+		RenderGraph graph;
+		const RenderGraphResource buffer = graph.Import("Buffer", ResourceState::Common);
+		graph.SetOutput(buffer, ResourceState::Common);
+		graph.AddPass("Write").Write(buffer);
+
+		CHECK(graph.Compile());
+		const RenderGraphStats first = graph.GetStats();
+		CHECK(graph.Compile());
+		CHECK_EQ(graph.GetStats().transitions, first.transitions);
+		CHECK_EQ(graph.GetStats().barrierBatches, first.barrierBatches);
+		CHECK_EQ(graph.GetOrder().size(), 1u);
+		CHECK_EQ(graph.GetBarriers(0).size(), 1u);
+	}
+}
+
+int main()
+{
+	RUN_TEST(TestCulling);
+	RUN_TEST(TestNothingNeeded);
+	RUN_TEST(TestMergedReadStates);
+	RUN_TEST(TestUAVBarriers);
+	RUN_TEST(TestWriteAfterUAVRead);
+	RUN_TEST(TestTransitionClearsUAVBarrier);
+	RUN_TEST(TestBarriersSubmittedBeforePass);
+	RUN_TEST(TestValidationErrors);
+	RUN_TEST(TestRecompile);
+	return TEST_RESULT();
+}
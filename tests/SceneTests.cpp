@@ -0,0 +1,182 @@
+#include "Check.h"
+#include "Scene.h"
+#include "NullBackend.h"
+#include "CPUScene.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	// One textured triangle, instanced by a TRS node and by its child with a matrix that scales x by 2 and moves z by 5
+	constexpr const char* TRIANGLE_GLTF = R"({
+		"asset": { "version": "2.0" },
+		"scene": 0,
+		"scenes": [ { "nodes": [ 0 ] } ],
+		"nodes": [
+			{ "mesh": 0, "translation": [ 1, 2, 3 ], "children": [ 1 ] },
+			{ "mesh": 0, "matrix": [ 2, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 5, 1 ] }
+		],
+		"meshes": [ { "name": "Triangle", "primitives": [ { "attributes": { "POSITION": 0, "NORMAL": 1, "TEXCOORD_0": 2 }, "indices": 3, "material": 0 } ] } ],
+		"materials": [ { "pbrMetallicRoughness": { "baseColorFactor": [ 0.5, 0.25, 1, 1 ], "baseColorTexture": { "index": 0 }, "metallicFactor": 0.1, "roughnessFactor": 0.7 } } ],
+		"textures": [ { "source": 0 } ],
+		"images": [ { "uri": "data:image/png;base64,iVBORw0KGgoAAAANSUhEUgAAAAEAAAABCAYAAAAfFcSJAAAADUlEQVR4nGP4z8DwHwAFAAH/iZk9HQAAAABJRU5ErkJggg==" } ],
+		"buffers": [ { "byteLength": 108, "uri": "data:application/octet-stream;base64,AAAAAAAAAAAAAAAAAACAPwAAAAAAAAAAAAAAAAAAgD8AAAAAAAAAAAAAAAAAAIA/AAAAAAAAAAAAAIA/AAAAAAAAAAAAAIA/AAAAAAAAAAAAAIA/AAAAAAAAAAAAAIA/AAAAAAEAAAACAAAA" } ],
+		"bufferViews": [
+			{ "buffer": 0, "byteOffset": 0, "byteLength": 36 },
+			{ "buffer": 0, "byteOffset": 36, "byteLength": 36 },
+			{ "buffer": 0, "byteOffset": 72, "byteLength": 24 },
+			{ "buffer": 0, "byteOffset": 96, "byteLength": 12 }
+		],
+		"accessors": [
+			{ "bufferView": 0, "componentType": 5126, "count": 3, "type": "VEC3", "min": [ 0, 0, 0 ], "max": [ 1, 1, 0 ] },
+			{ "bufferView": 1, "componentType": 5126, "count": 3, "type": "VEC3" },
+			{ "bufferView": 2, "componentType": 5126, "count": 3, "type": "VEC2" },
+			{ "bufferView": 3, "componentType": 5125, "count": 3, "type": "SCALAR" }
+		]
+	})";
+
+	std::filesystem::path GetTestDirectory()
+	{
+		const std::filesystem::path directory = std::filesystem::temp_directory_path() / "KyraSceneTests";
+		std::filesystem::create_directories(directory);
+		return directory;
+	}
+
+	std::string WriteTriangle()
+	{
+		const std::filesystem::path path = GetTestDirectory() / "triangle.gltf";
+		std::ofstream(path) << TRIANGLE_GLTF;
+		return path.string();
+	}
+
+	// Two uncompressed RGBE texels, a width below 8 can't be run length encoded
+	std::string WriteHDRI()
+	{
+		const std::filesystem::path path = GetTestDirectory() / "sky.hdr";
+		std::ofstream file(path, std::ios::binary);
+		file << "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y 1 +X 2\n";
+		const unsigned char texels[8] = { 128, 128, 128, 129, 128, 0, 0, 128 };
+		file.write(reinterpret_cast<const char*>(texels), sizeof(texels));
+		return path.string();
+	}
+
+	void TestLoadModel()
+	{
+		NullBackend backend(2);
+		Scene scene(backend);
+		CHECK_EQ(scene.GetTLASAddress(), 0u);
+		CHECK(scene.LoadModel(WriteTriangle()));
+
+		CHECK_EQ(scene.GetModels().size(), 1u);
+		const Model& model = scene.GetModels()[0];
+		CHECK_EQ(model.GetMeshes().size(), 2u);
+		CHECK_EQ(model.GetTextures().size(), 1u);
+		CHECK_EQ(backend.GetStats().texturesCreated, 1u);
+		CHECK_EQ(backend.GetStats().accelerationStructureBuilds, 3u); // a BLAS per mesh and the TLAS
+		CHECK(scene.GetTLASAddress() != 0);
+		CHECK(scene.GetMaterialsBufferAddress() != 0);
+
+		// Parent times local, like CPUScene
+		const glm::mat4& parent = model.GetMeshes()[0].GetTransformMatrix();
+		const glm::mat4& child = model.GetMeshes()[1].GetTransformMatrix();
+		CHECK(parent[3] == glm::vec4(1.0f, 2.0f, 3.0f, 1.0f));
+		CHECK(child[3] == glm::vec4(1.0f, 2.0f, 8.0f, 1.0f));
+		CHECK_EQ(child[0][0], 2.0f);
+
+		CPUScene cpuScene;
+		CHECK(cpuScene.LoadModel(scene.GetModelPaths()[0]));
+		CHECK_EQ(cpuScene.GetMeshes().size(), 2u);
+		for (size_t i = 0; i < cpuScene.GetMeshes().size() && i < model.GetMeshes().size(); i++)
+		{
+			CHECK(cpuScene.GetMeshes()[i].transform == model.GetMeshes()[i].GetTransformMatrix());
+		}
+
+		// The instance takes the top three rows
+		const ASInstance instance = model.GetMeshes()[1].GetInstance(1);
+		CHECK_EQ(instance.transform[0][0], 2.0f);
+		CHECK_EQ(instance.transform[2][3], 8.0f);
+		CHECK_EQ(instance.instanceId, 1u);
+
+		const Mesh& mesh = model.GetMeshes()[0];
+		const std::vector<uint8_t>& vertices = backend.GetContents(mesh.GetVertexBuffer());
+		CHECK_EQ(vertices.size(), 3 * sizeof(Vertex));
+		Vertex second{};
+		memcpy(&second, vertices.data() + sizeof(Vertex), sizeof(Vertex));
+		CHECK(second.position == glm::vec3(1.0f, 0.0f, 0.0f));
+		CHECK(second.normal == glm::vec3(0.0f, 0.0f, 1.0f));
+
+		const MaterialData& material = model.GetMaterials()[0];
+		CHECK(material.albedoFactor == glm::vec3(0.5f, 0.25f, 1.0f));
+		CHECK_EQ(material.albedoIndex, backend.GetDescriptorIndex(model.GetTextures()[0].Get()));
+		CHECK_EQ(material.normalIndex, -1);
+
+		const std::vector<HitGroupRecord> records = scene.GetHitGroupRecords();
+		CHECK_EQ(records.size(), 2u);
+		CHECK_EQ(records[0].vertexBuffer, backend.GetGPUAddress(mesh.GetVertexBuffer()));
+		CHECK_EQ(records[0].indexBuffer, backend.GetGPUAddress(mesh.GetIndexBuffer()));
+		CHECK_EQ(records[1].materialIndex, 0u);
+		CHECK_EQ(scene.GetCPUInstances().size(), 2u);
+	}
+
+	void TestLoadSecondModel()
+	{
+		NullBackend backend(2);
+		const std::string path = WriteTriangle();
+		{
+			Scene scene(backend);
+			CHECK(scene.LoadModel(path));
+			const uint64_t firstTLAS = scene.GetTLASAddress();
+			CHECK(scene.LoadModel(path));
+
+			// The TLAS is rebuilt over every mesh, the materials of the second model come after the first's
+			CHECK(scene.GetTLASAddress() != firstTLAS);
+			CHECK_EQ(backend.GetStats().accelerationStructureBuilds, 6u);
+			const std::vector<HitGroupRecord> records = scene.GetHitGroupRecords();
+			CHECK_EQ(records.size(), 4u);
+			CHECK_EQ(records[3].materialIndex, 1u);
+			CHECK_EQ(scene.GetModelPaths().size(), 2u);
+		}
+
+		// The scene released everything once the GPU is done with it
+		backend.Flush();
+		CHECK_EQ(backend.GetStats().resourcesAlive, 0u);
+		CHECK_EQ(backend.GetStats().bytesAlive, 0u);
+	}
+
+	void TestLoadHDRI()
+	{
+		NullBackend backend;
+		Scene scene(backend);
+		CHECK_EQ(scene.GetHDRIDescriptorIndex(), -1);
+		const std::string path = WriteHDRI();
+		CHECK(scene.LoadHDRI(path));
+		CHECK(scene.GetHDRIDescriptorIndex() >= 0);
+		CHECK_EQ(scene.GetHDRIPath(), path);
+		CHECK_EQ(backend.GetStats().bytesUploaded, 2u * 16);
+	}
+
+	void TestLoadFailures()
+	{
+		NullBackend backend;
+		Scene scene(backend);
+		const std::filesystem::path directory = GetTestDirectory();
+		CHECK(!scene.LoadModel((directory / "model.obj").string()));
+		CHECK(!scene.LoadModel((directory / "missing.gltf").string()));
+		CHECK(!scene.LoadHDRI((directory / "missing.hdr").string()));
+		CHECK(!scene.LoadHDRI((directory / "sky.exr").string()));
+		CHECK(scene.GetModels().empty());
+		CHECK_EQ(scene.GetHDRIDescriptorIndex(), -1);
+		CHECK_EQ(backend.GetStats().resourcesAlive, 0u);
+	}
+}
+
+int main()
+{
+	RUN_TEST(TestLoadModel);
+	RUN_TEST(TestLoadSecondModel);
+	RUN_TEST(TestLoadHDRI);
+	RUN_TEST(TestLoadFailures);
+	return TEST_RESULT();
+}
@@ -0,0 +1,139 @@
+#include "Check.h"
+#include "StagingRing.h"
+
+namespace
+{
+	void TestAllocate()
+	{
+		StagingRing ring(256);
+		CHECK_EQ(ring.Allocate(10, 1).value_or(~0ull), 0u);
+		// Aligned up past the previous allocation
+		CHECK_EQ(ring.Allocate(16, 16).value_or(~0ull), 16u);
+		CHECK_EQ(ring.GetUsed(), 32u);
+		CHECK(ring.HasOpenAllocations());
+		CHECK_EQ(ring.GetOldestFence(), 0u);
+
+		ring.Close(1);
+		CHECK(!ring.HasOpenAllocations());
+		CHECK_EQ(ring.GetOldestFence(), 1u);
+	}
+
+	void TestWrapAround()
+	{
+		StagingRing ring(256);
+		CHECK_EQ(ring.Allocate(100, 4).value_or(~0ull), 0u);
+		ring.Close(1);
+		CHECK_EQ(ring.Allocate(100, 4).value_or(~0ull), 100u);
+		ring.Close(2);
+		ring.Reclaim(1);
+		CHECK_EQ(ring.GetUsed(), 100u);
+
+		// 56 bytes are left before the end, so it continues at the start and the skipped space counts as used
+		CHECK_EQ(ring.Allocate(100, 4).value_or(~0ull), 0u);
+		CHECK_EQ(ring.GetUsed(), 256u);
+		ring.Close(3);
+
+		ring.Reclaim(2);
+		CHECK_EQ(ring.GetUsed(), 156u);
+		CHECK_EQ(ring.Allocate(100, 4).value_or(~0ull), 100u);
+	}
+
+	void TestFullRing()
+	{
+		StagingRing ring(256);
+		CHECK(ring.Allocate(200, 4).has_value());
+		ring.Close(1);
+
+		// Fits in the ring, but not until the first batch completed
+		CHECK(ring.Fits(100, 4));
+		CHECK(!ring.Allocate(100, 4).has_value());
+		CHECK(!ring.HasOpenAllocations());
+		CHECK_EQ(ring.GetUsed(), 200u);
+
+		ring.Reclaim(0);
+		CHECK(!ring.Allocate(100, 4).has_value());
+		ring.Reclaim(1);
+		CHECK_EQ(ring.Allocate(100, 4).value_or(~0ull), 0u);
+	}
+
+	void TestReclaimOrder()
+	{
+		StagingRing ring(1024);
+		for (uint64_t fence = 1; fence <= 3; fence++)
+		{
+			CHECK(ring.Allocate(100, 4).has_value());
+			ring.Close(fence * 10);
+		}
+		CHECK_EQ(ring.GetOldestFence(), 10u);
+
+		// Batches are freed oldest first, and only once their fence completed
+		ring.Reclaim(15);
+		CHECK_EQ(ring.GetOldestFence(), 20u);
+		CHECK_EQ(ring.GetUsed(), 200u);
+		ring.Reclaim(30);
+		CHECK_EQ(ring.GetOldestFence(), 0u);
+		CHECK_EQ(ring.GetUsed(), 0u);
+	}
+
+	void TestSharedFence()
+	{
+		StagingRing ring(1024);
+		CHECK(ring.Allocate(100, 4).has_value());
+		ring.Close(5);
+		CHECK(ring.Allocate(100, 4).has_value());
+		ring.Close(5);
+		// Closing without allocations doesn't add a batch
+		ring.Close(6);
+
+		ring.Reclaim(5);
+		CHECK_EQ(ring.GetUsed(), 0u);
+		CHECK_EQ(ring.GetOldestFence(), 0u);
+	}
+
+	void TestOversize()
+	{
+		StagingRing ring(256);
+		CHECK(ring.Fits(256, 4));
+		CHECK(!ring.Fits(257, 1));
+		// Alignment counts towards the size
+		CHECK(ring.Fits(200, 256));
+		CHECK(!ring.Fits(300, 256));
+
+		CHECK(!ring.Allocate(257, 1).has_value());
+		CHECK_EQ(ring.GetUsed(), 0u);
+		CHECK(!ring.HasOpenAllocations());
+
+		CHECK_EQ(ring.Allocate(256, 256).value_or(~0ull), 0u);
+		CHECK_EQ(ring.GetUsed(), 256u);
+	}
+
+	void TestIdleReset()
+	{
+		StagingRing ring(256);
+		CHECK(ring.Allocate(200, 4).has_value());
+		ring.Close(1);
+		ring.Reclaim(1);
+
+		// Nothing is in use, so a large allocation starts at the beginning instead of wrapping after the old head
+		CHECK_EQ(ring.GetUsed(), 0u);
+		CHECK_EQ(ring.Allocate(200, 4).value_or(~0ull), 0u);
+
+		// Open allocations keep the ring from resetting
+		ring.Reclaim(100);
+		CHECK_EQ(ring.GetUsed(), 200u);
+		CHECK(ring.HasOpenAllocations());
+		CHECK(!ring.Allocate(100, 4).has_value());
+	}
+}
+
+int main()
+{
+	RUN_TEST(TestAllocate);
+	RUN_TEST(TestWrapAround);
+	RUN_TEST(TestFullRing);
+	RUN_TEST(TestReclaimOrder);
+	RUN_TEST(TestSharedFence);
+	RUN_TEST(TestOversize);
+	RUN_TEST(TestIdleReset);
+	return TEST_RESULT();
+}